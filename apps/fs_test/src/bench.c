@@ -0,0 +1,239 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(FS_TEST_BENCH)
+
+#include <stdio.h>
+#include <string.h>
+#include <fs/fs.h>
+#if MYNEWT_VAL(FS_TEST_NFFS)
+#include "nffs/nffs.h"
+#endif
+
+#define BENCH_FILE_SIZE     MYNEWT_VAL(FS_TEST_BENCH_FILE_SIZE)
+#define BENCH_CHUNK_SIZE    256
+#define BENCH_SMALL_FILES   MYNEWT_VAL(FS_TEST_BENCH_SMALL_FILES)
+#define BENCH_ROUNDS        MYNEWT_VAL(FS_TEST_BENCH_ROUNDS)
+
+static uint8_t bench_buf[BENCH_CHUNK_SIZE];
+
+static void
+bench_report(const char *name, uint32_t ops, const char *unit, uint32_t bytes,
+             int64_t elapsed)
+{
+    if (elapsed <= 0) {
+        elapsed = 1;
+    }
+
+    printf("bench %-16s %6lu %s in %8lu us", name, (unsigned long)ops, unit,
+           (unsigned long)elapsed);
+    if (bytes) {
+        printf(" (%lu KiB/s)",
+               (unsigned long)((uint64_t)bytes * 1000000 / 1024 / elapsed));
+    }
+    printf("\n");
+}
+
+static int
+bench_seq(const char *root)
+{
+    struct fs_file *file;
+    char name[40];
+    uint32_t outlen;
+    uint32_t off;
+    int64_t start;
+    int rc;
+    int i;
+
+    sprintf(name, "%s/bench_seq", root);
+
+    for (i = 0; i < BENCH_CHUNK_SIZE; i++) {
+        bench_buf[i] = i;
+    }
+
+    start = os_get_uptime_usec();
+    rc = fs_open(name, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    if (rc != 0) {
+        return rc;
+    }
+    for (off = 0; off < BENCH_FILE_SIZE; off += BENCH_CHUNK_SIZE) {
+        rc = fs_write(file, bench_buf, BENCH_CHUNK_SIZE);
+        if (rc != 0) {
+            fs_close(file);
+            return rc;
+        }
+    }
+    fs_close(file);
+    bench_report("seq write", BENCH_FILE_SIZE / BENCH_CHUNK_SIZE, "writes",
+                 BENCH_FILE_SIZE, os_get_uptime_usec() - start);
+
+    start = os_get_uptime_usec();
+    rc = fs_open(name, FS_ACCESS_READ, &file);
+    if (rc != 0) {
+        return rc;
+    }
+    for (off = 0; off < BENCH_FILE_SIZE; off += BENCH_CHUNK_SIZE) {
+        rc = fs_read(file, BENCH_CHUNK_SIZE, bench_buf, &outlen);
+        if (rc != 0 || outlen != BENCH_CHUNK_SIZE ||
+            bench_buf[BENCH_CHUNK_SIZE - 1] != BENCH_CHUNK_SIZE - 1) {
+            fs_close(file);
+            return -1;
+        }
+    }
+    fs_close(file);
+    bench_report("seq read", BENCH_FILE_SIZE / BENCH_CHUNK_SIZE, "reads",
+                 BENCH_FILE_SIZE, os_get_uptime_usec() - start);
+
+    return fs_unlink(name);
+}
+
+/*
+ * Opens, reads and closes many small files; dominated by metadata lookups
+ * rather than data transfer.
+ */
+static int
+bench_small(const char *root)
+{
+    struct fs_file *file;
+    char name[40];
+    uint32_t outlen;
+    int64_t start;
+    int rc;
+    int r;
+    int i;
+
+    for (i = 0; i < BENCH_SMALL_FILES; i++) {
+        sprintf(name, "%s/bench_%d", root, i);
+        rc = fs_open(name, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+        if (rc != 0) {
+            return rc;
+        }
+        rc = fs_write(file, &i, sizeof(i));
+        fs_close(file);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    start = os_get_uptime_usec();
+    for (r = 0; r < BENCH_ROUNDS; r++) {
+        for (i = 0; i < BENCH_SMALL_FILES; i++) {
+            sprintf(name, "%s/bench_%d", root, i);
+            rc = fs_open(name, FS_ACCESS_READ, &file);
+            if (rc != 0) {
+                return rc;
+            }
+            rc = fs_read(file, sizeof(int), bench_buf, &outlen);
+            fs_close(file);
+            if (rc != 0 || outlen != sizeof(int) ||
+                memcmp(bench_buf, &i, sizeof(i)) != 0) {
+                return -1;
+            }
+        }
+    }
+    bench_report("small file read", BENCH_ROUNDS * BENCH_SMALL_FILES, "files",
+                 0, os_get_uptime_usec() - start);
+
+    for (i = 0; i < BENCH_SMALL_FILES; i++) {
+        sprintf(name, "%s/bench_%d", root, i);
+        rc = fs_unlink(name);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+#if MYNEWT_VAL(FS_TEST_NFFS)
+static int
+bench_mount_one(const char *name, const struct nffs_area_desc *descs)
+{
+    int64_t start;
+    int rc;
+
+    start = os_get_uptime_usec();
+    rc = nffs_detect(descs);
+    bench_report(name, 1, "mounts", 0, os_get_uptime_usec() - start);
+
+    return rc;
+}
+
+/*
+ * Remounts the file system; with NFFS_CHECKPOINT the second mount loads the
+ * index from the checkpoint instead of scanning the areas.
+ */
+static int
+bench_mount(void)
+{
+    struct nffs_area_desc descs[MYNEWT_VAL(NFFS_NUM_AREAS) + 1];
+    int cnt;
+    int rc;
+
+    cnt = MYNEWT_VAL(NFFS_NUM_AREAS);
+    rc = nffs_misc_desc_from_flash_area(MYNEWT_VAL(NFFS_FLASH_AREA), &cnt,
+                                        descs);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = bench_mount_one("mount (scan)", descs);
+    if (rc != 0) {
+        return rc;
+    }
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    rc = nffs_checkpoint();
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = bench_mount_one("mount (ckpt)", descs);
+#endif
+
+    return rc;
+}
+#endif
+
+int
+fs_test_bench(const char *root)
+{
+    int rc;
+
+    printf("Running throughput benchmark in (%s)\n", root);
+
+    rc = bench_seq(root);
+    if (rc == 0) {
+        rc = bench_small(root);
+    }
+#if MYNEWT_VAL(FS_TEST_NFFS)
+    if (rc == 0) {
+        rc = bench_mount();
+    }
+#endif
+    if (rc != 0) {
+        printf("Benchmark failed (%d)\n", rc);
+    }
+
+    return rc;
+}
+
+#endif
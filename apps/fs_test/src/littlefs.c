@@ -25,10 +25,7 @@
 #error "No LITTLEFS_FLASH_AREA defined"
 #endif
 
-#include "littlefs/lfs.h"
-
-int littlefs_reformat(void);
-int littlefs_init(void);
+#include "littlefs/littlefs.h"
 
 int
 fs_lowlevel_init(void)
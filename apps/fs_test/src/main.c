@@ -355,6 +355,9 @@ fs_test_cleanup(char *root)
 }
 
 extern int fs_lowlevel_init(void);
+#if MYNEWT_VAL(FS_TEST_BENCH)
+extern int fs_test_bench(const char *root);
+#endif
 
 static void
 fs_test_handler(void *arg)
@@ -383,6 +386,11 @@ fs_test_handler(void *arg)
     if (rc == 0) {
         rc = fs_test_read_directory(root);
     }
+#if MYNEWT_VAL(FS_TEST_BENCH)
+    if (rc == 0) {
+        rc = fs_test_bench(root);
+    }
+#endif
     if (rc == 0) {
         rc = fs_test_cleanup(root);
     }
@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "os_bench.h"
+
+#if MYNEWT_VAL(OS_BENCH_CALLOUT)
+
+#define CALLOUT_BENCH_COUNT     MYNEWT_VAL(OS_BENCH_CALLOUT_COUNT)
+#define CALLOUT_BENCH_ROUNDS    MYNEWT_VAL(OS_BENCH_CALLOUT_ROUNDS)
+
+static struct os_callout callout_bench_callouts[CALLOUT_BENCH_COUNT];
+static struct os_eventq callout_bench_evq;
+
+static uint32_t callout_bench_seed;
+
+static uint32_t
+callout_bench_rand(void)
+{
+    /* Simple LCG; good enough to spread expiry times. */
+    callout_bench_seed = callout_bench_seed * 1103515245 + 12345;
+    return callout_bench_seed >> 8;
+}
+
+/**
+ * Arms every callout with a pseudo-random timeout, mixing short protocol
+ * style timers with long ones, and measures the per-reset cost.
+ */
+static void
+callout_bench_arm(const char *name)
+{
+    uint32_t worst;
+    uint32_t start;
+    uint32_t op;
+    os_time_t ticks;
+    int rc;
+    int i;
+
+    worst = 0;
+    start = os_cputime_get32();
+
+    for (i = 0; i < CALLOUT_BENCH_COUNT; i++) {
+        if (i & 1) {
+            ticks = 1 + callout_bench_rand() % OS_TICKS_PER_SEC;
+        } else {
+            ticks = 1 + callout_bench_rand() % (OS_TICKS_PER_SEC * 600);
+        }
+
+        op = os_cputime_get32();
+        rc = os_callout_reset(&callout_bench_callouts[i], ticks);
+        op = os_cputime_get32() - op;
+        assert(rc == 0);
+        if (op > worst) {
+            worst = op;
+        }
+    }
+
+    os_bench_report(name, CALLOUT_BENCH_COUNT, os_cputime_get32() - start,
+                    worst);
+}
+
+/**
+ * Stops every callout in a scattered order so that removals do not simply
+ * walk the pending list from one end.
+ */
+static void
+callout_bench_cancel(const char *name)
+{
+    uint32_t worst;
+    uint32_t start;
+    uint32_t op;
+    int idx;
+    int i;
+
+    worst = 0;
+    start = os_cputime_get32();
+
+    idx = 0;
+    for (i = 0; i < CALLOUT_BENCH_COUNT; i++) {
+        /* 7919 is prime, so every callout is visited exactly once as long as
+         * the count is not a multiple of it.
+         */
+        idx = (idx + 7919) % CALLOUT_BENCH_COUNT;
+
+        op = os_cputime_get32();
+        os_callout_stop(&callout_bench_callouts[idx]);
+        op = os_cputime_get32() - op;
+        if (op > worst) {
+            worst = op;
+        }
+    }
+
+    os_bench_report(name, CALLOUT_BENCH_COUNT, os_cputime_get32() - start,
+                    worst);
+}
+
+/**
+ * Measures how long it takes to find the next expiry with every callout
+ * pending.  The tickless idle path does this on every sleep.
+ */
+static void
+callout_bench_wakeup(const char *name)
+{
+    uint32_t worst;
+    uint32_t start;
+    uint32_t op;
+    os_sr_t sr;
+    int i;
+
+    worst = 0;
+    start = os_cputime_get32();
+
+    for (i = 0; i < CALLOUT_BENCH_ROUNDS; i++) {
+        op = os_cputime_get32();
+        OS_ENTER_CRITICAL(sr);
+        os_callout_wakeup_ticks(os_time_get());
+        OS_EXIT_CRITICAL(sr);
+        op = os_cputime_get32() - op;
+        if (op > worst) {
+            worst = op;
+        }
+    }
+
+    os_bench_report(name, CALLOUT_BENCH_ROUNDS, os_cputime_get32() - start,
+                    worst);
+}
+
+void
+os_bench_callout(void)
+{
+    int i;
+
+    os_eventq_init(&callout_bench_evq);
+    for (i = 0; i < CALLOUT_BENCH_COUNT; i++) {
+        os_callout_init(&callout_bench_callouts[i], &callout_bench_evq,
+                        NULL, NULL);
+    }
+
+    callout_bench_seed = 1;
+    callout_bench_arm("callout arm");
+    callout_bench_wakeup("callout wakeup_ticks");
+
+    /* Re-arming an already pending callout removes it first. */
+    callout_bench_arm("callout rearm");
+    callout_bench_cancel("callout cancel");
+}
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "os_bench.h"
+
+#if MYNEWT_VAL(OS_BENCH_CBMEM)
+
+#include "cbmem/cbmem.h"
+
+#define CBMEM_BENCH_TASKS       4
+#define CBMEM_BENCH_STACK_SIZE  OS_STACK_ALIGN(256)
+#define CBMEM_BENCH_PRIO        MYNEWT_VAL(OS_BENCH_CBMEM_PRIO)
+#define CBMEM_BENCH_APPENDS     MYNEWT_VAL(OS_BENCH_CBMEM_APPENDS)
+#define CBMEM_BENCH_BURST       16
+
+#if CBMEM_BENCH_PRIO <= MYNEWT_VAL(OS_MAIN_TASK_PRIO) || \
+    CBMEM_BENCH_PRIO + CBMEM_BENCH_TASKS > OS_IDLE_PRIO
+#error "OS_BENCH_CBMEM_PRIO must leave room for the benchmark tasks " \
+       "between the main and idle tasks"
+#endif
+
+struct cbmem_bench_entry {
+    uint32_t seq;
+    uint8_t task;
+    uint8_t payload[27];
+};
+
+struct cbmem_bench_producer {
+    struct os_task task;
+    uint32_t busy;
+    uint32_t worst;
+    uint32_t failed;
+    uint32_t last_seq;
+    uint32_t seen;
+};
+
+static struct cbmem cbmem_bench_cbmem;
+static uint8_t cbmem_bench_buf[MYNEWT_VAL(OS_BENCH_CBMEM_BUF_SIZE)];
+static struct cbmem_bench_producer cbmem_bench_producers[CBMEM_BENCH_TASKS];
+static os_stack_t cbmem_bench_stacks[CBMEM_BENCH_TASKS]
+                                    [CBMEM_BENCH_STACK_SIZE];
+static struct os_sem cbmem_bench_done;
+
+/**
+ * Appends entries in bursts, sleeping for a tick between bursts.  The
+ * producers wake up on the same ticks, so the higher priority ones regularly
+ * preempt the lower priority ones in the middle of an append.
+ */
+static void
+cbmem_bench_task_handler(void *arg)
+{
+    struct cbmem_bench_producer *prod;
+    struct cbmem_bench_entry entry;
+    uint32_t seq;
+    uint32_t t;
+    int rc;
+
+    prod = arg;
+    memset(&entry, 0, sizeof(entry));
+    entry.task = prod - cbmem_bench_producers;
+
+    for (seq = 1; seq <= CBMEM_BENCH_APPENDS; seq++) {
+        entry.seq = seq;
+
+        t = os_cputime_get32();
+        rc = cbmem_append(&cbmem_bench_cbmem, &entry, sizeof(entry));
+        t = os_cputime_get32() - t;
+
+        prod->busy += t;
+        if (t > prod->worst) {
+            prod->worst = t;
+        }
+        if (rc != 0) {
+            prod->failed++;
+        }
+
+        if (seq % CBMEM_BENCH_BURST == 0) {
+            os_time_delay(1);
+        }
+    }
+
+    os_sem_release(&cbmem_bench_done);
+    os_time_delay(OS_TIMEOUT_NEVER);
+}
+
+/**
+ * Checks that each producer's surviving entries are intact and in order.
+ */
+static int
+cbmem_bench_walk(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr, void *arg)
+{
+    struct cbmem_bench_producer *prod;
+    struct cbmem_bench_entry entry;
+    int *errors;
+    int rc;
+
+    errors = arg;
+
+    rc = cbmem_read(cbmem, hdr, &entry, 0, sizeof(entry));
+    if (rc != sizeof(entry) || entry.task >= CBMEM_BENCH_TASKS) {
+        (*errors)++;
+        return 0;
+    }
+
+    prod = &cbmem_bench_producers[entry.task];
+    if (entry.seq <= prod->last_seq) {
+        (*errors)++;
+    }
+    prod->last_seq = entry.seq;
+    prod->seen++;
+
+    return 0;
+}
+
+static void
+cbmem_bench_run(bool lockfree)
+{
+    struct cbmem_bench_producer *prod;
+    uint32_t failed;
+    uint32_t worst;
+    uint32_t busy;
+    uint32_t seen;
+    char name[24];
+    int errors;
+    int rc;
+    int i;
+
+    memset(cbmem_bench_producers, 0, sizeof(cbmem_bench_producers));
+    os_sem_init(&cbmem_bench_done, 0);
+
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    if (lockfree) {
+        rc = cbmem_lockfree_init(&cbmem_bench_cbmem, cbmem_bench_buf,
+                                 sizeof(cbmem_bench_buf));
+    } else
+#endif
+    {
+        rc = cbmem_init(&cbmem_bench_cbmem, cbmem_bench_buf,
+                        sizeof(cbmem_bench_buf));
+    }
+    assert(rc == 0);
+
+    for (i = 0; i < CBMEM_BENCH_TASKS; i++) {
+        rc = os_task_init(&cbmem_bench_producers[i].task, "cbmem_bench",
+                          cbmem_bench_task_handler,
+                          &cbmem_bench_producers[i], CBMEM_BENCH_PRIO + i,
+                          OS_WAIT_FOREVER, cbmem_bench_stacks[i],
+                          CBMEM_BENCH_STACK_SIZE);
+        assert(rc == 0);
+    }
+
+    for (i = 0; i < CBMEM_BENCH_TASKS; i++) {
+        rc = os_sem_pend(&cbmem_bench_done, OS_TIMEOUT_NEVER);
+        assert(rc == 0);
+    }
+
+    busy = 0;
+    worst = 0;
+    failed = 0;
+    for (i = 0; i < CBMEM_BENCH_TASKS; i++) {
+        prod = &cbmem_bench_producers[i];
+        rc = os_task_remove(&prod->task);
+        assert(rc == 0);
+
+        busy += prod->busy;
+        failed += prod->failed;
+        if (prod->worst > worst) {
+            worst = prod->worst;
+        }
+    }
+
+    snprintf(name, sizeof(name), "cbmem %s %d tasks",
+             lockfree ? "lockfree" : "mutex", CBMEM_BENCH_TASKS);
+    os_bench_report(name, CBMEM_BENCH_TASKS * CBMEM_BENCH_APPENDS, busy,
+                    worst);
+
+    errors = 0;
+    cbmem_walk(&cbmem_bench_cbmem, cbmem_bench_walk, &errors);
+
+    seen = 0;
+    for (i = 0; i < CBMEM_BENCH_TASKS; i++) {
+        seen += cbmem_bench_producers[i].seen;
+    }
+    console_printf("cbmem: %lu entries kept, %lu appends failed, "
+                   "%d bad entries\n",
+                   (unsigned long)seen, (unsigned long)failed, errors);
+}
+
+void
+os_bench_cbmem(void)
+{
+    cbmem_bench_run(false);
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    cbmem_bench_run(true);
+#endif
+}
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "flash_map/flash_map.h"
+#include "os_bench.h"
+
+#if MYNEWT_VAL(OS_BENCH_CONFIG)
+
+#include "config/config.h"
+#include "config/config_fcb.h"
+
+#define CONFIG_BENCH_KEYS       MYNEWT_VAL(OS_BENCH_CONFIG_KEYS)
+#define CONFIG_BENCH_AREAS      8
+
+static struct flash_area config_bench_areas[CONFIG_BENCH_AREAS];
+
+static struct conf_fcb config_bench_fcb = {
+    .cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC),
+    .cf_fcb.f_sectors = config_bench_areas,
+};
+
+static void
+config_bench_init(void)
+{
+    int cnt;
+    int rc;
+    int i;
+
+    cnt = CONFIG_BENCH_AREAS;
+    rc = flash_area_to_sectors(MYNEWT_VAL(OS_BENCH_CONFIG_FLASH_AREA), &cnt,
+                               NULL);
+    assert(rc == 0 && cnt <= CONFIG_BENCH_AREAS);
+    flash_area_to_sectors(MYNEWT_VAL(OS_BENCH_CONFIG_FLASH_AREA), &cnt,
+                          config_bench_areas);
+    for (i = 0; i < cnt; i++) {
+        rc = flash_area_erase(&config_bench_areas[i], 0,
+                              config_bench_areas[i].fa_size);
+        assert(rc == 0);
+    }
+    config_bench_fcb.cf_fcb.f_sector_cnt = cnt;
+
+    rc = conf_fcb_src(&config_bench_fcb);
+    assert(rc == 0);
+    rc = conf_fcb_dst(&config_bench_fcb);
+    assert(rc == 0);
+}
+
+/*
+ * Dropping the index before each call makes the next one walk the FCB, as
+ * it would without CONFIG_FCB_INDEX.
+ */
+static void
+config_bench_drop_index(int walk)
+{
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    if (walk) {
+        config_bench_fcb.cf_index.ci_valid = 0;
+    }
+#endif
+}
+
+static void
+config_bench_save(const char *name, int round, int walk)
+{
+    char key[16];
+    char val[16];
+    uint32_t elapsed;
+    uint32_t worst;
+    uint32_t t;
+    int rc;
+    int i;
+
+    elapsed = 0;
+    worst = 0;
+    for (i = 0; i < CONFIG_BENCH_KEYS; i++) {
+        snprintf(key, sizeof(key), "bench/%d", i);
+        snprintf(val, sizeof(val), "%d", i + round);
+        config_bench_drop_index(walk);
+
+        t = os_cputime_get32();
+        rc = conf_save_one(key, val);
+        t = os_cputime_get32() - t;
+
+        assert(rc == 0);
+        elapsed += t;
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    os_bench_report(name, CONFIG_BENCH_KEYS, elapsed, worst);
+}
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+/*
+ * Same as config_bench_save(), with the settings committed in one
+ * transaction. The commit, which does the flash writes, is timed with
+ * the last save.
+ */
+static void
+config_bench_save_txn(const char *name, int round)
+{
+    char key[16];
+    char val[16];
+    uint32_t elapsed;
+    uint32_t worst;
+    uint32_t t;
+    int rc;
+    int i;
+
+    elapsed = 0;
+    worst = 0;
+    t = os_cputime_get32();
+    rc = conf_txn_begin();
+    assert(rc == 0);
+    for (i = 0; i < CONFIG_BENCH_KEYS; i++) {
+        snprintf(key, sizeof(key), "bench/%d", i);
+        snprintf(val, sizeof(val), "%d", i + round);
+
+        rc = conf_save_one(key, val);
+        assert(rc == 0);
+        if (i == CONFIG_BENCH_KEYS - 1) {
+            rc = conf_txn_commit();
+            assert(rc == 0);
+        }
+        t = os_cputime_get32() - t;
+
+        elapsed += t;
+        if (t > worst) {
+            worst = t;
+        }
+        t = os_cputime_get32();
+    }
+
+    os_bench_report(name, CONFIG_BENCH_KEYS, elapsed, worst);
+}
+#endif
+
+static void
+config_bench_get(const char *name, int round, int walk)
+{
+    char key[16];
+    char val[16];
+    uint32_t elapsed;
+    uint32_t worst;
+    uint32_t t;
+    int rc;
+    int i;
+
+    elapsed = 0;
+    worst = 0;
+    for (i = 0; i < CONFIG_BENCH_KEYS; i++) {
+        snprintf(key, sizeof(key), "bench/%d", i);
+        config_bench_drop_index(walk);
+
+        t = os_cputime_get32();
+        rc = conf_get_stored_value(key, val, sizeof(val));
+        t = os_cputime_get32() - t;
+
+        assert(rc == 0 && atoi(val) == i + round);
+        elapsed += t;
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    os_bench_report(name, CONFIG_BENCH_KEYS, elapsed, worst);
+}
+
+void
+os_bench_config(void)
+{
+    int round;
+
+    config_bench_init();
+
+    round = 0;
+    config_bench_save("config save new", round, 0);
+    config_bench_save("config save dup", round, 0);
+    round++;
+    config_bench_save("config save changed", round, 0);
+    config_bench_get("config get", round, 0);
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    round++;
+    config_bench_save_txn("config save changed txn", round);
+    config_bench_get("config get txn", round, 0);
+#endif
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    config_bench_save("config save dup walk", round, 1);
+    round++;
+    config_bench_save("config save changed walk", round, 1);
+    config_bench_get("config get walk", round, 1);
+#endif
+}
+
+#endif
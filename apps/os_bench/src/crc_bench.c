@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "os_bench.h"
+
+#if MYNEWT_VAL(OS_BENCH_CRC)
+
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+
+#define CRC_BENCH_BUF_SIZE      MYNEWT_VAL(OS_BENCH_CRC_BUF_SIZE)
+#define CRC_BENCH_ROUNDS        MYNEWT_VAL(OS_BENCH_CRC_ROUNDS)
+
+typedef uint32_t crc_bench_fn(uint32_t crc, const void *buf, int len);
+
+static uint8_t crc_bench_buf[CRC_BENCH_BUF_SIZE];
+
+static uint32_t
+crc_bench_crc16(uint32_t crc, const void *buf, int len)
+{
+    return crc16_ccitt(crc, buf, len);
+}
+
+/**
+ * Bit at a time CRC32, used as the baseline and to check the table driven
+ * implementations.
+ */
+static uint32_t
+crc_bench_crc32_bitwise(uint32_t crc, const void *buf, int len)
+{
+    const uint8_t *ptr;
+    int i;
+
+    ptr = buf;
+    crc = ~crc;
+    while (len-- > 0) {
+        crc ^= *ptr++;
+        for (i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+
+    return ~crc;
+}
+
+static uint32_t
+crc_bench_run(const char *name, crc_bench_fn *fn)
+{
+    uint32_t worst;
+    uint32_t start;
+    uint32_t crc;
+    uint32_t t;
+    int i;
+
+    crc = 0;
+    worst = 0;
+    start = os_cputime_get32();
+
+    for (i = 0; i < CRC_BENCH_ROUNDS; i++) {
+        t = os_cputime_get32();
+        crc = fn(0, crc_bench_buf, CRC_BENCH_BUF_SIZE);
+        t = os_cputime_get32() - t;
+
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    os_bench_report(name, CRC_BENCH_ROUNDS, os_cputime_get32() - start,
+                    worst);
+
+    return crc;
+}
+
+void
+os_bench_crc(void)
+{
+    char name[24];
+    uint32_t ref;
+    int i;
+
+    for (i = 0; i < CRC_BENCH_BUF_SIZE; i++) {
+        crc_bench_buf[i] = i * 31 + 7;
+    }
+
+    console_printf("crc: %d byte buffer, CRC_SLICE_BY %d\n",
+                   CRC_BENCH_BUF_SIZE, MYNEWT_VAL(CRC_SLICE_BY));
+
+    ref = crc_bench_run("crc32 bitwise", crc_bench_crc32_bitwise);
+
+    snprintf(name, sizeof(name), "crc32 slice%d", MYNEWT_VAL(CRC_SLICE_BY));
+    if (crc_bench_run(name, crc32) != ref) {
+        console_printf("crc: crc32 mismatch\n");
+    }
+
+    snprintf(name, sizeof(name), "crc32c slice%d", MYNEWT_VAL(CRC_SLICE_BY));
+    crc_bench_run(name, crc32c);
+
+    snprintf(name, sizeof(name), "crc16 slice%d", MYNEWT_VAL(CRC_SLICE_BY));
+    crc_bench_run(name, crc_bench_crc16);
+}
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "os_bench.h"
+
+#if MYNEWT_VAL(OS_BENCH_EVENTQ)
+
+#define EVENTQ_BENCH_BACKLOG    MYNEWT_VAL(OS_BENCH_EVENTQ_BACKLOG)
+#define EVENTQ_BENCH_ROUNDS     MYNEWT_VAL(OS_BENCH_EVENTQ_ROUNDS)
+
+static struct os_eventq eventq_bench_evq;
+static struct os_event eventq_bench_evs[EVENTQ_BENCH_BACKLOG];
+static struct os_event eventq_bench_urgent_ev;
+static uint32_t eventq_bench_urgent_time;
+
+static void
+eventq_bench_cb(struct os_event *ev)
+{
+}
+
+static void
+eventq_bench_urgent_cb(struct os_event *ev)
+{
+    eventq_bench_urgent_time = os_cputime_get32();
+}
+
+static void
+eventq_bench_fill(void)
+{
+    int i;
+
+    for (i = 0; i < EVENTQ_BENCH_BACKLOG; i++) {
+        os_eventq_put(&eventq_bench_evq, &eventq_bench_evs[i]);
+    }
+}
+
+/**
+ * Queues a backlog of events and drains it, either one event at a time or
+ * in batches of 'batch' events.
+ */
+static void
+eventq_bench_drain(const char *name, int batch)
+{
+    uint32_t worst;
+    uint32_t start;
+    uint32_t op;
+    int left;
+    int i;
+
+    worst = 0;
+    start = os_cputime_get32();
+
+    for (i = 0; i < EVENTQ_BENCH_ROUNDS; i++) {
+        eventq_bench_fill();
+
+        op = os_cputime_get32();
+        left = EVENTQ_BENCH_BACKLOG;
+        while (left > 0) {
+            if (batch == 0) {
+                os_eventq_run(&eventq_bench_evq);
+                left--;
+            } else {
+                left -= os_eventq_run_batch(&eventq_bench_evq, batch);
+            }
+        }
+        op = os_cputime_get32() - op;
+        if (op > worst) {
+            worst = op;
+        }
+    }
+
+    os_bench_report(name, EVENTQ_BENCH_ROUNDS * EVENTQ_BENCH_BACKLOG,
+                    os_cputime_get32() - start, worst);
+}
+
+#if MYNEWT_VAL(OS_EVENTQ_URGENT)
+/**
+ * Measures how long an event waits behind a full backlog, when queued as a
+ * regular event and when queued as an urgent one.
+ */
+static void
+eventq_bench_latency(const char *name, int urgent)
+{
+    uint32_t worst;
+    uint32_t start;
+    uint32_t put;
+    uint32_t op;
+    int i;
+
+    worst = 0;
+    start = os_cputime_get32();
+
+    for (i = 0; i < EVENTQ_BENCH_ROUNDS; i++) {
+        eventq_bench_fill();
+
+        put = os_cputime_get32();
+        if (urgent) {
+            os_eventq_put_urgent(&eventq_bench_evq, &eventq_bench_urgent_ev);
+        } else {
+            os_eventq_put(&eventq_bench_evq, &eventq_bench_urgent_ev);
+        }
+
+        do {
+            os_eventq_run_batch(&eventq_bench_evq,
+                                MYNEWT_VAL(OS_BENCH_EVENTQ_BATCH));
+        } while (!STAILQ_EMPTY(&eventq_bench_evq.evq_list));
+
+        op = eventq_bench_urgent_time - put;
+        if (op > worst) {
+            worst = op;
+        }
+    }
+
+    os_bench_report(name, EVENTQ_BENCH_ROUNDS, os_cputime_get32() - start,
+                    worst);
+}
+#endif
+
+void
+os_bench_eventq(void)
+{
+    int i;
+
+    os_eventq_init(&eventq_bench_evq);
+    for (i = 0; i < EVENTQ_BENCH_BACKLOG; i++) {
+        eventq_bench_evs[i].ev_cb = eventq_bench_cb;
+    }
+    eventq_bench_urgent_ev.ev_cb = eventq_bench_urgent_cb;
+
+    eventq_bench_drain("eventq run", 0);
+    eventq_bench_drain("eventq run_batch", MYNEWT_VAL(OS_BENCH_EVENTQ_BATCH));
+
+#if MYNEWT_VAL(OS_EVENTQ_URGENT)
+    eventq_bench_latency("eventq regular latency", 0);
+    eventq_bench_latency("eventq urgent latency", 1);
+#endif
+}
+
+#endif
@@ -0,0 +1,231 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "flash_map/flash_map.h"
+#include "log/log.h"
+#if MYNEWT_VAL(LOG_ASYNC)
+#include "log/log_async.h"
+#endif
+#include "os_bench.h"
+
+#if MYNEWT_VAL(OS_BENCH_LOG)
+
+#define LOG_BENCH_AREAS         8
+#define LOG_BENCH_BODY_LEN      32
+
+static struct flash_area log_bench_areas[LOG_BENCH_AREAS];
+static struct fcb_log log_bench_fcb_log;
+static struct log log_bench_log;
+
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+static struct log_fcb_sidx_sector log_bench_sidx[LOG_BENCH_AREAS];
+#endif
+
+#if MYNEWT_VAL(LOG_ASYNC)
+static struct log_async log_bench_async;
+static struct log log_bench_async_log;
+static uint8_t log_bench_async_buf[1024];
+#endif
+
+static uint32_t log_bench_seed;
+
+static uint32_t
+log_bench_rand(void)
+{
+    log_bench_seed = log_bench_seed * 1103515245 + 12345;
+    return log_bench_seed >> 8;
+}
+
+static void
+log_bench_init(void)
+{
+    int cnt;
+    int rc;
+    int i;
+
+    cnt = LOG_BENCH_AREAS;
+    rc = flash_area_to_sectors(MYNEWT_VAL(OS_BENCH_LOG_FLASH_AREA), &cnt,
+                               NULL);
+    assert(rc == 0 && cnt <= LOG_BENCH_AREAS);
+    flash_area_to_sectors(MYNEWT_VAL(OS_BENCH_LOG_FLASH_AREA), &cnt,
+                          log_bench_areas);
+    for (i = 0; i < cnt; i++) {
+        rc = flash_area_erase(&log_bench_areas[i], 0,
+                              log_bench_areas[i].fa_size);
+        assert(rc == 0);
+    }
+
+    log_bench_fcb_log.fl_fcb.f_magic = 0x7EADBADF;
+    log_bench_fcb_log.fl_fcb.f_sectors = log_bench_areas;
+    log_bench_fcb_log.fl_fcb.f_sector_cnt = cnt;
+    rc = fcb_init(&log_bench_fcb_log.fl_fcb);
+    assert(rc == 0);
+
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    log_fcb_init_sidx(&log_bench_fcb_log, log_bench_sidx, LOG_BENCH_AREAS);
+#endif
+
+    rc = log_register("bench", &log_bench_log, &log_fcb_handler,
+                      &log_bench_fcb_log, LOG_SYSLEVEL);
+    assert(rc == 0);
+
+#if MYNEWT_VAL(LOG_ASYNC)
+    /* Same FCB, written by the async log writer task. */
+    rc = log_async_init(&log_bench_async, &log_fcb_handler,
+                        &log_bench_fcb_log, log_bench_async_buf,
+                        sizeof(log_bench_async_buf), "bench_async");
+    assert(rc == 0);
+    log_async_set_policy(&log_bench_async, LOG_ASYNC_POLICY_BLOCK);
+
+    rc = log_register("bench_async", &log_bench_async_log, &log_async_handler,
+                      &log_bench_async, LOG_SYSLEVEL);
+    assert(rc == 0);
+#endif
+}
+
+static void
+log_bench_append(const char *name, struct log *log)
+{
+    uint8_t body[LOG_BENCH_BODY_LEN];
+    uint32_t elapsed;
+    uint32_t worst;
+    uint32_t t;
+    int rc;
+    int i;
+
+    memset(body, 0xa5, sizeof(body));
+    elapsed = 0;
+    worst = 0;
+    for (i = 0; i < MYNEWT_VAL(OS_BENCH_LOG_ENTRIES); i++) {
+        t = os_cputime_get32();
+        rc = log_append_body(log, 0, LOG_LEVEL_INFO,
+                             LOG_ETYPE_BINARY, body, sizeof(body));
+        t = os_cputime_get32() - t;
+
+        assert(rc == 0);
+        elapsed += t;
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    os_bench_report(name, MYNEWT_VAL(OS_BENCH_LOG_ENTRIES), elapsed, worst);
+}
+
+static int
+log_bench_stop_walk(struct log *log, struct log_offset *log_offset,
+                    const struct log_entry_hdr *hdr, const void *dptr,
+                    uint16_t len)
+{
+    *(uint32_t *)log_offset->lo_arg = hdr->ue_index;
+    return 1;
+}
+
+/*
+ * Returns the index of the first entry at or after index, or of the last
+ * entry if ts is -1.
+ */
+static uint32_t
+log_bench_find(uint32_t index, int64_t ts)
+{
+    struct log_offset log_offset;
+    uint32_t found;
+    int rc;
+
+    found = UINT32_MAX;
+    log_offset = (struct log_offset) {
+        .lo_arg = &found,
+        .lo_index = index,
+        .lo_ts = ts,
+    };
+    rc = log_walk_body(&log_bench_log, log_bench_stop_walk, &log_offset);
+    assert(rc == 0);
+    return found;
+}
+
+/*
+ * Seeks to pseudo-random entries, as a log reader asking for entries from
+ * an index onwards does.
+ */
+static void
+log_bench_seek(const char *name, uint32_t first, uint32_t last)
+{
+    uint32_t elapsed;
+    uint32_t worst;
+    uint32_t index;
+    uint32_t found;
+    uint32_t t;
+    int i;
+
+    log_bench_seed = 1;
+    elapsed = 0;
+    worst = 0;
+    for (i = 0; i < MYNEWT_VAL(OS_BENCH_LOG_SEEKS); i++) {
+        index = first + log_bench_rand() % (last - first + 1);
+
+        t = os_cputime_get32();
+        found = log_bench_find(index, 0);
+        t = os_cputime_get32() - t;
+
+        assert(found >= index && found <= last);
+        elapsed += t;
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    os_bench_report(name, MYNEWT_VAL(OS_BENCH_LOG_SEEKS), elapsed, worst);
+}
+
+void
+os_bench_log(void)
+{
+    uint32_t first;
+    uint32_t last;
+
+    log_bench_init();
+
+    log_bench_append("log append", &log_bench_log);
+
+    first = log_bench_find(0, 0);
+    last = log_bench_find(0, -1);
+    assert(last != UINT32_MAX);
+
+    log_bench_seek("log seek", first, last);
+
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    /* Without the index, seeks walk the FCB. */
+    log_fcb_init_sidx(&log_bench_fcb_log, NULL, 0);
+    log_bench_seek("log seek walk", first, last);
+#endif
+
+#if MYNEWT_VAL(LOG_ASYNC)
+    /*
+     * Callers only copy entries into RAM; they block when the queue is full
+     * until the lower priority writer task has programmed a batch.
+     */
+    log_bench_append("log append async", &log_bench_async_log);
+    log_async_drain(&log_bench_async_log);
+#endif
+}
+
+#endif
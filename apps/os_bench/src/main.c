@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "os_bench.h"
+
+void
+os_bench_report(const char *name, uint32_t ops, uint32_t elapsed,
+                uint32_t worst)
+{
+    uint32_t elapsed_usecs;
+    uint64_t ops_per_sec;
+
+    elapsed_usecs = os_cputime_ticks_to_usecs(elapsed);
+    if (elapsed_usecs == 0) {
+        elapsed_usecs = 1;
+    }
+    ops_per_sec = (uint64_t)ops * 1000000 / elapsed_usecs;
+
+    console_printf("%-24s %10lu ops %10lu us %10lu ops/s worst %lu us\n",
+                   name, (unsigned long)ops, (unsigned long)elapsed_usecs,
+                   (unsigned long)ops_per_sec,
+                   (unsigned long)os_cputime_ticks_to_usecs(worst));
+}
+
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+#if MYNEWT_VAL(OS_BENCH_MEMPOOL)
+    os_bench_mempool();
+#endif
+#if MYNEWT_VAL(OS_BENCH_CALLOUT)
+    os_bench_callout();
+#endif
+#if MYNEWT_VAL(OS_BENCH_SCHED)
+    os_bench_sched();
+#endif
+#if MYNEWT_VAL(OS_BENCH_EVENTQ)
+    os_bench_eventq();
+#endif
+#if MYNEWT_VAL(OS_BENCH_MALLOC)
+    os_bench_malloc();
+#endif
+#if MYNEWT_VAL(OS_BENCH_CRC)
+    os_bench_crc();
+#endif
+#if MYNEWT_VAL(OS_BENCH_CBMEM)
+    os_bench_cbmem();
+#endif
+#if MYNEWT_VAL(OS_BENCH_CONFIG)
+    os_bench_config();
+#endif
+#if MYNEWT_VAL(OS_BENCH_LOG)
+    os_bench_log();
+#endif
+#if MYNEWT_VAL(OS_BENCH_OIC)
+    os_bench_oic();
+#endif
+
+    console_printf("os_bench done\n");
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "os_bench.h"
+
+#if MYNEWT_VAL(OS_BENCH_MALLOC)
+
+#define MALLOC_BENCH_SLOTS      64
+#define MALLOC_BENCH_OPS        MYNEWT_VAL(OS_BENCH_MALLOC_OPS)
+
+/* One step of an allocation trace: allocate 'size' bytes into 'slot', or free
+ * the slot if size is 0.
+ */
+struct malloc_bench_op {
+    uint8_t slot;
+    uint16_t size;
+};
+
+static struct malloc_bench_op malloc_bench_trace[MALLOC_BENCH_OPS];
+static void *malloc_bench_ptrs[MALLOC_BENCH_SLOTS];
+
+/**
+ * Generates a trace resembling a long running networked device: mostly
+ * small, short lived buffers with the occasional large one.  The sequence is
+ * deterministic, so runs with different allocator settings replay the same
+ * trace.
+ */
+static void
+malloc_bench_gen_trace(void)
+{
+    uint32_t seed;
+    uint32_t r;
+    bool live[MALLOC_BENCH_SLOTS];
+    int slot;
+    int i;
+
+    memset(live, 0, sizeof(live));
+    seed = 1;
+
+    for (i = 0; i < MALLOC_BENCH_OPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        r = seed >> 8;
+
+        slot = r % MALLOC_BENCH_SLOTS;
+        malloc_bench_trace[i].slot = slot;
+        if (live[slot]) {
+            malloc_bench_trace[i].size = 0;
+        } else if (r % 10 < 7) {
+            malloc_bench_trace[i].size = 8 + (r >> 8) % 57;
+        } else if (r % 10 < 9) {
+            malloc_bench_trace[i].size = 65 + (r >> 8) % 64;
+        } else {
+            malloc_bench_trace[i].size = 129 + (r >> 8) % 896;
+        }
+        live[slot] = !live[slot];
+    }
+}
+
+void
+os_bench_malloc(void)
+{
+    const struct malloc_bench_op *op;
+    uint32_t worst;
+    uint32_t start;
+    uint32_t t;
+    int fails;
+    int i;
+
+    malloc_bench_gen_trace();
+
+    fails = 0;
+    worst = 0;
+    start = os_cputime_get32();
+
+    for (i = 0; i < MALLOC_BENCH_OPS; i++) {
+        op = &malloc_bench_trace[i];
+
+        t = os_cputime_get32();
+        if (op->size == 0) {
+            os_free(malloc_bench_ptrs[op->slot]);
+            malloc_bench_ptrs[op->slot] = NULL;
+        } else {
+            malloc_bench_ptrs[op->slot] = os_malloc(op->size);
+        }
+        t = os_cputime_get32() - t;
+
+        if (op->size != 0 && malloc_bench_ptrs[op->slot] == NULL) {
+            fails++;
+        }
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    os_bench_report(MYNEWT_VAL(OS_MALLOC_SLAB) ? "malloc slab" :
+                                                 "malloc arena",
+                    MALLOC_BENCH_OPS, os_cputime_get32() - start, worst);
+    if (fails != 0) {
+        console_printf("malloc: %d allocations failed\n", fails);
+    }
+
+    for (i = 0; i < MALLOC_BENCH_SLOTS; i++) {
+        os_free(malloc_bench_ptrs[i]);
+        malloc_bench_ptrs[i] = NULL;
+    }
+}
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "os_bench.h"
+
+#if MYNEWT_VAL(OS_BENCH_MEMPOOL)
+
+#define MEMPOOL_BENCH_BLOCKS        MYNEWT_VAL(OS_BENCH_MEMPOOL_BLOCKS)
+#define MEMPOOL_BENCH_BLOCK_SIZE    32
+#define MEMPOOL_BENCH_BURST         8
+#define MEMPOOL_BENCH_MAG_CAP       8
+
+static os_membuf_t mempool_bench_buf[
+    OS_MEMPOOL_SIZE(MEMPOOL_BENCH_BLOCKS, MEMPOOL_BENCH_BLOCK_SIZE)];
+static struct os_mempool mempool_bench_pool;
+
+static void *mempool_bench_mag_blocks[MEMPOOL_BENCH_MAG_CAP];
+static struct os_mempool_mag mempool_bench_mag;
+
+typedef void *mempool_bench_get_fn(void);
+typedef void mempool_bench_put_fn(void *block);
+
+static void *
+mempool_bench_pool_get(void)
+{
+    return os_memblock_get(&mempool_bench_pool);
+}
+
+static void
+mempool_bench_pool_put(void *block)
+{
+    os_memblock_put(&mempool_bench_pool, block);
+}
+
+static void *
+mempool_bench_mag_get(void)
+{
+    return os_memblock_mag_get(&mempool_bench_mag);
+}
+
+static void
+mempool_bench_mag_put(void *block)
+{
+    os_memblock_mag_put(&mempool_bench_mag, block);
+}
+
+/**
+ * Allocates and frees blocks in bursts, measuring the overall throughput and
+ * the longest single operation.  For a locking pool the longest operation is
+ * an upper bound on the time spent with interrupts disabled.
+ */
+static void
+mempool_bench_run(const char *name, mempool_bench_get_fn *get_cb,
+                  mempool_bench_put_fn *put_cb)
+{
+    void *blocks[MEMPOOL_BENCH_BURST];
+    uint32_t worst;
+    uint32_t start;
+    uint32_t op;
+    uint32_t i;
+    int j;
+
+    worst = 0;
+    start = os_cputime_get32();
+
+    for (i = 0; i < MYNEWT_VAL(OS_BENCH_MEMPOOL_ITERATIONS); i++) {
+        for (j = 0; j < MEMPOOL_BENCH_BURST; j++) {
+            op = os_cputime_get32();
+            blocks[j] = get_cb();
+            op = os_cputime_get32() - op;
+            assert(blocks[j] != NULL);
+            if (op > worst) {
+                worst = op;
+            }
+        }
+
+        for (j = MEMPOOL_BENCH_BURST - 1; j >= 0; j--) {
+            op = os_cputime_get32();
+            put_cb(blocks[j]);
+            op = os_cputime_get32() - op;
+            if (op > worst) {
+                worst = op;
+            }
+        }
+    }
+
+    os_bench_report(name,
+                    MYNEWT_VAL(OS_BENCH_MEMPOOL_ITERATIONS) *
+                    MEMPOOL_BENCH_BURST * 2,
+                    os_cputime_get32() - start, worst);
+}
+
+void
+os_bench_mempool(void)
+{
+    int rc;
+
+    rc = os_mempool_init(&mempool_bench_pool, MEMPOOL_BENCH_BLOCKS,
+                         MEMPOOL_BENCH_BLOCK_SIZE, mempool_bench_buf,
+                         "bench_locked");
+    assert(rc == 0);
+    mempool_bench_run("mempool locked", mempool_bench_pool_get,
+                      mempool_bench_pool_put);
+
+    rc = os_mempool_mag_init(&mempool_bench_mag, &mempool_bench_pool,
+                             mempool_bench_mag_blocks, MEMPOOL_BENCH_MAG_CAP);
+    assert(rc == 0);
+    mempool_bench_run("mempool locked+mag", mempool_bench_mag_get,
+                      mempool_bench_mag_put);
+    os_mempool_mag_flush(&mempool_bench_mag);
+    os_mempool_unregister(&mempool_bench_pool);
+
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    rc = os_mempool_lockfree_init(&mempool_bench_pool, MEMPOOL_BENCH_BLOCKS,
+                                  MEMPOOL_BENCH_BLOCK_SIZE, mempool_bench_buf,
+                                  "bench_lockfree");
+    assert(rc == 0);
+    mempool_bench_run("mempool lockfree", mempool_bench_pool_get,
+                      mempool_bench_pool_put);
+
+    rc = os_mempool_mag_init(&mempool_bench_mag, &mempool_bench_pool,
+                             mempool_bench_mag_blocks, MEMPOOL_BENCH_MAG_CAP);
+    assert(rc == 0);
+    mempool_bench_run("mempool lockfree+mag", mempool_bench_mag_get,
+                      mempool_bench_mag_put);
+    os_mempool_mag_flush(&mempool_bench_mag);
+    os_mempool_unregister(&mempool_bench_pool);
+#endif
+}
+
+#endif
@@ -0,0 +1,429 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "os_bench.h"
+
+#if MYNEWT_VAL(OS_BENCH_OIC)
+
+#include "oic/oc_api.h"
+#include "oic/port/mynewt/transport.h"
+#include "oic/port/oc_connectivity.h"
+#include "oic/messaging/coap/observe.h"
+
+#define OIC_BENCH_RESOURCES     8
+#define OIC_BENCH_URI_RESOURCES \
+    (MYNEWT_VAL(OC_APP_RESOURCES) - OIC_BENCH_RESOURCES)
+#define OIC_BENCH_OBSERVERS     MYNEWT_VAL(OS_BENCH_OIC_OBSERVERS)
+#define OIC_BENCH_HOT           MYNEWT_VAL(OS_BENCH_OIC_HOT_OBSERVERS)
+#define OIC_BENCH_ROUNDS        MYNEWT_VAL(OS_BENCH_OIC_ROUNDS)
+
+/*
+ * Endpoint of a simulated client.  Clients are told apart by id only;
+ * notifications sent to them are counted and dropped.
+ */
+struct oic_bench_ep {
+    struct oc_ep_hdr ep;
+    uint32_t id;
+};
+
+static uint8_t oic_bench_ep_size(const struct oc_endpoint *oe);
+static void oic_bench_tx(struct os_mbuf *m);
+static char *oic_bench_ep_str(char *ptr, int maxlen,
+                              const struct oc_endpoint *oe);
+static int oic_bench_ep_has_conn(const struct oc_endpoint *oe);
+static int oic_bench_transport_init(void);
+static void oic_bench_transport_shutdown(void);
+
+static const struct oc_transport oic_bench_transport = {
+    .ot_flags = 0,
+    .ot_ep_size = oic_bench_ep_size,
+    .ot_ep_has_conn = oic_bench_ep_has_conn,
+    .ot_tx_ucast = oic_bench_tx,
+    .ot_tx_mcast = oic_bench_tx,
+    .ot_get_trans_security = NULL,
+    .ot_ep_str = oic_bench_ep_str,
+    .ot_init = oic_bench_transport_init,
+    .ot_shutdown = oic_bench_transport_shutdown
+};
+
+static uint8_t oic_bench_transport_id;
+static uint32_t oic_bench_sent;
+static uint32_t oic_bench_gets;
+static oc_resource_t *oic_bench_res[OIC_BENCH_RESOURCES];
+static oc_resource_t *oic_bench_uri_res[OIC_BENCH_URI_RESOURCES];
+static uint32_t oic_bench_seed = 1;
+
+static uint8_t
+oic_bench_ep_size(const struct oc_endpoint *oe)
+{
+    return sizeof(struct oic_bench_ep);
+}
+
+static void
+oic_bench_tx(struct os_mbuf *m)
+{
+    oic_bench_sent++;
+    os_mbuf_free_chain(m);
+}
+
+static char *
+oic_bench_ep_str(char *ptr, int maxlen, const struct oc_endpoint *oe)
+{
+    snprintf(ptr, maxlen, "bench %lu",
+             (unsigned long)((const struct oic_bench_ep *)oe)->id);
+    return ptr;
+}
+
+/*
+ * Claiming a connection keeps notifications NON; a CON one would stay
+ * queued for retransmission.
+ */
+static int
+oic_bench_ep_has_conn(const struct oc_endpoint *oe)
+{
+    return 1;
+}
+
+static int
+oic_bench_transport_init(void)
+{
+    return 0;
+}
+
+static void
+oic_bench_transport_shutdown(void)
+{
+}
+
+static uint32_t
+oic_bench_rand(void)
+{
+    oic_bench_seed = oic_bench_seed * 1103515245 + 12345;
+    return oic_bench_seed >> 16;
+}
+
+static void
+oic_bench_ep_init(oc_endpoint_t *oe, uint32_t id)
+{
+    struct oic_bench_ep *ep = (struct oic_bench_ep *)oe;
+
+    memset(oe, 0, sizeof(*oe));
+    ep->ep.oe_type = oic_bench_transport_id;
+    ep->id = id;
+}
+
+static void
+oic_bench_get(oc_request_t *request, oc_interface_mask_t interface)
+{
+    oic_bench_gets++;
+    oc_rep_start_root_object();
+    oc_rep_set_int(root, value, oic_bench_sent);
+    oc_rep_end_root_object();
+    oc_send_response(request, OC_STATUS_OK);
+}
+
+static void
+oic_bench_app_init(void)
+{
+    oc_init_platform("Apache", NULL, NULL);
+}
+
+static oc_handler_t oic_bench_handler = {
+    .init = oic_bench_app_init,
+};
+
+/*
+ * Sends out the notifications queued for transmission.
+ */
+static void
+oic_bench_drain(void)
+{
+    struct os_event *ev;
+
+    while ((ev = os_eventq_get_no_wait(os_eventq_dflt_get())) != NULL) {
+        ev->ev_cb(ev);
+    }
+}
+
+static oc_resource_t *
+oic_bench_new_resource(const char *uri)
+{
+    oc_resource_t *res;
+    bool rc;
+
+    res = oc_new_resource(uri, 1, 0);
+    assert(res);
+    oc_resource_bind_resource_interface(res, OC_IF_R);
+    oc_resource_set_default_interface(res, OC_IF_R);
+    oc_resource_set_observable(res);
+    oc_resource_set_request_handler(res, OC_GET, oic_bench_get);
+    rc = oc_add_resource(res);
+    assert(rc);
+
+    return res;
+}
+
+static void
+oic_bench_init(void)
+{
+    char uri[24];
+    int8_t id;
+    int rc;
+    int i;
+
+    id = oc_transport_register(&oic_bench_transport);
+    assert(id >= 0);
+    oic_bench_transport_id = id;
+
+    rc = oc_main_init(&oic_bench_handler);
+    assert(rc == 0);
+
+    for (i = 0; i < OIC_BENCH_RESOURCES; i++) {
+        snprintf(uri, sizeof(uri), "/bench/%d", i);
+        oic_bench_res[i] = oic_bench_new_resource(uri);
+    }
+    for (i = 0; i < OIC_BENCH_URI_RESOURCES; i++) {
+        snprintf(uri, sizeof(uri), "/bench/uri/%d", i);
+        oic_bench_uri_res[i] = oic_bench_new_resource(uri);
+    }
+}
+
+/*
+ * Registers or deregisters (observe 0 or 1) client `id` as an observer of
+ * `res`, with the request the CoAP engine would pass in.
+ */
+static int
+oic_bench_observe(oc_resource_t *res, uint32_t id, int observe)
+{
+    struct coap_packet_rx req;
+    coap_packet_t rsp;
+    oc_endpoint_t ep;
+    const char *uri;
+    int rc;
+
+    memset(&req, 0, sizeof(req));
+    memset(&rsp, 0, sizeof(rsp));
+    oic_bench_ep_init(&ep, id);
+
+    req.code = COAP_GET;
+    req.observe = observe;
+    req.token_len = sizeof(id);
+    memcpy(req.token, &id, sizeof(id));
+    SET_OPTION(&req, COAP_OPTION_OBSERVE);
+    rsp.code = CONTENT_2_05;
+
+    uri = oc_string(res->uri) + 1;
+    req.m = os_msys_get_pkthdr(0, 0);
+    assert(req.m);
+    rc = os_mbuf_append(req.m, uri, strlen(uri));
+    assert(rc == 0);
+    req.uri_path_len = strlen(uri);
+    SET_OPTION(&req, COAP_OPTION_URI_PATH);
+
+    rc = coap_observe_handler(&req, &rsp, res, &ep);
+    os_mbuf_free_chain(req.m);
+    return rc;
+}
+
+/*
+ * Client i observes resource 0 if i < OIC_BENCH_HOT, one of the others
+ * otherwise.
+ */
+static oc_resource_t *
+oic_bench_res_of(uint32_t id)
+{
+    if (id < OIC_BENCH_HOT) {
+        return oic_bench_res[0];
+    }
+    return oic_bench_res[1 + id % (OIC_BENCH_RESOURCES - 1)];
+}
+
+static void
+oic_bench_add(void)
+{
+    uint32_t elapsed;
+    uint32_t worst;
+    uint32_t t;
+    uint32_t i;
+    int rc;
+
+    elapsed = 0;
+    worst = 0;
+    for (i = 0; i < OIC_BENCH_OBSERVERS; i++) {
+        t = os_cputime_get32();
+        rc = oic_bench_observe(oic_bench_res_of(i), i, 0);
+        t = os_cputime_get32() - t;
+
+        assert(rc == 0);
+        elapsed += t;
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    os_bench_report("oic observe add", OIC_BENCH_OBSERVERS, elapsed, worst);
+}
+
+/*
+ * Notifies the few observers of resource 0 while all the others stay
+ * registered.  The representation is encoded once per notification.
+ */
+static void
+oic_bench_notify(void)
+{
+    uint32_t elapsed;
+    uint32_t worst;
+    uint32_t t;
+    int rc;
+    int i;
+
+    elapsed = 0;
+    worst = 0;
+    oic_bench_sent = 0;
+    oic_bench_gets = 0;
+    for (i = 0; i < OIC_BENCH_ROUNDS; i++) {
+        t = os_cputime_get32();
+        rc = oc_notify_observers(oic_bench_res[0]);
+        t = os_cputime_get32() - t;
+
+        assert(rc == OIC_BENCH_HOT);
+        elapsed += t;
+        if (t > worst) {
+            worst = t;
+        }
+        oic_bench_drain();
+    }
+    assert(oic_bench_sent == OIC_BENCH_ROUNDS * OIC_BENCH_HOT);
+    assert(oic_bench_gets == OIC_BENCH_ROUNDS);
+
+    os_bench_report("oic notify", OIC_BENCH_ROUNDS, elapsed, worst);
+}
+
+/*
+ * Looks up observers by the MID of an RST, as the CoAP engine does for
+ * each RST received.  None match.
+ */
+static void
+oic_bench_rst(void)
+{
+    oc_endpoint_t ep;
+    uint32_t elapsed;
+    uint32_t worst;
+    uint32_t t;
+    int rc;
+    int i;
+
+    elapsed = 0;
+    worst = 0;
+    for (i = 0; i < OIC_BENCH_ROUNDS; i++) {
+        oic_bench_ep_init(&ep, oic_bench_rand() % OIC_BENCH_OBSERVERS);
+
+        t = os_cputime_get32();
+        rc = coap_remove_observer_by_mid(&ep, 0xffff);
+        t = os_cputime_get32() - t;
+
+        assert(rc == 0);
+        elapsed += t;
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    os_bench_report("oic rst lookup", OIC_BENCH_ROUNDS, elapsed, worst);
+}
+
+static void
+oic_bench_remove(void)
+{
+    uint32_t elapsed;
+    uint32_t worst;
+    uint32_t t;
+    uint32_t i;
+    int rc;
+
+    elapsed = 0;
+    worst = 0;
+    for (i = 0; i < OIC_BENCH_OBSERVERS; i++) {
+        t = os_cputime_get32();
+        rc = oic_bench_observe(oic_bench_res_of(i), i, 1);
+        t = os_cputime_get32() - t;
+
+        assert(rc == 1);
+        elapsed += t;
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    os_bench_report("oic observe remove", OIC_BENCH_OBSERVERS, elapsed,
+                    worst);
+}
+
+/*
+ * Looks up pseudo-random resources by URI, as done for each request
+ * received.
+ */
+static void
+oic_bench_uri(void)
+{
+    oc_resource_t *res;
+    char uri[24];
+    uint32_t elapsed;
+    uint32_t worst;
+    uint32_t t;
+    int idx;
+    int i;
+
+    elapsed = 0;
+    worst = 0;
+    for (i = 0; i < OIC_BENCH_ROUNDS; i++) {
+        idx = oic_bench_rand() % OIC_BENCH_URI_RESOURCES;
+        snprintf(uri, sizeof(uri), "/bench/uri/%d", idx);
+
+        t = os_cputime_get32();
+        res = oc_ri_get_app_resource_by_uri(uri);
+        t = os_cputime_get32() - t;
+
+        assert(res == oic_bench_uri_res[idx]);
+        elapsed += t;
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    os_bench_report("oic uri lookup", OIC_BENCH_ROUNDS, elapsed, worst);
+}
+
+void
+os_bench_oic(void)
+{
+    oic_bench_init();
+
+    oic_bench_add();
+    oic_bench_notify();
+    oic_bench_rst();
+    oic_bench_remove();
+    oic_bench_uri();
+}
+
+#endif
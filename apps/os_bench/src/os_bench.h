@@ -0,0 +1,55 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_OS_BENCH_
+#define H_OS_BENCH_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Prints the result of a single benchmark run.
+ *
+ * @param name                  Name of the benchmark run.
+ * @param ops                   Number of operations performed.
+ * @param elapsed               Total run time, in cputime ticks.
+ * @param worst                 Longest single operation, in cputime ticks.
+ */
+void os_bench_report(const char *name, uint32_t ops, uint32_t elapsed,
+                     uint32_t worst);
+
+void os_bench_mempool(void);
+void os_bench_callout(void);
+void os_bench_sched(void);
+void os_bench_eventq(void);
+void os_bench_malloc(void);
+void os_bench_crc(void);
+void os_bench_cbmem(void);
+void os_bench_config(void);
+void os_bench_log(void);
+void os_bench_oic(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
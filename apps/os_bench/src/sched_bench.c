@@ -0,0 +1,188 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "os/mynewt.h"
+#include "os_bench.h"
+
+#if MYNEWT_VAL(OS_BENCH_SCHED)
+
+#define SCHED_BENCH_MAX_TASKS   128
+#define SCHED_BENCH_STACK_SIZE  OS_STACK_ALIGN(64)
+#define SCHED_BENCH_PRIO        MYNEWT_VAL(OS_BENCH_SCHED_PRIO)
+#define SCHED_BENCH_SLEEP_TICKS (OS_TICKS_PER_SEC * 60)
+
+#if SCHED_BENCH_PRIO <= MYNEWT_VAL(OS_MAIN_TASK_PRIO) || \
+    SCHED_BENCH_PRIO + SCHED_BENCH_MAX_TASKS > OS_IDLE_PRIO
+#error "OS_BENCH_SCHED_PRIO must leave room for the benchmark tasks " \
+       "between the main and idle tasks"
+#endif
+
+static struct os_task sched_bench_tasks[SCHED_BENCH_MAX_TASKS];
+static os_stack_t sched_bench_stacks[SCHED_BENCH_MAX_TASKS]
+                                    [SCHED_BENCH_STACK_SIZE];
+static int sched_bench_num_tasks;
+
+static void
+sched_bench_task_handler(void *arg)
+{
+    /* The benchmark tasks are removed before they ever get to run. */
+    assert(0);
+}
+
+/**
+ * Creates ready tasks until 'count' of them exist.  The tasks have a lower
+ * priority than the main task, so they stay on the run list without running.
+ */
+static void
+sched_bench_add_tasks(int count)
+{
+    int rc;
+
+    while (sched_bench_num_tasks < count) {
+        rc = os_task_init(&sched_bench_tasks[sched_bench_num_tasks],
+                          "sched_bench", sched_bench_task_handler, NULL,
+                          SCHED_BENCH_PRIO + sched_bench_num_tasks,
+                          OS_WAIT_FOREVER,
+                          sched_bench_stacks[sched_bench_num_tasks],
+                          SCHED_BENCH_STACK_SIZE);
+        assert(rc == 0);
+        sched_bench_num_tasks++;
+    }
+}
+
+/**
+ * Blocks and unblocks each of the ready tasks in turn, then picks the next
+ * task to run.  This is the scheduler work done for every pair of context
+ * switches, minus the architecture specific register save and restore.
+ */
+static void
+sched_bench_run(void)
+{
+    struct os_task *next;
+    struct os_task *t;
+    char name[24];
+    uint32_t worst;
+    uint32_t start;
+    uint32_t op;
+    uint32_t i;
+    os_sr_t sr;
+
+    worst = 0;
+    start = os_cputime_get32();
+
+    for (i = 0; i < MYNEWT_VAL(OS_BENCH_SCHED_ITERATIONS); i++) {
+        t = &sched_bench_tasks[i % sched_bench_num_tasks];
+
+        OS_ENTER_CRITICAL(sr);
+        op = os_cputime_get32();
+        os_sched_sleep(t, OS_TIMEOUT_NEVER);
+        os_sched_wakeup(t);
+        next = os_sched_next_task();
+        op = os_cputime_get32() - op;
+        OS_EXIT_CRITICAL(sr);
+
+        assert(next == os_sched_get_current_task());
+        if (op > worst) {
+            worst = op;
+        }
+    }
+
+    snprintf(name, sizeof(name), "sched %d tasks", sched_bench_num_tasks);
+    os_bench_report(name, MYNEWT_VAL(OS_BENCH_SCHED_ITERATIONS),
+                    os_cputime_get32() - start, worst);
+}
+
+/**
+ * Puts all tasks to sleep with staggered timeouts, then wakes each of them up
+ * and puts it back to sleep in turn, looking up the next wakeup time as the
+ * idle task does.  The timeouts are long enough for no task to actually wake
+ * up during the run.
+ */
+static void
+sched_bench_sleep_run(void)
+{
+    struct os_task *t;
+    char name[24];
+    uint32_t worst;
+    uint32_t start;
+    uint32_t op;
+    uint32_t i;
+    os_sr_t sr;
+    int j;
+
+    OS_ENTER_CRITICAL(sr);
+    for (j = 0; j < sched_bench_num_tasks; j++) {
+        os_sched_sleep(&sched_bench_tasks[j],
+                       SCHED_BENCH_SLEEP_TICKS + (j * 37) % 1000);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    worst = 0;
+    start = os_cputime_get32();
+
+    for (i = 0; i < MYNEWT_VAL(OS_BENCH_SCHED_ITERATIONS); i++) {
+        t = &sched_bench_tasks[i % sched_bench_num_tasks];
+
+        OS_ENTER_CRITICAL(sr);
+        op = os_cputime_get32();
+        os_sched_wakeup(t);
+        os_sched_sleep(t, SCHED_BENCH_SLEEP_TICKS + (i * 37) % 1000);
+        os_sched_wakeup_ticks(os_time_get());
+        op = os_cputime_get32() - op;
+        OS_EXIT_CRITICAL(sr);
+
+        if (op > worst) {
+            worst = op;
+        }
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    for (j = 0; j < sched_bench_num_tasks; j++) {
+        os_sched_wakeup(&sched_bench_tasks[j]);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    snprintf(name, sizeof(name), "sleep %d tasks", sched_bench_num_tasks);
+    os_bench_report(name, MYNEWT_VAL(OS_BENCH_SCHED_ITERATIONS),
+                    os_cputime_get32() - start, worst);
+}
+
+void
+os_bench_sched(void)
+{
+    static const int counts[] = { 8, 32, SCHED_BENCH_MAX_TASKS };
+    unsigned int i;
+    int rc;
+
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        sched_bench_add_tasks(counts[i]);
+        sched_bench_run();
+        sched_bench_sleep_run();
+    }
+
+    for (i = 0; i < SCHED_BENCH_MAX_TASKS; i++) {
+        rc = os_task_remove(&sched_bench_tasks[i]);
+        assert(rc == 0);
+    }
+    sched_bench_num_tasks = 0;
+}
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "disk/disk.h"
+#include "fs/fs.h"
+
+#include "fatfs_test.h"
+
+uint8_t fatfs_test_disk[FATFS_TEST_DISK_SECTORS * FATFS_TEST_SECTOR_SIZE];
+
+/* The number of write commands the disk received. */
+int fatfs_test_write_cnt;
+
+static int
+fatfs_test_disk_read(uint8_t id, uint32_t addr, void *buf, uint32_t len)
+{
+    if (addr + len > sizeof(fatfs_test_disk)) {
+        return -1;
+    }
+    memcpy(buf, fatfs_test_disk + addr, len);
+    return 0;
+}
+
+static int
+fatfs_test_disk_write(uint8_t id, uint32_t addr, const void *buf, uint32_t len)
+{
+    if (addr + len > sizeof(fatfs_test_disk)) {
+        return -1;
+    }
+    memcpy(fatfs_test_disk + addr, buf, len);
+    fatfs_test_write_cnt++;
+    return 0;
+}
+
+static struct disk_ops fatfs_test_disk_ops = {
+    .read = fatfs_test_disk_read,
+    .write = fatfs_test_disk_write,
+};
+
+static void
+fatfs_test_put16(uint8_t *p, uint16_t val)
+{
+    p[0] = val;
+    p[1] = val >> 8;
+}
+
+/*
+ * Writes an empty FAT12 volume: a boot sector, one FAT sector and one root
+ * directory sector, followed by single-sector clusters.
+ */
+static void
+fatfs_test_format(void)
+{
+    uint8_t *bs;
+    uint8_t *fat;
+
+    memset(fatfs_test_disk, 0, sizeof(fatfs_test_disk));
+
+    bs = fatfs_test_sector(0);
+    memcpy(bs, "\xeb\x3c\x90" "MSDOS5.0", 11);
+    fatfs_test_put16(bs + 11, FATFS_TEST_SECTOR_SIZE);  /* Bytes/sector. */
+    bs[13] = 1;                                         /* Sectors/cluster. */
+    fatfs_test_put16(bs + 14, 1);                       /* Reserved sectors. */
+    bs[16] = 1;                                         /* Number of FATs. */
+    fatfs_test_put16(bs + 17, 16);                      /* Root entries. */
+    fatfs_test_put16(bs + 19, FATFS_TEST_VOL_SECTORS);  /* Total sectors. */
+    bs[21] = 0xf8;                                      /* Media type. */
+    fatfs_test_put16(bs + 22, 1);                       /* Sectors/FAT. */
+    bs[38] = 0x29;                                      /* Boot signature. */
+    memcpy(bs + 43, "NO NAME    " "FAT12   ", 19);
+    fatfs_test_put16(bs + 510, 0xaa55);
+
+    fat = fatfs_test_sector(1);
+    memcpy(fat, "\xf8\xff\xff", 3);
+}
+
+void
+fatfs_test_setup(void)
+{
+    static int ready;
+    struct fs_file *file;
+    int rc;
+
+    if (ready) {
+        return;
+    }
+
+    fatfs_test_format();
+    rc = disk_register(FATFS_TEST_DISK, "fatfs", &fatfs_test_disk_ops);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* The glue attaches a disk on its first access. */
+    rc = fs_open(FATFS_TEST_DISK ":/setup",
+                 FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fs_close(file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ready = 1;
+}
+
+uint8_t *
+fatfs_test_sector(uint32_t sector)
+{
+    return fatfs_test_disk + sector * FATFS_TEST_SECTOR_SIZE;
+}
+
+void
+fatfs_test_fill(uint8_t *buf, uint32_t sector, uint8_t gen)
+{
+    int i;
+
+    for (i = 0; i < FATFS_TEST_SECTOR_SIZE; i++) {
+        buf[i] = sector * 7 + gen * 31 + i;
+    }
+}
+
+int
+fatfs_test_matches(const uint8_t *buf, uint32_t sector, uint8_t gen)
+{
+    uint8_t expected[FATFS_TEST_SECTOR_SIZE];
+
+    fatfs_test_fill(expected, sector, gen);
+    return memcmp(buf, expected, FATFS_TEST_SECTOR_SIZE) == 0;
+}
+
+TEST_CASE_DECL(fatfs_test_cache_rw)
+TEST_CASE_DECL(fatfs_test_cache_sync)
+TEST_CASE_DECL(fatfs_test_cache_evict)
+TEST_CASE_DECL(fatfs_test_cache_file)
+
+TEST_SUITE(fatfs_test_all)
+{
+    fatfs_test_cache_rw();
+    fatfs_test_cache_sync();
+    fatfs_test_cache_evict();
+    fatfs_test_cache_file();
+}
+
+int
+main(int argc, char **argv)
+{
+    fatfs_test_all();
+    return tu_any_failed;
+}
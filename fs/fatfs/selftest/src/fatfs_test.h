@@ -0,0 +1,56 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _FATFS_TEST_H
+#define _FATFS_TEST_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+#include "fatfs/ff.h"
+#include "fatfs/diskio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FATFS_TEST_DISK             "ram0"
+#define FATFS_TEST_PDRV             0
+#define FATFS_TEST_SECTOR_SIZE      512
+
+/* The FAT volume takes the first half of the disk; the cache tests access
+ * the second half directly.
+ */
+#define FATFS_TEST_DISK_SECTORS     256
+#define FATFS_TEST_VOL_SECTORS      128
+
+extern uint8_t fatfs_test_disk[];
+extern int fatfs_test_write_cnt;
+
+void fatfs_test_setup(void);
+uint8_t *fatfs_test_sector(uint32_t sector);
+void fatfs_test_fill(uint8_t *buf, uint32_t sector, uint8_t gen);
+int fatfs_test_matches(const uint8_t *buf, uint32_t sector, uint8_t gen);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _FATFS_TEST_H */
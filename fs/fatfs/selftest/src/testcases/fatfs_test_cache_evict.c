@@ -0,0 +1,93 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fatfs_test.h"
+
+/* Three times as many sectors as the cache holds. */
+#define FATFS_TEST_EVICT_FIRST  192
+#define FATFS_TEST_EVICT_CNT    (3 * MYNEWT_VAL(FATFS_CACHE_SECTORS))
+
+static uint8_t
+fatfs_test_evict_gen(int i)
+{
+    /* The first half gets rewritten. */
+    return i < FATFS_TEST_EVICT_CNT / 2 ? 2 : 1;
+}
+
+TEST_CASE_SELF(fatfs_test_cache_evict)
+{
+    uint8_t buf[4 * FATFS_TEST_SECTOR_SIZE];
+    uint32_t sector;
+    DRESULT res;
+    int cnt;
+    int i;
+    int j;
+
+    fatfs_test_setup();
+
+    /* Write out of order, so that evictions flush scattered sectors. */
+    cnt = fatfs_test_write_cnt;
+    for (i = 0; i < FATFS_TEST_EVICT_CNT; i++) {
+        sector = FATFS_TEST_EVICT_FIRST + (i * 5) % FATFS_TEST_EVICT_CNT;
+        fatfs_test_fill(buf, sector, 1);
+        res = disk_write(FATFS_TEST_PDRV, buf, sector, 1);
+        TEST_ASSERT_FATAL(res == RES_OK);
+    }
+    TEST_ASSERT(fatfs_test_write_cnt > cnt);
+
+    /* Rewrite sectors, some of them still cached, while read misses take
+     * lines for their read-ahead.
+     */
+    for (i = 0; i < FATFS_TEST_EVICT_CNT / 2; i++) {
+        sector = FATFS_TEST_EVICT_FIRST + i;
+        fatfs_test_fill(buf, sector, 2);
+        res = disk_write(FATFS_TEST_PDRV, buf, sector, 1);
+        TEST_ASSERT_FATAL(res == RES_OK);
+
+        res = disk_read(FATFS_TEST_PDRV, buf,
+                        FATFS_TEST_EVICT_FIRST + FATFS_TEST_EVICT_CNT + i, 1);
+        TEST_ASSERT_FATAL(res == RES_OK);
+    }
+
+    /* Every sector reads back as last written, one at a time... */
+    for (i = 0; i < FATFS_TEST_EVICT_CNT; i++) {
+        sector = FATFS_TEST_EVICT_FIRST + i;
+        res = disk_read(FATFS_TEST_PDRV, buf, sector, 1);
+        TEST_ASSERT_FATAL(res == RES_OK);
+        TEST_ASSERT(fatfs_test_matches(buf, sector, fatfs_test_evict_gen(i)));
+    }
+
+    /* ...and several at a time. */
+    for (i = 0; i < FATFS_TEST_EVICT_CNT; i += 4) {
+        res = disk_read(FATFS_TEST_PDRV, buf, FATFS_TEST_EVICT_FIRST + i, 4);
+        TEST_ASSERT_FATAL(res == RES_OK);
+        for (j = 0; j < 4; j++) {
+            TEST_ASSERT(fatfs_test_matches(buf + j * FATFS_TEST_SECTOR_SIZE,
+                                           FATFS_TEST_EVICT_FIRST + i + j,
+                                           fatfs_test_evict_gen(i + j)));
+        }
+    }
+
+    res = disk_ioctl(FATFS_TEST_PDRV, CTRL_SYNC, NULL);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    for (i = 0; i < FATFS_TEST_EVICT_CNT; i++) {
+        sector = FATFS_TEST_EVICT_FIRST + i;
+        TEST_ASSERT(fatfs_test_matches(fatfs_test_sector(sector), sector,
+                                       fatfs_test_evict_gen(i)));
+    }
+}
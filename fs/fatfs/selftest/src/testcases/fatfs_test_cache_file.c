@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fs/fs.h"
+#include "fatfs_test.h"
+
+#define FATFS_TEST_FILE         FATFS_TEST_DISK ":/cache.bin"
+#define FATFS_TEST_CHUNK        100
+/* About 20 sectors, not a whole number of them. */
+#define FATFS_TEST_FILE_LEN     (103 * FATFS_TEST_CHUNK)
+
+static uint8_t
+fatfs_test_file_byte(uint32_t off)
+{
+    return off * 13 + off / 251;
+}
+
+TEST_CASE_SELF(fatfs_test_cache_file)
+{
+    struct fs_file *file;
+    uint8_t buf[FATFS_TEST_CHUNK];
+    uint32_t off;
+    uint32_t len;
+    int cnt;
+    int rc;
+    int i;
+
+    fatfs_test_setup();
+
+    rc = fs_open(FATFS_TEST_FILE, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (off = 0; off < FATFS_TEST_FILE_LEN; off += FATFS_TEST_CHUNK) {
+        for (i = 0; i < FATFS_TEST_CHUNK; i++) {
+            buf[i] = fatfs_test_file_byte(off + i);
+        }
+        rc = fs_write(file, buf, FATFS_TEST_CHUNK);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = fs_close(file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Closing the file synced the cache. */
+    cnt = fatfs_test_write_cnt;
+    TEST_ASSERT(disk_ioctl(FATFS_TEST_PDRV, CTRL_SYNC, NULL) == RES_OK);
+    TEST_ASSERT(fatfs_test_write_cnt == cnt);
+
+    rc = fs_open(FATFS_TEST_FILE, FS_ACCESS_READ, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fs_filelen(file, &len);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(len == FATFS_TEST_FILE_LEN);
+    for (off = 0; off < FATFS_TEST_FILE_LEN; off += FATFS_TEST_CHUNK) {
+        rc = fs_read(file, FATFS_TEST_CHUNK, buf, &len);
+        TEST_ASSERT_FATAL(rc == 0 && len == FATFS_TEST_CHUNK);
+        for (i = 0; i < FATFS_TEST_CHUNK; i++) {
+            TEST_ASSERT_FATAL(buf[i] == fatfs_test_file_byte(off + i));
+        }
+    }
+    rc = fs_close(file);
+    TEST_ASSERT_FATAL(rc == 0);
+}
@@ -0,0 +1,87 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fatfs_test.h"
+
+TEST_CASE_SELF(fatfs_test_cache_rw)
+{
+    uint8_t buf[4 * FATFS_TEST_SECTOR_SIZE];
+    uint8_t zero[FATFS_TEST_SECTOR_SIZE];
+    DRESULT res;
+    int i;
+
+    fatfs_test_setup();
+    memset(zero, 0, sizeof(zero));
+
+    /* A single-sector write stays in the cache, but reads see it. */
+    fatfs_test_fill(buf, 161, 1);
+    res = disk_write(FATFS_TEST_PDRV, buf, 161, 1);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    TEST_ASSERT(memcmp(fatfs_test_sector(161), zero, sizeof(zero)) == 0);
+
+    memset(buf, 0, sizeof(buf));
+    res = disk_read(FATFS_TEST_PDRV, buf, 161, 1);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    TEST_ASSERT(fatfs_test_matches(buf, 161, 1));
+
+    /* Multi-sector reads go to the disk, and see it too. */
+    res = disk_read(FATFS_TEST_PDRV, buf, 160, 4);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    for (i = 0; i < 4; i++) {
+        if (i == 1) {
+            TEST_ASSERT(fatfs_test_matches(buf + i * FATFS_TEST_SECTOR_SIZE,
+                                           161, 1));
+        } else {
+            TEST_ASSERT(memcmp(buf + i * FATFS_TEST_SECTOR_SIZE, zero,
+                               sizeof(zero)) == 0);
+        }
+    }
+
+    /* A multi-sector write goes to the disk, and replaces the cached copy. */
+    for (i = 0; i < 2; i++) {
+        fatfs_test_fill(buf + i * FATFS_TEST_SECTOR_SIZE, 160 + i, 2);
+    }
+    res = disk_write(FATFS_TEST_PDRV, buf, 160, 2);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    TEST_ASSERT(fatfs_test_matches(fatfs_test_sector(161), 161, 2));
+
+    res = disk_read(FATFS_TEST_PDRV, buf, 161, 1);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    TEST_ASSERT(fatfs_test_matches(buf, 161, 2));
+
+    res = disk_ioctl(FATFS_TEST_PDRV, CTRL_SYNC, NULL);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    TEST_ASSERT(fatfs_test_matches(fatfs_test_sector(161), 161, 2));
+
+    /* Read-ahead doesn't replace a cached sector with the older disk copy. */
+    fatfs_test_fill(buf, 169, 1);
+    res = disk_write(FATFS_TEST_PDRV, buf, 169, 1);
+    TEST_ASSERT_FATAL(res == RES_OK);
+
+    res = disk_read(FATFS_TEST_PDRV, buf, 168, 1);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    TEST_ASSERT(memcmp(buf, zero, sizeof(zero)) == 0);
+
+    res = disk_read(FATFS_TEST_PDRV, buf, 169, 1);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    TEST_ASSERT(fatfs_test_matches(buf, 169, 1));
+
+    res = disk_ioctl(FATFS_TEST_PDRV, CTRL_SYNC, NULL);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    TEST_ASSERT(fatfs_test_matches(fatfs_test_sector(169), 169, 1));
+}
@@ -0,0 +1,55 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fatfs_test.h"
+
+TEST_CASE_SELF(fatfs_test_cache_sync)
+{
+    uint8_t buf[FATFS_TEST_SECTOR_SIZE];
+    DRESULT res;
+    int cnt;
+    int i;
+
+    fatfs_test_setup();
+
+    cnt = fatfs_test_write_cnt;
+    for (i = 0; i < 4; i++) {
+        fatfs_test_fill(buf, 176 + i, 1);
+        res = disk_write(FATFS_TEST_PDRV, buf, 176 + i, 1);
+        TEST_ASSERT_FATAL(res == RES_OK);
+    }
+    TEST_ASSERT(fatfs_test_write_cnt == cnt);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(!fatfs_test_matches(fatfs_test_sector(176 + i),
+                                        176 + i, 1));
+    }
+
+    /* CTRL_SYNC writes the contiguous sectors with one command. */
+    res = disk_ioctl(FATFS_TEST_PDRV, CTRL_SYNC, NULL);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    TEST_ASSERT(fatfs_test_write_cnt == cnt + 1);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(fatfs_test_matches(fatfs_test_sector(176 + i),
+                                       176 + i, 1));
+    }
+
+    /* Nothing is left to write. */
+    res = disk_ioctl(FATFS_TEST_PDRV, CTRL_SYNC, NULL);
+    TEST_ASSERT_FATAL(res == RES_OK);
+    TEST_ASSERT(fatfs_test_write_cnt == cnt + 1);
+}
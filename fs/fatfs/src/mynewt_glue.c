@@ -169,16 +169,75 @@ int fatfs_to_vfs_error(FRESULT res)
     return rc;
 }
 
+/* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
+#define FATFS_SECTOR_SIZE           512
+
+#define FATFS_CACHE_SECTORS         MYNEWT_VAL(FATFS_CACHE_SECTORS)
+#define FATFS_CACHE_XFER_SECTORS    MYNEWT_VAL(FATFS_CACHE_XFER_SECTORS)
+#define FATFS_CACHE_INVALID         UINT32_MAX
+
+#if FATFS_CACHE_SECTORS > 0
+#if FATFS_CACHE_XFER_SECTORS < 1 || \
+    FATFS_CACHE_XFER_SECTORS > FATFS_CACHE_SECTORS
+#error "FATFS_CACHE_XFER_SECTORS must be in [1, FATFS_CACHE_SECTORS]"
+#endif
+
+struct fatfs_cache_sector {
+    TAILQ_ENTRY(fatfs_cache_sector) fcs_next;
+    /* Cached sector number; FATFS_CACHE_INVALID if unused. */
+    uint32_t fcs_sector;
+    /* Set if the data has not been written to the disk yet. */
+    uint8_t fcs_dirty;
+    uint8_t fcs_data[FATFS_SECTOR_SIZE];
+};
+
+TAILQ_HEAD(fatfs_cache_list, fatfs_cache_sector);
+
+/*
+ * Write-back sector cache of a disk.  Dirty sectors are written at sync time,
+ * or when their line is needed, in runs of contiguous sectors; single-sector
+ * read misses fetch the following sectors too.
+ */
+struct fatfs_cache {
+    /* Cached sectors, most recently used first. */
+    struct fatfs_cache_list fc_lru;
+    struct fatfs_cache_sector fc_sectors[FATFS_CACHE_SECTORS];
+
+    /* Holds multi-sector transfers between the disk and the cache. */
+    uint8_t fc_xfer[FATFS_CACHE_XFER_SECTORS * FATFS_SECTOR_SIZE];
+};
+#endif
+
 struct mounted_disk {
     char *disk_name;
     int disk_number;
     struct disk_ops *dops;
+#if FATFS_CACHE_SECTORS > 0
+    struct fatfs_cache cache;
+#endif
 
     SLIST_ENTRY(mounted_disk) sc_next;
 };
 
 static SLIST_HEAD(, mounted_disk) mounted_disks = SLIST_HEAD_INITIALIZER();
 
+#if FATFS_CACHE_SECTORS > 0
+static void
+fatfs_cache_init(struct fatfs_cache *fc)
+{
+    struct fatfs_cache_sector *fcs;
+    int i;
+
+    TAILQ_INIT(&fc->fc_lru);
+    for (i = 0; i < FATFS_CACHE_SECTORS; i++) {
+        fcs = &fc->fc_sectors[i];
+        fcs->fcs_sector = FATFS_CACHE_INVALID;
+        fcs->fcs_dirty = 0;
+        TAILQ_INSERT_TAIL(&fc->fc_lru, fcs, fcs_next);
+    }
+}
+#endif
+
 static int
 drivenumber_from_disk(char *disk_name)
 {
@@ -208,6 +267,9 @@ drivenumber_from_disk(char *disk_name)
     new_disk->disk_name = strdup(disk_name);
     new_disk->disk_number = disk_number;
     new_disk->dops = disk_ops_for(disk_name);
+#if FATFS_CACHE_SECTORS > 0
+    fatfs_cache_init(&new_disk->cache);
+#endif
     SLIST_INSERT_HEAD(&mounted_disks, new_disk, sc_next);
 
     return disk_number;
@@ -565,37 +627,278 @@ disk_status(BYTE pdrv)
     return RES_OK;
 }
 
-static struct disk_ops *dops_from_handle(BYTE pdrv)
+static struct mounted_disk *
+disk_from_handle(BYTE pdrv)
 {
     struct mounted_disk *sc;
 
     SLIST_FOREACH(sc, &mounted_disks, sc_next) {
         if (sc->disk_number == pdrv) {
-            return sc->dops;
+            return sc;
         }
     }
 
     return NULL;
 }
 
+static int
+disk_xfer_read(struct mounted_disk *md, uint32_t sector, void *buf,
+               uint32_t count)
+{
+    return md->dops->read(md->disk_number, sector * FATFS_SECTOR_SIZE, buf,
+                          count * FATFS_SECTOR_SIZE);
+}
+
+static int
+disk_xfer_write(struct mounted_disk *md, uint32_t sector, const void *buf,
+                uint32_t count)
+{
+    return md->dops->write(md->disk_number, sector * FATFS_SECTOR_SIZE, buf,
+                           count * FATFS_SECTOR_SIZE);
+}
+
+#if FATFS_CACHE_SECTORS > 0
+static struct fatfs_cache_sector *
+fatfs_cache_find(struct fatfs_cache *fc, uint32_t sector)
+{
+    struct fatfs_cache_sector *fcs;
+
+    TAILQ_FOREACH(fcs, &fc->fc_lru, fcs_next) {
+        if (fcs->fcs_sector == sector) {
+            return fcs;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+fatfs_cache_touch(struct fatfs_cache *fc, struct fatfs_cache_sector *fcs)
+{
+    if (fcs != TAILQ_FIRST(&fc->fc_lru)) {
+        TAILQ_REMOVE(&fc->fc_lru, fcs, fcs_next);
+        TAILQ_INSERT_HEAD(&fc->fc_lru, fcs, fcs_next);
+    }
+}
+
+/*
+ * Writes all dirty sectors to the disk, lowest first, merging contiguous
+ * ones into multi-sector writes.
+ */
+static int
+fatfs_cache_flush(struct mounted_disk *md)
+{
+    struct fatfs_cache *fc = &md->cache;
+    struct fatfs_cache_sector *run[FATFS_CACHE_XFER_SECTORS];
+    struct fatfs_cache_sector *fcs;
+    struct fatfs_cache_sector *next;
+    int count;
+    int rc;
+    int i;
+
+    while (1) {
+        next = NULL;
+        TAILQ_FOREACH(fcs, &fc->fc_lru, fcs_next) {
+            if (fcs->fcs_dirty &&
+                (!next || fcs->fcs_sector < next->fcs_sector)) {
+                next = fcs;
+            }
+        }
+        if (!next) {
+            return 0;
+        }
+
+        count = 0;
+        while (next && count < FATFS_CACHE_XFER_SECTORS) {
+            run[count++] = next;
+            next = fatfs_cache_find(fc, next->fcs_sector + 1);
+            if (next && !next->fcs_dirty) {
+                next = NULL;
+            }
+        }
+
+        if (count == 1) {
+            rc = disk_xfer_write(md, run[0]->fcs_sector, run[0]->fcs_data, 1);
+        } else {
+            for (i = 0; i < count; i++) {
+                memcpy(fc->fc_xfer + i * FATFS_SECTOR_SIZE, run[i]->fcs_data,
+                       FATFS_SECTOR_SIZE);
+            }
+            rc = disk_xfer_write(md, run[0]->fcs_sector, fc->fc_xfer, count);
+        }
+        if (rc < 0) {
+            return rc;
+        }
+
+        for (i = 0; i < count; i++) {
+            run[i]->fcs_dirty = 0;
+        }
+    }
+}
+
+/*
+ * Makes sure the least recently used `count` lines are clean, so that they
+ * can be reused.
+ */
+static int
+fatfs_cache_reserve(struct mounted_disk *md, int count)
+{
+    struct fatfs_cache_sector *fcs;
+
+    fcs = TAILQ_LAST(&md->cache.fc_lru, fatfs_cache_list);
+    while (count-- > 0) {
+        if (fcs->fcs_dirty) {
+            return fatfs_cache_flush(md);
+        }
+        fcs = TAILQ_PREV(fcs, fatfs_cache_list, fcs_next);
+    }
+
+    return 0;
+}
+
+/*
+ * Takes the least recently used line for a sector; the line must be clean.
+ */
+static struct fatfs_cache_sector *
+fatfs_cache_insert(struct fatfs_cache *fc, uint32_t sector, const void *data)
+{
+    struct fatfs_cache_sector *fcs;
+
+    fcs = TAILQ_LAST(&fc->fc_lru, fatfs_cache_list);
+    assert(!fcs->fcs_dirty);
+
+    fcs->fcs_sector = sector;
+    memcpy(fcs->fcs_data, data, FATFS_SECTOR_SIZE);
+    fatfs_cache_touch(fc, fcs);
+
+    return fcs;
+}
+
+static int
+fatfs_cache_read(struct mounted_disk *md, uint8_t *buff, uint32_t sector,
+                 uint32_t count)
+{
+    struct fatfs_cache *fc = &md->cache;
+    struct fatfs_cache_sector *fcs;
+    uint32_t ahead;
+    uint32_t i;
+    int rc;
+
+    if (count > 1) {
+        /* Multi-sector reads go straight to the disk; cached copies of the
+         * sectors are newer, though.
+         */
+        rc = disk_xfer_read(md, sector, buff, count);
+        if (rc < 0) {
+            return rc;
+        }
+        TAILQ_FOREACH(fcs, &fc->fc_lru, fcs_next) {
+            if (fcs->fcs_sector != FATFS_CACHE_INVALID &&
+                fcs->fcs_sector >= sector && fcs->fcs_sector - sector < count) {
+                memcpy(buff + (fcs->fcs_sector - sector) * FATFS_SECTOR_SIZE,
+                       fcs->fcs_data, FATFS_SECTOR_SIZE);
+            }
+        }
+        return 0;
+    }
+
+    fcs = fatfs_cache_find(fc, sector);
+    if (fcs) {
+        fatfs_cache_touch(fc, fcs);
+        memcpy(buff, fcs->fcs_data, FATFS_SECTOR_SIZE);
+        return 0;
+    }
+
+    rc = fatfs_cache_reserve(md, FATFS_CACHE_XFER_SECTORS);
+    if (rc < 0) {
+        return rc;
+    }
+
+#if MYNEWT_VAL(FATFS_READ_AHEAD)
+    /* Fetch the following sectors with the same command; this fails near
+     * the end of the disk, so fall back to the single sector then.
+     */
+    ahead = FATFS_CACHE_XFER_SECTORS;
+    rc = disk_xfer_read(md, sector, fc->fc_xfer, ahead);
+    if (rc < 0)
+#endif
+    {
+        ahead = 1;
+        rc = disk_xfer_read(md, sector, fc->fc_xfer, ahead);
+        if (rc < 0) {
+            return rc;
+        }
+    }
+
+    /* Insert the read-ahead sectors first, so the requested one ends up most
+     * recently used.  Sectors already cached may be dirty; keep those.
+     */
+    for (i = ahead; i-- > 0;) {
+        if (i == 0 || !fatfs_cache_find(fc, sector + i)) {
+            fatfs_cache_insert(fc, sector + i,
+                               fc->fc_xfer + i * FATFS_SECTOR_SIZE);
+        }
+    }
+    memcpy(buff, fc->fc_xfer, FATFS_SECTOR_SIZE);
+
+    return 0;
+}
+
+static int
+fatfs_cache_write(struct mounted_disk *md, const uint8_t *buff,
+                  uint32_t sector, uint32_t count)
+{
+    struct fatfs_cache *fc = &md->cache;
+    struct fatfs_cache_sector *fcs;
+    int rc;
+
+    if (count > 1) {
+        /* Multi-sector writes already are as large as the cache would make
+         * them; write them through, and drop the stale cached copies.
+         */
+        TAILQ_FOREACH(fcs, &fc->fc_lru, fcs_next) {
+            if (fcs->fcs_sector != FATFS_CACHE_INVALID &&
+                fcs->fcs_sector >= sector && fcs->fcs_sector - sector < count) {
+                fcs->fcs_sector = FATFS_CACHE_INVALID;
+                fcs->fcs_dirty = 0;
+            }
+        }
+        return disk_xfer_write(md, sector, buff, count);
+    }
+
+    fcs = fatfs_cache_find(fc, sector);
+    if (fcs) {
+        memcpy(fcs->fcs_data, buff, FATFS_SECTOR_SIZE);
+        fatfs_cache_touch(fc, fcs);
+    } else {
+        rc = fatfs_cache_reserve(md, 1);
+        if (rc < 0) {
+            return rc;
+        }
+        fcs = fatfs_cache_insert(fc, sector, buff);
+    }
+    fcs->fcs_dirty = 1;
+
+    return 0;
+}
+#endif
+
 DRESULT
 disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
 {
     int rc;
-    uint32_t address;
-    uint32_t num_bytes;
-    struct disk_ops *dops;
-
-    /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
-    address = (uint32_t) sector * 512;
-    num_bytes = (uint32_t) count * 512;
+    struct mounted_disk *md;
 
-    dops = dops_from_handle(pdrv);
-    if (dops == NULL) {
+    md = disk_from_handle(pdrv);
+    if (md == NULL || md->dops == NULL) {
         return STA_NOINIT;
     }
 
-    rc = dops->read(pdrv, address, (void *) buff, num_bytes);
+#if FATFS_CACHE_SECTORS > 0
+    rc = fatfs_cache_read(md, buff, sector, count);
+#else
+    rc = disk_xfer_read(md, sector, buff, count);
+#endif
     if (rc < 0) {
         return STA_NOINIT;
     }
@@ -607,20 +910,18 @@ DRESULT
 disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
 {
     int rc;
-    uint32_t address;
-    uint32_t num_bytes;
-    struct disk_ops *dops;
-
-    /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
-    address = (uint32_t) sector * 512;
-    num_bytes = (uint32_t) count * 512;
+    struct mounted_disk *md;
 
-    dops = dops_from_handle(pdrv);
-    if (dops == NULL) {
+    md = disk_from_handle(pdrv);
+    if (md == NULL || md->dops == NULL) {
         return STA_NOINIT;
     }
 
-    rc = dops->write(pdrv, address, (const void *) buff, num_bytes);
+#if FATFS_CACHE_SECTORS > 0
+    rc = fatfs_cache_write(md, buff, sector, count);
+#else
+    rc = disk_xfer_write(md, sector, buff, count);
+#endif
     if (rc < 0) {
         return STA_NOINIT;
     }
@@ -631,6 +932,20 @@ disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
 DRESULT
 disk_ioctl(BYTE pdrv, BYTE cmd, void* buff)
 {
+#if FATFS_CACHE_SECTORS > 0
+    struct mounted_disk *md;
+
+    if (cmd == CTRL_SYNC) {
+        /* FatFs syncs on f_sync() and f_close(); that is when cached writes
+         * must reach the disk.
+         */
+        md = disk_from_handle(pdrv);
+        if (md != NULL && md->dops != NULL && fatfs_cache_flush(md) < 0) {
+            return RES_ERROR;
+        }
+    }
+#endif
+
     return RES_OK;
 }
 
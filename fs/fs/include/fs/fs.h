@@ -79,6 +79,7 @@ int fs_flush(struct fs_file *);
 #define FS_EEXIST       11  /* File or directory already exists */
 #define FS_EACCESS      12  /* Operation prohibited by file open mode */
 #define FS_EUNINIT      13  /* File system not initialized */
+#define FS_EBUSY        14  /* File system or file in use */
 
 #define FS_MGMT_ID_FILE     0
 
@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LITTLEFS_
+#define H_LITTLEFS_
+
+#include <inttypes.h>
+#include "fs/fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Mounts the default littlefs instance on LITTLEFS_FLASH_AREA, formatting it
+ * first if LITTLEFS_DETECT_FAIL_FORMAT is set and no file system is found.
+ * Paths without a "<disk>:" prefix refer to this instance.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int littlefs_init(void);
+
+/**
+ * Formats the flash area of the default littlefs instance.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int littlefs_reformat(void);
+
+/**
+ * Mounts an additional littlefs instance.  Its files are accessed as
+ * "<name>:/<path>".  Every instance has its own lock, so operations on
+ * different instances do not wait for each other.
+ *
+ * @param name                  Disk name of the instance; the string must
+ *                                  stay valid even after an unmount.
+ * @param flash_area_id         Flash area holding the file system.
+ * @param block_size            Size of a littlefs block; the block count is
+ *                                  derived from the size of the flash area.
+ *
+ * @return                      0 on success; FS_E[...] error code on failure.
+ */
+int littlefs_mount(const char *name, uint8_t flash_area_id,
+                   uint32_t block_size);
+
+/**
+ * Formats a flash area with an empty littlefs file system.  The area must not
+ * be mounted.
+ *
+ * @param flash_area_id         Flash area to format.
+ * @param block_size            Size of a littlefs block.
+ *
+ * @return                      0 on success; FS_E[...] error code on failure.
+ */
+int littlefs_format(uint8_t flash_area_id, uint32_t block_size);
+
+/**
+ * Unmounts a littlefs instance mounted with littlefs_mount().  All of its
+ * files and directories must be closed first.
+ *
+ * @param name                  Disk name the instance was mounted as.
+ *
+ * @return                      0 on success;
+ *                              FS_EBUSY if a file or directory is still
+ *                                  open;
+ *                              other FS_E[...] error code on failure.
+ */
+int littlefs_unmount(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
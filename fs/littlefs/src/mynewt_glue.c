@@ -28,6 +28,7 @@
 
 #include <littlefs/lfs.h>
 #include <littlefs/lfs_util.h>
+#include <littlefs/littlefs.h>
 
 #include <fs/fs.h>
 #include <fs/fs_if.h>
@@ -56,10 +57,54 @@ static int littlefs_dirent_name(const struct fs_dirent *fs_dirent, size_t max_le
                                 char *out_name, uint8_t *out_name_len);
 static int littlefs_dirent_is_dir(const struct fs_dirent *fs_dirent);
 
+#define LITTLEFS_CACHE_LINES        MYNEWT_VAL(LITTLEFS_BLOCK_CACHE_LINES)
+#define LITTLEFS_CACHE_LINE_SIZE    MYNEWT_VAL(LITTLEFS_BLOCK_CACHE_LINE_SIZE)
+#define LITTLEFS_CACHE_INVALID      UINT32_MAX
+
+#if LITTLEFS_CACHE_LINES > 0
+/*
+ * A line of the block cache; holds LITTLEFS_CACHE_LINE_SIZE bytes read from
+ * the flash area.
+ */
+struct littlefs_cache_line {
+    TAILQ_ENTRY(littlefs_cache_line) lcl_next;
+    /* Flash area offset of the line; LITTLEFS_CACHE_INVALID if unused. */
+    uint32_t lcl_off;
+    uint8_t *lcl_data;
+};
+
+TAILQ_HEAD(littlefs_cache_list, littlefs_cache_line);
+#endif
+
+/*
+ * A mounted littlefs instance.
+ */
+struct littlefs {
+    /* Must be first: lfs callbacks get back to the instance through cfg. */
+    lfs_t lfs;
+    struct lfs_config cfg;
+    const struct flash_area *fa;
+
+    /* Serializes all lfs calls on this instance. */
+    struct os_mutex mtx;
+
+    /* Disk name of the instance; NULL for the default instance. */
+    const char *name;
+
+#if LITTLEFS_CACHE_LINES > 0
+    /* Block cache lines, most recently used first. */
+    struct littlefs_cache_list cache;
+    struct littlefs_cache_line cache_lines[LITTLEFS_CACHE_LINES];
+    uint8_t *cache_data;
+#endif
+
+    SLIST_ENTRY(littlefs) next;
+};
+
 struct littlefs_file {
     struct fs_ops *fops;
     lfs_file_t *file;
-    lfs_t *lfs;
+    struct littlefs *lfs;
 };
 
 struct littlefs_dirent {
@@ -71,7 +116,7 @@ struct littlefs_dir {
     struct fs_ops *fops;
     lfs_dir_t *dir;
     struct littlefs_dirent *cur_dirent;
-    lfs_t *lfs;
+    struct littlefs *lfs;
 };
 
 static struct fs_ops littlefs_ops = {
@@ -142,6 +187,134 @@ littlefs_to_vfs_error(int err)
     return rc;
 }
 
+
+static SLIST_HEAD(, littlefs) littlefs_list = SLIST_HEAD_INITIALIZER();
+static bool littlefs_registered;
+
+/*
+ * Protects littlefs_list.  A zeroed mutex is a valid, unowned one, so this
+ * is usable before sysinit runs.  The mutex is recursive; path based
+ * operations hold it from resolving an instance until they are done with
+ * it, so the instance can't be unmounted and freed under them.
+ */
+static struct os_mutex littlefs_list_mtx;
+
+#if LITTLEFS_CACHE_LINES > 0
+static void
+littlefs_cache_init(struct littlefs *lfs)
+{
+    struct littlefs_cache_line *line;
+    int i;
+
+    TAILQ_INIT(&lfs->cache);
+    for (i = 0; i < LITTLEFS_CACHE_LINES; i++) {
+        line = &lfs->cache_lines[i];
+        line->lcl_off = LITTLEFS_CACHE_INVALID;
+        line->lcl_data = lfs->cache_data + i * LITTLEFS_CACHE_LINE_SIZE;
+        TAILQ_INSERT_TAIL(&lfs->cache, line, lcl_next);
+    }
+}
+
+/*
+ * Returns the cache line holding the given line-aligned offset, reading it
+ * from flash into the least recently used line on a miss.
+ */
+static struct littlefs_cache_line *
+littlefs_cache_get(struct littlefs *lfs, uint32_t line_off)
+{
+    struct littlefs_cache_line *line;
+    int rc;
+
+    TAILQ_FOREACH(line, &lfs->cache, lcl_next) {
+        if (line->lcl_off == line_off) {
+            break;
+        }
+    }
+
+    if (!line) {
+        line = TAILQ_LAST(&lfs->cache, littlefs_cache_list);
+        rc = flash_area_read(lfs->fa, line_off, line->lcl_data,
+                             LITTLEFS_CACHE_LINE_SIZE);
+        if (rc != 0) {
+            line->lcl_off = LITTLEFS_CACHE_INVALID;
+            return NULL;
+        }
+        line->lcl_off = line_off;
+    }
+
+    if (line != TAILQ_FIRST(&lfs->cache)) {
+        TAILQ_REMOVE(&lfs->cache, line, lcl_next);
+        TAILQ_INSERT_HEAD(&lfs->cache, line, lcl_next);
+    }
+
+    return line;
+}
+
+static int
+littlefs_cache_read(struct littlefs *lfs, uint32_t off, uint8_t *dst,
+                    uint32_t len)
+{
+    struct littlefs_cache_line *line;
+    uint32_t line_off;
+    uint32_t chunk;
+
+    /*
+     * Reads of a whole line or more are file data streamed past the lfs
+     * caches; don't let them evict the metadata held in the lines.
+     */
+    if (len >= LITTLEFS_CACHE_LINE_SIZE) {
+        return flash_area_read(lfs->fa, off, dst, len);
+    }
+
+    while (len > 0) {
+        line_off = off - off % LITTLEFS_CACHE_LINE_SIZE;
+        line = littlefs_cache_get(lfs, line_off);
+        if (!line) {
+            return -1;
+        }
+
+        chunk = min(len, line_off + LITTLEFS_CACHE_LINE_SIZE - off);
+        memcpy(dst, line->lcl_data + (off - line_off), chunk);
+        off += chunk;
+        dst += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/*
+ * Brings the cache in line with a write of [off, off + len).  Cached lines
+ * take the written data; if the write failed they are dropped instead.
+ */
+static void
+littlefs_cache_write(struct littlefs *lfs, uint32_t off, const uint8_t *src,
+                     uint32_t len, bool valid)
+{
+    struct littlefs_cache_line *line;
+    uint32_t start;
+    uint32_t end;
+
+    TAILQ_FOREACH(line, &lfs->cache, lcl_next) {
+        if (line->lcl_off == LITTLEFS_CACHE_INVALID ||
+            line->lcl_off >= off + len ||
+            line->lcl_off + LITTLEFS_CACHE_LINE_SIZE <= off) {
+            continue;
+        }
+
+        if (!valid) {
+            line->lcl_off = LITTLEFS_CACHE_INVALID;
+            continue;
+        }
+
+        start = max(off, line->lcl_off);
+        end = min(off + len, line->lcl_off + LITTLEFS_CACHE_LINE_SIZE);
+        memcpy(line->lcl_data + (start - line->lcl_off), src + (start - off),
+               end - start);
+    }
+}
+#endif
+
 /*
  * Read a region in a block. Negative error codes are propagated
  * to the user.
@@ -151,12 +324,16 @@ flash_read(const struct lfs_config *c, lfs_block_t block,
            lfs_off_t off, void *buffer, lfs_size_t size)
 {
     int rc;
-    const struct flash_area *fa;
+    struct littlefs *lfs;
     uint32_t offset;
 
-    fa = (const struct flash_area *)(c->context);
+    lfs = c->context;
     offset = c->block_size * block + off;
-    rc = flash_area_read(fa, offset, buffer, size);
+#if LITTLEFS_CACHE_LINES > 0
+    rc = littlefs_cache_read(lfs, offset, buffer, size);
+#else
+    rc = flash_area_read(lfs->fa, offset, buffer, size);
+#endif
     if (rc != 0) {
         return LFS_ERR_IO;
     }
@@ -174,12 +351,15 @@ flash_prog(const struct lfs_config *c, lfs_block_t block,
            lfs_off_t off, const void *buffer, lfs_size_t size)
 {
     int rc;
-    const struct flash_area *fa;
+    struct littlefs *lfs;
     uint32_t offset;
 
-    fa = (const struct flash_area *)(c->context);
+    lfs = c->context;
     offset = c->block_size * block + off;
-    rc = flash_area_write(fa, offset, buffer, (uint32_t)size);
+    rc = flash_area_write(lfs->fa, offset, buffer, (uint32_t)size);
+#if LITTLEFS_CACHE_LINES > 0
+    littlefs_cache_write(lfs, offset, buffer, size, rc == 0);
+#endif
     if (rc != 0) {
         return LFS_ERR_IO;
     }
@@ -197,10 +377,14 @@ static int
 flash_erase(const struct lfs_config *c, lfs_block_t block)
 {
     int rc;
-    const struct flash_area *fa;
+    struct littlefs *lfs;
 
-    fa = (const struct flash_area *)(c->context);
-    rc = flash_area_erase(fa, c->block_size * block, c->block_size);
+    lfs = c->context;
+#if LITTLEFS_CACHE_LINES > 0
+    littlefs_cache_write(lfs, c->block_size * block, NULL, c->block_size,
+                         false);
+#endif
+    rc = flash_area_erase(lfs->fa, c->block_size * block, c->block_size);
     if (rc != 0) {
         return LFS_ERR_IO;
     }
@@ -219,18 +403,16 @@ flash_sync(const struct lfs_config *c)
     return 0;
 }
 
-static lfs_t *g_lfs = NULL;
-static bool g_lfs_alloc_done = false;
-
 #define READ_SIZE (MYNEWT_VAL(MCU_FLASH_MIN_WRITE_SIZE) * 2)
-static uint8_t read_buffer[READ_SIZE];
 #define WRITE_SIZE (MYNEWT_VAL(MCU_FLASH_MIN_WRITE_SIZE) * 2)
-static uint8_t prog_buffer[WRITE_SIZE];
-#define CACHE_SIZE 8
-static uint8_t __attribute__((aligned(4))) lookahead_buffer[CACHE_SIZE];
-static struct lfs_config g_lfs_cfg = {
-    .context = NULL,
+#define CACHE_SIZE MYNEWT_VAL(LITTLEFS_CACHE_SIZE)
+#define LOOKAHEAD_SIZE MYNEWT_VAL(LITTLEFS_LOOKAHEAD_SIZE)
 
+/*
+ * The read, prog and lookahead buffers are left NULL; lfs allocates them
+ * per instance, sized from the configuration.
+ */
+static const struct lfs_config littlefs_cfg_template = {
     .read = flash_read,
     .prog = flash_prog,
     .erase = flash_erase,
@@ -239,45 +421,101 @@ static struct lfs_config g_lfs_cfg = {
     /* block device configuration */
     .read_size = READ_SIZE,
     .prog_size = WRITE_SIZE,
-    .block_size = MYNEWT_VAL(LITTLEFS_BLOCK_SIZE),
-    .block_count = MYNEWT_VAL(LITTLEFS_BLOCK_COUNT),
     .block_cycles = 500,
-    .cache_size = 16,
-    .lookahead_size = CACHE_SIZE,
-    .read_buffer = read_buffer,
-    .prog_buffer = prog_buffer,
-    .lookahead_buffer = lookahead_buffer,
-    .name_max = 0,
-    .file_max = 0,
-    .attr_max = 0,
-    .metadata_max = 0,
+    .cache_size = CACHE_SIZE,
+    .lookahead_size = LOOKAHEAD_SIZE,
 };
 
-static struct os_mutex littlefs_mutex;
+static void
+littlefs_lock(struct littlefs *lfs)
+{
+    int rc;
+
+    rc = os_mutex_pend(&lfs->mtx, OS_TIMEOUT_NEVER);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+}
 
 static void
-littlefs_lock(void)
+littlefs_unlock(struct littlefs *lfs)
 {
     int rc;
 
-    rc = os_mutex_pend(&littlefs_mutex, OS_TIMEOUT_NEVER);
+    rc = os_mutex_release(&lfs->mtx);
     assert(rc == 0 || rc == OS_NOT_STARTED);
 }
 
 static void
-littlefs_unlock(void)
+littlefs_list_lock(void)
 {
     int rc;
 
-    rc = os_mutex_release(&littlefs_mutex);
+    rc = os_mutex_pend(&littlefs_list_mtx, OS_TIMEOUT_NEVER);
     assert(rc == 0 || rc == OS_NOT_STARTED);
 }
 
+static void
+littlefs_list_unlock(void)
+{
+    int rc;
+
+    rc = os_mutex_release(&littlefs_list_mtx);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+}
+
+/*
+ * The returned instance stays valid only while the caller holds the list
+ * lock.
+ */
+static struct littlefs *
+littlefs_find(const char *name, size_t name_len)
+{
+    struct littlefs *lfs;
+
+    littlefs_list_lock();
+    SLIST_FOREACH(lfs, &littlefs_list, next) {
+        if (!name) {
+            if (!lfs->name) {
+                break;
+            }
+        } else if (lfs->name && strlen(lfs->name) == name_len &&
+                   !memcmp(lfs->name, name, name_len)) {
+            break;
+        }
+    }
+    littlefs_list_unlock();
+
+    return lfs;
+}
+
+/*
+ * Finds the instance a VFS path refers to, and the path within it.  Paths
+ * of the form "<disk>:<path>" refer to the instance mounted as <disk>, all
+ * others to the default instance.  Must be called with the list lock held.
+ */
+static struct littlefs *
+littlefs_resolve(const char *path, const char **out_path)
+{
+    const char *colon;
+    struct littlefs *lfs;
+
+    colon = strchr(path, ':');
+    if (!colon) {
+        *out_path = path;
+        return littlefs_find(NULL, 0);
+    }
+
+    lfs = littlefs_find(path, colon - path);
+    *out_path = colon[1] != '\0' ? colon + 1 : "/";
+
+    return lfs;
+}
+
 static int
 littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_file)
 {
     lfs_file_t *out_file = NULL;
     struct littlefs_file *file = NULL;
+    struct littlefs *lfs;
     int flags;
     int rc;
 
@@ -285,7 +523,12 @@ littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_fi
         return FS_EINVAL;
     }
 
-    out_file = NULL;
+    littlefs_list_lock();
+    lfs = littlefs_resolve(path, &path);
+    if (!lfs) {
+        rc = FS_EUNINIT;
+        goto out;
+    }
 
     file = malloc(sizeof(struct littlefs_file));
     if (!file) {
@@ -322,9 +565,9 @@ littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_fi
         flags |= LFS_O_TRUNC;
     }
 
-    littlefs_lock();
-    rc = lfs_file_open(g_lfs, out_file, path, flags);
-    littlefs_unlock();
+    littlefs_lock(lfs);
+    rc = lfs_file_open(&lfs->lfs, out_file, path, flags);
+    littlefs_unlock(lfs);
     if (rc != LFS_ERR_OK) {
         rc = littlefs_to_vfs_error(rc);
         goto out;
@@ -332,11 +575,12 @@ littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_fi
 
     file->file = out_file;
     file->fops = &littlefs_ops;
-    file->lfs = g_lfs;
+    file->lfs = lfs;
     *out_fs_file = (struct fs_file *) file;
     rc = FS_EOK;
 
 out:
+    littlefs_list_unlock();
     if (rc != FS_EOK) {
         free(file);
         free(out_file);
@@ -349,7 +593,7 @@ littlefs_close(struct fs_file *fs_file)
 {
     int rc;
     lfs_file_t *file;
-    lfs_t *lfs;
+    struct littlefs *lfs;
 
     if (!fs_file) {
         return FS_EINVAL;
@@ -362,10 +606,11 @@ littlefs_close(struct fs_file *fs_file)
 
     lfs = ((struct littlefs_file *) fs_file)->lfs;
 
-    littlefs_lock();
-    rc = lfs_file_close(lfs, file);
-    littlefs_unlock();
+    littlefs_lock(lfs);
+    rc = lfs_file_close(&lfs->lfs, file);
+    littlefs_unlock(lfs);
     free(file);
+    free(fs_file);
 
     return littlefs_to_vfs_error(rc);
 }
@@ -374,7 +619,7 @@ static int
 littlefs_seek(struct fs_file *fs_file, uint32_t offset)
 {
     lfs_file_t *file;
-    lfs_t *lfs;
+    struct littlefs *lfs;
     int rc;
 
     if (!fs_file) {
@@ -385,9 +630,9 @@ littlefs_seek(struct fs_file *fs_file, uint32_t offset)
     lfs = ((struct littlefs_file *) fs_file)->lfs;
 
     /* Returns the new position if succesful */
-    littlefs_lock();
-    rc = lfs_file_seek(lfs, file, offset, LFS_SEEK_SET);
-    littlefs_unlock();
+    littlefs_lock(lfs);
+    rc = lfs_file_seek(&lfs->lfs, file, offset, LFS_SEEK_SET);
+    littlefs_unlock(lfs);
     if (rc < 0) {
         return littlefs_to_vfs_error(rc);
     }
@@ -399,7 +644,7 @@ static uint32_t
 littlefs_getpos(const struct fs_file *fs_file)
 {
     lfs_file_t *file;
-    lfs_t *lfs;
+    struct littlefs *lfs;
     int rc;
 
     if (!fs_file) {
@@ -414,9 +659,9 @@ littlefs_getpos(const struct fs_file *fs_file)
      * failing, so just return 0 and hope for the best. This should
      * eventually be fixed in the FS abstraction.
      */
-    littlefs_lock();
-    rc = lfs_file_tell(lfs, file);
-    littlefs_unlock();
+    littlefs_lock(lfs);
+    rc = lfs_file_tell(&lfs->lfs, file);
+    littlefs_unlock(lfs);
     if (rc < 0) {
         return 0;
     }
@@ -428,7 +673,7 @@ static int
 littlefs_file_len(const struct fs_file *fs_file, uint32_t *out_len)
 {
     lfs_file_t *file;
-    lfs_t *lfs;
+    struct littlefs *lfs;
     int32_t len;
 
     if (!fs_file || !out_len) {
@@ -438,9 +683,9 @@ littlefs_file_len(const struct fs_file *fs_file, uint32_t *out_len)
     file = ((struct littlefs_file *) fs_file)->file;
     lfs = ((struct littlefs_file *) fs_file)->lfs;
 
-    littlefs_lock();
-    len = (int32_t)lfs_file_size(lfs, file);
-    littlefs_unlock();
+    littlefs_lock(lfs);
+    len = (int32_t)lfs_file_size(&lfs->lfs, file);
+    littlefs_unlock(lfs);
     if (len < 0) {
         return littlefs_to_vfs_error((int)len);
     }
@@ -454,7 +699,7 @@ littlefs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
               uint32_t *out_len)
 {
     lfs_file_t *file;
-    lfs_t *lfs;
+    struct littlefs *lfs;
     int32_t size;
 
     if (!fs_file || !out_data || !out_len) {
@@ -469,9 +714,9 @@ littlefs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
     file = ((struct littlefs_file *) fs_file)->file;
     lfs = ((struct littlefs_file *) fs_file)->lfs;
 
-    littlefs_lock();
-    size = lfs_file_read(lfs, file, out_data, *out_len);
-    littlefs_unlock();
+    littlefs_lock(lfs);
+    size = lfs_file_read(&lfs->lfs, file, out_data, len);
+    littlefs_unlock(lfs);
     if (size < 0) {
         return littlefs_to_vfs_error((int)size);
     }
@@ -484,7 +729,7 @@ static int
 littlefs_write(struct fs_file *fs_file, const void *data, int len)
 {
     lfs_file_t *file;
-    lfs_t *lfs;
+    struct littlefs *lfs;
     int32_t size;
 
     if (!fs_file || !data) {
@@ -498,9 +743,9 @@ littlefs_write(struct fs_file *fs_file, const void *data, int len)
     file = ((struct littlefs_file *) fs_file)->file;
     lfs = ((struct littlefs_file *) fs_file)->lfs;
 
-    littlefs_lock();
-    size = lfs_file_write(lfs, file, data, len);
-    littlefs_unlock();
+    littlefs_lock(lfs);
+    size = lfs_file_write(&lfs->lfs, file, data, len);
+    littlefs_unlock(lfs);
     if (size < 0) {
         return littlefs_to_vfs_error((int)size);
     }
@@ -522,15 +767,24 @@ littlefs_flush(struct fs_file *fs_file)
 static int
 littlefs_unlink(const char *path)
 {
+    struct littlefs *lfs;
     int rc;
 
     if (!path) {
         return FS_EINVAL;
     }
 
-    littlefs_lock();
-    rc = lfs_remove(g_lfs, path);
-    littlefs_unlock();
+    littlefs_list_lock();
+    lfs = littlefs_resolve(path, &path);
+    if (!lfs) {
+        littlefs_list_unlock();
+        return FS_EUNINIT;
+    }
+
+    littlefs_lock(lfs);
+    rc = lfs_remove(&lfs->lfs, path);
+    littlefs_unlock(lfs);
+    littlefs_list_unlock();
 
     return littlefs_to_vfs_error(rc);
 }
@@ -538,15 +792,29 @@ littlefs_unlink(const char *path)
 static int
 littlefs_rename(const char *from, const char *to)
 {
+    struct littlefs *lfs;
     int rc;
 
     if (!from || !to) {
         return FS_EINVAL;
     }
 
-    littlefs_lock();
-    rc = lfs_rename(g_lfs, from, to);
-    littlefs_unlock();
+    littlefs_list_lock();
+    lfs = littlefs_resolve(from, &from);
+    if (!lfs) {
+        littlefs_list_unlock();
+        return FS_EUNINIT;
+    }
+    if (littlefs_resolve(to, &to) != lfs) {
+        /* Files can't be moved between instances. */
+        littlefs_list_unlock();
+        return FS_EINVAL;
+    }
+
+    littlefs_lock(lfs);
+    rc = lfs_rename(&lfs->lfs, from, to);
+    littlefs_unlock(lfs);
+    littlefs_list_unlock();
 
     return littlefs_to_vfs_error(rc);
 }
@@ -554,15 +822,24 @@ littlefs_rename(const char *from, const char *to)
 static int
 littlefs_mkdir(const char *path)
 {
+    struct littlefs *lfs;
     int rc;
 
     if (!path) {
         return FS_EINVAL;
     }
 
-    littlefs_lock();
-    rc = lfs_mkdir(g_lfs, path);
-    littlefs_unlock();
+    littlefs_list_lock();
+    lfs = littlefs_resolve(path, &path);
+    if (!lfs) {
+        littlefs_list_unlock();
+        return FS_EUNINIT;
+    }
+
+    littlefs_lock(lfs);
+    rc = lfs_mkdir(&lfs->lfs, path);
+    littlefs_unlock(lfs);
+    littlefs_list_unlock();
 
     return littlefs_to_vfs_error(rc);
 }
@@ -572,13 +849,19 @@ littlefs_opendir(const char *path, struct fs_dir **out_fs_dir)
 {
     lfs_dir_t *out_dir = NULL;
     struct littlefs_dir *dir = NULL;
+    struct littlefs *lfs;
     int rc;
 
     if (!path || !out_fs_dir) {
         return FS_EINVAL;
     }
 
-    out_dir = NULL;
+    littlefs_list_lock();
+    lfs = littlefs_resolve(path, &path);
+    if (!lfs) {
+        rc = FS_EUNINIT;
+        goto out;
+    }
 
     dir = malloc(sizeof(struct littlefs_dir));
     if (!dir) {
@@ -592,9 +875,9 @@ littlefs_opendir(const char *path, struct fs_dir **out_fs_dir)
         goto out;
     }
 
-    littlefs_lock();
-    rc = lfs_dir_open(g_lfs, out_dir, path);
-    littlefs_unlock();
+    littlefs_lock(lfs);
+    rc = lfs_dir_open(&lfs->lfs, out_dir, path);
+    littlefs_unlock(lfs);
     if (rc < 0) {
         rc = littlefs_to_vfs_error(rc);
         goto out;
@@ -603,11 +886,12 @@ littlefs_opendir(const char *path, struct fs_dir **out_fs_dir)
     dir->dir = out_dir;
     dir->cur_dirent = NULL;
     dir->fops = &littlefs_ops;
-    dir->lfs = g_lfs;
+    dir->lfs = lfs;
     *out_fs_dir = (struct fs_dir *)dir;
     rc = FS_EOK;
 
 out:
+    littlefs_list_unlock();
     if (rc != FS_EOK) {
         free(dir);
         free(out_dir);
@@ -621,7 +905,7 @@ littlefs_readdir(struct fs_dir *fs_dir, struct fs_dirent **out_fs_dirent)
     int rc;
     lfs_dir_t *dir;
     struct littlefs_dir *ldir;
-    lfs_t *lfs;
+    struct littlefs *lfs;
     struct littlefs_dirent *dirent;
 
     if (!fs_dir || !out_fs_dirent) {
@@ -642,9 +926,9 @@ littlefs_readdir(struct fs_dir *fs_dir, struct fs_dirent **out_fs_dirent)
     dir = ldir->dir;
     lfs = ldir->lfs;
 
-    littlefs_lock();
-    rc = lfs_dir_read(lfs, dir, &dirent->info);
-    littlefs_unlock();
+    littlefs_lock(lfs);
+    rc = lfs_dir_read(&lfs->lfs, dir, &dirent->info);
+    littlefs_unlock(lfs);
     if (rc < 0) {
         free(dirent);
         ldir->cur_dirent = NULL;
@@ -666,7 +950,7 @@ littlefs_closedir(struct fs_dir *fs_dir)
 {
     int rc;
     lfs_dir_t *dir;
-    lfs_t *lfs;
+    struct littlefs *lfs;
 
     if (!fs_dir) {
         return FS_EINVAL;
@@ -675,12 +959,13 @@ littlefs_closedir(struct fs_dir *fs_dir)
     dir = ((struct littlefs_dir *) fs_dir)->dir;
     lfs = ((struct littlefs_dir *) fs_dir)->lfs;
 
-    littlefs_lock();
-    rc = lfs_dir_close(lfs, dir);
-    littlefs_unlock();
+    littlefs_lock(lfs);
+    rc = lfs_dir_close(&lfs->lfs, dir);
+    littlefs_unlock(lfs);
 
     free(((struct littlefs_dir *) fs_dir)->cur_dirent);
     free(dir);
+    free(fs_dir);
     return littlefs_to_vfs_error(rc);
 }
 
@@ -722,51 +1007,120 @@ littlefs_dirent_is_dir(const struct fs_dirent *fs_dirent)
     return info->type == LFS_TYPE_DIR;
 }
 
+static void
+littlefs_free(struct littlefs *lfs)
+{
+    flash_area_close(lfs->fa);
+#if LITTLEFS_CACHE_LINES > 0
+    free(lfs->cache_data);
+#endif
+    free(lfs);
+}
+
 /*
- * Initializes only Mynewt glue, to fully initialize call
- * LitteFS must call littlefs_format or littlefs_mount.
+ * Initializes only Mynewt glue for an instance; to fully initialize
+ * LitteFS, lfs_format or lfs_mount must be called on it.
  */
 static int
-littlefs_alloc(void)
+littlefs_alloc(const char *name, uint8_t flash_area_id, uint32_t block_size,
+               uint32_t block_count, struct littlefs **out_lfs)
 {
     const struct flash_area *fa;
+    struct littlefs *lfs;
     int rc;
 
-    /*
-     * Already initialized.
-     */
-    if (g_lfs && g_lfs_alloc_done) {
-        return FS_EOK;
+    if (block_size == 0 || block_size % CACHE_SIZE != 0) {
+        return FS_EINVAL;
+    }
+#if LITTLEFS_CACHE_LINES > 0
+    if (block_size % LITTLEFS_CACHE_LINE_SIZE != 0) {
+        return FS_EINVAL;
     }
+#endif
 
-    rc = os_mutex_init(&littlefs_mutex);
-    if (rc != 0) {
-        return FS_EOS;
+    rc = flash_area_open(flash_area_id, &fa);
+    if (rc) {
+        return FS_EHW;
     }
 
-    g_lfs = malloc(sizeof(lfs_t));
-    if (!g_lfs) {
-        return FS_ENOMEM;
+    if (block_count == 0) {
+        block_count = fa->fa_size / block_size;
+    }
+    if (block_count == 0 || block_count * block_size > fa->fa_size) {
+        flash_area_close(fa);
+        return FS_EINVAL;
     }
 
     /*
      * This doesn't seem to be needed because lfs_mount initializes
      * all fields, but just to stay on the safe side...
      */
-    memset(g_lfs, 0, sizeof(lfs_t));
+    lfs = calloc(1, sizeof(*lfs));
+    if (!lfs) {
+        flash_area_close(fa);
+        return FS_ENOMEM;
+    }
+    lfs->fa = fa;
 
-    rc = flash_area_open(MYNEWT_VAL(LITTLEFS_FLASH_AREA), &fa);
-    if (rc) {
-        free(g_lfs);
-        g_lfs = NULL;
-        return FS_EHW;
+#if LITTLEFS_CACHE_LINES > 0
+    lfs->cache_data = malloc(LITTLEFS_CACHE_LINES * LITTLEFS_CACHE_LINE_SIZE);
+    if (!lfs->cache_data) {
+        littlefs_free(lfs);
+        return FS_ENOMEM;
     }
+    littlefs_cache_init(lfs);
+#endif
 
-    /*
-     * TODO: could check that fa_size matches the configured block size * count
-     */
-    g_lfs_cfg.context = (struct flash_area *)fa;
-    g_lfs_alloc_done = true;
+    rc = os_mutex_init(&lfs->mtx);
+    if (rc != 0) {
+        littlefs_free(lfs);
+        return FS_EOS;
+    }
+
+    lfs->name = name;
+    lfs->cfg = littlefs_cfg_template;
+    lfs->cfg.context = lfs;
+    lfs->cfg.block_size = block_size;
+    lfs->cfg.block_count = block_count;
+
+    *out_lfs = lfs;
+
+    return FS_EOK;
+}
+
+static int
+littlefs_add(struct littlefs *lfs)
+{
+    const char *fs_name;
+    int rc;
+
+    if (lfs->name) {
+        /*
+         * Route "<name>:" paths to littlefs.  A disk stays registered after
+         * an unmount, so it may already be there from an earlier mount.
+         */
+        fs_name = disk_fs_for(lfs->name);
+        if (!fs_name) {
+            rc = disk_register(lfs->name, littlefs_ops.f_name, NULL);
+            if (rc != 0) {
+                return FS_ENOMEM;
+            }
+        } else if (strcmp(fs_name, littlefs_ops.f_name) != 0) {
+            return FS_EEXIST;
+        }
+    }
+
+    if (!littlefs_registered) {
+        rc = fs_register(&littlefs_ops);
+        if (rc != 0) {
+            return rc;
+        }
+        littlefs_registered = true;
+    }
+
+    littlefs_list_lock();
+    SLIST_INSERT_HEAD(&littlefs_list, lfs, next);
+    littlefs_list_unlock();
 
     return FS_EOK;
 }
@@ -774,31 +1128,58 @@ littlefs_alloc(void)
 int
 littlefs_reformat(void)
 {
+    struct littlefs *lfs;
     int rc;
 
-    if (!g_lfs_alloc_done) {
-        rc = littlefs_alloc();
-        if (rc != FS_EOK) {
-            return -1;
+    littlefs_list_lock();
+    lfs = littlefs_find(NULL, 0);
+    if (lfs) {
+        littlefs_lock(lfs);
+        lfs_unmount(&lfs->lfs);
+        rc = lfs_format(&lfs->lfs, &lfs->cfg);
+        if (!rc) {
+            rc = lfs_mount(&lfs->lfs, &lfs->cfg);
         }
+        littlefs_unlock(lfs);
+        littlefs_list_unlock();
+        return rc;
     }
+    littlefs_list_unlock();
 
-    return lfs_format(g_lfs, &g_lfs_cfg);
+    rc = littlefs_alloc(NULL, MYNEWT_VAL(LITTLEFS_FLASH_AREA),
+                        MYNEWT_VAL(LITTLEFS_BLOCK_SIZE),
+                        MYNEWT_VAL(LITTLEFS_BLOCK_COUNT), &lfs);
+    if (rc != FS_EOK) {
+        return -1;
+    }
+
+    rc = lfs_format(&lfs->lfs, &lfs->cfg);
+    littlefs_free(lfs);
+
+    return rc;
 }
 
 int
 littlefs_init(void)
 {
+    struct littlefs *lfs;
     int rc;
 
-    if (!g_lfs_alloc_done) {
-        rc = littlefs_alloc();
-        if (rc != FS_EOK) {
-            return rc;
-        }
+    littlefs_list_lock();
+    if (littlefs_find(NULL, 0)) {
+        littlefs_list_unlock();
+        return 0;
     }
 
-    rc = lfs_mount(g_lfs, &g_lfs_cfg);
+    rc = littlefs_alloc(NULL, MYNEWT_VAL(LITTLEFS_FLASH_AREA),
+                        MYNEWT_VAL(LITTLEFS_BLOCK_SIZE),
+                        MYNEWT_VAL(LITTLEFS_BLOCK_COUNT), &lfs);
+    if (rc != FS_EOK) {
+        littlefs_list_unlock();
+        return rc;
+    }
+
+    rc = lfs_mount(&lfs->lfs, &lfs->cfg);
     switch (rc) {
     case LFS_ERR_OK:
         break;
@@ -808,21 +1189,118 @@ littlefs_init(void)
          * detection failure policy.
          */
 #if MYNEWT_VAL(LITTLEFS_DETECT_FAIL_FORMAT)
-        rc = lfs_format(g_lfs, &g_lfs_cfg);
+        rc = lfs_format(&lfs->lfs, &lfs->cfg);
         if (!rc) {
-            rc = lfs_mount(g_lfs, &g_lfs_cfg);
+            rc = lfs_mount(&lfs->lfs, &lfs->cfg);
         }
 #endif
         break;
     }
 
     if (!rc) {
-        fs_register(&littlefs_ops);
+        rc = littlefs_add(lfs);
+        if (rc) {
+            lfs_unmount(&lfs->lfs);
+        }
+    }
+    if (rc) {
+        littlefs_free(lfs);
     }
+    littlefs_list_unlock();
 
     return rc;
 }
 
+int
+littlefs_mount(const char *name, uint8_t flash_area_id, uint32_t block_size)
+{
+    struct littlefs *lfs;
+    int rc;
+
+    if (!name || strchr(name, ':')) {
+        return FS_EINVAL;
+    }
+
+    littlefs_list_lock();
+    if (littlefs_find(name, strlen(name))) {
+        rc = FS_EEXIST;
+        goto out;
+    }
+
+    rc = littlefs_alloc(name, flash_area_id, block_size, 0, &lfs);
+    if (rc != FS_EOK) {
+        goto out;
+    }
+
+    rc = lfs_mount(&lfs->lfs, &lfs->cfg);
+    if (rc) {
+        littlefs_free(lfs);
+        rc = littlefs_to_vfs_error(rc);
+        goto out;
+    }
+
+    rc = littlefs_add(lfs);
+    if (rc) {
+        lfs_unmount(&lfs->lfs);
+        littlefs_free(lfs);
+    }
+
+out:
+    littlefs_list_unlock();
+    return rc;
+}
+
+int
+littlefs_format(uint8_t flash_area_id, uint32_t block_size)
+{
+    struct littlefs *lfs;
+    int rc;
+
+    rc = littlefs_alloc(NULL, flash_area_id, block_size, 0, &lfs);
+    if (rc != FS_EOK) {
+        return rc;
+    }
+
+    rc = lfs_format(&lfs->lfs, &lfs->cfg);
+    littlefs_free(lfs);
+
+    return littlefs_to_vfs_error(rc);
+}
+
+int
+littlefs_unmount(const char *name)
+{
+    struct littlefs *lfs;
+    int rc;
+
+    if (!name) {
+        return FS_EINVAL;
+    }
+
+    littlefs_list_lock();
+    lfs = littlefs_find(name, strlen(name));
+    if (!lfs) {
+        littlefs_list_unlock();
+        return FS_ENOENT;
+    }
+
+    littlefs_lock(lfs);
+    if (lfs->lfs.mlist) {
+        /* Open files and directories still point at this instance. */
+        littlefs_unlock(lfs);
+        littlefs_list_unlock();
+        return FS_EBUSY;
+    }
+    rc = lfs_unmount(&lfs->lfs);
+    littlefs_unlock(lfs);
+
+    SLIST_REMOVE(&littlefs_list, lfs, littlefs, next);
+    littlefs_list_unlock();
+    littlefs_free(lfs);
+
+    return littlefs_to_vfs_error(rc);
+}
+
 void
 littlefs_pkg_init(void)
 {
@@ -99,7 +99,11 @@ TEST_CASE_DECL(nffs_test_lost_found)
 TEST_CASE_DECL(nffs_test_readdir)
 TEST_CASE_DECL(nffs_test_split_file)
 TEST_CASE_DECL(nffs_test_gc_on_oom)
+TEST_CASE_DECL(nffs_test_hash_grow)
 TEST_CASE_DECL(nffs_test_cache_large_file)
+TEST_CASE_DECL(nffs_test_ckpt_restore)
+TEST_CASE_DECL(nffs_test_ckpt_stale)
+TEST_CASE_DECL(nffs_test_ckpt_corrupt)
 
 static void
 nffs_test_basic_cases(void)
@@ -129,6 +133,7 @@ nffs_test_basic_cases(void)
     nffs_test_readdir();
     nffs_test_split_file();
     nffs_test_gc_on_oom();
+    nffs_test_hash_grow();
 }
 
 TEST_SUITE(nffs_test_suite_1_1)
@@ -167,6 +172,17 @@ TEST_SUITE(nffs_suite_cache)
     nffs_test_cache_large_file();
 }
 
+TEST_SUITE(nffs_suite_ckpt)
+{
+    nffs_config.nc_num_cache_inodes = 4;
+    nffs_config.nc_num_cache_blocks = 64;
+    tu_suite_set_pre_test_cb(nffs_testcase_pre, NULL);
+
+    nffs_test_ckpt_restore();
+    nffs_test_ckpt_stale();
+    nffs_test_ckpt_corrupt();
+}
+
 int
 main(void)
 {
@@ -179,5 +195,7 @@ main(void)
 
     nffs_suite_cache();
 
+    nffs_suite_ckpt();
+
     return tu_any_failed;
 }
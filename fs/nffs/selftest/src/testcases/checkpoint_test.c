@@ -0,0 +1,195 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+
+#include <stddef.h>
+#include "flash_map/flash_map.h"
+
+/* Kept clear of the checkpoint flash area. */
+static const struct nffs_area_desc nffs_test_ckpt_area_descs[] = {
+    { 0x00000000, 16 * 1024 },
+    { 0x00004000, 16 * 1024 },
+    { 0x00008000, 16 * 1024 },
+    { 0x0000c000, 16 * 1024 },
+    { 0, 0 },
+};
+
+/**
+ * Creates a small file system and checkpoints it.  The next file ID is
+ * bumped first, so the returned value is only in effect after a reboot if
+ * the checkpoint was loaded; a full scan derives a lower one.
+ */
+static uint32_t
+nffs_test_ckpt_setup(void)
+{
+    int rc;
+
+    rc = nffs_format(nffs_test_ckpt_area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fs_mkdir("/mydir");
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_util_create_file("/mydir/a", "aaaa", 4);
+    nffs_test_util_create_file("/mydir/b", "bbbb", 4);
+    nffs_test_util_append_file("/mydir/b", "1234", 4);
+    nffs_test_util_create_file("/mydir/c", "cccc", 4);
+
+    nffs_hash_next_file_id += 100;
+
+    rc = nffs_checkpoint();
+    TEST_ASSERT_FATAL(rc == 0);
+
+    return nffs_hash_next_file_id;
+}
+
+static void
+nffs_test_ckpt_reboot(void)
+{
+    int rc;
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = nffs_detect(nffs_test_ckpt_area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+static void
+nffs_test_ckpt_assert_abc(void)
+{
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "mydir",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "a",
+                    .contents = "aaaa",
+                    .contents_len = 4,
+                }, {
+                    .filename = "b",
+                    .contents = "bbbb1234",
+                    .contents_len = 8,
+                }, {
+                    .filename = "c",
+                    .contents = "cccc",
+                    .contents_len = 4,
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    nffs_test_assert_system_once(expected_system);
+    nffs_test_util_assert_contents("/mydir/a", "aaaa", 4);
+    nffs_test_util_assert_contents("/mydir/b", "bbbb1234", 8);
+    nffs_test_util_assert_contents("/mydir/c", "cccc", 4);
+}
+#endif
+
+TEST_CASE_SELF(nffs_test_ckpt_restore)
+{
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    uint32_t next_file_id;
+    int rc;
+
+    next_file_id = nffs_test_ckpt_setup();
+
+    /* The index comes from the checkpoint. */
+    nffs_test_ckpt_reboot();
+    TEST_ASSERT(nffs_hash_next_file_id == next_file_id);
+    nffs_test_ckpt_assert_abc();
+
+    /* The checkpoint stays valid until something is written. */
+    nffs_test_ckpt_reboot();
+    TEST_ASSERT(nffs_hash_next_file_id == next_file_id);
+    nffs_test_ckpt_assert_abc();
+
+    /* The restored index can be written to. */
+    nffs_test_util_append_file("/mydir/a", "5678", 4);
+    nffs_test_util_assert_contents("/mydir/a", "aaaa5678", 8);
+    rc = nffs_checkpoint();
+    TEST_ASSERT(rc == 0);
+    nffs_test_ckpt_reboot();
+    nffs_test_util_assert_contents("/mydir/a", "aaaa5678", 8);
+#endif
+}
+
+TEST_CASE_SELF(nffs_test_ckpt_stale)
+{
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    const struct flash_area *fa;
+    struct nffs_ckpt_hdr hdr;
+    uint32_t next_file_id;
+    int rc;
+    int i;
+
+    next_file_id = nffs_test_ckpt_setup();
+
+    /* The first write after the checkpoint invalidates it. */
+    nffs_test_util_create_file("/mydir/d", "dddd", 4);
+
+    rc = flash_area_open(MYNEWT_VAL(NFFS_CHECKPOINT_FLASH_AREA), &fa);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_read(fa, 0, &hdr, sizeof hdr);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(hdr.nch_magic == NFFS_CKPT_MAGIC);
+    for (i = 0; i < NFFS_CKPT_INVAL_SZ; i++) {
+        TEST_ASSERT(hdr.nch_inval[i] == 0);
+    }
+
+    /* A full scan finds the new file; the checkpoint would not have. */
+    nffs_test_ckpt_reboot();
+    TEST_ASSERT(nffs_hash_next_file_id == next_file_id + 1);
+    nffs_test_util_assert_contents("/mydir/b", "bbbb1234", 8);
+    nffs_test_util_assert_contents("/mydir/d", "dddd", 4);
+#endif
+}
+
+TEST_CASE_SELF(nffs_test_ckpt_corrupt)
+{
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    const struct flash_area *fa;
+    uint32_t next_file_id;
+    uint32_t off;
+    int rc;
+
+    next_file_id = nffs_test_ckpt_setup();
+
+    /* Corrupt a reserved byte of the first entry; only the CRC covers it. */
+    rc = flash_area_open(MYNEWT_VAL(NFFS_CHECKPOINT_FLASH_AREA), &fa);
+    TEST_ASSERT_FATAL(rc == 0);
+    off = fa->fa_off + sizeof (struct nffs_ckpt_hdr) +
+          nffs_num_areas * sizeof (struct nffs_ckpt_area) +
+          offsetof(struct nffs_ckpt_entry, reserved8);
+    rc = flash_native_memset(off, 0x5a, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* The checkpoint is rejected before it touches the index. */
+    nffs_test_ckpt_reboot();
+    TEST_ASSERT(nffs_hash_next_file_id != next_file_id);
+    nffs_test_ckpt_assert_abc();
+#endif
+}
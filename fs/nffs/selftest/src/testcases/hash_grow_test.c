@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+TEST_CASE_SELF(nffs_test_hash_grow)
+{
+    char filename[32];
+    int num_files;
+    int rc;
+    int i;
+
+    /*** Setup. */
+    nffs_config.nc_num_inodes = 2048;
+    nffs_config.nc_num_blocks = 2048;
+
+    rc = nffs_init();
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    rc = fs_mkdir("/dir");
+    TEST_ASSERT(rc == 0);
+
+    /* Each file is an inode and a data block; create enough of them to push
+     * the initial table past its load factor.
+     */
+    num_files = MYNEWT_VAL(NFFS_HASH_SIZE) *
+                MYNEWT_VAL(NFFS_HASH_LOAD_FACTOR) / 2 + 1;
+    for (i = 0; i < num_files; i++) {
+        snprintf(filename, sizeof filename, "/dir/f%d", i);
+        nffs_test_util_create_file(filename, filename, strlen(filename));
+    }
+
+    /* Restore from flash; the table must grow back to the same size. */
+    rc = nffs_detect(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    if (MYNEWT_VAL(NFFS_HASH_MAX_SIZE) > MYNEWT_VAL(NFFS_HASH_SIZE)) {
+        TEST_ASSERT(nffs_hash_size > MYNEWT_VAL(NFFS_HASH_SIZE));
+    } else {
+        TEST_ASSERT(nffs_hash_size == MYNEWT_VAL(NFFS_HASH_SIZE));
+    }
+
+    for (i = 0; i < num_files; i++) {
+        snprintf(filename, sizeof filename, "/dir/f%d", i);
+        nffs_test_util_assert_contents(filename, filename, strlen(filename));
+    }
+}
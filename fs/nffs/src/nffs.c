@@ -106,6 +106,9 @@ STATS_SECT_DECL(nffs_stats) nffs_stats;
 STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_hashcnt_ins)
     STATS_NAME(nffs_stats, nffs_hashcnt_rm)
+    STATS_NAME(nffs_stats, nffs_hashcnt_find)
+    STATS_NAME(nffs_stats, nffs_hashcnt_probe)
+    STATS_NAME(nffs_stats, nffs_hashcnt_grow)
     STATS_NAME(nffs_stats, nffs_object_count)
     STATS_NAME(nffs_stats, nffs_iocnt_read)
     STATS_NAME(nffs_stats, nffs_iocnt_write)
@@ -123,6 +126,7 @@ STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_readcnt_filename)
     STATS_NAME(nffs_stats, nffs_readcnt_object)
     STATS_NAME(nffs_stats, nffs_readcnt_detect)
+    STATS_NAME(nffs_stats, nffs_readcnt_ckpt)
 STATS_NAME_END(nffs_stats)
 
 static void
@@ -139,6 +143,9 @@ nffs_unlock(void)
 {
     int rc;
 
+    /* No table iteration can be in progress here; resize if it got busy. */
+    nffs_hash_grow();
+
     rc = os_mutex_release(&nffs_mutex);
     assert(rc == 0 || rc == OS_NOT_STARTED);
 }
@@ -687,6 +694,37 @@ nffs_detect(const struct nffs_area_desc *area_descs)
     return rc;
 }
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+/**
+ * Writes a checkpoint of the RAM index to NFFS_CHECKPOINT_FLASH_AREA.  The
+ * next nffs_detect() loads the checkpoint instead of reading every area, as
+ * long as the file system is not modified in the meantime.  Call this before
+ * a planned reset or power down.
+ *
+ * @return                  0 on success;
+ *                          FS_EACCESS if an unlinked file is still open;
+ *                          other nonzero on error.
+ */
+int
+nffs_checkpoint(void)
+{
+    int rc;
+
+    nffs_lock();
+    rc = nffs_ckpt_write();
+    nffs_unlock();
+
+    return rc;
+}
+
+int
+nffs_ckpt_sysdown(int reason)
+{
+    nffs_checkpoint();
+    return SYSDOWN_COMPLETE;
+}
+#endif
+
 /**
  * Initializes internal nffs memory and data structures.  This must be called
  * before any nffs operations are attempted.
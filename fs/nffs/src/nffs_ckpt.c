@@ -0,0 +1,602 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * NFFS checkpoint.
+ *
+ * A checkpoint is a snapshot of the RAM index (every inode and block hash
+ * entry plus the directory tree) stored in a dedicated flash area.  Loading it
+ * at mount time replaces the scan of every object in every area.
+ *
+ * The checkpoint is only trusted if the file system has not changed since it
+ * was written:
+ *     o The first flash write or erase performed by NFFS after the checkpoint
+ *       is written or loaded programs the header's invalidation slot.
+ *     o Each area's header must match the one recorded in the checkpoint, and
+ *       each area must still be erased at its recorded write offset.
+ *     o The CRC of the checkpoint body must be correct; it is verified
+ *       before anything is added to the RAM index.
+ * If any check fails, the regular scan is performed instead.
+ *
+ * Flash layout:
+ *     o Header (struct nffs_ckpt_hdr); written last, except for the
+ *       invalidation slot, which stays erased until the checkpoint goes
+ *       stale.  Programming erased flash is cheap and, unlike programming
+ *       over the magic, allowed on flash with ECC.
+ *     o One struct nffs_ckpt_area per area.
+ *     o One struct nffs_ckpt_entry per hash entry.  Inodes come first; the
+ *       children of each directory are contiguous and in child-list order.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+
+#include <assert.h>
+#include <string.h>
+#include "flash_map/flash_map.h"
+#include "nffs/nffs.h"
+#include "nffs_priv.h"
+
+#define NFFS_CKPT_ENTRIES_PER_BUF   \
+    (NFFS_FLASH_BUF_SZ / sizeof (struct nffs_ckpt_entry))
+
+/** Flags that are recomputed when a checkpoint is loaded. */
+#define NFFS_CKPT_FLAGS_VOLATILE    \
+    (NFFS_INODE_FLAG_INHASH | NFFS_INODE_FLAG_INTREE)
+
+/**
+ * Whether the checkpoint area may contain a valid header.  Unknown until the
+ * first restore, so assume it does.
+ */
+static uint8_t nffs_ckpt_present = 1;
+
+/** Buffered sequential writer; nffs_flash_buf holds the pending bytes. */
+struct nffs_ckpt_writer {
+    const struct flash_area *ncw_fa;
+    uint32_t ncw_off;
+    uint16_t ncw_buf_len;
+    uint16_t ncw_crc16;
+    int ncw_rc;
+};
+
+static int
+nffs_ckpt_open(const struct flash_area **out_fa)
+{
+    if (flash_area_open(MYNEWT_VAL(NFFS_CHECKPOINT_FLASH_AREA), out_fa) != 0) {
+        return FS_EHW;
+    }
+
+    return 0;
+}
+
+static void
+nffs_ckpt_flush(struct nffs_ckpt_writer *w)
+{
+    uint8_t align;
+    uint16_t len;
+
+    if (w->ncw_rc != 0 || w->ncw_buf_len == 0) {
+        return;
+    }
+
+    /* Pad the last chunk to the flash write alignment. */
+    align = flash_area_align(w->ncw_fa);
+    len = w->ncw_buf_len;
+    if (align > 1 && len % align != 0) {
+        memset(nffs_flash_buf + len, flash_area_erased_val(w->ncw_fa),
+               align - len % align);
+        len += align - len % align;
+    }
+
+    if (flash_area_write(w->ncw_fa, w->ncw_off, nffs_flash_buf, len) != 0) {
+        w->ncw_rc = FS_EHW;
+        return;
+    }
+
+    w->ncw_off += w->ncw_buf_len;
+    w->ncw_buf_len = 0;
+}
+
+static void
+nffs_ckpt_out(struct nffs_ckpt_writer *w, const void *data, uint16_t len)
+{
+    const uint8_t *u8p;
+    uint16_t chunk;
+
+    if (w->ncw_off + w->ncw_buf_len + len > w->ncw_fa->fa_size) {
+        w->ncw_rc = FS_EFULL;
+        return;
+    }
+
+    w->ncw_crc16 = crc16_ccitt(w->ncw_crc16, data, len);
+
+    /* Only full buffers are written until the end, so every write but the
+     * last starts and ends on an aligned offset.
+     */
+    u8p = data;
+    while (len > 0) {
+        chunk = NFFS_FLASH_BUF_SZ - w->ncw_buf_len;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(nffs_flash_buf + w->ncw_buf_len, u8p, chunk);
+        w->ncw_buf_len += chunk;
+        u8p += chunk;
+        len -= chunk;
+
+        if (w->ncw_buf_len == NFFS_FLASH_BUF_SZ) {
+            nffs_ckpt_flush(w);
+        }
+    }
+}
+
+static void
+nffs_ckpt_out_inode(struct nffs_ckpt_writer *w,
+                    struct nffs_inode_entry *inode_entry, uint32_t parent_id)
+{
+    struct nffs_ckpt_entry rec;
+
+    memset(&rec, 0, sizeof rec);
+    rec.nce_id = inode_entry->nie_hash_entry.nhe_id;
+    rec.nce_flash_loc = inode_entry->nie_hash_entry.nhe_flash_loc;
+    rec.nce_parent_id = parent_id;
+    rec.nce_lastblock_id = NFFS_ID_NONE;
+    if (nffs_hash_id_is_file(rec.nce_id) &&
+        inode_entry->nie_last_block_entry != NULL) {
+
+        rec.nce_lastblock_id = inode_entry->nie_last_block_entry->nhe_id;
+    }
+    rec.nce_flags = inode_entry->nie_flags & ~NFFS_CKPT_FLAGS_VOLATILE;
+
+    nffs_ckpt_out(w, &rec, sizeof rec);
+}
+
+/**
+ * Writes a checkpoint of the current RAM index.  Every inode must be part of
+ * the directory tree; an unlinked file that is still open prevents a
+ * checkpoint from being written.
+ *
+ * @return                      0 on success;
+ *                              FS_EACCESS if an inode is not reachable from
+ *                                  the root directory;
+ *                              other FS_E[...] code on failure.
+ */
+int
+nffs_ckpt_write(void)
+{
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_inode_entry *child;
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    struct nffs_ckpt_writer w;
+    struct nffs_ckpt_area area;
+    struct nffs_ckpt_hdr hdr;
+    uint32_t num_inodes;
+    uint32_t num_entries;
+    int rc;
+    int i;
+
+    if (!nffs_misc_ready()) {
+        return FS_EUNINIT;
+    }
+
+    memset(&w, 0, sizeof w);
+    rc = nffs_ckpt_open(&w.ncw_fa);
+    if (rc != 0) {
+        return rc;
+    }
+
+    nffs_ckpt_present = 1;
+    if (flash_area_erase(w.ncw_fa, 0, w.ncw_fa->fa_size) != 0) {
+        return FS_EHW;
+    }
+    w.ncw_off = sizeof hdr;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        memset(&area, 0, sizeof area);
+        area.nca_offset = nffs_areas[i].na_offset;
+        area.nca_length = nffs_areas[i].na_length;
+        area.nca_cur = nffs_areas[i].na_cur;
+        area.nca_id = nffs_areas[i].na_id;
+        area.nca_gc_seq = nffs_areas[i].na_gc_seq;
+        area.nca_flash_id = nffs_areas[i].na_flash_id;
+        nffs_ckpt_out(&w, &area, sizeof area);
+    }
+
+    /* Inodes: the root directory, then the children of each directory. */
+    nffs_ckpt_out_inode(&w, nffs_root_dir, NFFS_ID_NONE);
+    num_entries = 1;
+    num_inodes = 0;
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (!nffs_hash_id_is_inode(entry->nhe_id)) {
+            continue;
+        }
+        num_inodes++;
+
+        inode_entry = (struct nffs_inode_entry *)entry;
+        if (nffs_hash_id_is_dir(entry->nhe_id)) {
+            SLIST_FOREACH(child, &inode_entry->nie_child_list,
+                          nie_sibling_next) {
+                nffs_ckpt_out_inode(&w, child, entry->nhe_id);
+                num_entries++;
+            }
+        }
+    }
+    if (num_entries != num_inodes) {
+        return FS_EACCESS;
+    }
+
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (nffs_hash_id_is_block(entry->nhe_id)) {
+            struct nffs_ckpt_entry rec;
+
+            memset(&rec, 0, sizeof rec);
+            rec.nce_id = entry->nhe_id;
+            rec.nce_flash_loc = entry->nhe_flash_loc;
+            rec.nce_parent_id = NFFS_ID_NONE;
+            rec.nce_lastblock_id = NFFS_ID_NONE;
+            nffs_ckpt_out(&w, &rec, sizeof rec);
+            num_entries++;
+        }
+    }
+
+    nffs_ckpt_flush(&w);
+    if (w.ncw_rc != 0) {
+        return w.ncw_rc;
+    }
+
+    /* The header goes last; the checkpoint is valid once it is written. */
+    memset(&hdr, 0, sizeof hdr);
+    hdr.nch_magic = NFFS_CKPT_MAGIC;
+    hdr.nch_num_entries = num_entries;
+    hdr.nch_next_dir_id = nffs_hash_next_dir_id;
+    hdr.nch_next_file_id = nffs_hash_next_file_id;
+    hdr.nch_next_block_id = nffs_hash_next_block_id;
+    hdr.nch_block_max_data_sz = nffs_block_max_data_sz;
+    hdr.nch_num_areas = nffs_num_areas;
+    hdr.nch_scratch_area_idx = nffs_scratch_area_idx;
+    hdr.nch_crc16 = w.ncw_crc16;
+    if (flash_area_write(w.ncw_fa, NFFS_CKPT_INVAL_SZ, &hdr.nch_magic,
+                         sizeof hdr - NFFS_CKPT_INVAL_SZ) != 0) {
+        return FS_EHW;
+    }
+
+    return 0;
+}
+
+/**
+ * Programs the invalidation slot of the checkpoint header to zero if a
+ * checkpoint may be present.  Called before NFFS modifies flash, since the
+ * checkpoint no longer describes the file system afterwards.
+ */
+void
+nffs_ckpt_invalidate(void)
+{
+    static const uint8_t zeros[NFFS_CKPT_INVAL_SZ];
+    const struct flash_area *fa;
+    uint8_t buf[NFFS_CKPT_INVAL_SZ];
+    int rc;
+
+    if (!nffs_ckpt_present) {
+        return;
+    }
+
+    if (nffs_ckpt_open(&fa) != 0) {
+        return;
+    }
+
+    /* The slot may only be programmed once. */
+    rc = flash_area_read_is_empty(fa, 0, buf, sizeof buf);
+    if (rc < 0) {
+        return;
+    }
+    if (rc == 1 && flash_area_write(fa, 0, zeros, sizeof zeros) != 0) {
+        return;
+    }
+
+    nffs_ckpt_present = 0;
+}
+
+/**
+ * Verifies that an area has not been written to beyond the offset recorded
+ * in the checkpoint.
+ */
+static int
+nffs_ckpt_area_is_clean(uint8_t area_idx, uint32_t cur)
+{
+    uint8_t buf[sizeof (struct nffs_disk_inode)];
+    uint32_t len;
+    int rc;
+    int i;
+
+    len = nffs_areas[area_idx].na_length - cur;
+    if (len > sizeof buf) {
+        len = sizeof buf;
+    }
+    if (len == 0) {
+        return 1;
+    }
+
+    rc = nffs_flash_read(area_idx, cur, buf, len);
+    if (rc != 0) {
+        return 0;
+    }
+
+    for (i = 0; i < len; i++) {
+        if (buf[i] != 0xff) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int
+nffs_ckpt_restore_entry(const struct nffs_ckpt_entry *rec)
+{
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_hash_entry *entry;
+
+    if (nffs_hash_find(rec->nce_id) != NULL) {
+        return FS_ECORRUPT;
+    }
+
+    if (nffs_hash_id_is_inode(rec->nce_id)) {
+        inode_entry = nffs_inode_entry_alloc();
+        if (inode_entry == NULL) {
+            return FS_ENOMEM;
+        }
+        inode_entry->nie_hash_entry.nhe_id = rec->nce_id;
+        inode_entry->nie_hash_entry.nhe_flash_loc = rec->nce_flash_loc;
+        inode_entry->nie_refcnt = 1;
+        inode_entry->nie_flags = rec->nce_flags & ~NFFS_CKPT_FLAGS_VOLATILE;
+        entry = &inode_entry->nie_hash_entry;
+    } else if (nffs_hash_id_is_block(rec->nce_id)) {
+        entry = nffs_block_entry_alloc();
+        if (entry == NULL) {
+            return FS_ENOMEM;
+        }
+        entry->nhe_id = rec->nce_id;
+        entry->nhe_flash_loc = rec->nce_flash_loc;
+    } else {
+        return FS_ECORRUPT;
+    }
+
+    nffs_hash_insert(entry);
+    nffs_hash_grow();
+
+    return 0;
+}
+
+/**
+ * Links a restored inode into the directory tree and to its last block.
+ * Siblings are stored in child-list order, so each child is appended after
+ * the previous one.
+ */
+static int
+nffs_ckpt_link_inode(const struct nffs_ckpt_entry *rec,
+                     struct nffs_inode_entry **prev)
+{
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_inode_entry *parent;
+
+    inode_entry = nffs_hash_find_inode(rec->nce_id);
+    assert(inode_entry != NULL);
+
+    if (nffs_hash_id_is_file(rec->nce_id) &&
+        rec->nce_lastblock_id != NFFS_ID_NONE) {
+
+        inode_entry->nie_last_block_entry =
+            nffs_hash_find_block(rec->nce_lastblock_id);
+        if (inode_entry->nie_last_block_entry == NULL) {
+            return FS_ECORRUPT;
+        }
+    }
+
+    if (rec->nce_parent_id == NFFS_ID_NONE) {
+        if (rec->nce_id != NFFS_ID_ROOT_DIR) {
+            return FS_ECORRUPT;
+        }
+        nffs_root_dir = inode_entry;
+        nffs_inode_setflags(inode_entry, NFFS_INODE_FLAG_INTREE);
+        return 0;
+    }
+
+    if (!nffs_hash_id_is_dir(rec->nce_parent_id)) {
+        return FS_ECORRUPT;
+    }
+    parent = nffs_hash_find_inode(rec->nce_parent_id);
+    if (parent == NULL) {
+        return FS_ECORRUPT;
+    }
+
+    if (*prev == NULL) {
+        SLIST_INSERT_HEAD(&parent->nie_child_list, inode_entry,
+                          nie_sibling_next);
+    } else {
+        SLIST_INSERT_AFTER(*prev, inode_entry, nie_sibling_next);
+    }
+    nffs_inode_setflags(inode_entry, NFFS_INODE_FLAG_INTREE);
+    *prev = inode_entry;
+
+    return 0;
+}
+
+/**
+ * Loads the RAM index from the checkpoint.  The areas must already have been
+ * detected, and the hash table must be empty.  On failure the RAM state is
+ * left partially populated; the caller must reset it.
+ *
+ * @param out_block_max_data_sz On success, the maximum data block size in
+ *                                  effect when the checkpoint was written gets
+ *                                  written here.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOENT if there is no checkpoint;
+ *                              FS_ECORRUPT if the checkpoint does not match
+ *                                  the file system;
+ *                              other FS_E[...] code on failure.
+ */
+int
+nffs_ckpt_restore(uint16_t *out_block_max_data_sz)
+{
+    struct nffs_inode_entry *prev;
+    const struct nffs_ckpt_entry *rec;
+    const struct flash_area *fa;
+    struct nffs_ckpt_area area;
+    struct nffs_ckpt_hdr hdr;
+    uint32_t prev_parent_id;
+    uint32_t entries_off;
+    uint32_t remaining;
+    uint32_t off;
+    uint16_t crc16;
+    uint8_t erased_val;
+    int pass;
+    int cnt;
+    int rc;
+    int i;
+
+    rc = nffs_ckpt_open(&fa);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (flash_area_read(fa, 0, &hdr, sizeof hdr) != 0) {
+        return FS_EHW;
+    }
+    erased_val = flash_area_erased_val(fa);
+    for (i = 0; i < NFFS_CKPT_INVAL_SZ; i++) {
+        if (hdr.nch_inval[i] != erased_val) {
+            break;
+        }
+    }
+    if (hdr.nch_magic != NFFS_CKPT_MAGIC || i < NFFS_CKPT_INVAL_SZ) {
+        nffs_ckpt_present = 0;
+        return FS_ENOENT;
+    }
+    nffs_ckpt_present = 1;
+
+    if (hdr.nch_num_areas != nffs_num_areas ||
+        hdr.nch_scratch_area_idx != nffs_scratch_area_idx ||
+        sizeof hdr + hdr.nch_num_areas * sizeof area +
+        hdr.nch_num_entries * sizeof *rec > fa->fa_size) {
+
+        return FS_ECORRUPT;
+    }
+
+    crc16 = 0;
+    off = sizeof hdr;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (flash_area_read(fa, off, &area, sizeof area) != 0) {
+            return FS_EHW;
+        }
+        crc16 = crc16_ccitt(crc16, &area, sizeof area);
+        off += sizeof area;
+
+        if (area.nca_offset != nffs_areas[i].na_offset ||
+            area.nca_length != nffs_areas[i].na_length ||
+            area.nca_flash_id != nffs_areas[i].na_flash_id ||
+            area.nca_id != nffs_areas[i].na_id ||
+            area.nca_gc_seq != nffs_areas[i].na_gc_seq ||
+            area.nca_cur > area.nca_length) {
+
+            return FS_ECORRUPT;
+        }
+
+        if (i != nffs_scratch_area_idx &&
+            !nffs_ckpt_area_is_clean(i, area.nca_cur)) {
+
+            return FS_ECORRUPT;
+        }
+    }
+    entries_off = off;
+
+    /* Pass 0 only checks the CRC, so a corrupt checkpoint leaves the RAM
+     * index untouched; pass 1 populates the hash table; pass 2 links inodes
+     * to their parents and last blocks.
+     */
+    for (pass = 0; pass < 3; pass++) {
+        off = entries_off;
+        remaining = hdr.nch_num_entries;
+        prev = NULL;
+        prev_parent_id = NFFS_ID_NONE;
+
+        while (remaining > 0) {
+            cnt = remaining;
+            if (cnt > NFFS_CKPT_ENTRIES_PER_BUF) {
+                cnt = NFFS_CKPT_ENTRIES_PER_BUF;
+            }
+            if (flash_area_read(fa, off, nffs_flash_buf,
+                                cnt * sizeof *rec) != 0) {
+                return FS_EHW;
+            }
+            STATS_INC(nffs_stats, nffs_readcnt_ckpt);
+            off += cnt * sizeof *rec;
+            remaining -= cnt;
+
+            if (pass == 0) {
+                crc16 = crc16_ccitt(crc16, nffs_flash_buf, cnt * sizeof *rec);
+            }
+
+            for (i = 0; i < cnt && pass > 0; i++) {
+                rec = (const struct nffs_ckpt_entry *)nffs_flash_buf + i;
+                if (pass == 1) {
+                    rc = nffs_ckpt_restore_entry(rec);
+                } else if (nffs_hash_id_is_inode(rec->nce_id)) {
+                    if (rec->nce_parent_id != prev_parent_id) {
+                        prev = NULL;
+                        prev_parent_id = rec->nce_parent_id;
+                    }
+                    rc = nffs_ckpt_link_inode(rec, &prev);
+                } else {
+                    rc = 0;
+                }
+                if (rc != 0) {
+                    return rc;
+                }
+            }
+        }
+
+        if (pass == 0 && crc16 != hdr.nch_crc16) {
+            return FS_ECORRUPT;
+        }
+    }
+
+    off = sizeof hdr;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (flash_area_read(fa, off, &area, sizeof area) != 0) {
+            return FS_EHW;
+        }
+        off += sizeof area;
+
+        if (i != nffs_scratch_area_idx) {
+            nffs_areas[i].na_cur = area.nca_cur;
+        }
+    }
+
+    nffs_hash_next_dir_id = hdr.nch_next_dir_id;
+    nffs_hash_next_file_id = hdr.nch_next_file_id;
+    nffs_hash_next_block_id = hdr.nch_next_block_id;
+    *out_block_max_data_sz = hdr.nch_block_max_data_sz;
+
+    return 0;
+}
+
+#endif
@@ -96,6 +96,10 @@ nffs_flash_write(uint8_t area_idx, uint32_t area_offset, const void *data,
         return FS_EOFFSET;
     }
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    nffs_ckpt_invalidate();
+#endif
+
     STATS_INC(nffs_stats, nffs_iocnt_write);
     rc = hal_flash_write(area->na_flash_id, area->na_offset + area_offset,
                          data, len);
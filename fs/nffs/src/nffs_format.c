@@ -72,6 +72,10 @@ nffs_format_area(uint8_t area_idx, int is_scratch)
 
     area = nffs_areas + area_idx;
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    nffs_ckpt_invalidate();
+#endif
+
     rc = hal_flash_erase(area->na_flash_id, area->na_offset, area->na_length);
     if (rc != 0) {
         return FS_EHW;
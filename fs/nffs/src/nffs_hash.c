@@ -24,6 +24,10 @@
 #include "nffs_priv.h"
 
 struct nffs_hash_list *nffs_hash;
+int nffs_hash_size;
+
+/** Number of entries currently in the hash table. */
+static int nffs_hash_count;
 
 uint32_t nffs_hash_next_dir_id;
 uint32_t nffs_hash_next_file_id;
@@ -56,7 +60,7 @@ nffs_hash_id_is_block(uint32_t id)
 static int
 nffs_hash_fn(uint32_t id)
 {
-    return id % NFFS_HASH_SIZE;
+    return id % nffs_hash_size;
 }
 
 static struct nffs_hash_entry *
@@ -70,8 +74,11 @@ nffs_hash_find_reorder(uint32_t id)
     idx = nffs_hash_fn(id);
     list = nffs_hash + idx;
 
+    STATS_INC(nffs_stats, nffs_hashcnt_find);
+
     prev = NULL;
     SLIST_FOREACH(entry, list, nhe_next) {
+        STATS_INC(nffs_stats, nffs_hashcnt_probe);
         if (entry->nhe_id == id) {
             /* Put entry at the front of the list. */
             if (prev != NULL) {
@@ -97,7 +104,10 @@ nffs_hash_find(uint32_t id)
     idx = nffs_hash_fn(id);
     list = nffs_hash + idx;
 
+    STATS_INC(nffs_stats, nffs_hashcnt_find);
+
     SLIST_FOREACH(entry, list, nhe_next) {
+        STATS_INC(nffs_stats, nffs_hashcnt_probe);
         if (entry->nhe_id == id) {
             return entry;
         }
@@ -156,6 +166,7 @@ nffs_hash_insert(struct nffs_hash_entry *entry)
     list = nffs_hash + idx;
 
     SLIST_INSERT_HEAD(list, entry, nhe_next);
+    nffs_hash_count++;
     STATS_INC(nffs_stats, nffs_hashcnt_ins);
 
     if (nffs_hash_id_is_inode(entry->nhe_id)) {
@@ -186,6 +197,7 @@ nffs_hash_remove(struct nffs_hash_entry *entry)
     list = nffs_hash + idx;
 
     SLIST_REMOVE(list, entry, nffs_hash_entry, nhe_next);
+    nffs_hash_count--;
     STATS_INC(nffs_stats, nffs_hashcnt_rm);
 
     if (nffs_hash_id_is_inode(entry->nhe_id) && nie) {
@@ -194,6 +206,60 @@ nffs_hash_remove(struct nffs_hash_entry *entry)
     assert(nffs_hash_find(entry->nhe_id) == NULL);
 }
 
+/**
+ * Doubles the number of buckets in the hash table if the average chain length
+ * exceeds NFFS_HASH_LOAD_FACTOR.  The table never grows beyond
+ * NFFS_HASH_MAX_SIZE buckets.  If the larger table cannot be allocated, the
+ * current one is kept; lookups just stay a bit slower.
+ *
+ * Entries move to different buckets, so this must not be called while the
+ * table is being iterated.  It is invoked after each restored object and
+ * before the file system lock is released.
+ */
+void
+nffs_hash_grow(void)
+{
+    struct nffs_hash_list *old_hash;
+    struct nffs_hash_entry *entry;
+    int old_size;
+    int new_size;
+    int i;
+
+    if (nffs_hash_count <= nffs_hash_size * MYNEWT_VAL(NFFS_HASH_LOAD_FACTOR)) {
+        return;
+    }
+
+    new_size = nffs_hash_size * 2;
+    if (new_size > MYNEWT_VAL(NFFS_HASH_MAX_SIZE)) {
+        return;
+    }
+
+    old_hash = nffs_hash;
+    old_size = nffs_hash_size;
+
+    nffs_hash = malloc(new_size * sizeof *nffs_hash);
+    if (nffs_hash == NULL) {
+        nffs_hash = old_hash;
+        return;
+    }
+    nffs_hash_size = new_size;
+
+    for (i = 0; i < new_size; i++) {
+        SLIST_INIT(nffs_hash + i);
+    }
+
+    for (i = 0; i < old_size; i++) {
+        while ((entry = SLIST_FIRST(old_hash + i)) != NULL) {
+            SLIST_REMOVE_HEAD(old_hash + i, nhe_next);
+            SLIST_INSERT_HEAD(nffs_hash + nffs_hash_fn(entry->nhe_id), entry,
+                              nhe_next);
+        }
+    }
+
+    free(old_hash);
+    STATS_INC(nffs_stats, nffs_hashcnt_grow);
+}
+
 int
 nffs_hash_init(void)
 {
@@ -201,12 +267,15 @@ nffs_hash_init(void)
 
     free(nffs_hash);
 
-    nffs_hash = malloc(NFFS_HASH_SIZE * sizeof *nffs_hash);
+    nffs_hash_size = MYNEWT_VAL(NFFS_HASH_SIZE);
+    nffs_hash_count = 0;
+
+    nffs_hash = malloc(nffs_hash_size * sizeof *nffs_hash);
     if (nffs_hash == NULL) {
         return FS_ENOMEM;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         SLIST_INIT(nffs_hash + i);
     }
 
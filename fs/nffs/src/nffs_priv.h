@@ -32,8 +32,6 @@
 extern "C" {
 #endif
 
-#define NFFS_HASH_SIZE               256
-
 #define NFFS_ID_DIR_MIN              0
 #define NFFS_ID_DIR_MAX              0x10000000
 #define NFFS_ID_FILE_MIN             0x10000000
@@ -51,6 +49,7 @@ extern "C" {
 #define NFFS_AREA_MAGIC3             0xb185fc8e
 #define NFFS_BLOCK_MAGIC             0x53ba23b9
 #define NFFS_INODE_MAGIC             0x925f8bc0
+#define NFFS_CKPT_MAGIC              0x4e434b50  /* "NCKP" */
 
 #define NFFS_AREA_ID_NONE            0xff
 #define NFFS_AREA_VER_0                 0
@@ -106,6 +105,46 @@ struct nffs_disk_block {
 
 #define NFFS_DISK_BLOCK_OFFSET_CRC  18
 
+/* Large enough for any flash write alignment NFFS supports. */
+#define NFFS_CKPT_INVAL_SZ          32
+
+/** On-disk representation of the checkpoint header. */
+struct nffs_ckpt_hdr {
+    uint8_t nch_inval[NFFS_CKPT_INVAL_SZ];  /* Erased while valid. */
+    uint32_t nch_magic;     /* NFFS_CKPT_MAGIC */
+    uint32_t nch_num_entries;
+    uint32_t nch_next_dir_id;
+    uint32_t nch_next_file_id;
+    uint32_t nch_next_block_id;
+    uint16_t nch_block_max_data_sz;
+    uint8_t nch_num_areas;
+    uint8_t nch_scratch_area_idx;
+    uint16_t nch_crc16;     /* Covers the area and entry records. */
+    uint16_t reserved16;
+    uint32_t reserved32;
+};
+
+/** On-disk representation of an area in the checkpoint. */
+struct nffs_ckpt_area {
+    uint32_t nca_offset;
+    uint32_t nca_length;
+    uint32_t nca_cur;
+    uint16_t nca_id;
+    uint8_t nca_gc_seq;
+    uint8_t nca_flash_id;
+};
+
+/** On-disk representation of an inode or block in the checkpoint. */
+struct nffs_ckpt_entry {
+    uint32_t nce_id;
+    uint32_t nce_flash_loc;
+    uint32_t nce_parent_id;     /* Inodes only; NFFS_ID_NONE if root. */
+    uint32_t nce_lastblock_id;  /* Files only. */
+    uint8_t nce_flags;
+    uint8_t reserved8;
+    uint16_t reserved16;
+};
+
 /**
  * What gets stored in the hash table.  Each entry represents a data block or
  * an inode.
@@ -250,6 +289,9 @@ struct nffs_dir {
 STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_hashcnt_ins)
     STATS_SECT_ENTRY(nffs_hashcnt_rm)
+    STATS_SECT_ENTRY(nffs_hashcnt_find)
+    STATS_SECT_ENTRY(nffs_hashcnt_probe)
+    STATS_SECT_ENTRY(nffs_hashcnt_grow)
     STATS_SECT_ENTRY(nffs_object_count)
     STATS_SECT_ENTRY(nffs_iocnt_read)
     STATS_SECT_ENTRY(nffs_iocnt_write)
@@ -267,6 +309,7 @@ STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_readcnt_filename)
     STATS_SECT_ENTRY(nffs_readcnt_object)
     STATS_SECT_ENTRY(nffs_readcnt_detect)
+    STATS_SECT_ENTRY(nffs_readcnt_ckpt)
 STATS_SECT_END
 extern STATS_SECT_DECL(nffs_stats) nffs_stats;
 
@@ -296,6 +339,7 @@ extern struct nffs_area_desc *nffs_current_area_descs;
 extern uint8_t nffs_flash_buf[NFFS_FLASH_BUF_SZ];
 
 extern struct nffs_hash_list *nffs_hash;
+extern int nffs_hash_size;
 extern struct nffs_inode_entry *nffs_root_dir;
 extern struct nffs_inode_entry *nffs_lost_found_dir;
 
@@ -346,6 +390,11 @@ int nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t to,
                     struct nffs_cache_block **out_cache_block);
 void nffs_cache_clear(void);
 
+/* @ckpt */
+int nffs_ckpt_write(void);
+int nffs_ckpt_restore(uint16_t *out_block_max_data_sz);
+void nffs_ckpt_invalidate(void);
+
 /* @crc */
 int nffs_crc_flash(uint16_t initial_crc, uint8_t area_idx,
                    uint32_t area_offset, uint32_t len, uint16_t *out_crc);
@@ -410,6 +459,7 @@ struct nffs_inode_entry *nffs_hash_find_inode(uint32_t id);
 struct nffs_hash_entry *nffs_hash_find_block(uint32_t id);
 void nffs_hash_insert(struct nffs_hash_entry *entry);
 void nffs_hash_remove(struct nffs_hash_entry *entry);
+void nffs_hash_grow(void);
 int nffs_hash_init(void);
 int nffs_hash_entry_is_dummy(struct nffs_hash_entry *he);
 int nffs_hash_id_is_dummy(uint32_t id);
@@ -503,7 +553,7 @@ int nffs_write_to_file(struct nffs_file *file, const void *data, int len);
 
 
 #define NFFS_HASH_FOREACH(entry, i, next)                               \
-    for ((i) = 0; (i) < NFFS_HASH_SIZE; (i)++)                          \
+    for ((i) = 0; (i) < nffs_hash_size; (i)++)                          \
         for ((entry) = SLIST_FIRST(nffs_hash + (i));                    \
              (entry) && (((next)) = SLIST_NEXT((entry), nhe_next), 1);  \
              (entry) = ((next)))
@@ -287,7 +287,7 @@ nffs_restore_sweep(void)
     /* Iterate through every object in the hash table, deleting all inodes that
      * should be removed.
      */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         list = nffs_hash + i;
 
         entry = SLIST_FIRST(list);
@@ -1065,6 +1065,7 @@ nffs_restore_area_contents(int area_idx)
             } else {
                 STATS_INC(nffs_stats, nffs_object_count); /* restored objects */
                 area->na_cur += nffs_restore_disk_object_size(&disk_object);
+                nffs_hash_grow();
             }
             break;
 
@@ -1159,7 +1160,7 @@ nffs_restore_corrupt_scratch(void)
     }
 
     /* Invalidate all objects resident in the bad area. */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         entry = SLIST_FIRST(&nffs_hash[i]);
         while (entry != NULL) {
             next = SLIST_NEXT(entry, nhe_next);
@@ -1274,20 +1275,16 @@ nffs_log_contents(void)
 }
 
 /**
- * Searches for a valid nffs file system among the specified areas.  This
- * function succeeds if a file system is detected among any subset of the
- * supplied areas.  If the area set does not contain a valid file system,
- * a new one can be created via a call to nffs_format().
+ * Restores the RAM representation of the file system.
  *
- * @param area_descs        The area set to search.  This array must be
- *                              terminated with a 0-length area.
+ * @param area_descs            The areas that make up the file system.
+ * @param use_ckpt              Whether to load the index from the checkpoint
+ *                                  instead of reading every area's contents.
  *
- * @return                  0 on success;
- *                          FS_ECORRUPT if no valid file system was detected;
- *                          other nonzero on error.
+ * @return                      0 on success; nonzero on failure.
  */
-int
-nffs_restore_full(const struct nffs_area_desc *area_descs)
+static int
+nffs_restore_areas(const struct nffs_area_desc *area_descs, int use_ckpt)
 {
     struct nffs_disk_area disk_area;
     int cur_area_idx;
@@ -1357,11 +1354,22 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             } else {
                 nffs_areas[cur_area_idx].na_cur =
                     sizeof (struct nffs_disk_area);
-                nffs_restore_area_contents(cur_area_idx);
+                if (!use_ckpt) {
+                    nffs_restore_area_contents(cur_area_idx);
+                }
             }
         }
     }
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    if (use_ckpt) {
+        rc = nffs_ckpt_restore(&nffs_restore_largest_block_data_len);
+        if (rc != 0) {
+            goto err;
+        }
+    }
+#endif
+
     /* All areas have been restored from flash. */
 
     if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
@@ -1396,9 +1404,11 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
     }
 
     /* Delete from RAM any objects that were invalidated when subsequent areas
-     * were restored.
+     * were restored.  A checkpoint is taken from an already swept index.
      */
-    nffs_restore_sweep();
+    if (!use_ckpt) {
+        nffs_restore_sweep();
+    }
 
     /* Set the maximum data block size according to the size of the smallest
      * area.
@@ -1417,3 +1427,29 @@ err:
     nffs_misc_reset();
     return rc;
 }
+
+/**
+ * Searches for a valid nffs file system among the specified areas.  This
+ * function succeeds if a file system is detected among any subset of the
+ * supplied areas.  If the area set does not contain a valid file system,
+ * a new one can be created via a call to nffs_format().
+ *
+ * @param area_descs        The area set to search.  This array must be
+ *                              terminated with a 0-length area.
+ *
+ * @return                  0 on success;
+ *                          FS_ECORRUPT if no valid file system was detected;
+ *                          other nonzero on error.
+ */
+int
+nffs_restore_full(const struct nffs_area_desc *area_descs)
+{
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    /* Fall back to reading every area if the checkpoint is missing or stale. */
+    if (nffs_restore_areas(area_descs, 1) == 0) {
+        return 0;
+    }
+#endif
+
+    return nffs_restore_areas(area_descs, 0);
+}
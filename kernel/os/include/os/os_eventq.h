@@ -89,6 +89,11 @@ struct os_eventq {
 
     STAILQ_HEAD(, os_event) evq_list;
 
+#if MYNEWT_VAL(OS_EVENTQ_URGENT)
+    /** Last urgent event on the queue, or NULL if there is none. */
+    struct os_event *evq_urgent_last;
+#endif
+
 #if MYNEWT_VAL(OS_EVENTQ_DEBUG)
     /** Most recently processed event. */
     struct os_event *evq_prev;
@@ -121,6 +126,18 @@ int os_eventq_inited(const struct os_eventq *evq);
  */
 void os_eventq_put(struct os_eventq *, struct os_event *);
 
+#if MYNEWT_VAL(OS_EVENTQ_URGENT)
+/**
+ * Put an urgent event on the event queue.  Urgent events are processed
+ * before any regular event already on the queue, in the order they were
+ * put.
+ *
+ * @param evq The event queue to put an event on
+ * @param ev The event to put on the queue
+ */
+void os_eventq_put_urgent(struct os_eventq *evq, struct os_event *ev);
+#endif
+
 /**
  * Poll an event from the event queue and return it immediately.
  * If no event is available, don't block, just return NULL.
@@ -147,6 +164,23 @@ struct os_event *os_eventq_get(struct os_eventq *);
  */
 void os_eventq_run(struct os_eventq *evq);
 
+/**
+ * Pull up to 'max' items off the event queue and call their event
+ * callbacks.  This function blocks until there is at least one item on the
+ * event queue, then keeps processing items until the queue is empty or 'max'
+ * items were processed.  Draining a busy queue this way avoids the per-item
+ * ownership checks and scheduler interaction of os_eventq_run().
+ *
+ * Items are dequeued one at a time, so an item removed from the queue by an
+ * earlier callback (e.g., by stopping a callout) is not run.
+ *
+ * @param evq The event queue to pull the items off.
+ * @param max The maximum number of items to process.
+ *
+ * @return The number of items processed.
+ */
+int os_eventq_run_batch(struct os_eventq *evq, int max);
+
 
 /**
  * Poll the list of event queues specified by the evq parameter
@@ -108,6 +108,41 @@ struct os_mbuf {
     uint8_t om_databuf[0];
 };
 
+struct os_mbuf_ext;
+
+/**
+ * Function called when the last reference to an external mbuf buffer is
+ * released.
+ *
+ * @param ext                   The external buffer descriptor.
+ * @param arg                   The optional argument registered with the
+ *                                  descriptor.
+ */
+typedef void os_mbuf_ext_free_fn(struct os_mbuf_ext *ext, void *arg);
+
+/**
+ * Descriptor of an externally owned, reference counted data buffer.  Mbufs
+ * flagged with OS_MBUF_F_EXT point into such a buffer instead of their own
+ * data area.  Any number of mbufs (possibly in different chains) may
+ * reference the same buffer; the buffer's free callback is executed when the
+ * last reference is dropped.
+ *
+ * The data of an external buffer is shared, so it must be treated as
+ * read-only once it is referenced by more than one mbuf.
+ */
+struct os_mbuf_ext {
+    /** Start of the external data buffer */
+    uint8_t *ome_buf;
+    /** Called when the reference count drops to zero; may be NULL */
+    os_mbuf_ext_free_fn *ome_free_cb;
+    /** Argument passed to the free callback */
+    void *ome_arg;
+    /** Size of the external data buffer, in bytes */
+    uint16_t ome_len;
+    /** Number of references held on the buffer */
+    uint16_t ome_refcnt;
+};
+
 /**
  * Structure representing a queue of mbufs.
  */
@@ -124,6 +159,17 @@ struct os_mqueue {
  */
 #define OS_MBUF_F_MASK(__n) (1 << (__n))
 
+/** Mbuf data lives in an external, reference counted buffer */
+#define OS_MBUF_F_EXT               0
+
+/*
+ * Checks whether a given mbuf references an external buffer
+ *
+ * @param __om The mbuf to check
+ */
+#define OS_MBUF_IS_EXT(__om) \
+    (((__om)->om_flags & OS_MBUF_F_MASK(OS_MBUF_F_EXT)) != 0)
+
 /*
  * Checks whether a given mbuf is a packet header mbuf
  *
@@ -184,6 +230,11 @@ _os_mbuf_leadingspace(struct os_mbuf *om)
     uint16_t startoff;
     uint16_t leadingspace;
 
+    /* External data is shared; never grow into it. */
+    if (OS_MBUF_IS_EXT(om)) {
+        return 0;
+    }
+
     startoff = 0;
     if (OS_MBUF_IS_PKTHDR(om)) {
         startoff = om->om_pkthdr_len;
@@ -218,6 +269,10 @@ _os_mbuf_trailingspace(struct os_mbuf *om)
 {
     struct os_mbuf_pool *omp;
 
+    if (OS_MBUF_IS_EXT(om)) {
+        return 0;
+    }
+
     omp = om->om_omp;
 
     return (&om->om_databuf[0] + omp->omp_databuf_len) -
@@ -373,8 +428,64 @@ struct os_mbuf *os_mbuf_get(struct os_mbuf_pool *omp, uint16_t);
 struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp,
         uint8_t pkthdr_len);
 
+/**
+ * Initializes an external buffer descriptor.  The caller owns the initial
+ * reference, which must eventually be dropped with os_mbuf_ext_release().
+ *
+ * @param ext     The descriptor to initialize
+ * @param buf     The external data buffer
+ * @param len     The size of the external data buffer
+ * @param free_cb Called when the last reference is released; may be NULL
+ * @param arg     Argument passed to free_cb
+ */
+void os_mbuf_ext_init(struct os_mbuf_ext *ext, void *buf, uint16_t len,
+                      os_mbuf_ext_free_fn *free_cb, void *arg);
+
+/**
+ * Acquires an additional reference on an external buffer.
+ *
+ * @param ext The external buffer descriptor
+ */
+void os_mbuf_ext_ref(struct os_mbuf_ext *ext);
+
+/**
+ * Drops a reference on an external buffer.  If this was the last reference,
+ * the buffer's free callback is executed.
+ *
+ * @param ext The external buffer descriptor
+ */
+void os_mbuf_ext_release(struct os_mbuf_ext *ext);
+
+/**
+ * Allocates an mbuf that references a slice of an external buffer without
+ * copying it.  The mbuf holds a reference on the buffer until it is freed.
+ * The mbuf has no leading or trailing space.
+ *
+ * @param omp The mbuf pool to allocate the mbuf header from
+ * @param ext The external buffer to reference
+ * @param off The offset of the slice within the external buffer
+ * @param len The length of the slice
+ *
+ * @return An initialized mbuf on success, and NULL on failure.
+ */
+struct os_mbuf *os_mbuf_get_ext(struct os_mbuf_pool *omp,
+                                struct os_mbuf_ext *ext,
+                                uint16_t off, uint16_t len);
+
+/**
+ * Retrieves the external buffer referenced by an mbuf.
+ *
+ * @param om The mbuf to query
+ *
+ * @return The external buffer descriptor, or NULL if the mbuf stores its
+ *         data internally.
+ */
+struct os_mbuf_ext *os_mbuf_to_ext(const struct os_mbuf *om);
+
 /**
  * Duplicate a chain of mbufs.  Return the start of the duplicated chain.
+ * Data stored in the mbufs themselves is copied; data held in external
+ * buffers is shared by reference rather than copied.
  *
  * @param omp The mbuf pool to duplicate out of
  * @param om  The mbuf chain to duplicate
@@ -458,7 +569,29 @@ int os_mbuf_appendfrom(struct os_mbuf *dst, const struct os_mbuf *src,
                        uint16_t src_off, uint16_t len);
 
 /**
- * Release a mbuf back to the pool
+ * Appends a range of one mbuf chain to another without copying data held in
+ * external buffers: each external segment of the source range is appended as
+ * a new mbuf referencing the same buffer.  Segments of the source stored
+ * inside regular mbufs are copied as with os_mbuf_appendfrom().  On error,
+ * the specified data range may be partially appended.
+ *
+ * @param dst                   The mbuf to append to.
+ * @param src                   The mbuf to reference data from.
+ * @param src_off               The absolute offset within the source mbuf
+ *                                  chain to read from.
+ * @param len                   The number of bytes to append.
+ *
+ * @return                      0 on success;
+ *                              OS_EINVAL if the specified range extends beyond
+ *                                  the end of the source mbuf chain;
+ *                              OS_ENOMEM if an mbuf could not be allocated.
+ */
+int os_mbuf_appendref(struct os_mbuf *dst, const struct os_mbuf *src,
+                      uint16_t src_off, uint16_t len);
+
+/**
+ * Release a mbuf back to the pool.  If the mbuf references an external
+ * buffer, its reference on that buffer is dropped.
  *
  * @param omp The Mbuf pool to release back to
  * @param om  The Mbuf to release back to the pool
@@ -562,7 +695,9 @@ struct os_mbuf *os_mbuf_prepend_pullup(struct os_mbuf *om, uint16_t len);
  * Copies the contents of a flat buffer into an mbuf chain, starting at the
  * specified destination offset.  If the mbuf is too small for the source data,
  * it is extended as necessary.  If the destination mbuf contains a packet
- * header, the header length is updated.
+ * header, the header length is updated.  External (OS_MBUF_F_EXT) data is
+ * read-only: if the destination range overlaps an external segment, nothing
+ * is written and OS_EINVAL is returned.
  *
  * @param omp                   The mbuf pool to allocate from.
  * @param om                    The mbuf chain to copy into.
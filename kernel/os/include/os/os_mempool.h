@@ -65,6 +65,13 @@ struct os_mempool {
     uint16_t mp_min_free;
     /** Bitmap of OS_MEMPOOL_F_[...] values. */
     uint8_t mp_flags;
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    /**
+     * Head of the lock-free free list: ABA tag in the upper 16 bits, index
+     * of the first free block plus one in the lower 16 bits.
+     */
+    uint32_t mp_lf_head;
+#endif
     /** Address of memory buffer used by pool */
     uint32_t mp_membuf_addr;
     STAILQ_ENTRY(os_mempool) mp_list;
@@ -79,6 +86,12 @@ struct os_mempool {
  */
 #define OS_MEMPOOL_F_EXT        0x01
 
+/**
+ * Indicates a lock-free mempool.  Blocks are allocated and freed with atomic
+ * compare-and-swap operations rather than inside a critical section.
+ */
+#define OS_MEMPOOL_F_LOCKFREE   0x02
+
 struct os_mempool_ext;
 
 /**
@@ -212,6 +225,27 @@ os_error_t os_mempool_init(struct os_mempool *mp, uint16_t blocks,
 os_error_t os_mempool_ext_init(struct os_mempool_ext *mpe, uint16_t blocks,
                                uint32_t block_size, void *membuf, char *name);
 
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+/**
+ * Initializes a lock-free memory pool.  The pool is used through the regular
+ * os_memblock_get() / os_memblock_put() API, but these functions never
+ * disable interrupts for it, so they do not add to interrupt latency when
+ * called at high rates from ISRs.  A lock-free pool is limited to 65535
+ * blocks.
+ *
+ * @param mp            The mempool to initialize.
+ * @param blocks        The number of blocks in the pool.
+ * @param block_size    The size of each block, in bytes.
+ * @param membuf        Pointer to memory to contain blocks.
+ * @param name          Name of the pool.
+ *
+ * @return os_error_t
+ */
+os_error_t os_mempool_lockfree_init(struct os_mempool *mp, uint16_t blocks,
+                                    uint32_t block_size, void *membuf,
+                                    char *name);
+#endif
+
 /**
  * Removes the specified mempool from the list of initialized mempools.
  *
@@ -286,6 +320,69 @@ os_error_t os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr);
  */
 os_error_t os_memblock_put(struct os_mempool *mp, void *block_addr);
 
+/**
+ * Magazine: a small, unlocked cache of free blocks owned by a single task.
+ * Blocks are taken from and returned to the magazine without any
+ * synchronization; the magazine exchanges blocks with its backing mempool in
+ * batches of half its capacity.  Blocks held in a magazine are accounted as
+ * allocated by the backing mempool.
+ */
+struct os_mempool_mag {
+    /** The mempool backing this magazine */
+    struct os_mempool *mm_mp;
+    /** Storage for cached block pointers */
+    void **mm_blocks;
+    /** Capacity of mm_blocks */
+    uint16_t mm_cap;
+    /** Number of blocks currently cached */
+    uint16_t mm_cnt;
+};
+
+/**
+ * Initializes a magazine on top of a mempool.  Extended mempools are not
+ * supported, since their put callbacks would be bypassed.
+ *
+ * @param mag           The magazine to initialize.
+ * @param mp            The backing mempool.
+ * @param blocks        Storage for cap block pointers.
+ * @param cap           The capacity of the magazine; must be at least 2.
+ *
+ * @return os_error_t
+ */
+os_error_t os_mempool_mag_init(struct os_mempool_mag *mag,
+                               struct os_mempool *mp, void **blocks,
+                               uint16_t cap);
+
+/**
+ * Gets a memory block through a magazine, refilling the magazine from its
+ * mempool if it is empty.  Must only be called by the magazine's owner.
+ *
+ * @param mag           The magazine.
+ *
+ * @return Pointer to block if available; NULL otherwise
+ */
+void *os_memblock_mag_get(struct os_mempool_mag *mag);
+
+/**
+ * Puts a memory block back through a magazine, spilling half of the cached
+ * blocks to the mempool if the magazine is full.  Must only be called by the
+ * magazine's owner.
+ *
+ * @param mag           The magazine.
+ * @param block_addr    The block to free; must belong to the magazine's
+ *                          mempool.
+ *
+ * @return os_error_t
+ */
+os_error_t os_memblock_mag_put(struct os_mempool_mag *mag, void *block_addr);
+
+/**
+ * Returns all blocks cached in a magazine to its mempool.
+ *
+ * @param mag           The magazine to flush.
+ */
+void os_mempool_mag_flush(struct os_mempool_mag *mag);
+
 #ifdef __cplusplus
 }
 #endif
@@ -105,6 +105,14 @@ struct os_task {
     uint8_t t_flags;
     uint8_t t_lockcnt;
     uint8_t t_pad;
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    /** Priority the task was queued with on the run list */
+    uint8_t t_run_prio;
+#endif
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    /** Index of the task in the sleep heap */
+    uint8_t t_sleep_idx;
+#endif
 
     /** Task name */
     const char *t_name;
@@ -33,8 +33,10 @@ TEST_SUITE_DECL(os_time_test_suite);
 TEST_SUITE_DECL(os_mbuf_test_suite);
 TEST_SUITE_DECL(os_eventq_test_suite);
 TEST_SUITE_DECL(os_callout_test_suite);
+TEST_SUITE_DECL(os_malloc_test_suite);
 
 TEST_CASE_DECL(os_time_test_change);
+TEST_CASE_DECL(os_malloc_test_slab);
 
 int os_test_all(void);
 
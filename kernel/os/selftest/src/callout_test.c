@@ -226,6 +226,7 @@ callout_task_stop_listen(void *arg)
 }
 
 TEST_CASE_DECL(callout_test_speak)
+TEST_CASE_DECL(callout_test_wheel)
 TEST_CASE_DECL(callout_test_stop)
 TEST_CASE_DECL(callout_test)
 
@@ -234,4 +235,5 @@ TEST_SUITE(os_callout_test_suite)
     callout_test();
     callout_test_stop();
     callout_test_speak();
+    callout_test_wheel();
 }
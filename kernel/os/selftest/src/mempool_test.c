@@ -58,6 +58,7 @@ mempool_test_get_pool_size(int num_blocks, int block_size)
 TEST_CASE_DECL(os_mempool_test_case)
 TEST_CASE_DECL(os_mempool_test_ext_basic)
 TEST_CASE_DECL(os_mempool_test_ext_nested)
+TEST_CASE_DECL(os_mempool_test_mag)
 
 TEST_SUITE(os_mempool_test_suite)
 {
@@ -69,6 +70,7 @@ TEST_SUITE(os_mempool_test_suite)
     os_mempool_test_case();
     os_mempool_test_ext_basic();
     os_mempool_test_ext_nested();
+    os_mempool_test_mag();
 
     free(TstMembuf);
     TstMembufSz = 0;
@@ -0,0 +1,119 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define EVENT_TEST_BATCH_NUM    5
+
+static int event_test_batch_order[EVENT_TEST_BATCH_NUM * 2];
+static int event_test_batch_cnt;
+
+static void
+event_test_batch_cb(struct os_event *ev)
+{
+    event_test_batch_order[event_test_batch_cnt++] = (intptr_t)ev->ev_arg;
+}
+
+static struct os_eventq *event_test_batch_evq;
+static struct os_event *event_test_batch_victim;
+
+static void
+event_test_batch_cancel_cb(struct os_event *ev)
+{
+    event_test_batch_cb(ev);
+    os_eventq_remove(event_test_batch_evq, event_test_batch_victim);
+}
+
+/**
+ * Tests os_eventq_run_batch() and urgent events.  The queue never runs dry,
+ * so this does not involve the scheduler and works without starting the OS.
+ */
+TEST_CASE_SELF(event_test_batch)
+{
+    struct os_event evs[EVENT_TEST_BATCH_NUM];
+    struct os_eventq evq;
+    int rc;
+    int i;
+
+    os_eventq_init(&evq);
+    memset(evs, 0, sizeof evs);
+    for (i = 0; i < EVENT_TEST_BATCH_NUM; i++) {
+        evs[i].ev_cb = event_test_batch_cb;
+        evs[i].ev_arg = (void *)(intptr_t)i;
+        os_eventq_put(&evq, &evs[i]);
+    }
+
+    /* Events are processed in FIFO order, at most 'max' at a time. */
+    event_test_batch_cnt = 0;
+    rc = os_eventq_run_batch(&evq, 3);
+    TEST_ASSERT(rc == 3);
+    rc = os_eventq_run_batch(&evq, 10);
+    TEST_ASSERT(rc == 2);
+    TEST_ASSERT(event_test_batch_cnt == EVENT_TEST_BATCH_NUM);
+    for (i = 0; i < EVENT_TEST_BATCH_NUM; i++) {
+        TEST_ASSERT(event_test_batch_order[i] == i);
+        TEST_ASSERT(!OS_EVENT_QUEUED(&evs[i]));
+    }
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == NULL);
+
+    /* An event removed by an earlier callback of the same batch is not
+     * run.
+     */
+    event_test_batch_evq = &evq;
+    event_test_batch_victim = &evs[2];
+    evs[0].ev_cb = event_test_batch_cancel_cb;
+    for (i = 0; i < 4; i++) {
+        os_eventq_put(&evq, &evs[i]);
+    }
+    event_test_batch_cnt = 0;
+    rc = os_eventq_run_batch(&evq, EVENT_TEST_BATCH_NUM);
+    TEST_ASSERT(rc == 3);
+    TEST_ASSERT(event_test_batch_order[0] == 0);
+    TEST_ASSERT(event_test_batch_order[1] == 1);
+    TEST_ASSERT(event_test_batch_order[2] == 3);
+    TEST_ASSERT(!OS_EVENT_QUEUED(&evs[2]));
+    evs[0].ev_cb = event_test_batch_cb;
+
+#if MYNEWT_VAL(OS_EVENTQ_URGENT)
+    /* Urgent events overtake regular ones, but stay in FIFO order among
+     * themselves.  Removing the last urgent event must not break that.
+     */
+    os_eventq_put(&evq, &evs[0]);
+    os_eventq_put(&evq, &evs[1]);
+    os_eventq_put_urgent(&evq, &evs[2]);
+    os_eventq_put_urgent(&evq, &evs[3]);
+    os_eventq_remove(&evq, &evs[3]);
+    os_eventq_put_urgent(&evq, &evs[4]);
+    os_eventq_put_urgent(&evq, &evs[3]);
+
+    event_test_batch_cnt = 0;
+    rc = os_eventq_run_batch(&evq, EVENT_TEST_BATCH_NUM);
+    TEST_ASSERT(rc == EVENT_TEST_BATCH_NUM);
+    TEST_ASSERT(event_test_batch_order[0] == 2);
+    TEST_ASSERT(event_test_batch_order[1] == 4);
+    TEST_ASSERT(event_test_batch_order[2] == 3);
+    TEST_ASSERT(event_test_batch_order[3] == 0);
+    TEST_ASSERT(event_test_batch_order[4] == 1);
+
+    /* The urgent section is empty again; a new urgent event goes first. */
+    os_eventq_put(&evq, &evs[0]);
+    os_eventq_put_urgent(&evq, &evs[1]);
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == &evs[1]);
+    TEST_ASSERT(os_eventq_get_no_wait(&evq) == &evs[0]);
+#endif
+}
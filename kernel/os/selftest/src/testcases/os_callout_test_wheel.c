@@ -0,0 +1,80 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/*
+ * Callouts armed on each level of the callout wheel, and beyond it; the
+ * earliest one must always be found, whichever are armed.
+ */
+static const os_time_t callout_wheel_ticks[] = {
+    1, 63, 64, 65, 4095, 4096, 300000, (1UL << 24) - 1, (1UL << 24) + 5,
+    0x10000000,
+};
+
+#define CALLOUT_WHEEL_CNT \
+    (sizeof(callout_wheel_ticks) / sizeof(callout_wheel_ticks[0]))
+
+static struct os_callout callout_wheel_c[CALLOUT_WHEEL_CNT];
+static struct os_eventq callout_wheel_evq;
+
+TEST_CASE_SELF(callout_test_wheel)
+{
+    os_time_t now;
+    os_sr_t sr;
+    int i;
+
+    os_eventq_init(&callout_wheel_evq);
+    for (i = 0; i < CALLOUT_WHEEL_CNT; i++) {
+        os_callout_init(&callout_wheel_c[i], &callout_wheel_evq,
+                        my_callout, NULL);
+    }
+
+    /* Keep the time from moving while the callouts are checked. */
+    OS_ENTER_CRITICAL(sr);
+    now = os_time_get();
+
+    /* Arm the latest first, so that each one is the new earliest. */
+    for (i = CALLOUT_WHEEL_CNT - 1; i >= 0; i--) {
+        os_callout_reset(&callout_wheel_c[i], callout_wheel_ticks[i]);
+        TEST_ASSERT(os_callout_queued(&callout_wheel_c[i]));
+        TEST_ASSERT(os_callout_remaining_ticks(&callout_wheel_c[i], now) ==
+                    callout_wheel_ticks[i]);
+        TEST_ASSERT(os_callout_wakeup_ticks(now) == callout_wheel_ticks[i]);
+    }
+
+    /* Stop the earliest one at a time. */
+    for (i = 0; i < CALLOUT_WHEEL_CNT; i++) {
+        TEST_ASSERT(os_callout_wakeup_ticks(now) == callout_wheel_ticks[i]);
+        os_callout_stop(&callout_wheel_c[i]);
+        TEST_ASSERT(!os_callout_queued(&callout_wheel_c[i]));
+    }
+    TEST_ASSERT(os_callout_wakeup_ticks(now) == OS_TIMEOUT_NEVER);
+
+    /* Rearm in order and stop from the latest. */
+    for (i = 0; i < CALLOUT_WHEEL_CNT; i++) {
+        os_callout_reset(&callout_wheel_c[i], callout_wheel_ticks[i]);
+        TEST_ASSERT(os_callout_wakeup_ticks(now) == callout_wheel_ticks[0]);
+    }
+    for (i = CALLOUT_WHEEL_CNT - 1; i >= 0; i--) {
+        TEST_ASSERT(os_callout_wakeup_ticks(now) == callout_wheel_ticks[0]);
+        os_callout_stop(&callout_wheel_c[i]);
+    }
+    TEST_ASSERT(os_callout_wakeup_ticks(now) == OS_TIMEOUT_NEVER);
+    OS_EXIT_CRITICAL(sr);
+}
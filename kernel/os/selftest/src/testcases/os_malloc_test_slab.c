@@ -0,0 +1,180 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+#define OMTS_CLASSES    MYNEWT_VAL(OS_MALLOC_SLAB_CLASSES)
+#define OMTS_MIN_SIZE   MYNEWT_VAL(OS_MALLOC_SLAB_MIN_SIZE)
+#define OMTS_BLOCKS     MYNEWT_VAL(OS_MALLOC_SLAB_BLOCKS)
+#else
+#define OMTS_CLASSES    4
+#define OMTS_MIN_SIZE   16
+#define OMTS_BLOCKS     16
+#endif
+
+#define OMTS_MAX_SIZE   (OMTS_MIN_SIZE << (OMTS_CLASSES - 1))
+
+/* Every class, and then some from the heap. */
+#define OMTS_PTRS       (OMTS_CLASSES * OMTS_BLOCKS + 8)
+
+static uint8_t *omts_ptrs[OMTS_PTRS];
+static size_t omts_sizes[OMTS_PTRS];
+
+static void
+omts_fill(uint8_t *p, size_t size, int seed)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        p[i] = (uint8_t)(seed + i);
+    }
+}
+
+static int
+omts_check(const uint8_t *p, size_t size, int seed)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        if (p[i] != (uint8_t)(seed + i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Allocates blocks of every size up to twice the largest class, until the
+ * classes are exhausted and requests go to the heap, and checks that none
+ * of them overlap or are corrupted.
+ */
+static void
+omts_alloc_all(void)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < OMTS_PTRS; i++) {
+        omts_sizes[i] = 1 + (i * 7) % (OMTS_MAX_SIZE * 2);
+        omts_ptrs[i] = os_malloc(omts_sizes[i]);
+        TEST_ASSERT_FATAL(omts_ptrs[i] != NULL);
+        TEST_ASSERT(((uintptr_t)omts_ptrs[i] & (OS_ALIGNMENT - 1)) == 0);
+        omts_fill(omts_ptrs[i], omts_sizes[i], i);
+    }
+    for (i = 0; i < OMTS_PTRS; i++) {
+        TEST_ASSERT(omts_check(omts_ptrs[i], omts_sizes[i], i));
+        for (j = i + 1; j < OMTS_PTRS; j++) {
+            TEST_ASSERT(omts_ptrs[i] + omts_sizes[i] <= omts_ptrs[j] ||
+                        omts_ptrs[j] + omts_sizes[j] <= omts_ptrs[i]);
+        }
+    }
+}
+
+static void
+omts_free_all(void)
+{
+    int i;
+
+    for (i = 0; i < OMTS_PTRS; i++) {
+        os_free(omts_ptrs[i]);
+        omts_ptrs[i] = NULL;
+    }
+}
+
+TEST_CASE_SELF(os_malloc_test_slab)
+{
+    uint8_t *first[OMTS_BLOCKS];
+    uint8_t *again[OMTS_BLOCKS];
+    uint8_t *p;
+    uint8_t *q;
+    int found;
+    int i;
+    int j;
+
+    /* Freed blocks can be allocated again, as many times as needed. */
+    for (i = 0; i < 3; i++) {
+        omts_alloc_all();
+        omts_free_all();
+    }
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    /*
+     * Blocks of the smallest class are handed out again once freed.
+     */
+    for (i = 0; i < OMTS_BLOCKS; i++) {
+        first[i] = os_malloc(OMTS_MIN_SIZE);
+        TEST_ASSERT_FATAL(first[i] != NULL);
+    }
+    for (i = 0; i < OMTS_BLOCKS; i++) {
+        os_free(first[i]);
+    }
+    for (i = 0; i < OMTS_BLOCKS; i++) {
+        p = os_malloc(OMTS_MIN_SIZE);
+        TEST_ASSERT_FATAL(p != NULL);
+        found = 0;
+        for (j = 0; j < OMTS_BLOCKS; j++) {
+            if (first[j] == p) {
+                found = 1;
+            }
+        }
+        TEST_ASSERT(found);
+        again[i] = p;
+    }
+    for (i = 0; i < OMTS_BLOCKS; i++) {
+        os_free(again[i]);
+    }
+#endif
+
+    /*
+     * Realloc within a block keeps it; growing it through every class and
+     * into the heap keeps the contents; shrinking to nothing frees it.
+     */
+    p = os_malloc(1);
+    TEST_ASSERT_FATAL(p != NULL);
+    omts_fill(p, 1, 0);
+    q = os_realloc(p, OMTS_MIN_SIZE);
+    TEST_ASSERT_FATAL(q != NULL);
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    TEST_ASSERT(q == p);
+#endif
+    p = q;
+    omts_fill(p, OMTS_MIN_SIZE, 0);
+    for (i = OMTS_MIN_SIZE * 2; i <= OMTS_MAX_SIZE * 4; i *= 2) {
+        q = os_realloc(p, i);
+        TEST_ASSERT_FATAL(q != NULL);
+        TEST_ASSERT(omts_check(q, i / 2, 0));
+        omts_fill(q, i, 0);
+        p = q;
+    }
+    for (i = OMTS_MAX_SIZE * 2; i >= 1; i /= 2) {
+        q = os_realloc(p, i);
+        TEST_ASSERT_FATAL(q != NULL);
+        TEST_ASSERT(omts_check(q, i, 0));
+        p = q;
+    }
+    q = os_realloc(p, 0);
+    TEST_ASSERT(q == NULL);
+
+    p = os_realloc(NULL, OMTS_MIN_SIZE);
+    TEST_ASSERT_FATAL(p != NULL);
+    os_free(p);
+    os_free(NULL);
+}
@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+static int os_mbuf_test_ext_freed;
+
+static void
+os_mbuf_test_ext_free_cb(struct os_mbuf_ext *ext, void *arg)
+{
+    TEST_ASSERT(arg == os_mbuf_test_data);
+    os_mbuf_test_ext_freed++;
+}
+
+TEST_CASE_SELF(os_mbuf_test_ext)
+{
+    struct os_mbuf_ext ext;
+    struct os_mbuf *om;
+    struct os_mbuf *dup;
+    struct os_mbuf *ref;
+    uint16_t num_free;
+    int rc;
+
+    os_mbuf_test_setup();
+    os_mbuf_test_ext_freed = 0;
+    num_free = os_mbuf_mempool.mp_num_free;
+
+    /* Reference a buffer larger than any single mbuf. */
+    os_mbuf_ext_init(&ext, os_mbuf_test_data, 600, os_mbuf_test_ext_free_cb,
+                     os_mbuf_test_data);
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 10);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ref = os_mbuf_get_ext(&os_mbuf_pool, &ext, 10, 590);
+    TEST_ASSERT_FATAL(ref != NULL);
+    TEST_ASSERT(OS_MBUF_IS_EXT(ref));
+    TEST_ASSERT(os_mbuf_to_ext(ref) == &ext);
+    TEST_ASSERT(os_mbuf_to_ext(om) == NULL);
+    TEST_ASSERT(OS_MBUF_LEADINGSPACE(ref) == 0);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(ref) == 0);
+    TEST_ASSERT(ext.ome_refcnt == 2);
+    os_mbuf_concat(om, ref);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 600);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data, 600) == 0);
+
+    /* Out of range slices are rejected. */
+    TEST_ASSERT(os_mbuf_get_ext(&os_mbuf_pool, &ext, 100, 501) == NULL);
+
+    /* Duplicating the chain shares the external data. */
+    dup = os_mbuf_dup(om);
+    TEST_ASSERT_FATAL(dup != NULL);
+    TEST_ASSERT(ext.ome_refcnt == 3);
+    TEST_ASSERT(OS_MBUF_PKTLEN(dup) == 600);
+    TEST_ASSERT(SLIST_NEXT(dup, om_next)->om_data ==
+                SLIST_NEXT(om, om_next)->om_data);
+    TEST_ASSERT(os_mbuf_cmpf(dup, 0, os_mbuf_test_data, 600) == 0);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == num_free - 4);
+
+    /* Appending data after an external mbuf allocates a new mbuf. */
+    rc = os_mbuf_append(dup, os_mbuf_test_data + 600, 20);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(OS_MBUF_PKTLEN(dup) == 620);
+    TEST_ASSERT(os_mbuf_cmpf(dup, 0, os_mbuf_test_data, 620) == 0);
+
+    /* Reference a slice spanning both internal and external data. */
+    ref = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(ref != NULL);
+    rc = os_mbuf_appendref(ref, dup, 5, 610);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(OS_MBUF_PKTLEN(ref) == 610);
+    TEST_ASSERT(ext.ome_refcnt == 4);
+    TEST_ASSERT(os_mbuf_cmpf(ref, 0, os_mbuf_test_data + 5, 610) == 0);
+
+    rc = os_mbuf_appendref(ref, dup, 600, 21);
+    TEST_ASSERT(rc == OS_EINVAL);
+
+    /* Shared external data is never overwritten in place; internal data in
+     * front of it still is.
+     */
+    rc = os_mbuf_copyinto(ref, 0, os_mbuf_test_data + 100, 10);
+    TEST_ASSERT(rc == OS_EINVAL);
+    TEST_ASSERT(os_mbuf_cmpf(ref, 0, os_mbuf_test_data + 5, 610) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data, 600) == 0);
+    rc = os_mbuf_copyinto(om, 0, os_mbuf_test_data + 100, 10);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data + 100, 10) == 0);
+    rc = os_mbuf_copyinto(om, 5, os_mbuf_test_data, 10);
+    TEST_ASSERT(rc == OS_EINVAL);
+
+    /* The buffer is released only when the last reference is dropped. */
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_free_chain(dup);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ext.ome_refcnt == 2);
+
+    os_mbuf_ext_release(&ext);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 0);
+
+    rc = os_mbuf_free_chain(ref);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ext.ome_refcnt == 0);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 1);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == num_free);
+}
@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define MEMPOOL_TEST_MAG_CAP    4
+
+static void
+os_mempool_test_mag_pool(struct os_mempool *mp)
+{
+    void *mag_blocks[MEMPOOL_TEST_MAG_CAP];
+    struct os_mempool_mag mag;
+    int rc;
+    int i;
+
+    rc = os_mempool_mag_init(&mag, mp, mag_blocks, 1);
+    TEST_ASSERT(rc == OS_INVALID_PARM);
+
+    rc = os_mempool_mag_init(&mag, mp, mag_blocks, MEMPOOL_TEST_MAG_CAP);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* The first get refills half the magazine. */
+    block_array[0] = os_memblock_mag_get(&mag);
+    TEST_ASSERT_FATAL(block_array[0] != NULL);
+    TEST_ASSERT(mag.mm_cnt == MEMPOOL_TEST_MAG_CAP / 2 - 1);
+    TEST_ASSERT(mp->mp_num_free == NUM_MEM_BLOCKS - MEMPOOL_TEST_MAG_CAP / 2);
+
+    /* Drain the pool completely through the magazine. */
+    for (i = 1; i < NUM_MEM_BLOCKS; i++) {
+        block_array[i] = os_memblock_mag_get(&mag);
+        TEST_ASSERT_FATAL(block_array[i] != NULL);
+        TEST_ASSERT(os_memblock_from(mp, block_array[i]));
+    }
+    TEST_ASSERT(os_memblock_mag_get(&mag) == NULL);
+    TEST_ASSERT(mp->mp_num_free == 0);
+
+    /* Once full, the magazine spills half of its blocks to the pool. */
+    for (i = 0; i < NUM_MEM_BLOCKS; i++) {
+        rc = os_memblock_mag_put(&mag, block_array[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(mag.mm_cnt <= MEMPOOL_TEST_MAG_CAP);
+    }
+    TEST_ASSERT(mp->mp_num_free + mag.mm_cnt == NUM_MEM_BLOCKS);
+
+    os_mempool_mag_flush(&mag);
+    TEST_ASSERT(mag.mm_cnt == 0);
+    TEST_ASSERT(mp->mp_num_free == NUM_MEM_BLOCKS);
+    TEST_ASSERT(os_mempool_is_sane(mp));
+}
+
+TEST_CASE_SELF(os_mempool_test_mag)
+{
+    int rc;
+
+    os_mempool_unregister(&g_TstMempool);
+    rc = os_mempool_init(&g_TstMempool, NUM_MEM_BLOCKS, MEM_BLOCK_SIZE,
+                         &TstMembuf[0], "TestMemPool");
+    TEST_ASSERT_FATAL(rc == 0);
+    os_mempool_test_mag_pool(&g_TstMempool);
+    os_mempool_unregister(&g_TstMempool);
+
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    rc = os_mempool_lockfree_init(&g_TstMempool, NUM_MEM_BLOCKS,
+                                  MEM_BLOCK_SIZE, &TstMembuf[0],
+                                  "TestMemPool");
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(g_TstMempool.mp_flags & OS_MEMPOOL_F_LOCKFREE);
+    TEST_ASSERT(os_mempool_is_sane(&g_TstMempool));
+    os_mempool_test_mag_pool(&g_TstMempool);
+
+    rc = os_mempool_clear(&g_TstMempool);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(os_mempool_is_sane(&g_TstMempool));
+    os_mempool_unregister(&g_TstMempool);
+#endif
+}
@@ -26,8 +26,318 @@
 #include "os/mynewt.h"
 #include "os_priv.h"
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+
+/*
+ * Hierarchical timing wheel.  Level 0 has one slot per tick; each slot of
+ * level n covers as many ticks as the whole level n - 1.  A callout is
+ * placed on the lowest level whose span covers its expiry.  When the wheel
+ * reaches the start of a higher level slot, that slot's callouts are
+ * "cascaded", i.e., reinserted relative to the current time, which moves them
+ * to lower levels.  Callouts too far in the future for the wheel are kept on
+ * an unsorted overflow list which is cascaded once per wheel revolution.
+ *
+ * Slots are NULL-terminated doubly linked lists threaded through the
+ * callouts' c_next entries: tqe_prev points to the previous callout's
+ * tqe_next or to the slot head.  This allows a callout to be unlinked in
+ * constant time without knowing which slot it is on.
+ */
+#define OS_CALLOUT_WHEEL_BITS   MYNEWT_VAL(OS_CALLOUT_WHEEL_SLOT_BITS)
+#define OS_CALLOUT_WHEEL_SLOTS  (1 << OS_CALLOUT_WHEEL_BITS)
+#define OS_CALLOUT_WHEEL_MASK   (OS_CALLOUT_WHEEL_SLOTS - 1)
+#define OS_CALLOUT_WHEEL_LEVELS MYNEWT_VAL(OS_CALLOUT_WHEEL_LEVELS)
+
+#define OS_CALLOUT_WHEEL_IDX(ticks, level) \
+    (((ticks) >> ((level) * OS_CALLOUT_WHEEL_BITS)) & OS_CALLOUT_WHEEL_MASK)
+
+#if OS_CALLOUT_WHEEL_BITS < 1 || OS_CALLOUT_WHEEL_BITS > 6
+#error "OS_CALLOUT_WHEEL_SLOT_BITS must be between 1 and 6"
+#endif
+
+#if OS_CALLOUT_WHEEL_LEVELS < 1 || \
+    OS_CALLOUT_WHEEL_LEVELS * OS_CALLOUT_WHEEL_BITS > 31
+#error "Invalid OS_CALLOUT_WHEEL_LEVELS"
+#endif
+
+struct os_callout_wheel {
+    /** Last tick processed by the wheel. */
+    os_time_t cw_now;
+    /** Number of callouts in the wheel. */
+    uint32_t cw_count;
+    /** Per level bitmap of non-empty slots. */
+    uint64_t cw_occupied[OS_CALLOUT_WHEEL_LEVELS];
+    /** Slot list heads. */
+    struct os_callout *cw_slots[OS_CALLOUT_WHEEL_LEVELS][OS_CALLOUT_WHEEL_SLOTS];
+    /** Callouts beyond the span of the top level. */
+    struct os_callout *cw_overflow;
+};
+
+static struct os_callout_wheel g_callout_wheel;
+
+static void
+os_callout_slot_insert(struct os_callout **head, struct os_callout *c)
+{
+    c->c_next.tqe_next = *head;
+    if (*head != NULL) {
+        (*head)->c_next.tqe_prev = &c->c_next.tqe_next;
+    }
+    *head = c;
+    c->c_next.tqe_prev = head;
+}
+
+static void
+os_callout_wheel_remove(struct os_callout *c)
+{
+    struct os_callout_wheel *cw;
+    struct os_callout **prev;
+    struct os_callout *next;
+    uint32_t slot;
+
+    cw = &g_callout_wheel;
+
+    prev = c->c_next.tqe_prev;
+    next = c->c_next.tqe_next;
+    if (next != NULL) {
+        next->c_next.tqe_prev = prev;
+    }
+    *prev = next;
+    c->c_next.tqe_prev = NULL;
+
+    /* If the callout was the only entry on a slot, the slot is now empty. */
+    if (*prev == NULL && prev >= &cw->cw_slots[0][0] &&
+        prev < &cw->cw_slots[0][0] +
+               OS_CALLOUT_WHEEL_LEVELS * OS_CALLOUT_WHEEL_SLOTS) {
+
+        slot = prev - &cw->cw_slots[0][0];
+        cw->cw_occupied[slot / OS_CALLOUT_WHEEL_SLOTS] &=
+            ~(1ULL << (slot % OS_CALLOUT_WHEEL_SLOTS));
+    }
+
+    cw->cw_count--;
+}
+
+static void
+os_callout_wheel_insert(struct os_callout *c)
+{
+    struct os_callout_wheel *cw;
+    os_stime_t delta;
+    os_time_t slot_ticks;
+    int level;
+    int idx;
+
+    cw = &g_callout_wheel;
+
+    slot_ticks = c->c_ticks;
+    delta = c->c_ticks - cw->cw_now;
+    if (delta < 0) {
+        /* Already expired; fire on the next processed tick.  c_ticks is left
+         * as set so remaining-time queries still see the callout as due.
+         */
+        slot_ticks = cw->cw_now + 1;
+        delta = 1;
+    }
+
+    cw->cw_count++;
+
+    for (level = 0; level < OS_CALLOUT_WHEEL_LEVELS; level++) {
+        if ((os_time_t)delta <
+            (1UL << ((level + 1) * OS_CALLOUT_WHEEL_BITS))) {
+            idx = OS_CALLOUT_WHEEL_IDX(slot_ticks, level);
+            os_callout_slot_insert(&cw->cw_slots[level][idx], c);
+            cw->cw_occupied[level] |= 1ULL << idx;
+            return;
+        }
+    }
+
+    os_callout_slot_insert(&cw->cw_overflow, c);
+}
+
+/**
+ * Reinserts every callout on a list relative to the wheel's current time.
+ * The list is emptied first since callouts may land back on it (e.g., the
+ * overflow list).
+ */
+static void
+os_callout_wheel_cascade(struct os_callout **head)
+{
+    struct os_callout *list;
+    struct os_callout *c;
+
+    list = NULL;
+    while ((c = *head) != NULL) {
+        os_callout_wheel_remove(c);
+        os_callout_slot_insert(&list, c);
+    }
+
+    while ((c = list) != NULL) {
+        list = c->c_next.tqe_next;
+        os_callout_wheel_insert(c);
+    }
+}
+
+/**
+ * Moves the wheel forward by one tick, cascading higher level slots as their
+ * start is reached.
+ */
+static void
+os_callout_wheel_step(void)
+{
+    struct os_callout_wheel *cw;
+    int level;
+    int idx;
+
+    cw = &g_callout_wheel;
+    cw->cw_now++;
+
+    for (level = 1; level < OS_CALLOUT_WHEEL_LEVELS; level++) {
+        if (OS_CALLOUT_WHEEL_IDX(cw->cw_now, level - 1) != 0) {
+            return;
+        }
+
+        idx = OS_CALLOUT_WHEEL_IDX(cw->cw_now, level);
+        os_callout_wheel_cascade(&cw->cw_slots[level][idx]);
+    }
+
+    if (OS_CALLOUT_WHEEL_IDX(cw->cw_now, OS_CALLOUT_WHEEL_LEVELS - 1) == 0) {
+        os_callout_wheel_cascade(&cw->cw_overflow);
+    }
+}
+
+/**
+ * Returns the first tick after the wheel's current position at which a
+ * non-empty slot gets processed, i.e., its callouts expire (level 0) or are
+ * cascaded (higher levels).  Ticks in between can be skipped.
+ */
+static os_time_t
+os_callout_wheel_next(void)
+{
+    struct os_callout_wheel *cw;
+    os_time_t span;
+    os_time_t next;
+    os_time_t t;
+    uint64_t occupied;
+    uint64_t later;
+    bool found;
+    int level;
+    int start;
+    int idx;
+
+    cw = &g_callout_wheel;
+    found = false;
+    next = 0;
+
+    for (level = 0; level < OS_CALLOUT_WHEEL_LEVELS; level++) {
+        occupied = cw->cw_occupied[level];
+        if (occupied == 0) {
+            continue;
+        }
+
+        start = (OS_CALLOUT_WHEEL_IDX(cw->cw_now, level) + 1) &
+                OS_CALLOUT_WHEEL_MASK;
+        later = occupied & ~((1ULL << start) - 1);
+        idx = __builtin_ctzll(later != 0 ? later : occupied);
+
+        span = 1UL << ((level + 1) * OS_CALLOUT_WHEEL_BITS);
+        t = (cw->cw_now & ~(span - 1)) |
+            ((os_time_t)idx << (level * OS_CALLOUT_WHEEL_BITS));
+        if (!OS_TIME_TICK_GT(t, cw->cw_now)) {
+            t += span;
+        }
+
+        if (!found || OS_TIME_TICK_LT(t, next)) {
+            next = t;
+            found = true;
+        }
+    }
+
+    if (cw->cw_overflow != NULL) {
+        span = 1UL << (OS_CALLOUT_WHEEL_LEVELS * OS_CALLOUT_WHEEL_BITS);
+        t = (cw->cw_now & ~(span - 1)) + span;
+        if (!found || OS_TIME_TICK_LT(t, next)) {
+            next = t;
+        }
+    }
+
+    return next;
+}
+
+/**
+ * Advances the wheel up to the specified time, stopping at the first
+ * expired callout.  The callout is removed from the wheel.
+ *
+ * @return The expired callout, or NULL if none expired by 'now'.
+ */
+static struct os_callout *
+os_callout_wheel_expire(os_time_t now)
+{
+    struct os_callout_wheel *cw;
+    struct os_callout *c;
+    os_time_t next;
+
+    cw = &g_callout_wheel;
+
+    while (1) {
+        if (cw->cw_count == 0) {
+            if (OS_TIME_TICK_LT(cw->cw_now, now)) {
+                cw->cw_now = now;
+            }
+            return NULL;
+        }
+
+        c = cw->cw_slots[0][OS_CALLOUT_WHEEL_IDX(cw->cw_now, 0)];
+        if (c != NULL) {
+            os_callout_wheel_remove(c);
+            return c;
+        }
+
+        if (OS_TIME_TICK_GEQ(cw->cw_now, now)) {
+            return NULL;
+        }
+
+        /* Jump straight to the next tick with any work to do. */
+        next = os_callout_wheel_next();
+        if (OS_TIME_TICK_GT(next, now)) {
+            cw->cw_now = now;
+            return NULL;
+        }
+
+        cw->cw_now = next - 1;
+        os_callout_wheel_step();
+    }
+}
+
+/**
+ * Finds the earliest expiry among the callouts on a list.
+ */
+static void
+os_callout_wheel_min(struct os_callout *c, os_time_t *best, bool *found)
+{
+    for (; c != NULL; c = c->c_next.tqe_next) {
+        if (!*found || OS_TIME_TICK_LT(c->c_ticks, *best)) {
+            *best = c->c_ticks;
+            *found = true;
+        }
+    }
+}
+
+void
+os_callout_module_init(void)
+{
+    memset(&g_callout_wheel, 0, sizeof(g_callout_wheel));
+}
+
+#else
+
 struct os_callout_list g_callout_list;
 
+void
+os_callout_module_init(void)
+{
+    TAILQ_INIT(&g_callout_list);
+}
+
+#endif
+
 void os_callout_init(struct os_callout *c, struct os_eventq *evq,
                      os_event_fn *ev_cb, void *ev_arg)
 {
@@ -51,8 +361,12 @@ os_callout_stop(struct os_callout *c)
     OS_ENTER_CRITICAL(sr);
 
     if (os_callout_queued(c)) {
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+        os_callout_wheel_remove(c);
+#else
         TAILQ_REMOVE(&g_callout_list, c, c_next);
         c->c_next.tqe_prev = NULL;
+#endif
     }
 
     if (c->c_evq) {
@@ -67,7 +381,9 @@ os_callout_stop(struct os_callout *c)
 int
 os_callout_reset(struct os_callout *c, os_time_t ticks)
 {
+#if !MYNEWT_VAL(OS_CALLOUT_WHEEL)
     struct os_callout *entry;
+#endif
     os_sr_t sr;
     int ret;
 
@@ -91,6 +407,15 @@ os_callout_reset(struct os_callout *c, os_time_t ticks)
 
     c->c_ticks = os_time_get() + ticks;
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    if (g_callout_wheel.cw_count == 0) {
+        /* Nothing is pending, so there is no need to replay the ticks that
+         * elapsed since the wheel last ran.
+         */
+        g_callout_wheel.cw_now = c->c_ticks - ticks;
+    }
+    os_callout_wheel_insert(c);
+#else
     entry = NULL;
     TAILQ_FOREACH(entry, &g_callout_list, c_next) {
         if (OS_TIME_TICK_LT(c->c_ticks, entry->c_ticks)) {
@@ -103,6 +428,7 @@ os_callout_reset(struct os_callout *c, os_time_t ticks)
     } else {
         TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
     }
+#endif
 
     OS_EXIT_CRITICAL(sr);
 
@@ -133,6 +459,9 @@ os_callout_tick(void)
 
     while (1) {
         OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+        c = os_callout_wheel_expire(now);
+#else
         c = TAILQ_FIRST(&g_callout_list);
         if (c) {
             if (OS_TIME_TICK_GEQ(now, c->c_ticks)) {
@@ -142,6 +471,7 @@ os_callout_tick(void)
                 c = NULL;
             }
         }
+#endif
         OS_EXIT_CRITICAL(sr);
 
         if (c) {
@@ -166,6 +496,61 @@ os_callout_tick(void)
  *
  * @return Number of ticks to first pending callout
  */
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+os_time_t
+os_callout_wakeup_ticks(os_time_t now)
+{
+    struct os_callout_wheel *cw;
+    os_time_t first;
+    uint64_t occupied;
+    uint64_t later;
+    bool found;
+    int level;
+    int start;
+    int idx;
+
+    OS_ASSERT_CRITICAL();
+
+    cw = &g_callout_wheel;
+    if (cw->cw_count == 0) {
+        return OS_TIMEOUT_NEVER;
+    }
+
+    /* On each level, the first non-empty slot following the wheel's
+     * position holds that level's earliest callouts.  Level 0 starts at the
+     * current slot since it may still hold callouts due now.
+     */
+    found = false;
+    for (level = 0; level < OS_CALLOUT_WHEEL_LEVELS; level++) {
+        occupied = cw->cw_occupied[level];
+        if (occupied == 0) {
+            continue;
+        }
+
+        start = OS_CALLOUT_WHEEL_IDX(cw->cw_now, level);
+        if (level != 0) {
+            start = (start + 1) & OS_CALLOUT_WHEEL_MASK;
+        }
+
+        later = occupied & ~((1ULL << start) - 1);
+        if (later != 0) {
+            idx = __builtin_ctzll(later);
+        } else {
+            idx = __builtin_ctzll(occupied);
+        }
+
+        os_callout_wheel_min(cw->cw_slots[level][idx], &first, &found);
+    }
+    os_callout_wheel_min(cw->cw_overflow, &first, &found);
+
+    assert(found);
+    if (OS_TIME_TICK_GEQ(first, now)) {
+        return first - now;
+    } else {
+        return 0;       /* callout time is in the past */
+    }
+}
+#else
 os_time_t
 os_callout_wakeup_ticks(os_time_t now)
 {
@@ -187,6 +572,7 @@ os_callout_wakeup_ticks(os_time_t now)
 
     return (rt);
 }
+#endif
 
 
 os_time_t
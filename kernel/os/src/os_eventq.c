@@ -27,6 +27,31 @@
 
 static struct os_eventq os_eventq_main;
 
+/**
+ * Removes the first event from an event queue.  Must be called with
+ * interrupts disabled.
+ *
+ * @return The removed event, or NULL if the queue is empty.
+ */
+static struct os_event *
+os_eventq_pop(struct os_eventq *evq)
+{
+    struct os_event *ev;
+
+    ev = STAILQ_FIRST(&evq->evq_list);
+    if (ev) {
+        STAILQ_REMOVE_HEAD(&evq->evq_list, ev_next);
+        ev->ev_queued = 0;
+#if MYNEWT_VAL(OS_EVENTQ_URGENT)
+        if (evq->evq_urgent_last == ev) {
+            evq->evq_urgent_last = NULL;
+        }
+#endif
+    }
+
+    return ev;
+}
+
 void
 os_eventq_init(struct os_eventq *evq)
 {
@@ -40,8 +65,8 @@ os_eventq_inited(const struct os_eventq *evq)
     return evq->evq_list.stqh_last != NULL;
 }
 
-void
-os_eventq_put(struct os_eventq *evq, struct os_event *ev)
+static void
+os_eventq_put_priv(struct os_eventq *evq, struct os_event *ev, int urgent)
 {
     int resched;
     os_sr_t sr;
@@ -61,7 +86,23 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
 
     /* Queue the event */
     ev->ev_queued = 1;
-    STAILQ_INSERT_TAIL(&evq->evq_list, ev, ev_next);
+#if MYNEWT_VAL(OS_EVENTQ_URGENT)
+    if (urgent) {
+        /* Urgent events go after the urgent events already queued, but
+         * before all regular ones.
+         */
+        if (evq->evq_urgent_last != NULL) {
+            STAILQ_INSERT_AFTER(&evq->evq_list, evq->evq_urgent_last, ev,
+                                ev_next);
+        } else {
+            STAILQ_INSERT_HEAD(&evq->evq_list, ev, ev_next);
+        }
+        evq->evq_urgent_last = ev;
+    } else
+#endif
+    {
+        STAILQ_INSERT_TAIL(&evq->evq_list, ev, ev_next);
+    }
 
     resched = 0;
     if (evq->evq_task) {
@@ -88,6 +129,20 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
     os_trace_api_ret(OS_TRACE_ID_EVENTQ_PUT);
 }
 
+void
+os_eventq_put(struct os_eventq *evq, struct os_event *ev)
+{
+    os_eventq_put_priv(evq, ev, 0);
+}
+
+#if MYNEWT_VAL(OS_EVENTQ_URGENT)
+void
+os_eventq_put_urgent(struct os_eventq *evq, struct os_event *ev)
+{
+    os_eventq_put_priv(evq, ev, 1);
+}
+#endif
+
 struct os_event *
 os_eventq_get_no_wait(struct os_eventq *evq)
 {
@@ -95,11 +150,7 @@ os_eventq_get_no_wait(struct os_eventq *evq)
 
     os_trace_api_u32(OS_TRACE_ID_EVENTQ_GET_NO_WAIT, (uint32_t)evq);
 
-    ev = STAILQ_FIRST(&evq->evq_list);
-    if (ev) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
-        ev->ev_queued = 0;
-    }
+    ev = os_eventq_pop(evq);
 
     os_trace_api_ret_u32(OS_TRACE_ID_EVENTQ_GET_NO_WAIT, (uint32_t)ev);
 
@@ -129,10 +180,8 @@ os_eventq_get(struct os_eventq *evq)
     }
     OS_ENTER_CRITICAL(sr);
 pull_one:
-    ev = STAILQ_FIRST(&evq->evq_list);
+    ev = os_eventq_pop(evq);
     if (ev) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
-        ev->ev_queued = 0;
         t->t_flags &= ~OS_TASK_FLAG_EVQ_WAIT;
     } else {
         evq->evq_task = t;
@@ -179,16 +228,14 @@ os_eventq_mon_find(struct os_eventq *evq, struct os_event *ev)
 }
 #endif
 
-void
-os_eventq_run(struct os_eventq *evq)
+static void
+os_eventq_dispatch(struct os_eventq *evq, struct os_event *ev)
 {
-    struct os_event *ev;
 #if MYNEWT_VAL(OS_EVENTQ_MONITOR)
     struct os_eventq_mon *mon;
     uint32_t ticks;
 #endif
 
-    ev = os_eventq_get(evq);
     assert(ev->ev_cb != NULL);
 #if MYNEWT_VAL(OS_EVENTQ_MONITOR)
     ticks = os_cputime_get32();
@@ -215,6 +262,52 @@ os_eventq_run(struct os_eventq *evq)
 #endif
 }
 
+void
+os_eventq_run(struct os_eventq *evq)
+{
+    struct os_event *ev;
+
+    ev = os_eventq_get(evq);
+    os_eventq_dispatch(evq, ev);
+}
+
+int
+os_eventq_run_batch(struct os_eventq *evq, int max)
+{
+    struct os_event *ev;
+    os_sr_t sr;
+    int cnt;
+
+    if (max <= 0) {
+        return 0;
+    }
+
+    ev = os_eventq_get(evq);
+    cnt = 0;
+    while (1) {
+        os_eventq_dispatch(evq, ev);
+        if (++cnt >= max) {
+            break;
+        }
+
+        /* Events are dequeued one at a time so that a callback can still
+         * cancel a later event (e.g., by stopping a callout).
+         */
+        OS_ENTER_CRITICAL(sr);
+        ev = os_eventq_pop(evq);
+        OS_EXIT_CRITICAL(sr);
+        if (ev == NULL) {
+            break;
+        }
+
+#if MYNEWT_VAL(OS_EVENTQ_DEBUG)
+        evq->evq_prev = ev;
+#endif
+    }
+
+    return cnt;
+}
+
 static struct os_event *
 os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
 {
@@ -229,10 +322,8 @@ os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
 
     OS_ENTER_CRITICAL(sr);
     for (i = 0; i < nevqs; i++) {
-        ev = STAILQ_FIRST(&evq[i]->evq_list);
+        ev = os_eventq_pop(evq[i]);
         if (ev) {
-            STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-            ev->ev_queued = 0;
             break;
         }
     }
@@ -267,10 +358,8 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
     cur_t = os_sched_get_current_task();
 
     for (i = 0; i < nevqs; i++) {
-        ev = STAILQ_FIRST(&evq[i]->evq_list);
+        ev = os_eventq_pop(evq[i]);
         if (ev) {
-            STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-            ev->ev_queued = 0;
             /* Reset the items that already have an evq task set. */
             for (j = 0; j < i; j++) {
                 evq[j]->evq_task = NULL;
@@ -298,11 +387,7 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
          * we haven't found one.
          */
         if (!ev) {
-            ev = STAILQ_FIRST(&evq[i]->evq_list);
-            if (ev) {
-                STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-                ev->ev_queued = 0;
-            }
+            ev = os_eventq_pop(evq[i]);
         }
         evq[i]->evq_task = NULL;
     }
@@ -317,12 +402,31 @@ has_event:
 void
 os_eventq_remove(struct os_eventq *evq, struct os_event *ev)
 {
+#if MYNEWT_VAL(OS_EVENTQ_URGENT)
+    struct os_event *prev;
+#endif
     os_sr_t sr;
 
     os_trace_api_u32x2(OS_TRACE_ID_EVENTQ_REMOVE, (uint32_t)evq, (uint32_t)ev);
 
     OS_ENTER_CRITICAL(sr);
     if (OS_EVENT_QUEUED(ev)) {
+#if MYNEWT_VAL(OS_EVENTQ_URGENT)
+        if (evq->evq_urgent_last == ev) {
+            /* All events ahead of the last urgent one are urgent too; its
+             * predecessor becomes the new last urgent event.
+             */
+            prev = STAILQ_FIRST(&evq->evq_list);
+            if (prev == ev) {
+                prev = NULL;
+            } else {
+                while (STAILQ_NEXT(prev, ev_next) != ev) {
+                    prev = STAILQ_NEXT(prev, ev_next);
+                }
+            }
+            evq->evq_urgent_last = prev;
+        }
+#endif
         STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
     }
     ev->ev_queued = 0;
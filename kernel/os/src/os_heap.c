@@ -18,12 +18,245 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "os/mynewt.h"
+#include "os_priv.h"
+#if MYNEWT_VAL(OS_MALLOC_SLAB_STATS)
+#include "stats/stats.h"
+#endif
 
 #if MYNEWT_VAL(OS_SCHEDULING)
 static struct os_mutex os_malloc_mutex;
 #endif
 
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+
+/*
+ * Small allocations are served from a set of memory pools, one per size
+ * class.  Class n holds blocks of (OS_MALLOC_SLAB_MIN_SIZE << n) bytes.  A
+ * request goes to the smallest class that fits it; if that class is
+ * exhausted, the next larger classes are tried before falling back to the
+ * libc arena.  Pool operations are interrupt safe on their own, so the slab
+ * path does not take the malloc mutex.  The pools share one buffer, which
+ * makes telling slab blocks from arena blocks a range check.
+ *
+ * Like malloc(), blocks are aligned for any type (OS_MALLOC_SLAB_ALIGN): the
+ * buffer is aligned that way, and each class's block size, including a
+ * mempool guard, is rounded up to a multiple of it.
+ */
+#define OS_MALLOC_SLAB_CLASSES  MYNEWT_VAL(OS_MALLOC_SLAB_CLASSES)
+#define OS_MALLOC_SLAB_MIN_SIZE MYNEWT_VAL(OS_MALLOC_SLAB_MIN_SIZE)
+#define OS_MALLOC_SLAB_BLOCKS   MYNEWT_VAL(OS_MALLOC_SLAB_BLOCKS)
+
+#if OS_MALLOC_SLAB_CLASSES < 1 || OS_MALLOC_SLAB_CLASSES > 8
+#error "OS_MALLOC_SLAB_CLASSES must be between 1 and 8"
+#endif
+
+#if OS_MALLOC_SLAB_MIN_SIZE < OS_ALIGNMENT || \
+    (OS_MALLOC_SLAB_MIN_SIZE & (OS_MALLOC_SLAB_MIN_SIZE - 1)) != 0
+#error "OS_MALLOC_SLAB_MIN_SIZE must be a power of two, at least OS_ALIGNMENT"
+#endif
+
+#define OS_MALLOC_SLAB_ALIGN        8
+
+#define OS_MALLOC_SLAB_SIZE(cls)    (OS_MALLOC_SLAB_MIN_SIZE << (cls))
+
+/* Size passed to os_mempool_init() so that consecutive blocks stay aligned
+ * to OS_MALLOC_SLAB_ALIGN, with or without OS_MEMPOOL_GUARD.
+ */
+#define OS_MALLOC_SLAB_BLOCK_SIZE(cls)                              \
+    (((OS_MEMPOOL_BLOCK_SZ(OS_MALLOC_SLAB_SIZE(cls)) +              \
+       OS_MALLOC_SLAB_ALIGN - 1) & ~(OS_MALLOC_SLAB_ALIGN - 1)) -    \
+     OS_MEMPOOL_BLOCK_SZ(0))
+
+#define OS_MALLOC_SLAB_MEMBUF(cls)                                  \
+    ((cls) < OS_MALLOC_SLAB_CLASSES ?                               \
+     OS_MEMPOOL_SIZE(OS_MALLOC_SLAB_BLOCKS,                         \
+                     OS_MALLOC_SLAB_BLOCK_SIZE(cls)) : 0)
+
+#define OS_MALLOC_SLAB_MEMBUF_TOTAL                                 \
+    (OS_MALLOC_SLAB_MEMBUF(0) + OS_MALLOC_SLAB_MEMBUF(1) +          \
+     OS_MALLOC_SLAB_MEMBUF(2) + OS_MALLOC_SLAB_MEMBUF(3) +          \
+     OS_MALLOC_SLAB_MEMBUF(4) + OS_MALLOC_SLAB_MEMBUF(5) +          \
+     OS_MALLOC_SLAB_MEMBUF(6) + OS_MALLOC_SLAB_MEMBUF(7))
+
+static os_membuf_t os_malloc_slab_buf[OS_MALLOC_SLAB_MEMBUF_TOTAL]
+    __attribute__((aligned(OS_MALLOC_SLAB_ALIGN)));
+static struct os_mempool os_malloc_slab_pools[OS_MALLOC_SLAB_CLASSES];
+static bool os_malloc_slab_ready;
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB_STATS)
+STATS_SECT_START(os_malloc_stats)
+    STATS_SECT_ENTRY(slab_allocs)
+    STATS_SECT_ENTRY(slab_frees)
+    STATS_SECT_ENTRY(arena_allocs)
+    STATS_SECT_ENTRY(arena_frees)
+    STATS_SECT_ENTRY(class_full)
+    STATS_SECT_ENTRY(alloc_fails)
+    STATS_SECT_ENTRY(slab_waste_total)
+    STATS_SECT_ENTRY(alloc_time_max)
+STATS_SECT_END
+
+STATS_NAME_START(os_malloc_stats)
+    STATS_NAME(os_malloc_stats, slab_allocs)
+    STATS_NAME(os_malloc_stats, slab_frees)
+    STATS_NAME(os_malloc_stats, arena_allocs)
+    STATS_NAME(os_malloc_stats, arena_frees)
+    STATS_NAME(os_malloc_stats, class_full)
+    STATS_NAME(os_malloc_stats, alloc_fails)
+    STATS_NAME(os_malloc_stats, slab_waste_total)
+    STATS_NAME(os_malloc_stats, alloc_time_max)
+STATS_NAME_END(os_malloc_stats)
+
+static STATS_SECT_DECL(os_malloc_stats) os_malloc_stats;
+
+/* Longest allocation, in os_cputime ticks. */
+static uint32_t os_malloc_time_max;
+
+#define OS_MALLOC_STATS_INC(var) do {                               \
+    os_sr_t sr_;                                                    \
+                                                                    \
+    OS_ENTER_CRITICAL(sr_);                                         \
+    STATS_INC(os_malloc_stats, var);                                \
+    OS_EXIT_CRITICAL(sr_);                                          \
+} while (0)
+
+/**
+ * Records the time taken by an allocation and, for slab allocations, the
+ * number of bytes lost to rounding the request up to the class size.  A
+ * freed block does not know the size it was requested with, so
+ * slab_waste_total adds up the waste of all slab allocations since boot,
+ * not of those currently allocated.
+ */
+static void
+os_malloc_stats_alloc(uint32_t start, size_t waste)
+{
+    uint32_t ticks;
+    os_sr_t sr;
+
+    ticks = os_cputime_get32() - start;
+
+    OS_ENTER_CRITICAL(sr);
+    STATS_INCN(os_malloc_stats, slab_waste_total, waste);
+    if (ticks > os_malloc_time_max) {
+        /* Stats can only be incremented; raise the maximum by the
+         * difference.
+         */
+        STATS_INCN(os_malloc_stats, alloc_time_max,
+                   ticks - os_malloc_time_max);
+        os_malloc_time_max = ticks;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+os_malloc_stats_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = stats_init_and_reg(STATS_HDR(os_malloc_stats),
+                            STATS_SIZE_INIT_PARMS(os_malloc_stats,
+                                                  STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(os_malloc_stats),
+                            "os_malloc");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+#else
+#define OS_MALLOC_STATS_INC(var)
+#endif
+
+void
+os_malloc_module_init(void)
+{
+    uint32_t off;
+    int rc;
+    int i;
+
+    off = 0;
+    for (i = 0; i < OS_MALLOC_SLAB_CLASSES; i++) {
+        rc = os_mempool_init(&os_malloc_slab_pools[i], OS_MALLOC_SLAB_BLOCKS,
+                             OS_MALLOC_SLAB_BLOCK_SIZE(i),
+                             &os_malloc_slab_buf[off],
+                             "os_malloc_slab");
+        assert(rc == 0);
+        off += OS_MALLOC_SLAB_MEMBUF(i);
+    }
+
+    os_malloc_slab_ready = true;
+}
+
+/**
+ * Returns the size class of a slab block, or -1 if the pointer was not
+ * allocated from the slab.
+ */
+static int
+os_malloc_slab_class(const void *ptr)
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    int i;
+
+    p = ptr;
+    end = (const uint8_t *)os_malloc_slab_buf;
+    if (p < end || p >= end + sizeof(os_malloc_slab_buf)) {
+        return -1;
+    }
+
+    for (i = 0; i < OS_MALLOC_SLAB_CLASSES; i++) {
+        end += OS_MALLOC_SLAB_MEMBUF(i) * sizeof(os_membuf_t);
+        if (p < end) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * Allocates from the smallest size class that fits and has a free block.
+ *
+ * @param size                  The number of bytes to allocate.
+ * @param out_waste             On success, the number of bytes the request
+ *                                  was rounded up by is written here.
+ *
+ * @return The allocated block, or NULL if the request must go to the arena.
+ */
+static void *
+os_malloc_slab_get(size_t size, size_t *out_waste)
+{
+    void *ptr;
+    int cls;
+
+    if (!os_malloc_slab_ready || size == 0 ||
+        size > OS_MALLOC_SLAB_SIZE(OS_MALLOC_SLAB_CLASSES - 1)) {
+        return NULL;
+    }
+
+    if (size <= OS_MALLOC_SLAB_MIN_SIZE) {
+        cls = 0;
+    } else {
+        /* Number of bits in (size - 1), less those of the minimum size. */
+        cls = 32 - __builtin_clz(size - 1) -
+              __builtin_ctz(OS_MALLOC_SLAB_MIN_SIZE);
+    }
+
+    for (; cls < OS_MALLOC_SLAB_CLASSES; cls++) {
+        ptr = os_memblock_get(&os_malloc_slab_pools[cls]);
+        if (ptr != NULL) {
+            *out_waste = OS_MALLOC_SLAB_SIZE(cls) - size;
+            return ptr;
+        }
+        OS_MALLOC_STATS_INC(class_full);
+    }
+
+    return NULL;
+}
+
+#endif
+
 static void
 os_malloc_lock(void)
 {
@@ -54,17 +287,61 @@ void *
 os_malloc(size_t size)
 {
     void *ptr;
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    size_t waste;
+#if MYNEWT_VAL(OS_MALLOC_SLAB_STATS)
+    uint32_t start;
+
+    start = os_cputime_get32();
+#endif
+
+    ptr = os_malloc_slab_get(size, &waste);
+    if (ptr != NULL) {
+        OS_MALLOC_STATS_INC(slab_allocs);
+#if MYNEWT_VAL(OS_MALLOC_SLAB_STATS)
+        os_malloc_stats_alloc(start, waste);
+#endif
+        return ptr;
+    }
+#endif
 
     os_malloc_lock();
     ptr = malloc(size);
     os_malloc_unlock();
 
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    if (ptr != NULL) {
+        OS_MALLOC_STATS_INC(arena_allocs);
+#if MYNEWT_VAL(OS_MALLOC_SLAB_STATS)
+        os_malloc_stats_alloc(start, 0);
+#endif
+    } else {
+        OS_MALLOC_STATS_INC(alloc_fails);
+    }
+#endif
+
     return ptr;
 }
 
 void
 os_free(void *mem)
 {
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    int cls;
+
+    if (mem == NULL) {
+        return;
+    }
+
+    cls = os_malloc_slab_class(mem);
+    if (cls >= 0) {
+        os_memblock_put(&os_malloc_slab_pools[cls], mem);
+        OS_MALLOC_STATS_INC(slab_frees);
+        return;
+    }
+    OS_MALLOC_STATS_INC(arena_frees);
+#endif
+
     os_malloc_lock();
     free(mem);
     os_malloc_unlock();
@@ -74,6 +351,32 @@ void *
 os_realloc(void *ptr, size_t size)
 {
     void *new_ptr;
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    int cls;
+
+    if (ptr == NULL) {
+        return os_malloc(size);
+    }
+
+    cls = os_malloc_slab_class(ptr);
+    if (cls >= 0) {
+        if (size == 0) {
+            os_free(ptr);
+            return NULL;
+        }
+        if (size <= OS_MALLOC_SLAB_SIZE(cls)) {
+            return ptr;
+        }
+
+        /* Growing beyond the block's class; move the data. */
+        new_ptr = os_malloc(size);
+        if (new_ptr != NULL) {
+            memcpy(new_ptr, ptr, OS_MALLOC_SLAB_SIZE(cls));
+            os_free(ptr);
+        }
+        return new_ptr;
+    }
+#endif
 
     os_malloc_lock();
     new_ptr = realloc(ptr, size);
@@ -182,6 +182,112 @@ done:
     return om;
 }
 
+/**
+ * Returns a pointer to the slot holding an external mbuf's buffer descriptor.
+ * The slot occupies the last pointer-aligned word of the mbuf's own data
+ * area, which is otherwise unused by an external mbuf.
+ */
+static struct os_mbuf_ext **
+os_mbuf_ext_slot(const struct os_mbuf *om)
+{
+    uintptr_t addr;
+
+    addr = (uintptr_t)&om->om_databuf[0] + om->om_omp->omp_databuf_len -
+           sizeof(struct os_mbuf_ext *);
+    addr &= ~(uintptr_t)(sizeof(struct os_mbuf_ext *) - 1);
+
+    return (struct os_mbuf_ext **)addr;
+}
+
+void
+os_mbuf_ext_init(struct os_mbuf_ext *ext, void *buf, uint16_t len,
+                 os_mbuf_ext_free_fn *free_cb, void *arg)
+{
+    ext->ome_buf = buf;
+    ext->ome_len = len;
+    ext->ome_free_cb = free_cb;
+    ext->ome_arg = arg;
+    ext->ome_refcnt = 1;
+}
+
+void
+os_mbuf_ext_ref(struct os_mbuf_ext *ext)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    assert(ext->ome_refcnt != 0 && ext->ome_refcnt != UINT16_MAX);
+    ext->ome_refcnt++;
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+os_mbuf_ext_release(struct os_mbuf_ext *ext)
+{
+    uint16_t refcnt;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    assert(ext->ome_refcnt != 0);
+    refcnt = --ext->ome_refcnt;
+    OS_EXIT_CRITICAL(sr);
+
+    if (refcnt == 0 && ext->ome_free_cb != NULL) {
+        ext->ome_free_cb(ext, ext->ome_arg);
+    }
+}
+
+struct os_mbuf_ext *
+os_mbuf_to_ext(const struct os_mbuf *om)
+{
+    if (!OS_MBUF_IS_EXT(om)) {
+        return NULL;
+    }
+
+    return *os_mbuf_ext_slot(om);
+}
+
+/**
+ * Turns a freshly allocated mbuf into a reference to a slice of an external
+ * buffer.
+ */
+static void
+os_mbuf_attach_ext(struct os_mbuf *om, struct os_mbuf_ext *ext,
+                   uint16_t off, uint16_t len)
+{
+    /* The descriptor slot must not overlap the packet header. */
+    assert(om->om_pkthdr_len <=
+           (uint8_t *)os_mbuf_ext_slot(om) - &om->om_databuf[0]);
+
+    os_mbuf_ext_ref(ext);
+
+    *os_mbuf_ext_slot(om) = ext;
+    om->om_flags |= OS_MBUF_F_MASK(OS_MBUF_F_EXT);
+    om->om_data = ext->ome_buf + off;
+    om->om_len = len;
+}
+
+struct os_mbuf *
+os_mbuf_get_ext(struct os_mbuf_pool *omp, struct os_mbuf_ext *ext,
+                uint16_t off, uint16_t len)
+{
+    struct os_mbuf *om;
+
+    if (omp->omp_databuf_len < 2 * sizeof(struct os_mbuf_ext *) ||
+        off > ext->ome_len || len > ext->ome_len - off) {
+        return NULL;
+    }
+
+    om = os_mbuf_get(omp, 0);
+    if (om == NULL) {
+        return NULL;
+    }
+
+    os_mbuf_attach_ext(om, ext, off, len);
+
+    return om;
+}
+
 int
 os_mbuf_free(struct os_mbuf *om)
 {
@@ -189,6 +295,11 @@ os_mbuf_free(struct os_mbuf *om)
 
     os_trace_api_u32(OS_TRACE_ID_MBUF_FREE, (uint32_t)om);
 
+    if (OS_MBUF_IS_EXT(om)) {
+        os_mbuf_ext_release(*os_mbuf_ext_slot(om));
+        om->om_flags &= ~OS_MBUF_F_MASK(OS_MBUF_F_EXT);
+    }
+
     if (om->om_omp != NULL) {
         rc = os_memblock_put(om->om_omp->omp_pool, om);
         if (rc != 0) {
@@ -364,6 +475,60 @@ os_mbuf_appendfrom(struct os_mbuf *dst, const struct os_mbuf *src,
     return 0;
 }
 
+int
+os_mbuf_appendref(struct os_mbuf *dst, const struct os_mbuf *src,
+                  uint16_t src_off, uint16_t len)
+{
+    const struct os_mbuf *src_cur_om;
+    struct os_mbuf_ext *ext;
+    struct os_mbuf *last;
+    struct os_mbuf *new;
+    uint16_t src_cur_off;
+    uint16_t chunk_sz;
+    int rc;
+
+    src_cur_om = os_mbuf_off(src, src_off, &src_cur_off);
+    while (len > 0) {
+        if (src_cur_om == NULL) {
+            return OS_EINVAL;
+        }
+
+        chunk_sz = min(len, src_cur_om->om_len - src_cur_off);
+        ext = os_mbuf_to_ext(src_cur_om);
+        if (ext == NULL) {
+            rc = os_mbuf_append(dst, src_cur_om->om_data + src_cur_off,
+                                chunk_sz);
+            if (rc != 0) {
+                return rc;
+            }
+        } else if (chunk_sz > 0) {
+            new = os_mbuf_get_ext(dst->om_omp, ext,
+                                  src_cur_om->om_data + src_cur_off -
+                                  ext->ome_buf,
+                                  chunk_sz);
+            if (new == NULL) {
+                return OS_ENOMEM;
+            }
+
+            last = dst;
+            while (SLIST_NEXT(last, om_next) != NULL) {
+                last = SLIST_NEXT(last, om_next);
+            }
+            SLIST_NEXT(last, om_next) = new;
+
+            if (OS_MBUF_IS_PKTHDR(dst)) {
+                OS_MBUF_PKTHDR(dst)->omp_len += chunk_sz;
+            }
+        }
+
+        len -= chunk_sz;
+        src_cur_om = SLIST_NEXT(src_cur_om, om_next);
+        src_cur_off = 0;
+    }
+
+    return 0;
+}
+
 struct os_mbuf *
 os_mbuf_dup(struct os_mbuf *om)
 {
@@ -397,10 +562,17 @@ os_mbuf_dup(struct os_mbuf *om)
             }
             copy = head;
         }
-        copy->om_flags = om->om_flags;
-        copy->om_len = om->om_len;
-        memcpy(OS_MBUF_DATA(copy, uint8_t *), OS_MBUF_DATA(om, uint8_t *),
-                om->om_len);
+        if (OS_MBUF_IS_EXT(om)) {
+            /* Share external data instead of copying it. */
+            os_mbuf_attach_ext(copy, *os_mbuf_ext_slot(om),
+                               om->om_data - os_mbuf_to_ext(om)->ome_buf,
+                               om->om_len);
+        } else {
+            copy->om_flags = om->om_flags;
+            copy->om_len = om->om_len;
+            memcpy(OS_MBUF_DATA(copy, uint8_t *), OS_MBUF_DATA(om, uint8_t *),
+                    om->om_len);
+        }
     }
 
     return (head);
@@ -715,6 +887,7 @@ os_mbuf_copyinto(struct os_mbuf *om, int off, const void *src, int len)
     struct os_mbuf *next;
     struct os_mbuf *cur;
     const uint8_t *sptr;
+    uint16_t cur_off_ext;
     uint16_t cur_off;
     int copylen;
     int rc;
@@ -725,6 +898,23 @@ os_mbuf_copyinto(struct os_mbuf *om, int off, const void *src, int len)
         return -1;
     }
 
+    /* External data may be shared with other chains; refuse to overwrite it
+     * before anything is modified.
+     */
+    copylen = len;
+    next = cur;
+    cur_off_ext = cur_off;
+    while (next != NULL && copylen > 0) {
+        if (next->om_len > cur_off_ext) {
+            if (OS_MBUF_IS_EXT(next)) {
+                return OS_EINVAL;
+            }
+            copylen -= next->om_len - cur_off_ext;
+        }
+        cur_off_ext = 0;
+        next = SLIST_NEXT(next, om_next);
+    }
+
     /* Overwrite existing data until we reach the end of the chain. */
     sptr = src;
     while (1) {
@@ -114,6 +114,123 @@ os_mempool_guard_check(const struct os_mempool *mp, void *start)
 #define os_mempool_guard_check(mp, start)
 #endif
 
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+#if !defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4) || \
+    !defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_2)
+#error "OS_MEMPOOL_LOCKFREE requires 16 and 32-bit compare-and-swap support"
+#endif
+
+/*
+ * The lock-free free list identifies blocks by index (plus one, so that zero
+ * means empty) rather than by address.  This leaves room in a 32-bit head
+ * word for a tag which is incremented on every update, so a stale
+ * compare-and-swap fails even if the same block is back at the head of the
+ * list (ABA problem).  The first word of each free block holds the index of
+ * the next free block.
+ */
+#define OS_MEMPOOL_LF_IDX(head)         ((head) & 0xffff)
+#define OS_MEMPOOL_LF_TAG(head)         ((head) >> 16)
+#define OS_MEMPOOL_LF_HEAD(tag, idx)    (((uint32_t)(tag) << 16) | (idx))
+
+static inline struct os_memblock *
+os_mempool_lf_block(const struct os_mempool *mp, uint32_t idx)
+{
+    return (struct os_memblock *)(mp->mp_membuf_addr +
+                                  (idx - 1) * OS_MEMPOOL_TRUE_BLOCK_SIZE(mp));
+}
+
+static inline uint32_t
+os_mempool_lf_idx(const struct os_mempool *mp, const void *block)
+{
+    return ((uint32_t)block - mp->mp_membuf_addr) /
+           OS_MEMPOOL_TRUE_BLOCK_SIZE(mp) + 1;
+}
+
+static inline uint32_t
+os_mempool_lf_next_idx(const struct os_memblock *block)
+{
+    return OS_MEMPOOL_LF_IDX(*(const volatile uint32_t *)block);
+}
+
+/**
+ * Chains all blocks of a lock-free mempool to its free list.  Must not race
+ * with any other access to the pool.
+ */
+static void
+os_mempool_lf_chain(struct os_mempool *mp)
+{
+    uint32_t idx;
+
+    for (idx = 1; idx <= mp->mp_num_blocks; idx++) {
+        os_mempool_poison(mp, os_mempool_lf_block(mp, idx));
+        os_mempool_guard(mp, os_mempool_lf_block(mp, idx));
+        *(volatile uint32_t *)os_mempool_lf_block(mp, idx) =
+            idx < mp->mp_num_blocks ? idx + 1 : 0;
+    }
+
+    mp->mp_lf_head = OS_MEMPOOL_LF_HEAD(0, mp->mp_num_blocks ? 1 : 0);
+}
+
+static struct os_memblock *
+os_mempool_lf_get(struct os_mempool *mp)
+{
+    struct os_memblock *block;
+    uint16_t min_free;
+    uint16_t num_free;
+    uint32_t head;
+    uint32_t next;
+
+    head = __atomic_load_n(&mp->mp_lf_head, __ATOMIC_ACQUIRE);
+    do {
+        if (OS_MEMPOOL_LF_IDX(head) == 0) {
+            return NULL;
+        }
+
+        /* The block may be handed out concurrently, so its link may be
+         * garbage; the tag check in the exchange below catches that.
+         */
+        block = os_mempool_lf_block(mp, OS_MEMPOOL_LF_IDX(head));
+        next = OS_MEMPOOL_LF_HEAD(OS_MEMPOOL_LF_TAG(head) + 1,
+                                  os_mempool_lf_next_idx(block));
+    } while (!__atomic_compare_exchange_n(&mp->mp_lf_head, &head, next, true,
+                                          __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE));
+
+    num_free = __atomic_sub_fetch(&mp->mp_num_free, 1, __ATOMIC_RELAXED);
+    min_free = __atomic_load_n(&mp->mp_min_free, __ATOMIC_RELAXED);
+    while (num_free < min_free &&
+           !__atomic_compare_exchange_n(&mp->mp_min_free, &min_free, num_free,
+                                        true, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+    }
+
+    return block;
+}
+
+static void
+os_mempool_lf_put(struct os_mempool *mp, struct os_memblock *block)
+{
+    uint32_t head;
+    uint32_t next;
+    uint32_t idx;
+
+    idx = os_mempool_lf_idx(mp, block);
+
+    /* Count the block as free before publishing it, so the counter never
+     * drops below zero when the block is taken right away.
+     */
+    __atomic_add_fetch(&mp->mp_num_free, 1, __ATOMIC_RELAXED);
+
+    head = __atomic_load_n(&mp->mp_lf_head, __ATOMIC_RELAXED);
+    do {
+        *(volatile uint32_t *)block = OS_MEMPOOL_LF_IDX(head);
+        next = OS_MEMPOOL_LF_HEAD(OS_MEMPOOL_LF_TAG(head) + 1, idx);
+    } while (!__atomic_compare_exchange_n(&mp->mp_lf_head, &head, next, true,
+                                          __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+}
+#endif
+
 static os_error_t
 os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
                          uint32_t block_size, void *membuf, char *name,
@@ -152,6 +269,12 @@ os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
     mp->name = name;
     SLIST_FIRST(mp) = membuf;
 
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    if (flags & OS_MEMPOOL_F_LOCKFREE) {
+        SLIST_FIRST(mp) = NULL;
+        os_mempool_lf_chain(mp);
+    } else
+#endif
     if (blocks > 0) {
         os_mempool_poison(mp, membuf);
         os_mempool_guard(mp, membuf);
@@ -202,6 +325,16 @@ os_mempool_ext_init(struct os_mempool_ext *mpe, uint16_t blocks,
     return 0;
 }
 
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+os_error_t
+os_mempool_lockfree_init(struct os_mempool *mp, uint16_t blocks,
+                         uint32_t block_size, void *membuf, char *name)
+{
+    return os_mempool_init_internal(mp, blocks, block_size, membuf, name,
+                                    OS_MEMPOOL_F_LOCKFREE);
+}
+#endif
+
 os_error_t
 os_mempool_unregister(struct os_mempool *mp)
 {
@@ -257,6 +390,14 @@ os_mempool_clear(struct os_mempool *mp)
     /* cleanup the memory pool structure */
     mp->mp_num_free = mp->mp_num_blocks;
     mp->mp_min_free = mp->mp_num_blocks;
+
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    if (mp->mp_flags & OS_MEMPOOL_F_LOCKFREE) {
+        os_mempool_lf_chain(mp);
+        return OS_OK;
+    }
+#endif
+
     os_mempool_poison(mp, (void *)mp->mp_membuf_addr);
     os_mempool_guard(mp, (void *)mp->mp_membuf_addr);
     SLIST_FIRST(mp) = (void *)mp->mp_membuf_addr;
@@ -285,6 +426,24 @@ bool
 os_mempool_is_sane(const struct os_mempool *mp)
 {
     struct os_memblock *block;
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    uint32_t idx;
+
+    if (mp->mp_flags & OS_MEMPOOL_F_LOCKFREE) {
+        idx = OS_MEMPOOL_LF_IDX(mp->mp_lf_head);
+        while (idx != 0) {
+            if (idx > mp->mp_num_blocks) {
+                return false;
+            }
+            block = os_mempool_lf_block(mp, idx);
+            os_mempool_poison_check(mp, block);
+            os_mempool_guard_check(mp, block);
+            idx = os_mempool_lf_next_idx(block);
+        }
+
+        return true;
+    }
+#endif
 
     /* Verify that each block in the free list belongs to the mempool. */
     SLIST_FOREACH(block, mp, mb_next) {
@@ -336,6 +495,16 @@ os_memblock_get(struct os_mempool *mp)
     /* Check to make sure they passed in a memory pool (or something) */
     block = NULL;
     if (mp) {
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+        if (mp->mp_flags & OS_MEMPOOL_F_LOCKFREE) {
+            block = os_mempool_lf_get(mp);
+            if (block) {
+                os_mempool_poison_check(mp, block);
+                os_mempool_guard_check(mp, block);
+            }
+            goto done;
+        }
+#endif
         OS_ENTER_CRITICAL(sr);
         /* Check for any free */
         if (mp->mp_num_free) {
@@ -359,6 +528,9 @@ os_memblock_get(struct os_mempool *mp)
         }
     }
 
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+done:
+#endif
     os_trace_api_ret_u32(OS_TRACE_ID_MEMBLOCK_GET, (uint32_t)block);
 
     return (void *)block;
@@ -377,6 +549,14 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
     os_mempool_poison(mp, block_addr);
 
     block = (struct os_memblock *)block_addr;
+
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    if (mp->mp_flags & OS_MEMPOOL_F_LOCKFREE) {
+        os_mempool_lf_put(mp, block);
+        goto done;
+    }
+#endif
+
     OS_ENTER_CRITICAL(sr);
 
     /* Chain current free list pointer to this block; make this block head */
@@ -389,6 +569,9 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
 
     OS_EXIT_CRITICAL(sr);
 
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+done:
+#endif
     os_trace_api_ret_u32(OS_TRACE_ID_MEMBLOCK_PUT_FROM_CB, (uint32_t)OS_OK);
 
     return OS_OK;
@@ -402,6 +585,9 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
 #if MYNEWT_VAL(OS_MEMPOOL_CHECK)
     struct os_memblock *block;
     int sr;
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    uint32_t idx;
+#endif
 #endif
 
     os_trace_api_u32x2(OS_TRACE_ID_MEMBLOCK_PUT, (uint32_t)mp,
@@ -421,6 +607,16 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
      * Check for duplicate free.
      */
     OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    if (mp->mp_flags & OS_MEMPOOL_F_LOCKFREE) {
+        idx = OS_MEMPOOL_LF_IDX(mp->mp_lf_head);
+        while (idx != 0) {
+            block = os_mempool_lf_block(mp, idx);
+            assert(block != (struct os_memblock *)block_addr);
+            idx = os_mempool_lf_next_idx(block);
+        }
+    }
+#endif
     SLIST_FOREACH(block, mp, mb_next) {
         assert(block != (struct os_memblock *)block_addr);
     }
@@ -446,6 +642,86 @@ done:
     return ret;
 }
 
+os_error_t
+os_mempool_mag_init(struct os_mempool_mag *mag, struct os_mempool *mp,
+                    void **blocks, uint16_t cap)
+{
+    if (mag == NULL || mp == NULL || blocks == NULL || cap < 2) {
+        return OS_INVALID_PARM;
+    }
+
+    if (mp->mp_flags & OS_MEMPOOL_F_EXT) {
+        return OS_INVALID_PARM;
+    }
+
+    mag->mm_mp = mp;
+    mag->mm_blocks = blocks;
+    mag->mm_cap = cap;
+    mag->mm_cnt = 0;
+
+    return OS_OK;
+}
+
+void *
+os_memblock_mag_get(struct os_mempool_mag *mag)
+{
+    void *block;
+
+    if (mag->mm_cnt == 0) {
+        /* Refill half of the magazine. */
+        while (mag->mm_cnt < mag->mm_cap / 2) {
+            block = os_memblock_get(mag->mm_mp);
+            if (block == NULL) {
+                break;
+            }
+            mag->mm_blocks[mag->mm_cnt++] = block;
+        }
+
+        if (mag->mm_cnt == 0) {
+            return NULL;
+        }
+    }
+
+    return mag->mm_blocks[--mag->mm_cnt];
+}
+
+os_error_t
+os_memblock_mag_put(struct os_mempool_mag *mag, void *block_addr)
+{
+    os_error_t rc;
+
+    if (block_addr == NULL) {
+        return OS_INVALID_PARM;
+    }
+
+#if MYNEWT_VAL(OS_MEMPOOL_CHECK)
+    assert(os_memblock_from(mag->mm_mp, block_addr));
+#endif
+
+    if (mag->mm_cnt == mag->mm_cap) {
+        /* Spill half of the magazine back to the pool. */
+        while (mag->mm_cnt > mag->mm_cap / 2) {
+            rc = os_memblock_put(mag->mm_mp, mag->mm_blocks[mag->mm_cnt - 1]);
+            if (rc != OS_OK) {
+                return rc;
+            }
+            mag->mm_cnt--;
+        }
+    }
+
+    mag->mm_blocks[mag->mm_cnt++] = block_addr;
+
+    return OS_OK;
+}
+
+void
+os_mempool_mag_flush(struct os_mempool_mag *mag)
+{
+    while (mag->mm_cnt > 0) {
+        os_memblock_put(mag->mm_mp, mag->mm_blocks[--mag->mm_cnt]);
+    }
+}
+
 struct os_mempool *
 os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
 {
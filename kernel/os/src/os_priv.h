@@ -35,9 +35,13 @@ extern struct os_task g_idle_task;
 extern struct os_task_list g_os_run_list;
 extern struct os_task_list g_os_sleep_list;
 extern struct os_task_stailq g_os_task_list;
+#if !MYNEWT_VAL(OS_CALLOUT_WHEEL)
 extern struct os_callout_list g_callout_list;
+#endif
 
+void os_callout_module_init(void);
 void os_mempool_module_init(void);
+void os_malloc_module_init(void);
 void os_msys_init(void);
 
 /**
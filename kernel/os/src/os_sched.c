@@ -18,6 +18,7 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "os/mynewt.h"
 #include "os_priv.h"
 
@@ -29,6 +30,302 @@ struct os_task *g_current_task;
 extern os_time_t g_os_time;
 os_time_t g_os_last_ctx_sw_time;
 
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+
+/*
+ * The run list is kept sorted by priority, with tasks of equal priority in
+ * FIFO order.  Instead of walking the list to find the insertion point, the
+ * last task of each priority is recorded in os_sched_prio_tail and the
+ * priorities with ready tasks are tracked in a two-level bitmap: bit n of
+ * os_sched_prio_map[w] is set if priority (w * 32 + n) has a ready task, and
+ * bit w of os_sched_prio_summary is set if os_sched_prio_map[w] is non-zero.
+ * A new task goes right after the tail of the nearest priority not lower
+ * than its own, which is found with two count-leading-zeros operations.
+ */
+#define OS_SCHED_PRIO_WORDS     (256 / 32)
+
+static uint32_t os_sched_prio_map[OS_SCHED_PRIO_WORDS];
+static uint8_t os_sched_prio_summary;
+static struct os_task *os_sched_prio_tail[256];
+
+/**
+ * Returns the numerically highest priority not greater than 'prio' which has
+ * a task on the run list, or -1 if there is no such priority.
+ */
+static int
+os_sched_prio_find(uint8_t prio)
+{
+    uint32_t word;
+    uint32_t summary;
+    int w;
+
+    w = prio / 32;
+    word = os_sched_prio_map[w] & (0xffffffffUL >> (31 - prio % 32));
+    if (word == 0) {
+        summary = os_sched_prio_summary & ((1UL << w) - 1);
+        if (summary == 0) {
+            return -1;
+        }
+        w = 31 - __builtin_clz(summary);
+        word = os_sched_prio_map[w];
+    }
+
+    return w * 32 + 31 - __builtin_clz(word);
+}
+
+static void
+os_sched_prio_clear(uint8_t prio)
+{
+    os_sched_prio_tail[prio] = NULL;
+    os_sched_prio_map[prio / 32] &= ~(1UL << (prio % 32));
+    if (os_sched_prio_map[prio / 32] == 0) {
+        os_sched_prio_summary &= ~(1 << (prio / 32));
+    }
+}
+
+#endif
+
+/**
+ * Removes a ready task from the run list.
+ */
+static void
+os_sched_run_list_remove(struct os_task *t)
+{
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    struct os_task *prev;
+    uint8_t prio;
+
+    /* Use the priority the task was queued with; the task's priority may
+     * have changed since (see os_sched_resort()).
+     */
+    prio = t->t_run_prio;
+    if (os_sched_prio_tail[prio] == t) {
+        prev = TAILQ_PREV(t, os_task_list, t_os_list);
+        if (prev != NULL && prev->t_run_prio == prio) {
+            os_sched_prio_tail[prio] = prev;
+        } else {
+            os_sched_prio_clear(prio);
+        }
+    }
+#endif
+
+    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+}
+
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+
+#define OS_SCHED_SLEEP_HEAP_SIZE    MYNEWT_VAL(OS_SCHED_SLEEP_HEAP_SIZE)
+
+#if OS_SCHED_SLEEP_HEAP_SIZE < 1 || OS_SCHED_SLEEP_HEAP_SIZE > 256
+#error "OS_SCHED_SLEEP_HEAP_SIZE must be between 1 and 256"
+#endif
+
+/*
+ * Tasks sleeping with a timeout are kept in a binary min-heap ordered by
+ * wakeup time, so the next task to wake up is always at index 0.  Each task
+ * records its position in the heap, allowing it to be removed in logarithmic
+ * time when it gets woken up early (e.g., a semaphore is released).  Tasks
+ * sleeping without a timeout stay on g_os_sleep_list, as do tasks that do not
+ * fit in the heap once it is full.
+ */
+static struct os_task *os_sched_sleep_heap[OS_SCHED_SLEEP_HEAP_SIZE];
+static int os_sched_sleep_heap_cnt;
+
+static void
+os_sched_sleep_heap_set(int idx, struct os_task *t)
+{
+    os_sched_sleep_heap[idx] = t;
+    t->t_sleep_idx = idx;
+}
+
+static void
+os_sched_sleep_heap_up(int idx)
+{
+    struct os_task *parent;
+    struct os_task *t;
+
+    t = os_sched_sleep_heap[idx];
+    while (idx > 0) {
+        parent = os_sched_sleep_heap[(idx - 1) / 2];
+        if (!OS_TIME_TICK_LT(t->t_next_wakeup, parent->t_next_wakeup)) {
+            break;
+        }
+        os_sched_sleep_heap_set(idx, parent);
+        idx = (idx - 1) / 2;
+    }
+    os_sched_sleep_heap_set(idx, t);
+}
+
+static void
+os_sched_sleep_heap_down(int idx)
+{
+    struct os_task *child;
+    struct os_task *t;
+    int i;
+
+    t = os_sched_sleep_heap[idx];
+    while (1) {
+        i = idx * 2 + 1;
+        if (i >= os_sched_sleep_heap_cnt) {
+            break;
+        }
+        child = os_sched_sleep_heap[i];
+        if (i + 1 < os_sched_sleep_heap_cnt &&
+            OS_TIME_TICK_LT(os_sched_sleep_heap[i + 1]->t_next_wakeup,
+                            child->t_next_wakeup)) {
+            i++;
+            child = os_sched_sleep_heap[i];
+        }
+        if (!OS_TIME_TICK_LT(child->t_next_wakeup, t->t_next_wakeup)) {
+            break;
+        }
+        os_sched_sleep_heap_set(idx, child);
+        idx = i;
+    }
+    os_sched_sleep_heap_set(idx, t);
+}
+
+/**
+ * Inserts a task in the sleep heap.
+ *
+ * @return 0 on success; OS_ENOMEM if the heap is full.
+ */
+static int
+os_sched_sleep_heap_insert(struct os_task *t)
+{
+    if (os_sched_sleep_heap_cnt >= OS_SCHED_SLEEP_HEAP_SIZE) {
+        return OS_ENOMEM;
+    }
+
+    os_sched_sleep_heap[os_sched_sleep_heap_cnt] = t;
+    os_sched_sleep_heap_up(os_sched_sleep_heap_cnt++);
+
+    return 0;
+}
+
+static bool
+os_sched_sleep_heap_contains(const struct os_task *t)
+{
+    return t->t_sleep_idx < os_sched_sleep_heap_cnt &&
+           os_sched_sleep_heap[t->t_sleep_idx] == t;
+}
+
+static void
+os_sched_sleep_heap_remove(struct os_task *t)
+{
+    struct os_task *last;
+    int idx;
+
+    idx = t->t_sleep_idx;
+    assert(idx < os_sched_sleep_heap_cnt && os_sched_sleep_heap[idx] == t);
+
+    last = os_sched_sleep_heap[--os_sched_sleep_heap_cnt];
+    if (last == t) {
+        return;
+    }
+
+    /* Fill the hole with the last entry and restore the heap order. */
+    os_sched_sleep_heap_set(idx, last);
+    if (idx > 0 &&
+        OS_TIME_TICK_LT(last->t_next_wakeup,
+                        os_sched_sleep_heap[(idx - 1) / 2]->t_next_wakeup)) {
+        os_sched_sleep_heap_up(idx);
+    } else {
+        os_sched_sleep_heap_down(idx);
+    }
+}
+
+#endif
+
+/**
+ * Inserts a task sleeping with a timeout in g_os_sleep_list, ahead of tasks
+ * that wake up later and of tasks sleeping forever.
+ */
+static void
+os_sched_sleep_list_insert(struct os_task *t)
+{
+    struct os_task *entry;
+
+    TAILQ_FOREACH(entry, &g_os_sleep_list, t_os_list) {
+        if ((entry->t_flags & OS_TASK_FLAG_NO_TIMEOUT) ||
+                OS_TIME_TICK_GT(entry->t_next_wakeup, t->t_next_wakeup)) {
+            break;
+        }
+    }
+    if (entry) {
+        TAILQ_INSERT_BEFORE(entry, t, t_os_list);
+    } else {
+        TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
+    }
+}
+
+/**
+ * Removes a sleeping task from the sleep list.
+ */
+static void
+os_sched_sleep_list_remove(struct os_task *t)
+{
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    if (!(t->t_flags & OS_TASK_FLAG_NO_TIMEOUT) &&
+        os_sched_sleep_heap_contains(t)) {
+
+        os_sched_sleep_heap_remove(t);
+        return;
+    }
+#endif
+
+    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+}
+
+/**
+ * Returns the sleeping task with the earliest wakeup time, or NULL if no task
+ * is sleeping with a timeout.
+ */
+static struct os_task *
+os_sched_sleep_list_first(void)
+{
+    struct os_task *t;
+
+    t = TAILQ_FIRST(&g_os_sleep_list);
+    if (t != NULL && (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+        t = NULL;
+    }
+
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    /* The list only holds tasks with a timeout if the heap overflowed. */
+    if (os_sched_sleep_heap_cnt != 0 &&
+        (t == NULL ||
+         OS_TIME_TICK_LT(os_sched_sleep_heap[0]->t_next_wakeup,
+                         t->t_next_wakeup))) {
+
+        t = os_sched_sleep_heap[0];
+    }
+#endif
+
+    return t;
+}
+
+/**
+ * os sched init
+ *
+ * Empties the run and sleep lists.
+ */
+void
+os_sched_init(void)
+{
+    TAILQ_INIT(&g_os_run_list);
+    TAILQ_INIT(&g_os_sleep_list);
+
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    memset(os_sched_prio_map, 0, sizeof(os_sched_prio_map));
+    memset(os_sched_prio_tail, 0, sizeof(os_sched_prio_tail));
+    os_sched_prio_summary = 0;
+#endif
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    os_sched_sleep_heap_cnt = 0;
+#endif
+}
+
 /**
  * os sched insert
  *
@@ -43,7 +340,11 @@ os_time_t g_os_last_ctx_sw_time;
 os_error_t
 os_sched_insert(struct os_task *t)
 {
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    int prio;
+#else
     struct os_task *entry;
+#endif
     os_sr_t sr;
     os_error_t rc;
 
@@ -52,8 +353,22 @@ os_sched_insert(struct os_task *t)
         goto err;
     }
 
-    entry = NULL;
     OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    prio = os_sched_prio_find(t->t_prio);
+    if (prio >= 0) {
+        TAILQ_INSERT_AFTER(&g_os_run_list, os_sched_prio_tail[prio], t,
+                           t_os_list);
+    } else {
+        TAILQ_INSERT_HEAD(&g_os_run_list, t, t_os_list);
+    }
+
+    t->t_run_prio = t->t_prio;
+    os_sched_prio_tail[t->t_prio] = t;
+    os_sched_prio_map[t->t_prio / 32] |= 1UL << (t->t_prio % 32);
+    os_sched_prio_summary |= 1 << (t->t_prio / 32);
+#else
+    entry = NULL;
     TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
         if (t->t_prio < entry->t_prio) {
             break;
@@ -64,6 +379,7 @@ os_sched_insert(struct os_task *t)
     } else {
         TAILQ_INSERT_TAIL(&g_os_run_list, (struct os_task *) t, t_os_list);
     }
+#endif
     OS_EXIT_CRITICAL(sr);
 
     return (0);
@@ -148,28 +464,23 @@ os_sched(struct os_task *next_t)
 int
 os_sched_sleep(struct os_task *t, os_time_t nticks)
 {
-    struct os_task *entry;
-
-    entry = NULL;
-
-    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+    os_sched_run_list_remove(t);
     t->t_state = OS_TASK_SLEEP;
     t->t_next_wakeup = os_time_get() + nticks;
     if (nticks == OS_TIMEOUT_NEVER) {
         t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
         TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
     } else {
-        TAILQ_FOREACH(entry, &g_os_sleep_list, t_os_list) {
-            if ((entry->t_flags & OS_TASK_FLAG_NO_TIMEOUT) ||
-                    OS_TIME_TICK_GT(entry->t_next_wakeup, t->t_next_wakeup)) {
-                break;
-            }
-        }
-        if (entry) {
-            TAILQ_INSERT_BEFORE(entry, t, t_os_list);
-        } else {
-            TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+        if (os_sched_sleep_heap_insert(t) != 0) {
+            /* More tasks sleeping with a timeout than
+             * OS_SCHED_SLEEP_HEAP_SIZE; fall back to the sorted list.
+             */
+            os_sched_sleep_list_insert(t);
         }
+#else
+        os_sched_sleep_list_insert(t);
+#endif
     }
 
     os_trace_task_stop_ready(t, OS_TASK_SLEEP);
@@ -194,9 +505,9 @@ os_sched_remove(struct os_task *t)
 {
 
     if (t->t_state == OS_TASK_SLEEP) {
-        TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+        os_sched_sleep_list_remove(t);
     } else if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_remove(t);
     }
     t->t_next_wakeup = 0;
     t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
@@ -236,10 +547,10 @@ os_sched_wakeup(struct os_task *t)
     }
 
     /* Remove task from sleep list */
+    os_sched_sleep_list_remove(t);
     t->t_state = OS_TASK_READY;
     t->t_next_wakeup = 0;
     t->t_flags &= ~OS_TASK_FLAG_NO_TIMEOUT;
-    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
     os_sched_insert(t);
 
     os_trace_task_start_ready(t);
@@ -260,7 +571,6 @@ void
 os_sched_os_timer_exp(void)
 {
     struct os_task *t;
-    struct os_task *next;
     os_time_t now;
     os_sr_t sr;
 
@@ -269,21 +579,14 @@ os_sched_os_timer_exp(void)
     OS_ENTER_CRITICAL(sr);
 
     /*
-     * Wakeup any tasks that have their sleep timer expired
+     * Wakeup any tasks that have their sleep timer expired.  Tasks waiting
+     * forever are never returned by os_sched_sleep_list_first().
      */
-    t = TAILQ_FIRST(&g_os_sleep_list);
-    while (t) {
-        /* If task waiting forever, do not check next wakeup time */
-        if (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT) {
+    while ((t = os_sched_sleep_list_first()) != NULL) {
+        if (!OS_TIME_TICK_GEQ(now, t->t_next_wakeup)) {
             break;
         }
-        next = TAILQ_NEXT(t, t_os_list);
-        if (OS_TIME_TICK_GEQ(now, t->t_next_wakeup)) {
-            os_sched_wakeup(t);
-        } else {
-            break;
-        }
-        t = next;
+        os_sched_wakeup(t);
     }
 
     OS_EXIT_CRITICAL(sr);
@@ -301,8 +604,8 @@ os_sched_wakeup_ticks(os_time_t now)
 
     OS_ASSERT_CRITICAL();
 
-    t = TAILQ_FIRST(&g_os_sleep_list);
-    if (t == NULL || (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+    t = os_sched_sleep_list_first();
+    if (t == NULL) {
         rt = OS_TIMEOUT_NEVER;
     } else if (OS_TIME_TICK_GEQ(t->t_next_wakeup, now)) {
         rt = t->t_next_wakeup - now;
@@ -346,7 +649,7 @@ void
 os_sched_resort(struct os_task *t)
 {
     if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_remove(t);
         os_sched_insert(t);
     }
 }
@@ -19,6 +19,9 @@
 
 #include <assert.h>
 #include "os/mynewt.h"
+#if MYNEWT_VAL(OS_TICK_STATS)
+#include "stats/stats.h"
+#endif
 
 CTASSERT(sizeof(os_time_t) == 4);
 
@@ -56,6 +59,59 @@ os_time_get(void)
     return (g_os_time);
 }
 
+#if MYNEWT_VAL(OS_TICK_STATS)
+STATS_SECT_START(os_tick_stats)
+    STATS_SECT_ENTRY(ticks)
+    STATS_SECT_ENTRY(total_us)
+    STATS_SECT_ENTRY(max_us)
+STATS_SECT_END
+
+STATS_NAME_START(os_tick_stats)
+    STATS_NAME(os_tick_stats, ticks)
+    STATS_NAME(os_tick_stats, total_us)
+    STATS_NAME(os_tick_stats, max_us)
+STATS_NAME_END(os_tick_stats)
+
+static STATS_SECT_DECL(os_tick_stats) os_tick_stats;
+
+/* Longest time spent processing a tick, in microseconds. */
+static uint32_t os_tick_max_us;
+
+void
+os_tick_stats_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = stats_init_and_reg(STATS_HDR(os_tick_stats),
+                            STATS_SIZE_INIT_PARMS(os_tick_stats,
+                                                  STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(os_tick_stats),
+                            "os_tick");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+static void
+os_tick_stats_update(uint32_t start)
+{
+    uint32_t usecs;
+
+    usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+
+    STATS_INC(os_tick_stats, ticks);
+    STATS_INCN(os_tick_stats, total_us, usecs);
+    if (usecs > os_tick_max_us) {
+        /* Stats can only be incremented; raise the maximum by the
+         * difference.
+         */
+        STATS_INCN(os_tick_stats, max_us, usecs - os_tick_max_us);
+        os_tick_max_us = usecs;
+    }
+}
+#endif
+
 #if MYNEWT_VAL(OS_SCHEDULING)
 static void
 os_time_tick(int ticks)
@@ -85,15 +141,25 @@ os_time_tick(int ticks)
 void
 os_time_advance(int ticks)
 {
+#if MYNEWT_VAL(OS_TICK_STATS)
+    uint32_t start;
+#endif
+
     assert(ticks >= 0);
 
     if (ticks > 0) {
         if (!os_started()) {
             g_os_time += ticks;
         } else {
+#if MYNEWT_VAL(OS_TICK_STATS)
+            start = os_cputime_get32();
+#endif
             os_time_tick(ticks);
             os_callout_tick();
             os_sched_os_timer_exp();
+#if MYNEWT_VAL(OS_TICK_STATS)
+            os_tick_stats_update(start);
+#endif
             os_sched(NULL);
         }
     }
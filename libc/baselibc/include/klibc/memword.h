@@ -0,0 +1,156 @@
+/*
+ * klibc/memword.h
+ *
+ * Word at a time helpers for the mem*() functions
+ */
+
+#ifndef _KLIBC_MEMWORD_H
+#define _KLIBC_MEMWORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The widest integer register: 32 bits on Cortex-M, 64 bits on 64-bit
+ * targets.  Accesses through memword_t must be aligned.
+ */
+typedef uintptr_t __attribute__((__may_alias__)) memword_t;
+
+#define MEMWORD_SIZE		sizeof(memword_t)
+#define MEMWORD_MASK		(MEMWORD_SIZE - 1)
+#define MEMWORD_ALIGNED(p)	(((uintptr_t)(p) & MEMWORD_MASK) == 0)
+
+/*
+ * Word loads from the source buffer.  Where single word loads may be
+ * unaligned (e.g. Cortex-M3/4/7/33) the source only needs to be byte
+ * aligned; otherwise it must share the destination's alignment.
+ */
+#if defined(__ARM_FEATURE_UNALIGNED) || defined(__i386__) || \
+    defined(__x86_64__)
+typedef uintptr_t __attribute__((__may_alias__, __aligned__(1))) memword_src_t;
+#define MEMWORD_SRC_OK(p)	1
+#else
+typedef memword_t memword_src_t;
+#define MEMWORD_SRC_OK(p)	MEMWORD_ALIGNED(p)
+#endif
+
+/*
+ * Copies n bytes in ascending address order.  Also safe for overlapping
+ * buffers as long as dst is below src.
+ */
+static inline void memword_copy_fwd(char *q, const char *p, size_t n)
+{
+	memword_t *wq;
+	const memword_src_t *wp;
+
+	if (n >= 2 * MEMWORD_SIZE) {
+		while (!MEMWORD_ALIGNED(q)) {
+			*q++ = *p++;
+			n--;
+		}
+
+		if (MEMWORD_SRC_OK(p)) {
+			wq = (memword_t *)q;
+			wp = (const memword_src_t *)p;
+
+			for (; n >= 4 * MEMWORD_SIZE; n -= 4 * MEMWORD_SIZE) {
+				wq[0] = wp[0];
+				wq[1] = wp[1];
+				wq[2] = wp[2];
+				wq[3] = wp[3];
+				wq += 4;
+				wp += 4;
+			}
+			for (; n >= MEMWORD_SIZE; n -= MEMWORD_SIZE) {
+				*wq++ = *wp++;
+			}
+
+			q = (char *)wq;
+			p = (const char *)wp;
+		}
+	}
+
+	while (n--) {
+		*q++ = *p++;
+	}
+}
+
+/*
+ * Copies n bytes in descending address order.  Also safe for overlapping
+ * buffers as long as dst is above src.
+ */
+static inline void memword_copy_bwd(char *q, const char *p, size_t n)
+{
+	memword_t *wq;
+	const memword_src_t *wp;
+
+	q += n;
+	p += n;
+
+	if (n >= 2 * MEMWORD_SIZE) {
+		while (!MEMWORD_ALIGNED(q)) {
+			*--q = *--p;
+			n--;
+		}
+
+		if (MEMWORD_SRC_OK(p)) {
+			wq = (memword_t *)q;
+			wp = (const memword_src_t *)p;
+
+			for (; n >= 4 * MEMWORD_SIZE; n -= 4 * MEMWORD_SIZE) {
+				wq -= 4;
+				wp -= 4;
+				wq[3] = wp[3];
+				wq[2] = wp[2];
+				wq[1] = wp[1];
+				wq[0] = wp[0];
+			}
+			for (; n >= MEMWORD_SIZE; n -= MEMWORD_SIZE) {
+				*--wq = *--wp;
+			}
+
+			q = (char *)wq;
+			p = (const char *)wp;
+		}
+	}
+
+	while (n--) {
+		*--q = *--p;
+	}
+}
+
+/*
+ * Sets n bytes to the low byte of c.
+ */
+static inline void memword_set(char *q, int c, size_t n)
+{
+	memword_t *wq;
+	memword_t v;
+
+	if (n >= 2 * MEMWORD_SIZE) {
+		while (!MEMWORD_ALIGNED(q)) {
+			*q++ = c;
+			n--;
+		}
+
+		v = ((memword_t)-1 / 0xff) * (unsigned char)c;
+		wq = (memword_t *)q;
+		for (; n >= 4 * MEMWORD_SIZE; n -= 4 * MEMWORD_SIZE) {
+			wq[0] = v;
+			wq[1] = v;
+			wq[2] = v;
+			wq[3] = v;
+			wq += 4;
+		}
+		for (; n >= MEMWORD_SIZE; n -= MEMWORD_SIZE) {
+			*wq++ = v;
+		}
+		q = (char *)wq;
+	}
+
+	while (n--) {
+		*q++ = c;
+	}
+}
+
+#endif				/* _KLIBC_MEMWORD_H */
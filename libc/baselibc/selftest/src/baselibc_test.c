@@ -22,10 +22,16 @@
 #include "testutil/testutil.h"
 
 TEST_CASE_DECL(tinyprintf_test)
+TEST_CASE_DECL(memfunc_test)
+TEST_CASE_DECL(memword_test)
+TEST_CASE_DECL(memfunc_throughput_test)
 
 TEST_SUITE(baselibc_test_suite)
 {
     tinyprintf_test();
+    memfunc_test();
+    memword_test();
+    memfunc_throughput_test();
 }
 
 int
@@ -0,0 +1,130 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "testutil/testutil.h"
+
+#define MEMFUNC_TEST_BUF_SIZE   256
+
+static unsigned char memfunc_test_src[MEMFUNC_TEST_BUF_SIZE];
+static unsigned char memfunc_test_dst[MEMFUNC_TEST_BUF_SIZE];
+static unsigned char memfunc_test_exp[MEMFUNC_TEST_BUF_SIZE];
+
+static void
+memfunc_test_fill(void)
+{
+    int i;
+
+    for (i = 0; i < MEMFUNC_TEST_BUF_SIZE; i++) {
+        memfunc_test_src[i] = i * 13 + 1;
+        memfunc_test_dst[i] = 0xa5;
+        memfunc_test_exp[i] = 0xa5;
+    }
+}
+
+static int
+memfunc_test_cmp(void)
+{
+    int i;
+
+    for (i = 0; i < MEMFUNC_TEST_BUF_SIZE; i++) {
+        if (memfunc_test_dst[i] != memfunc_test_exp[i]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int
+memfunc_test_sign(int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+/*
+ * Checks every combination of source and destination alignment against
+ * byte at a time reference results, for lengths that cover the byte, word and
+ * multi-word paths.  Bytes outside the destination range must be untouched.
+ */
+TEST_CASE_SELF(memfunc_test)
+{
+    void *rc;
+    int doff;
+    int soff;
+    int len;
+    int i;
+
+    for (doff = 0; doff < 8; doff++) {
+        for (soff = 0; soff < 8; soff++) {
+            for (len = 0; len < 100; len++) {
+                /* memcpy */
+                memfunc_test_fill();
+                for (i = 0; i < len; i++) {
+                    memfunc_test_exp[doff + i] = memfunc_test_src[soff + i];
+                }
+                rc = memcpy(memfunc_test_dst + doff, memfunc_test_src + soff,
+                            len);
+                TEST_ASSERT_FATAL(rc == memfunc_test_dst + doff);
+                TEST_ASSERT_FATAL(memfunc_test_cmp() == 0,
+                                  "memcpy doff=%d soff=%d len=%d",
+                                  doff, soff, len);
+
+                /* memcmp; equal, then differing in the last byte */
+                TEST_ASSERT_FATAL(memcmp(memfunc_test_dst + doff,
+                                         memfunc_test_src + soff, len) == 0);
+                if (len > 0) {
+                    memfunc_test_dst[doff + len - 1]++;
+                    TEST_ASSERT_FATAL(
+                        memfunc_test_sign(memcmp(memfunc_test_dst + doff,
+                                                 memfunc_test_src + soff,
+                                                 len)) ==
+                        memfunc_test_sign(memfunc_test_dst[doff + len - 1] -
+                                          memfunc_test_src[soff + len - 1]),
+                        "memcmp doff=%d soff=%d len=%d", doff, soff, len);
+                }
+
+                /* memset */
+                memfunc_test_fill();
+                for (i = 0; i < len; i++) {
+                    memfunc_test_exp[doff + i] = soff + 0x80;
+                }
+                rc = memset(memfunc_test_dst + doff, soff + 0x80, len);
+                TEST_ASSERT_FATAL(rc == memfunc_test_dst + doff);
+                TEST_ASSERT_FATAL(memfunc_test_cmp() == 0,
+                                  "memset doff=%d len=%d", doff, len);
+
+                /* memmove, overlapping in both directions */
+                memfunc_test_fill();
+                memcpy(memfunc_test_dst, memfunc_test_src,
+                       MEMFUNC_TEST_BUF_SIZE);
+                memcpy(memfunc_test_exp, memfunc_test_src,
+                       MEMFUNC_TEST_BUF_SIZE);
+                for (i = 0; i < len; i++) {
+                    memfunc_test_exp[doff * 3 + i] =
+                        memfunc_test_src[soff * 3 + i];
+                }
+                rc = memmove(memfunc_test_dst + doff * 3,
+                             memfunc_test_dst + soff * 3, len);
+                TEST_ASSERT_FATAL(rc == memfunc_test_dst + doff * 3);
+                TEST_ASSERT_FATAL(memfunc_test_cmp() == 0,
+                                  "memmove doff=%d soff=%d len=%d",
+                                  doff * 3, soff * 3, len);
+            }
+        }
+    }
+}
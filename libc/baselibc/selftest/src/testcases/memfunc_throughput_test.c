@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+#define MEMFUNC_PERF_BUF_SIZE   4096
+#define MEMFUNC_PERF_ROUNDS     4000
+
+static uint8_t memfunc_perf_src[MEMFUNC_PERF_BUF_SIZE];
+static uint8_t memfunc_perf_dst[MEMFUNC_PERF_BUF_SIZE];
+
+/* Byte at a time copy; volatile keeps the compiler from turning it into a
+ * memcpy() call.
+ */
+static void
+memfunc_perf_copy_bytes(volatile uint8_t *dst, const volatile uint8_t *src,
+                        size_t n)
+{
+    while (n--) {
+        *dst++ = *src++;
+    }
+}
+
+static void
+memfunc_perf_set_bytes(volatile uint8_t *dst, int c, size_t n)
+{
+    while (n--) {
+        *dst++ = c;
+    }
+}
+
+static void
+memfunc_perf_report(const char *name, uint64_t start)
+{
+    uint32_t usecs;
+
+    usecs = os_get_uptime_usec() - start;
+    printf("%-16s %8lu us for %d x %d bytes\n", name, (unsigned long)usecs,
+           MEMFUNC_PERF_ROUNDS, MEMFUNC_PERF_BUF_SIZE);
+}
+
+/*
+ * Times memcpy(), memset() and memcmp() on a buffer with mismatched
+ * alignment, against plain byte loops.  The timings depend on host load, so
+ * they are only reported, not checked.
+ */
+TEST_CASE_TASK(memfunc_throughput_test)
+{
+    uint64_t start;
+    int i;
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < MEMFUNC_PERF_ROUNDS; i++) {
+        memfunc_perf_copy_bytes(memfunc_perf_dst + 1, memfunc_perf_src,
+                                MEMFUNC_PERF_BUF_SIZE - 1);
+    }
+    memfunc_perf_report("byte copy", start);
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < MEMFUNC_PERF_ROUNDS; i++) {
+        memcpy(memfunc_perf_dst + 1, memfunc_perf_src,
+               MEMFUNC_PERF_BUF_SIZE - 1);
+    }
+    memfunc_perf_report("memcpy", start);
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < MEMFUNC_PERF_ROUNDS; i++) {
+        TEST_ASSERT_FATAL(memcmp(memfunc_perf_dst + 1, memfunc_perf_src,
+                                 MEMFUNC_PERF_BUF_SIZE - 1) == 0);
+    }
+    memfunc_perf_report("memcmp", start);
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < MEMFUNC_PERF_ROUNDS; i++) {
+        memfunc_perf_set_bytes(memfunc_perf_dst + 1, i,
+                               MEMFUNC_PERF_BUF_SIZE - 1);
+    }
+    memfunc_perf_report("byte set", start);
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < MEMFUNC_PERF_ROUNDS; i++) {
+        memset(memfunc_perf_dst + 1, i, MEMFUNC_PERF_BUF_SIZE - 1);
+    }
+    memfunc_perf_report("memset", start);
+}
@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "klibc/memword.h"
+#include "testutil/testutil.h"
+
+#define MEMWORD_TEST_BUF_SIZE   256
+
+static unsigned char memword_test_src[MEMWORD_TEST_BUF_SIZE];
+static unsigned char memword_test_dst[MEMWORD_TEST_BUF_SIZE];
+static unsigned char memword_test_exp[MEMWORD_TEST_BUF_SIZE];
+
+static void
+memword_test_fill(void)
+{
+    int i;
+
+    for (i = 0; i < MEMWORD_TEST_BUF_SIZE; i++) {
+        memword_test_src[i] = i * 13 + 1;
+        memword_test_dst[i] = i * 7 + 3;
+        memword_test_exp[i] = i * 7 + 3;
+    }
+}
+
+static int
+memword_test_cmp(void)
+{
+    int i;
+
+    for (i = 0; i < MEMWORD_TEST_BUF_SIZE; i++) {
+        if (memword_test_dst[i] != memword_test_exp[i]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Exercises the C word at a time helpers directly.  On some targets (e.g. the
+ * x86 native sim) memcpy(), memset() and memmove() use assembly instead, so
+ * memfunc_test alone would never reach this code.
+ */
+TEST_CASE_SELF(memword_test)
+{
+    int dist;
+    int doff;
+    int soff;
+    int len;
+    int i;
+
+    for (doff = 0; doff < 8; doff++) {
+        for (soff = 0; soff < 8; soff++) {
+            for (len = 0; len < 100; len++) {
+                /* Forward copy between separate buffers */
+                memword_test_fill();
+                for (i = 0; i < len; i++) {
+                    memword_test_exp[doff + i] = memword_test_src[soff + i];
+                }
+                memword_copy_fwd((char *)memword_test_dst + doff,
+                                 (const char *)memword_test_src + soff, len);
+                TEST_ASSERT_FATAL(memword_test_cmp() == 0,
+                                  "fwd doff=%d soff=%d len=%d",
+                                  doff, soff, len);
+
+                /*
+                 * Overlapping copies, with the source 1..8 bytes above
+                 * (forward) or below (backward) the destination.
+                 */
+                dist = soff + 1;
+
+                memword_test_fill();
+                for (i = 0; i < len; i++) {
+                    memword_test_exp[doff + i] =
+                        memword_test_dst[doff + dist + i];
+                }
+                memword_copy_fwd((char *)memword_test_dst + doff,
+                                 (const char *)memword_test_dst + doff + dist,
+                                 len);
+                TEST_ASSERT_FATAL(memword_test_cmp() == 0,
+                                  "fwd overlap doff=%d dist=%d len=%d",
+                                  doff, dist, len);
+
+                memword_test_fill();
+                for (i = 0; i < len; i++) {
+                    memword_test_exp[doff + dist + i] =
+                        memword_test_dst[doff + i];
+                }
+                memword_copy_bwd((char *)memword_test_dst + doff + dist,
+                                 (const char *)memword_test_dst + doff, len);
+                TEST_ASSERT_FATAL(memword_test_cmp() == 0,
+                                  "bwd overlap doff=%d dist=%d len=%d",
+                                  doff, dist, len);
+
+                /* Backward copy between separate buffers */
+                memword_test_fill();
+                for (i = 0; i < len; i++) {
+                    memword_test_exp[doff + i] = memword_test_src[soff + i];
+                }
+                memword_copy_bwd((char *)memword_test_dst + doff,
+                                 (const char *)memword_test_src + soff, len);
+                TEST_ASSERT_FATAL(memword_test_cmp() == 0,
+                                  "bwd doff=%d soff=%d len=%d",
+                                  doff, soff, len);
+
+                /* Fill; only the low byte of the value is used */
+                memword_test_fill();
+                for (i = 0; i < len; i++) {
+                    memword_test_exp[doff + i] = soff + 0x80;
+                }
+                memword_set((char *)memword_test_dst + doff,
+                            0x100 + soff + 0x80, len);
+                TEST_ASSERT_FATAL(memword_test_cmp() == 0,
+                                  "set doff=%d len=%d", doff, len);
+            }
+        }
+    }
+}
@@ -3,6 +3,7 @@
  */
 
 #include <string.h>
+#include "klibc/memword.h"
 
 int memcmp(const void *s1, const void *s2, size_t n)
 {
@@ -44,6 +45,29 @@ int memcmp(const void *s1, const void *s2, size_t n)
 #else
 	const unsigned char *c1 = s1, *c2 = s2;
 
+	/*
+	 * Skip over equal words; the byte loop below then locates the first
+	 * difference, if any.
+	 */
+	if (n >= 2 * MEMWORD_SIZE) {
+		while (!MEMWORD_ALIGNED(c1)) {
+			d = (int)*c1++ - (int)*c2++;
+			n--;
+			if (d)
+				return d;
+		}
+
+		if (MEMWORD_SRC_OK(c2)) {
+			while (n >= MEMWORD_SIZE &&
+			       *(const memword_t *)c1 ==
+			       *(const memword_src_t *)c2) {
+				c1 += MEMWORD_SIZE;
+				c2 += MEMWORD_SIZE;
+				n -= MEMWORD_SIZE;
+			}
+		}
+	}
+
 	while (n--) {
 		d = (int)*c1++ - (int)*c2++;
 		if (d)
@@ -4,6 +4,7 @@
 
 #include <string.h>
 #include <stdint.h>
+#include "klibc/memword.h"
 
 void *memcpy(void *dst, const void *src, size_t n)
 {
@@ -19,36 +20,8 @@ void *memcpy(void *dst, const void *src, size_t n)
 	asm volatile ("cld ; rep ; movsq ; movl %3,%%ecx ; rep ; movsb":"+c"
 		      (nq), "+S"(p), "+D"(q)
 		      :"r"((uint32_t) (n & 7)));
-#elif defined(__arm__)
-        (void)p;
-        (void)q;
-
-#if defined(__ARM_FEATURE_UNALIGNED)
-        /*
-         * We can speed up a bit by moving 32-bit words if unaligned access is
-         * supported (e.g. Cortex-M3/4/7/33).
-         */
-        asm (".syntax unified           \n"
-             "       b    test1         \n"
-             "loop1: ldr  r3, [r1, r2]  \n"
-             "       str  r3, [r0, r2]  \n"
-             "test1: subs r2, #4        \n"
-             "       bpl  loop1         \n"
-             "       add  r2, #4        \n"
-            );
-#endif
-
-        asm (".syntax unified           \n"
-             "       b    test2         \n"
-             "loop2: ldrb r3, [r1, r2]  \n"
-             "       strb r3, [r0, r2]  \n"
-             "test2: subs r2, #1        \n"
-             "       bpl  loop2         \n"
-            );
 #else
-	while (n--) {
-		*q++ = *p++;
-	}
+	memword_copy_fwd(q, p, n);
 #endif
 
 	return dst;
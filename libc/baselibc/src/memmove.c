@@ -3,33 +3,29 @@
  */
 
 #include <string.h>
+#include <stdint.h>
+#include "klibc/memword.h"
 
 void *memmove(void *dst, const void *src, size_t n)
 {
 	const char *p = src;
 	char *q = dst;
-#if defined(__i386__) || defined(__x86_64__)
-	if (q < p) {
-		asm volatile("cld; rep; movsb"
-			     : "+c" (n), "+S"(p), "+D"(q));
-	} else {
-		p += (n - 1);
-		q += (n - 1);
-		asm volatile("std; rep; movsb; cld"
-			     : "+c" (n), "+S"(p), "+D"(q));
+
+	/*
+	 * Copy upwards unless dst overlaps the tail of src; memcpy() copies
+	 * upwards too, so it handles dst below src.
+	 */
+	if ((uintptr_t)q - (uintptr_t)p >= n) {
+		return memcpy(dst, src, n);
 	}
+
+#if defined(__i386__) || defined(__x86_64__)
+	p += (n - 1);
+	q += (n - 1);
+	asm volatile("std; rep; movsb; cld"
+		     : "+c" (n), "+S"(p), "+D"(q));
 #else
-	if (q < p) {
-		while (n--) {
-			*q++ = *p++;
-		}
-	} else {
-		p += n;
-		q += n;
-		while (n--) {
-			*--q = *--p;
-		}
-	}
+	memword_copy_bwd(q, p, n);
 #endif
 
 	return dst;
@@ -4,6 +4,7 @@
 
 #include <string.h>
 #include <stdint.h>
+#include "klibc/memword.h"
 
 #if defined(__arm__)
 #include <mcu/cmsis_nvic.h>
@@ -67,9 +68,7 @@ void *memset(void *dst, int c, size_t n)
                   : "r3", "r4", "memory"
                  );
 #else
-	while (n--) {
-		*q++ = c;
-	}
+	memword_set(q, c, n);
 #endif
 
 	return dst;
@@ -47,7 +47,9 @@ extern "C" {
 #define COAP_OBSERVER_URL_LEN 20
 
 typedef struct coap_observer {
-  SLIST_ENTRY(coap_observer) next;
+  LIST_ENTRY(coap_observer) res_next; /* observers of the same resource */
+  LIST_ENTRY(coap_observer) ep_next;  /* endpoint hash bucket */
+  uint32_t ep_hash;
 
   oc_resource_t *resource;
 
@@ -55,13 +55,14 @@ extern "C" {
 
 /* container for transactions with message buffer and retransmission info */
 typedef struct coap_transaction {
-    SLIST_ENTRY(coap_transaction) next;
+    LIST_ENTRY(coap_transaction) next;
 
     uint16_t mid;
     uint8_t retrans_counter;
     coap_message_type_t type;
     uint32_t retrans_tmo;
-    struct os_callout retrans_timer;
+    os_time_t retrans_time;     /* when to retransmit */
+    int16_t retrans_idx;        /* position in retransmission heap, or -1 */
     struct os_mbuf *m;
 } coap_transaction_t;
 
@@ -55,6 +55,7 @@ typedef void (*oc_response_handler_t)(oc_client_response_t *);
 
 typedef struct oc_client_cb {
     SLIST_ENTRY(oc_client_cb) next;
+    LIST_ENTRY(oc_client_cb) mid_next;
     struct os_callout callout;
     oc_string_t uri;
     uint8_t token[COAP_TOKEN_LEN];
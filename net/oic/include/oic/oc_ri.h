@@ -30,6 +30,7 @@ extern "C" {
 struct oc_separate_response;
 struct oc_response_buffer;
 struct oc_endpoint;
+struct coap_observer;
 
 typedef struct oc_response {
     struct oc_separate_response *separate_response;
@@ -49,6 +50,8 @@ typedef void (*oc_request_handler_t)(oc_request_t *, oc_interface_mask_t);
 
 typedef struct oc_resource {
   SLIST_ENTRY(oc_resource) next;
+  SLIST_ENTRY(oc_resource) hash_next;
+  uint32_t uri_hash;
   int device;
   oc_string_t uri;
   oc_string_array_t types;
@@ -61,7 +64,8 @@ typedef struct oc_resource {
   oc_request_handler_t delete_handler;
   struct os_callout callout;
   uint32_t observe_period_mseconds;
-  uint8_t num_observers;
+  uint16_t num_observers;
+  LIST_HEAD(, coap_observer) observers;
 } oc_resource_t;
 
 void oc_ri_init(void);
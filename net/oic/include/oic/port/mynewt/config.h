@@ -57,10 +57,20 @@ typedef os_time_t oc_clock_time_t;
 /* Maximum number of server resources */
 #define MAX_APP_RESOURCES MYNEWT_VAL(OC_APP_RESOURCES)
 
+/* Maximum number of observers; by default sized from the above */
+#if MYNEWT_VAL(OC_MAX_OBSERVERS) > 0
+#define COAP_MAX_OBSERVERS MYNEWT_VAL(OC_MAX_OBSERVERS)
+#endif
+
 /* Common paramters */
 /* Maximum number of concurrent requests */
 #define MAX_NUM_CONCURRENT_REQUESTS MYNEWT_VAL(OC_CONCURRENT_REQUESTS)
 
+/* Maximum number of open transactions; by default sized from the above */
+#if MYNEWT_VAL(OC_MAX_TRANSACTIONS) > 0
+#define COAP_MAX_OPEN_TRANSACTIONS MYNEWT_VAL(OC_MAX_TRANSACTIONS)
+#endif
+
 /* Estimated number of nodes in payload tree structure */
 #define EST_NUM_REP_OBJECTS MYNEWT_VAL(OC_NUM_REP_OBJECTS)
 
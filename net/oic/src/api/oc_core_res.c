@@ -21,6 +21,7 @@
 #include "oic/messaging/coap/oc_coap.h"
 #include "oic/oc_rep.h"
 #include "oic/oc_ri.h"
+#include "api/oc_priv.h"
 
 #ifdef OC_SECURITY
 #include "security/oc_pstat.h"
@@ -264,6 +265,7 @@ oc_core_populate_resource(int type, const char *uri, const char *rt,
     oc_resource_t *r = &core_resources[type];
     r->device = device;
     oc_new_string(&r->uri, uri);
+    oc_ri_hash_uri(r);
     r->properties = properties;
     oc_new_string_array(&r->types, 1);
     oc_string_array_add_item(r->types, rt);
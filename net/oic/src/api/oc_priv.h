@@ -23,4 +23,12 @@ void oc_rep_init(void);
 void oc_buffer_init(void);
 void oc_ri_mem_init(void);
 
+struct oc_resource;
+
+/*
+ * Sets the uri_hash of a resource from its URI.  Must be called when the
+ * URI is set, before requests are dispatched to the resource.
+ */
+void oc_ri_hash_uri(struct oc_resource *resource);
+
 #endif /* __OC_OC_PRIV_H__ */
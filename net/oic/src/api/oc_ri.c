@@ -50,12 +50,28 @@ static struct os_mempool oc_resource_pool;
 static uint8_t oc_resource_area[OS_MEMPOOL_BYTES(MAX_APP_RESOURCES,
       sizeof(oc_resource_t))];
 
+/*
+ * Application resources are also hashed by URI, so requests are dispatched
+ * without comparing the URI against every resource.
+ */
+#define OC_RES_BUCKETS MYNEWT_VAL(OC_RESOURCE_HASH_SIZE)
+
+static SLIST_HEAD(oc_res_bucket, oc_resource) oc_res_table[OC_RES_BUCKETS];
+
 static void periodic_observe_handler(struct os_event *ev);
 #endif /* OC_SERVER */
 
 #ifdef OC_CLIENT
 #include "oc_client_state.h"
 static SLIST_HEAD(, oc_client_cb) oc_client_cbs;
+
+/*
+ * Client requests are also hashed by the MID of their transaction.
+ */
+#define OC_CLIENT_CB_BUCKETS MYNEWT_VAL(OC_TRANSACTION_HASH_SIZE)
+
+static LIST_HEAD(oc_client_cb_bucket, oc_client_cb)
+    oc_client_cb_table[OC_CLIENT_CB_BUCKETS];
 static struct os_mempool oc_client_cb_pool;
 static uint8_t oc_client_cb_area[OS_MEMPOOL_BYTES(MAX_NUM_CONCURRENT_REQUESTS,
       sizeof(oc_client_cb_t))];
@@ -190,26 +206,86 @@ stop_processes(void)
 #endif
 }
 
+/*
+ * Hash of a request Uri-Path, i.e. of a resource URI without its leading
+ * '/'.
+ */
+static uint32_t
+oc_ri_uri_hash(const char *path, int len)
+{
+    uint32_t hash = 2166136261u;  /* FNV-1a */
+
+    while (len-- > 0) {
+        hash = (hash ^ (uint8_t)*path++) * 16777619u;
+    }
+    return hash;
+}
+
+void
+oc_ri_hash_uri(oc_resource_t *resource)
+{
+    int len = oc_string_len(resource->uri);
+
+    resource->uri_hash = 0;
+    if (len > 0) {
+        resource->uri_hash = oc_ri_uri_hash(oc_string(resource->uri) + 1,
+                                            len - 1);
+    }
+}
+
+/*
+ * Whether the URI of `res` is `path`, with a leading '/' added.
+ */
+static bool
+oc_ri_uri_match(oc_resource_t *res, const char *path, int len, uint32_t hash)
+{
+    return res->uri_hash == hash &&
+      oc_string_len(res->uri) == len + 1 &&
+      strncmp(oc_string(res->uri) + 1, path, len) == 0;
+}
+
 #ifdef OC_SERVER
-oc_resource_t *
-oc_ri_get_app_resource_by_uri(const char *uri)
+static struct oc_res_bucket *
+oc_ri_res_bucket(uint32_t hash)
+{
+    return &oc_res_table[hash % OC_RES_BUCKETS];
+}
+
+static oc_resource_t *
+oc_ri_find_app_resource(const char *path, int len, uint32_t hash)
 {
     oc_resource_t *res;
 
-    SLIST_FOREACH(res, &oc_app_resources, next) {
-        if (oc_string_len(res->uri) == strlen(uri) &&
-          strncmp(uri, oc_string(res->uri), strlen(uri)) == 0)
+    SLIST_FOREACH(res, oc_ri_res_bucket(hash), hash_next) {
+        if (oc_ri_uri_match(res, path, len, hash)) {
             return res;
+        }
     }
-
     return NULL;
 }
+
+oc_resource_t *
+oc_ri_get_app_resource_by_uri(const char *uri)
+{
+    int len = strlen(uri);
+
+    if (len == 0 || uri[0] != '/') {
+        return NULL;
+    }
+    return oc_ri_find_app_resource(uri + 1, len - 1,
+                                   oc_ri_uri_hash(uri + 1, len - 1));
+}
 #endif
 
 void
 oc_ri_mem_init(void)
 {
 #ifdef OC_SERVER
+  int i;
+
+  for (i = 0; i < OC_RES_BUCKETS; i++) {
+      SLIST_INIT(&oc_res_table[i]);
+  }
   os_mempool_init(&oc_resource_pool, MAX_APP_RESOURCES, sizeof(oc_resource_t),
                   oc_resource_area, "oc_res");
 #endif
@@ -225,7 +301,12 @@ void
 oc_ri_init(void)
 {
 #ifdef OC_CLIENT
+    int i;
+
     SLIST_INIT(&oc_client_cbs);
+    for (i = 0; i < OC_CLIENT_CB_BUCKETS; i++) {
+        LIST_INIT(&oc_client_cb_table[i]);
+    }
 #endif
 
     start_processes();
@@ -257,13 +338,19 @@ void
 oc_ri_delete_resource(oc_resource_t *resource)
 {
     oc_resource_t *tmp;
+    coap_observer_t *obs;
 
     SLIST_FOREACH(tmp, &oc_app_resources, next) {
         if (tmp == resource) {
             SLIST_REMOVE(&oc_app_resources, tmp, oc_resource, next);
+            SLIST_REMOVE(oc_ri_res_bucket(tmp->uri_hash), tmp, oc_resource,
+                         hash_next);
             break;
         }
     }
+    while ((obs = LIST_FIRST(&resource->observers))) {
+        coap_remove_observer(obs);
+    }
     os_memblock_put(&oc_resource_pool, resource);
 }
 
@@ -281,7 +368,10 @@ oc_ri_add_resource(oc_resource_t *resource)
         valid = false;
     }
     if (valid) {
+        oc_ri_hash_uri(resource);
         SLIST_INSERT_HEAD(&oc_app_resources, resource, next);
+        SLIST_INSERT_HEAD(oc_ri_res_bucket(resource->uri_hash), resource,
+                          hash_next);
     }
 
     return valid;
@@ -460,13 +550,13 @@ oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
    */
   /* Check against list of declared core resources.
    */
+  uint32_t uri_hash = oc_ri_uri_hash(uri_path, uri_path_len);
+
   if (!bad_request) {
     int i;
     for (i = 0; i < NUM_OC_CORE_RESOURCES; i++) {
       resource = oc_core_get_resource_by_index(i);
-      if (oc_string_len(resource->uri) == (uri_path_len + 1) &&
-          strncmp((const char *)oc_string(resource->uri) + 1, uri_path,
-                  uri_path_len) == 0) {
+      if (oc_ri_uri_match(resource, uri_path, uri_path_len, uri_hash)) {
         request_obj.resource = cur_resource = resource;
         break;
       }
@@ -474,17 +564,11 @@ oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
   }
 
 #ifdef OC_SERVER
-  /* Check against list of declared application resources.
+  /* Check against table of declared application resources.
    */
   if (!cur_resource && !bad_request) {
-      SLIST_FOREACH(resource, &oc_app_resources, next) {
-          if (oc_string_len(resource->uri) == (uri_path_len + 1) &&
-            strncmp((const char *)oc_string(resource->uri) + 1, uri_path,
-              uri_path_len) == 0) {
-              request_obj.resource = cur_resource = resource;
-              break;
-          }
-      }
+      cur_resource = oc_ri_find_app_resource(uri_path, uri_path_len, uri_hash);
+      request_obj.resource = cur_resource;
   }
 #endif
 
@@ -691,12 +775,19 @@ oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
 }
 
 #ifdef OC_CLIENT
+static struct oc_client_cb_bucket *
+oc_ri_client_cb_bucket(uint16_t mid)
+{
+    return &oc_client_cb_table[mid % OC_CLIENT_CB_BUCKETS];
+}
+
 static void
 free_client_cb(oc_client_cb_t *cb)
 {
     os_callout_stop(&cb->callout);
     oc_free_string(&cb->uri);
     SLIST_REMOVE(&oc_client_cbs, cb, oc_client_cb, next);
+    LIST_REMOVE(cb, mid_next);
     os_memblock_put(&oc_client_cb_pool, cb);
 }
 
@@ -705,7 +796,7 @@ oc_ri_remove_client_cb_by_mid(uint16_t mid)
 {
     oc_client_cb_t *cb;
 
-    SLIST_FOREACH(cb, &oc_client_cbs, next) {
+    LIST_FOREACH(cb, oc_ri_client_cb_bucket(mid), mid_next) {
         if (cb->mid == mid) {
             break;
         }
@@ -902,6 +993,7 @@ oc_ri_alloc_client_cb(const char *uri, oc_server_handle_t *server,
     os_callout_init(&cb->callout, oc_evq_get(), oc_ri_remove_cb, cb);
 
     SLIST_INSERT_HEAD(&oc_client_cbs, cb, next);
+    LIST_INSERT_HEAD(oc_ri_client_cb_bucket(cb->mid), cb, mid_next);
     return cb;
 }
 #endif /* OC_CLIENT */
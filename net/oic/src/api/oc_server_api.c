@@ -113,6 +113,7 @@ oc_new_resource(const char *uri, uint8_t num_resource_types, int device)
   resource->observe_period_mseconds = 0;
   resource->properties = OC_ACTIVE;
   resource->num_observers = 0;
+  LIST_INIT(&resource->observers);
   resource->device = device;
   return resource;
 }
@@ -48,7 +48,15 @@
 /*-------------------*/
 uint64_t observe_counter = 3;
 /*---------------------------------------------------------------------------*/
-static SLIST_HEAD(, coap_observer) oc_observers;
+/*
+ * Observers are linked on the list of the resource they observe, and
+ * hashed by client endpoint.  Notifications walk only the observers of
+ * the resource, removals only the bucket of the endpoint.
+ */
+#define COAP_OBSERVER_BUCKETS MYNEWT_VAL(OC_OBSERVER_HASH_SIZE)
+
+static LIST_HEAD(coap_observer_bucket, coap_observer)
+    coap_observer_table[COAP_OBSERVER_BUCKETS];
 
 static struct os_mempool coap_observer_pool;
 static uint8_t coap_observer_area[OS_MEMPOOL_BYTES(COAP_MAX_OBSERVERS,
@@ -57,6 +65,57 @@ static uint8_t coap_observer_area[OS_MEMPOOL_BYTES(COAP_MAX_OBSERVERS,
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+static uint32_t
+coap_observer_ep_hash(const oc_endpoint_t *endpoint, int len)
+{
+    const uint8_t *p = (const uint8_t *)endpoint;
+    uint32_t hash = 2166136261u;  /* FNV-1a */
+
+    while (len-- > 0) {
+        hash = (hash ^ *p++) * 16777619u;
+    }
+    return hash;
+}
+
+static struct coap_observer_bucket *
+coap_observer_bucket(uint32_t hash)
+{
+    return &coap_observer_table[hash % COAP_OBSERVER_BUCKETS];
+}
+
+static int
+coap_observer_ep_match(const coap_observer_t *obs, const oc_endpoint_t *ep,
+                       uint32_t hash, int len)
+{
+    return obs->ep_hash == hash && memcmp(&obs->endpoint, ep, len) == 0;
+}
+
+/*
+ * Returns the observer following `obs`, or the first one if `obs` is NULL.
+ * With a resource, walks the observers of that resource.  Otherwise walks
+ * hash buckets `*bucket` through `last`; `*bucket` keeps track of the next
+ * bucket to visit.
+ */
+static coap_observer_t *
+coap_observer_next(coap_observer_t *obs, oc_resource_t *resource,
+                   int *bucket, int last)
+{
+    if (resource) {
+        if (obs) {
+            return LIST_NEXT(obs, res_next);
+        }
+        return LIST_FIRST(&resource->observers);
+    }
+    if (obs) {
+        obs = LIST_NEXT(obs, ep_next);
+    }
+    while (!obs && *bucket <= last) {
+        obs = LIST_FIRST(&coap_observer_table[*bucket]);
+        (*bucket)++;
+    }
+    return obs;
+}
+
 static int
 add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
              const uint8_t *token, size_t token_len, const char *uri,
@@ -64,6 +123,7 @@ add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
 {
     /* Remove existing observe relationship, if any. */
     int dup = coap_remove_observer_by_uri(endpoint, uri);
+    int ep_len;
 
     coap_observer_t *o = os_memblock_get(&coap_observer_pool);
 
@@ -74,7 +134,9 @@ add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
         }
         memcpy(o->url, uri, max);
         o->url[max] = 0;
-        memcpy(&o->endpoint, endpoint, oc_endpoint_size(endpoint));
+        ep_len = oc_endpoint_size(endpoint);
+        memcpy(&o->endpoint, endpoint, ep_len);
+        o->ep_hash = coap_observer_ep_hash(endpoint, ep_len);
         o->token_len = token_len;
         memcpy(o->token, token, token_len);
         o->last_mid = 0;
@@ -84,7 +146,8 @@ add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
         OC_LOG_DEBUG("Adding observer (%u/%u) for /%s [0x%02X%02X]\n",
           coap_observer_pool.mp_num_blocks - coap_observer_pool.mp_num_free,
           coap_observer_pool.mp_num_blocks, o->url, o->token[0], o->token[1]);
-        SLIST_INSERT_HEAD(&oc_observers, o, next);
+        LIST_INSERT_HEAD(&resource->observers, o, res_next);
+        LIST_INSERT_HEAD(coap_observer_bucket(o->ep_hash), o, ep_next);
         return dup;
     }
     return -1;
@@ -97,7 +160,8 @@ coap_remove_observer(coap_observer_t *o)
 {
     OC_LOG_DEBUG("Removing observer for /%s [0x%02X%02X]\n",
                  o->url, o->token[0], o->token[1]);
-    SLIST_REMOVE(&oc_observers, o, coap_observer, next);
+    LIST_REMOVE(o, res_next);
+    LIST_REMOVE(o, ep_next);
     os_memblock_put(&coap_observer_pool, o);
 }
 /*---------------------------------------------------------------------------*/
@@ -105,12 +169,14 @@ int
 coap_remove_observer_by_client(oc_endpoint_t *endpoint)
 {
     int removed = 0;
+    int len = oc_endpoint_size(endpoint);
+    uint32_t hash = coap_observer_ep_hash(endpoint, len);
     coap_observer_t *obs, *next;
 
-    obs = SLIST_FIRST(&oc_observers);
+    obs = LIST_FIRST(coap_observer_bucket(hash));
     while (obs) {
-        next = SLIST_NEXT(obs, next);
-        if (memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0) {
+        next = LIST_NEXT(obs, ep_next);
+        if (coap_observer_ep_match(obs, endpoint, hash, len)) {
             obs->resource->num_observers--;
             coap_remove_observer(obs);
             removed++;
@@ -124,36 +190,34 @@ int
 coap_remove_observer_by_token(oc_endpoint_t *endpoint, uint8_t *token,
                               size_t token_len)
 {
-    int removed = 0;
-    coap_observer_t *obs, *next;
+    int len = oc_endpoint_size(endpoint);
+    uint32_t hash = coap_observer_ep_hash(endpoint, len);
+    coap_observer_t *obs;
 
-    obs = SLIST_FIRST(&oc_observers);
-    while (obs) {
-        next = SLIST_NEXT(obs, next);
-        if (memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0 &&
+    LIST_FOREACH(obs, coap_observer_bucket(hash), ep_next) {
+        if (coap_observer_ep_match(obs, endpoint, hash, len) &&
           obs->token_len == token_len &&
           memcmp(obs->token, token, token_len) == 0) {
             obs->resource->num_observers--;
             coap_remove_observer(obs);
-            removed++;
-            break;
+            return 1;
         }
-        obs = next;
     }
-    return removed;
+    return 0;
 }
 /*---------------------------------------------------------------------------*/
 int
 coap_remove_observer_by_uri(oc_endpoint_t *endpoint, const char *uri)
 {
     int removed = 0;
+    int len = oc_endpoint_size(endpoint);
+    uint32_t hash = coap_observer_ep_hash(endpoint, len);
     coap_observer_t *obs, *next;
 
-    obs = SLIST_FIRST(&oc_observers);
+    obs = LIST_FIRST(coap_observer_bucket(hash));
     while (obs) {
-        next = SLIST_NEXT(obs, next);
-        if (((memcmp(&obs->endpoint, endpoint,
-                     oc_endpoint_size(endpoint)) == 0)) &&
+        next = LIST_NEXT(obs, ep_next);
+        if (coap_observer_ep_match(obs, endpoint, hash, len) &&
           (obs->url == uri || memcmp(obs->url, uri, strlen(obs->url)) == 0)) {
             obs->resource->num_observers--;
             coap_remove_observer(obs);
@@ -167,33 +231,32 @@ coap_remove_observer_by_uri(oc_endpoint_t *endpoint, const char *uri)
 int
 coap_remove_observer_by_mid(oc_endpoint_t *endpoint, uint16_t mid)
 {
-    int removed = 0;
-    coap_observer_t *obs, *next;
+    int len = oc_endpoint_size(endpoint);
+    uint32_t hash = coap_observer_ep_hash(endpoint, len);
+    coap_observer_t *obs;
 
-    obs = SLIST_FIRST(&oc_observers);
-    while (obs) {
-        next = SLIST_NEXT(obs, next);
-        if (memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0 &&
+    LIST_FOREACH(obs, coap_observer_bucket(hash), ep_next) {
+        if (coap_observer_ep_match(obs, endpoint, hash, len) &&
           obs->last_mid == mid) {
             obs->resource->num_observers--;
             coap_remove_observer(obs);
-            removed++;
-            break;
+            return 1;
         }
-        obs = next;
     }
-    return removed;
+    return 0;
 }
 
 void
 coap_observer_walk(int (*walk_func)(struct coap_observer *, void *), void *arg)
 {
     struct coap_observer *obs, *next;
+    int bucket = 0;
     int rc;
 
-    obs = SLIST_FIRST(&oc_observers);
+    obs = coap_observer_next(NULL, NULL, &bucket, COAP_OBSERVER_BUCKETS - 1);
     while (obs) {
-        next = SLIST_NEXT(obs, next);
+        next = coap_observer_next(obs, NULL, &bucket,
+                                  COAP_OBSERVER_BUCKETS - 1);
         rc = walk_func(obs, arg);
         if (rc) {
             break;
@@ -205,6 +268,64 @@ coap_observer_walk(int (*walk_func)(struct coap_observer *, void *), void *arg)
 /*---------------------------------------------------------------------------*/
 /*- Notification ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/*
+ * Encoded representation shared by the notifications to all observers.
+ */
+struct coap_notify_payload {
+    struct os_mbuf_ext cnp_ext;
+    uint8_t cnp_data[0];
+};
+
+static void
+coap_notify_payload_free(struct os_mbuf_ext *ext, void *arg)
+{
+    os_free(arg);
+}
+
+/*
+ * Moves the representation in m to an external buffer.  coap_set_payload()
+ * duplicates the returned chain for each observer, which then references
+ * the buffer instead of copying it.  If memory runs out, m is returned as
+ * it is, to be copied.
+ */
+static struct os_mbuf *
+coap_notify_payload_share(struct os_mbuf *m)
+{
+    struct coap_notify_payload *cnp;
+    struct os_mbuf *hdr;
+    struct os_mbuf *om;
+    uint16_t len;
+
+    len = OS_MBUF_PKTLEN(m);
+    if (!len) {
+        return m;
+    }
+    cnp = os_malloc(sizeof(*cnp) + len);
+    if (!cnp) {
+        return m;
+    }
+    os_mbuf_copydata(m, 0, len, cnp->cnp_data);
+    os_mbuf_ext_init(&cnp->cnp_ext, cnp->cnp_data, len,
+                     coap_notify_payload_free, cnp);
+
+    hdr = os_msys_get_pkthdr(0, 0);
+    om = NULL;
+    if (hdr) {
+        om = os_mbuf_get_ext(hdr->om_omp, &cnp->cnp_ext, 0, len);
+    }
+    /* The mbuf holds its own reference, if it was allocated. */
+    os_mbuf_ext_release(&cnp->cnp_ext);
+    if (!om) {
+        if (hdr) {
+            os_mbuf_free_chain(hdr);
+        }
+        return m;
+    }
+    os_mbuf_concat(hdr, om);
+    os_mbuf_free_chain(m);
+    return hdr;
+}
+
 int
 coap_notify_observers(oc_resource_t *resource,
                       oc_response_buffer_t *response_buf,
@@ -221,6 +342,10 @@ coap_notify_observers(oc_resource_t *resource,
     coap_packet_t notification[1];
     coap_transaction_t *transaction = NULL;
     struct os_mbuf *m = NULL;
+    uint32_t ep_hash = 0;
+    int ep_len = 0;
+    int bucket;
+    int last;
 
     if (resource) {
         if (!resource->num_observers) {
@@ -233,20 +358,34 @@ coap_notify_observers(oc_resource_t *resource,
         request.response = &response;
     }
 
-    /* iterate over observers */
-    for (obs = SLIST_FIRST(&oc_observers); obs; obs = SLIST_NEXT(obs, next)) {
-        /* skip if neither resource nor endpoint match */
-        if ((resource && resource != obs->resource) ||
-            (endpoint && memcmp(&obs->endpoint, endpoint,
-                                oc_endpoint_size(endpoint)) != 0)) {
+    if (endpoint) {
+        ep_len = oc_endpoint_size(endpoint);
+        ep_hash = coap_observer_ep_hash(endpoint, ep_len);
+        bucket = ep_hash % COAP_OBSERVER_BUCKETS;
+        last = bucket;
+    } else {
+        bucket = 0;
+        last = COAP_OBSERVER_BUCKETS - 1;
+    }
+
+    /* iterate over observers of the resource, or of the endpoint */
+    for (obs = coap_observer_next(NULL, resource, &bucket, last); obs;
+         obs = coap_observer_next(obs, resource, &bucket, last)) {
+        /* skip if endpoint does not match */
+        if (endpoint &&
+            !coap_observer_ep_match(obs, endpoint, ep_hash, ep_len)) {
             continue;
         }
 
-        response.separate_response = 0;
         num_observers = obs->resource->num_observers;
         if (!response_buf && resource) {
             OC_LOG_DEBUG("coap_notify_observers: GET request to resource\n");
-            /* performing GET on the resource */
+            /*
+             * Performing GET on the resource.  The representation is
+             * encoded once, and referenced by the notification to each
+             * observer.
+             */
+            response.separate_response = 0;
             m = os_msys_get_pkthdr(0, 0);
             if (!m) {
                 return num_observers;
@@ -261,6 +400,10 @@ coap_notify_observers(oc_resource_t *resource,
                 os_mbuf_free_chain(m);
                 return num_observers;
             }
+            if (!endpoint && num_observers > 1) {
+                m = coap_notify_payload_share(m);
+                response_buffer.buffer = m;
+            }
         }
 #if MYNEWT_VAL(OC_SEPARATE_RESPONSES)
         if (response.separate_response != NULL &&
@@ -322,14 +465,6 @@ coap_notify_observers(oc_resource_t *resource,
                 } else {
                     coap_clear_transaction(transaction);
                 }
-                if (response_buf == &response_buffer) {
-                    /*
-                     * We allocated mbuf, and it's still valid.
-                     */
-                    os_mbuf_free_chain(m);
-                    m = NULL;
-                    response_buf = NULL;
-                }
             } else if (response_buf) {
                 /*
                  * Failed to alloc transaction.
@@ -376,6 +511,11 @@ coap_observe_handler(struct coap_packet_rx *coap_req, coap_packet_t *coap_res,
 void
 coap_observe_init(void)
 {
+    int i;
+
+    for (i = 0; i < COAP_OBSERVER_BUCKETS; i++) {
+        LIST_INIT(&coap_observer_table[i]);
+    }
     os_mempool_init(&coap_observer_pool, COAP_MAX_OBSERVERS,
       sizeof(coap_observer_t), coap_observer_area, "coap_obs");
 }
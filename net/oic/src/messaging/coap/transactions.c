@@ -31,6 +31,7 @@
  * This file is part of the Contiki operating system.
  */
 
+#include <assert.h>
 #include <string.h>
 #include <stddef.h>
 
@@ -54,13 +55,163 @@
 static struct os_mempool oc_transaction_memb;
 static uint8_t oc_transaction_area[OS_MEMPOOL_BYTES(COAP_MAX_OPEN_TRANSACTIONS,
       sizeof(coap_transaction_t))];
-static SLIST_HEAD(, coap_transaction) oc_transaction_list;
+
+/*
+ * Open transactions are hashed by MID.
+ */
+#define COAP_TRANSACTION_BUCKETS MYNEWT_VAL(OC_TRANSACTION_HASH_SIZE)
+
+static LIST_HEAD(coap_transaction_bucket, coap_transaction)
+    oc_transaction_table[COAP_TRANSACTION_BUCKETS];
+
+#if COAP_MAX_OPEN_TRANSACTIONS > INT16_MAX
+#error "COAP_MAX_OPEN_TRANSACTIONS must be at most 32767"
+#endif
+
+/*
+ * Confirmable transactions waiting for an ACK are kept in a binary
+ * min-heap ordered by retransmission time.  A single callout is armed for
+ * the transaction at the root, instead of one callout per transaction.
+ */
+static coap_transaction_t *oc_transaction_heap[COAP_MAX_OPEN_TRANSACTIONS];
+static int oc_transaction_heap_cnt;
+static struct os_callout oc_transaction_timer;
 
 static void coap_transaction_retrans(struct os_event *ev);
 
+static void
+coap_transaction_heap_set(int idx, coap_transaction_t *t)
+{
+    oc_transaction_heap[idx] = t;
+    t->retrans_idx = idx;
+}
+
+static void
+coap_transaction_heap_up(int idx)
+{
+    coap_transaction_t *parent;
+    coap_transaction_t *t;
+
+    t = oc_transaction_heap[idx];
+    while (idx > 0) {
+        parent = oc_transaction_heap[(idx - 1) / 2];
+        if (!OS_TIME_TICK_LT(t->retrans_time, parent->retrans_time)) {
+            break;
+        }
+        coap_transaction_heap_set(idx, parent);
+        idx = (idx - 1) / 2;
+    }
+    coap_transaction_heap_set(idx, t);
+}
+
+static void
+coap_transaction_heap_down(int idx)
+{
+    coap_transaction_t *child;
+    coap_transaction_t *t;
+    int i;
+
+    t = oc_transaction_heap[idx];
+    while (1) {
+        i = idx * 2 + 1;
+        if (i >= oc_transaction_heap_cnt) {
+            break;
+        }
+        child = oc_transaction_heap[i];
+        if (i + 1 < oc_transaction_heap_cnt &&
+            OS_TIME_TICK_LT(oc_transaction_heap[i + 1]->retrans_time,
+                            child->retrans_time)) {
+            i++;
+            child = oc_transaction_heap[i];
+        }
+        if (!OS_TIME_TICK_LT(child->retrans_time, t->retrans_time)) {
+            break;
+        }
+        coap_transaction_heap_set(idx, child);
+        idx = i;
+    }
+    coap_transaction_heap_set(idx, t);
+}
+
+/*
+ * Arms the retransmission callout for the transaction at the root of the
+ * heap, or stops it if there is none.
+ */
+static void
+coap_transaction_timer_reset(void)
+{
+    os_stime_t ticks;
+
+    if (oc_transaction_heap_cnt == 0) {
+        os_callout_stop(&oc_transaction_timer);
+        return;
+    }
+    ticks = oc_transaction_heap[0]->retrans_time - os_time_get();
+    if (ticks < 0) {
+        ticks = 0;
+    }
+    os_callout_reset(&oc_transaction_timer, ticks);
+}
+
+static void
+coap_transaction_heap_insert(coap_transaction_t *t)
+{
+    assert(oc_transaction_heap_cnt < COAP_MAX_OPEN_TRANSACTIONS);
+
+    oc_transaction_heap[oc_transaction_heap_cnt] = t;
+    coap_transaction_heap_up(oc_transaction_heap_cnt++);
+    if (t->retrans_idx == 0) {
+        coap_transaction_timer_reset();
+    }
+}
+
+static void
+coap_transaction_heap_remove(coap_transaction_t *t)
+{
+    coap_transaction_t *last;
+    int idx;
+
+    idx = t->retrans_idx;
+    if (idx < 0) {
+        return;
+    }
+    assert(idx < oc_transaction_heap_cnt && oc_transaction_heap[idx] == t);
+    t->retrans_idx = -1;
+
+    last = oc_transaction_heap[--oc_transaction_heap_cnt];
+    if (last != t) {
+        /* Fill the hole with the last entry and restore the heap order. */
+        coap_transaction_heap_set(idx, last);
+        if (idx > 0 &&
+            OS_TIME_TICK_LT(last->retrans_time,
+                            oc_transaction_heap[(idx - 1) / 2]->retrans_time)) {
+            coap_transaction_heap_up(idx);
+        } else {
+            coap_transaction_heap_down(idx);
+        }
+    }
+    if (idx == 0) {
+        coap_transaction_timer_reset();
+    }
+}
+
+static struct coap_transaction_bucket *
+coap_transaction_bucket(uint16_t mid)
+{
+    return &oc_transaction_table[mid % COAP_TRANSACTION_BUCKETS];
+}
+
 void
 coap_transaction_init(void)
 {
+    int i;
+
+    for (i = 0; i < COAP_TRANSACTION_BUCKETS; i++) {
+        LIST_INIT(&oc_transaction_table[i]);
+    }
+    oc_transaction_heap_cnt = 0;
+    os_callout_init(&oc_transaction_timer, oc_evq_get(),
+                    coap_transaction_retrans, NULL);
     os_mempool_init(&oc_transaction_memb, COAP_MAX_OPEN_TRANSACTIONS,
       sizeof(coap_transaction_t), oc_transaction_area, "coap_tran");
 }
@@ -77,12 +228,10 @@ coap_new_transaction(uint16_t mid, oc_endpoint_t *endpoint)
         if (m) {
             t->mid = mid;
             t->retrans_counter = 0;
+            t->retrans_idx = -1;
             t->m = m;
 
-            os_callout_init(&t->retrans_timer, oc_evq_get(),
-              coap_transaction_retrans, t);
-            /* list itself makes sure same element is not added twice */
-            SLIST_INSERT_HEAD(&oc_transaction_list, t, next);
+            LIST_INSERT_HEAD(coap_transaction_bucket(mid), t, next);
         } else {
             os_memblock_put(&oc_transaction_memb, t);
             t = NULL;
@@ -117,7 +266,9 @@ coap_send_transaction(coap_transaction_t *t)
                 OC_LOG_DEBUG("Doubled " OC_CLK_FMT "\n", t->retrans_tmo);
             }
 
-            os_callout_reset(&t->retrans_timer, t->retrans_tmo);
+            coap_transaction_heap_remove(t);
+            t->retrans_time = os_time_get() + t->retrans_tmo;
+            coap_transaction_heap_insert(t);
 
             coap_send_message(t->m, 1);
 
@@ -154,23 +305,12 @@ coap_send_transaction(coap_transaction_t *t)
 void
 coap_clear_transaction(coap_transaction_t *t)
 {
-    struct coap_transaction *tmp;
-
     if (t) {
-        os_callout_stop(&t->retrans_timer);
+        coap_transaction_heap_remove(t);
         os_mbuf_free_chain(t->m);
-
-        /*
-         * Transaction might not be in the list yet.
-         */
-        SLIST_FOREACH(tmp, &oc_transaction_list, next) {
-            if (t == tmp) {
-                SLIST_REMOVE(&oc_transaction_list, t, coap_transaction, next);
-                break;
-            }
-        }
+        LIST_REMOVE(t, next);
         os_memblock_put(&oc_transaction_memb, t);
-  }
+    }
 }
 
 coap_transaction_t *
@@ -178,7 +318,7 @@ coap_get_transaction_by_mid(uint16_t mid)
 {
     coap_transaction_t *t;
 
-    SLIST_FOREACH(t, &oc_transaction_list, next) {
+    LIST_FOREACH(t, coap_transaction_bucket(mid), next) {
         if (t->mid == mid) {
             return t;
         }
@@ -186,12 +326,26 @@ coap_get_transaction_by_mid(uint16_t mid)
     return NULL;
 }
 
+/*
+ * Retransmits, or times out, all transactions that are due.
+ */
 static void
 coap_transaction_retrans(struct os_event *ev)
 {
-    coap_transaction_t *t = ev->ev_arg;
-    ++(t->retrans_counter);
-    OC_LOG_DEBUG("Retransmitting %u (%u)\n", t->mid, t->retrans_counter);
-    coap_send_transaction(t);
+    coap_transaction_t *t;
+    os_time_t now;
+
+    now = os_time_get();
+    while (oc_transaction_heap_cnt > 0) {
+        t = oc_transaction_heap[0];
+        if (OS_TIME_TICK_GT(t->retrans_time, now)) {
+            break;
+        }
+        coap_transaction_heap_remove(t);
+        ++(t->retrans_counter);
+        OC_LOG_DEBUG("Retransmitting %u (%u)\n", t->mid, t->retrans_counter);
+        coap_send_transaction(t);
+    }
+    coap_transaction_timer_reset();
 }
 
@@ -270,6 +270,31 @@ int conf_save(void);
  */
 int conf_save_tree(char *name);
 
+/**
+ * Start a config transaction. Values saved with conf_save_one() until the
+ * matching conf_txn_commit() may be buffered by the storage backend and
+ * written together; with CONFIG_FCB_TXN, the FCB backend writes them as
+ * one record, so that either all or none of them are stored. Values which
+ * do not fit in CONFIG_FCB_TXN_BUF_SIZE fail with OS_ENOMEM, and the
+ * transaction is then discarded. The config lock is held until
+ * conf_txn_commit(). Transactions nest; only the outermost commit writes.
+ * Settings saved by conf_save() and conf_save_tree() join a transaction
+ * open in the calling task.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int conf_txn_begin(void);
+
+/**
+ * Finish a config transaction started with conf_txn_begin(), writing any
+ * values still buffered.
+ *
+ * @return 0 on success, OS_EINVAL if no transaction is open, OS_ENOMEM if
+ *         the transaction was discarded for not fitting, other non-zero
+ *         values if buffered values could not be written.
+ */
+int conf_txn_commit(void);
+
 /**
  * Write a single configuration value to persisted storage (if it has
  * changed value).
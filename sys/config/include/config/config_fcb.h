@@ -23,6 +23,8 @@
 
 #include "config/config.h"
 #include "config/config_store.h"
+#include "config/config_index.h"
+#include "config/config_txn.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,6 +33,12 @@ extern "C" {
 struct conf_fcb {
     struct conf_store cf_store;
     struct fcb cf_fcb;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_index cf_index;
+#endif
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    struct conf_txn_buf cf_txn;
+#endif
 };
 
 /**
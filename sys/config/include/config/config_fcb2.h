@@ -23,6 +23,8 @@
 
 #include "config/config.h"
 #include "config/config_store.h"
+#include "config/config_index.h"
+#include "config/config_txn.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,6 +33,12 @@ extern "C" {
 struct conf_fcb2 {
     struct conf_store cf2_store;
     struct fcb2 cf2_fcb;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_index cf2_index;
+#endif
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    struct conf_txn_buf cf2_txn;
+#endif
 };
 
 /**
@@ -0,0 +1,67 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef __SYS_CONFIG_INDEX_H_
+#define __SYS_CONFIG_INDEX_H_
+
+#include <stdint.h>
+
+#include "os/mynewt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Location of a config record within FCB/FCB2.  For FCB, cil_area is the
+ * flash area of the record; for FCB2 it is the sector range and cil_sector
+ * the sector within it.  The record may hold other settings too.
+ */
+struct conf_index_loc {
+    void *cil_area;
+    uint32_t cil_data_off;
+    uint16_t cil_sector;
+    uint16_t cil_data_len;
+};
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+
+struct conf_index_entry {
+    uint32_t cie_name_hash;
+    uint32_t cie_name_hash2;
+    uint32_t cie_val_hash;
+    struct conf_index_loc cie_loc;     /* cil_area is NULL if slot is free */
+};
+
+/*
+ * In-RAM index from setting name to the latest record holding it.  Embedded
+ * in the FCB config stores when CONFIG_FCB_INDEX is enabled.
+ */
+struct conf_index {
+    struct conf_index_entry ci_entries[MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE)];
+    uint16_t ci_cnt;
+    uint8_t ci_valid;
+};
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYS_CONFIG_INDEX_H_ */
@@ -37,11 +37,30 @@ struct conf_store;
  * API for config storage.
  */
 typedef void (*conf_store_load_cb)(char *name, char *val, void *cb_arg);
+
+/*
+ * Return values from csi_dup_check.
+ */
+#define CONF_STORED_NONE        0   /* No record of the setting */
+#define CONF_STORED_SAME        1   /* Latest record has the same value */
+#define CONF_STORED_DIFFERENT   2   /* Latest record has a different value */
+
 struct conf_store_itf {
     int (*csi_load)(struct conf_store *cs, conf_store_load_cb cb, void *cb_arg);
     int (*csi_save_start)(struct conf_store *cs);
     int (*csi_save)(struct conf_store *cs, const char *name, const char *value);
     int (*csi_save_end)(struct conf_store *cs);
+
+    /*
+     * Optional lookups which avoid a full csi_load() walk.  csi_dup_check
+     * returns one of CONF_STORED_*; csi_get returns 0 with the value copied
+     * to buf, or OS_ENOENT if the setting is not stored.  Any other return
+     * value makes the caller fall back to csi_load().
+     */
+    int (*csi_dup_check)(struct conf_store *cs, const char *name,
+                         const char *value);
+    int (*csi_get)(struct conf_store *cs, const char *name, char *buf,
+                   int buf_len);
 };
 
 struct conf_store {
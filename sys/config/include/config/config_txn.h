@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef __SYS_CONFIG_TXN_H_
+#define __SYS_CONFIG_TXN_H_
+
+#include <stdint.h>
+
+#include "os/mynewt.h"
+#include "config/config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Largest record in an FCB store: one line, or with CONFIG_FCB_TXN, the
+ * settings of a whole transaction.
+ */
+#define CONF_LINE_MAX_LEN	(CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32)
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+#if MYNEWT_VAL(CONFIG_FCB_TXN_BUF_SIZE) > CONF_LINE_MAX_LEN
+#define CONF_RECORD_MAX_LEN	MYNEWT_VAL(CONFIG_FCB_TXN_BUF_SIZE)
+#endif
+#endif
+#ifndef CONF_RECORD_MAX_LEN
+#define CONF_RECORD_MAX_LEN	CONF_LINE_MAX_LEN
+#endif
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+
+/*
+ * Settings staged by conf_txn_begin() in an FCB store, kept as one record
+ * of '\0' separated lines.  Embedded in the FCB config stores when
+ * CONFIG_FCB_TXN is enabled.  ctb_full is set once a transaction has
+ * outgrown the buffer; it is then discarded.
+ */
+struct conf_txn_buf {
+    uint8_t ctb_open;
+    uint8_t ctb_full;
+    uint16_t ctb_len;
+    char ctb_buf[CONF_RECORD_MAX_LEN];
+};
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYS_CONFIG_TXN_H_ */
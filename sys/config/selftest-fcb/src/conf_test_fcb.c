@@ -382,6 +382,8 @@ TEST_SUITE(config_test_c2)
 
     config_test_save_one_fcb();
     config_test_get_stored_fcb();
+    config_test_index_fcb();
+    config_test_txn_fcb();
 }
 
 TEST_SUITE(config_test_c3)
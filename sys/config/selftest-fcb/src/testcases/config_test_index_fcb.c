@@ -0,0 +1,155 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+#include "config/config_generic_kv.h"
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+
+#define CONFIG_TEST_INDEX_KEYS      600
+
+static struct conf_fcb config_test_index_cf;
+
+static void
+config_test_index_name(char *name, int i)
+{
+    sprintf(name, "idx/k%d", i);
+}
+
+static void
+config_test_index_check(int i, int round)
+{
+    char name[16];
+    char val[16];
+    int rc;
+
+    config_test_index_name(name, i);
+    rc = conf_get_stored_value(name, val, sizeof(val));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(atoi(val) == i + round);
+}
+
+static void
+config_test_index_save(int first, int last, int round)
+{
+    char name[16];
+    char val[16];
+    int rc;
+    int i;
+
+    for (i = first; i < last; i++) {
+        config_test_index_name(name, i);
+        sprintf(val, "%d", i + round);
+        rc = conf_save_one(name, val);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+TEST_CASE_SELF(config_test_index_fcb)
+{
+    struct conf_fcb *cf = &config_test_index_cf;
+    struct flash_area *active_area;
+    uint32_t active_off;
+    char val[16];
+    int round;
+    int rc;
+    int i;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    cf->cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf->cf_fcb.f_sectors = fcb_areas;
+    cf->cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(cf);
+    TEST_ASSERT(rc == 0);
+    rc = conf_fcb_dst(cf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cf->cf_index.ci_valid);
+
+    /*
+     * Fill the FCB until it has been compressed a few times; the index
+     * has to follow records as they are copied.
+     */
+    for (round = 0; round < 6; round++) {
+        config_test_index_save(0, CONFIG_TEST_INDEX_KEYS, round);
+        TEST_ASSERT_FATAL(cf->cf_index.ci_valid);
+        TEST_ASSERT(cf->cf_index.ci_cnt == CONFIG_TEST_INDEX_KEYS);
+    }
+    round--;
+    for (i = 0; i < CONFIG_TEST_INDEX_KEYS; i++) {
+        config_test_index_check(i, round);
+    }
+
+    rc = conf_get_stored_value("idx/none", val, sizeof(val));
+    TEST_ASSERT(rc == OS_ENOENT);
+
+    rc = conf_fcb_kv_load(&cf->cf_fcb, "idx/k7", val, sizeof(val));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(atoi(val) == 7 + round);
+
+    /*
+     * Saving the same values again must not write anything.
+     */
+    active_area = cf->cf_fcb.f_active.fe_area;
+    active_off = cf->cf_fcb.f_active.fe_elem_off;
+    config_test_index_save(0, CONFIG_TEST_INDEX_KEYS, round);
+    TEST_ASSERT(cf->cf_fcb.f_active.fe_area == active_area);
+    TEST_ASSERT(cf->cf_fcb.f_active.fe_elem_off == active_off);
+
+    /*
+     * Lookups which walk the FCB give the same answer, and rebuild the
+     * index.
+     */
+    cf->cf_index.ci_valid = 0;
+    config_test_index_check(3, round);
+    TEST_ASSERT(cf->cf_index.ci_valid);
+    TEST_ASSERT(cf->cf_index.ci_cnt == CONFIG_TEST_INDEX_KEYS);
+
+    /*
+     * Deleted values are stored as empty ones.
+     */
+    rc = conf_save_one("idx/k5", NULL);
+    TEST_ASSERT(rc == 0);
+    rc = conf_get_stored_value("idx/k5", val, sizeof(val));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val[0] == '\0');
+    active_off = cf->cf_fcb.f_active.fe_elem_off;
+    rc = conf_save_one("idx/k5", "");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cf->cf_fcb.f_active.fe_elem_off == active_off);
+
+    /*
+     * More settings than the index can hold; everything still works by
+     * walking the FCB.
+     */
+    config_test_index_save(CONFIG_TEST_INDEX_KEYS,
+                           MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE), round);
+    TEST_ASSERT(!cf->cf_index.ci_valid);
+    config_test_index_check(MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE) - 1, round);
+    config_test_index_check(CONFIG_TEST_INDEX_KEYS - 1, round);
+    active_off = cf->cf_fcb.f_active.fe_elem_off;
+    config_test_index_save(0, 1, round);
+    TEST_ASSERT(cf->cf_fcb.f_active.fe_elem_off == active_off);
+}
+#else
+TEST_CASE_SELF(config_test_index_fcb)
+{
+}
+#endif
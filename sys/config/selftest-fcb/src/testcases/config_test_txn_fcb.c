@@ -0,0 +1,225 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+
+static struct conf_fcb config_test_txn_cf;
+
+static int
+config_test_txn_count_cb(struct fcb_entry *loc, void *arg)
+{
+    (*(int *)arg)++;
+    return 0;
+}
+
+static int
+config_test_txn_records(struct conf_fcb *cf)
+{
+    int cnt;
+
+    cnt = 0;
+    fcb_walk(&cf->cf_fcb, NULL, config_test_txn_count_cb, &cnt);
+    return cnt;
+}
+
+static void
+config_test_txn_save(int first, int last, int round)
+{
+    char name[16];
+    char val[16];
+    int rc;
+    int i;
+
+    for (i = first; i < last; i++) {
+        sprintf(name, "txn/k%d", i);
+        sprintf(val, "%d", i + round);
+        rc = conf_save_one(name, val);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+static void
+config_test_txn_check(int first, int last, int round)
+{
+    char name[16];
+    char val[16];
+    int rc;
+    int i;
+
+    for (i = first; i < last; i++) {
+        sprintf(name, "txn/k%d", i);
+        rc = conf_get_stored_value(name, val, sizeof(val));
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(atoi(val) == i + round);
+        rc = conf_fcb_kv_load(&config_test_txn_cf.cf_fcb, name, val,
+                              sizeof(val));
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(atoi(val) == i + round);
+    }
+}
+
+TEST_CASE_SELF(config_test_txn_fcb)
+{
+    struct conf_fcb *cf = &config_test_txn_cf;
+    char name[16];
+    char val[16];
+    int records;
+    int round;
+    int rc;
+    int i;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    cf->cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf->cf_fcb.f_sectors = fcb_areas;
+    cf->cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(cf);
+    TEST_ASSERT(rc == 0);
+    rc = conf_fcb_dst(cf);
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * A commit without a transaction is rejected.
+     */
+    rc = conf_txn_commit();
+    TEST_ASSERT(rc == OS_EINVAL);
+
+    /*
+     * Settings saved within a transaction go out as one record, and are
+     * visible before the commit.
+     */
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    config_test_txn_save(0, 10, 0);
+    config_test_txn_check(0, 10, 0);
+    TEST_ASSERT(config_test_txn_records(cf) == 0);
+    rc = conf_txn_commit();
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(config_test_txn_records(cf) == 1);
+    config_test_txn_check(0, 10, 0);
+
+    /*
+     * Nested transactions commit with the outermost one. A setting staged
+     * and then set back to its stored value is still written.
+     */
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    config_test_txn_save(0, 1, 1);
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    config_test_txn_save(0, 1, 0);
+    config_test_txn_save(1, 2, 1);
+    rc = conf_txn_commit();
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(config_test_txn_records(cf) == 1);
+    rc = conf_txn_commit();
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(config_test_txn_records(cf) == 2);
+    config_test_txn_check(0, 1, 0);
+    config_test_txn_check(1, 2, 1);
+
+    /*
+     * Unchanged settings are not staged at all.
+     */
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    config_test_txn_save(2, 10, 0);
+    rc = conf_txn_commit();
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(config_test_txn_records(cf) == 2);
+
+    /*
+     * A transaction which does not fit in one record is discarded as a
+     * whole.
+     */
+    records = config_test_txn_records(cf);
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < 100; i++) {
+        sprintf(name, "txn/k%d", i);
+        sprintf(val, "%d", i + 2);
+        rc = conf_save_one(name, val);
+        if (rc) {
+            break;
+        }
+    }
+    TEST_ASSERT(rc == OS_ENOMEM);
+    rc = conf_save_one("txn/k0", "2");
+    TEST_ASSERT(rc == OS_ENOMEM);
+    rc = conf_txn_commit();
+    TEST_ASSERT(rc == OS_ENOMEM);
+    TEST_ASSERT(config_test_txn_records(cf) == records);
+    config_test_txn_check(0, 1, 0);
+    config_test_txn_check(1, 2, 1);
+    config_test_txn_check(2, 10, 0);
+    rc = conf_get_stored_value("txn/k10", val, sizeof(val));
+    TEST_ASSERT(rc == OS_ENOENT);
+
+    /*
+     * Grouped records survive compression, only keeping the settings
+     * which have not been overwritten since.
+     */
+    for (round = 3; round < 40; round++) {
+        for (i = 0; i < 100; i += 20) {
+            rc = conf_txn_begin();
+            TEST_ASSERT_FATAL(rc == 0);
+            config_test_txn_save(i ? i : round % 2, i + 20, round);
+            rc = conf_txn_commit();
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+    }
+    round--;
+    config_test_txn_check(1, 100, round);
+    config_test_txn_check(0, 1, round - 1);
+
+    conf_fcb_compress(cf, NULL, NULL);
+    config_test_txn_check(1, 100, round);
+    config_test_txn_check(0, 1, round - 1);
+
+    rc = conf_get_stored_value("txn/none", val, sizeof(val));
+    TEST_ASSERT(rc == OS_ENOENT);
+
+    /*
+     * Saving a subtree writes all of its settings as one record.
+     */
+    i = c2_var_count;
+    c2_var_count = 4;
+    for (round = 0; round < c2_var_count; round++) {
+        sprintf(val_string[round], "tree%d", round);
+    }
+    records = config_test_txn_records(cf);
+    rc = conf_save_tree("2nd");
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(config_test_txn_records(cf) == records + 1);
+    for (round = 0; round < c2_var_count; round++) {
+        sprintf(name, "2nd/string%d", round);
+        rc = conf_get_stored_value(name, val, sizeof(val));
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(!strcmp(val, val_string[round]));
+    }
+    c2_var_count = i;
+}
+#else
+TEST_CASE_SELF(config_test_txn_fcb)
+{
+}
+#endif
@@ -35,6 +35,12 @@
 struct conf_fcb_load_cb_arg {
     conf_store_load_cb cb;
     void *cb_arg;
+    struct conf_index *ci;
+};
+
+struct conf_fcb_newer_arg {
+    struct fcb *fcb;
+    struct fcb_entry *loc;
 };
 
 struct conf_kv_load_cb_arg {
@@ -47,12 +53,75 @@ static int conf_fcb_load(struct conf_store *, conf_store_load_cb cb,
                          void *cb_arg);
 static int conf_fcb_save(struct conf_store *, const char *name,
                          const char *value);
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+static int conf_fcb_dup_check(struct conf_store *, const char *name,
+                              const char *value);
+static int conf_fcb_get(struct conf_store *, const char *name, char *buf,
+                        int buf_len);
+#endif
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+static int conf_fcb_save_start(struct conf_store *);
+static int conf_fcb_save_end(struct conf_store *);
+#endif
 
 static struct conf_store_itf conf_fcb_itf = {
     .csi_load = conf_fcb_load,
     .csi_save = conf_fcb_save,
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    .csi_save_start = conf_fcb_save_start,
+    .csi_save_end = conf_fcb_save_end,
+#endif
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    .csi_dup_check = conf_fcb_dup_check,
+    .csi_get = conf_fcb_get,
+#endif
 };
 
+static void
+conf_fcb_index_loc(struct fcb_entry *loc, struct conf_index_loc *cil)
+{
+    cil->cil_area = loc->fe_area;
+    cil->cil_data_off = loc->fe_data_off;
+    cil->cil_sector = 0;
+    cil->cil_data_len = loc->fe_data_len;
+}
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+static int
+conf_fcb_index_read(const struct conf_index_loc *cil, char *buf, int len)
+{
+    return flash_area_read(cil->cil_area, cil->cil_data_off, buf, len);
+}
+
+/*
+ * Returns the config source using this FCB, if any. The kv API works on
+ * bare FCBs, and must keep the index of a registered source up to date.
+ */
+static struct conf_fcb *
+conf_fcb_find(struct fcb *fcb)
+{
+    struct conf_store *cs;
+    struct conf_fcb *cf;
+
+    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+        cf = (struct conf_fcb *)cs;
+        if (cs->cs_itf == &conf_fcb_itf && &cf->cf_fcb == fcb) {
+            return cf;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Rebuilds the index with a walk through the FCB.
+ */
+static void
+conf_fcb_index_build(struct conf_fcb *cf)
+{
+    conf_fcb_load(&cf->cf_store, NULL, NULL);
+}
+#endif
+
 int
 conf_fcb_src(struct conf_fcb *cf)
 {
@@ -83,8 +152,14 @@ conf_fcb_src(struct conf_fcb *cf)
         }
     }
 
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    memset(&cf->cf_txn, 0, sizeof(cf->cf_txn));
+#endif
     cf->cf_store.cs_itf = &conf_fcb_itf;
     conf_src_register(&cf->cf_store);
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    conf_fcb_index_build(cf);
+#endif
 
     return OS_OK;
 }
@@ -92,40 +167,52 @@ conf_fcb_src(struct conf_fcb *cf)
 int
 conf_fcb_dst(struct conf_fcb *cf)
 {
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    memset(&cf->cf_txn, 0, sizeof(cf->cf_txn));
+#endif
     cf->cf_store.cs_itf = &conf_fcb_itf;
     conf_dst_register(&cf->cf_store);
 
     return OS_OK;
 }
 
+/*
+ * Reads a record, and returns its length or -1 on failure.
+ */
 static int
-conf_fcb_load_cb(struct fcb_entry *loc, void *arg)
+conf_fcb_var_read(struct fcb_entry *loc, char *buf, int buf_len)
 {
-    struct conf_fcb_load_cb_arg *argp;
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    char *name_str;
-    char *val_str;
-    int rc;
     int len;
-
-    argp = (struct conf_fcb_load_cb_arg *)arg;
+    int rc;
 
     len = loc->fe_data_len;
-    if (len >= sizeof(buf)) {
-        len = sizeof(buf) - 1;
+    if (len >= buf_len) {
+        len = buf_len - 1;
     }
-
     rc = flash_area_read(loc->fe_area, loc->fe_data_off, buf, len);
     if (rc) {
-        return 0;
+        return -1;
     }
     buf[len] = '\0';
+    return len;
+}
 
-    rc = conf_line_parse(buf, &name_str, &val_str);
-    if (rc) {
+static int
+conf_fcb_load_cb(struct fcb_entry *loc, void *arg)
+{
+    struct conf_fcb_load_cb_arg *argp;
+    char buf[CONF_RECORD_MAX_LEN];
+    struct conf_index_loc cil;
+    int len;
+
+    argp = (struct conf_fcb_load_cb_arg *)arg;
+
+    len = conf_fcb_var_read(loc, buf, sizeof(buf));
+    if (len < 0) {
         return 0;
     }
-    argp->cb(name_str, val_str, argp->cb_arg);
+    conf_fcb_index_loc(loc, &cil);
+    conf_record_load(buf, len, argp->cb, argp->cb_arg, argp->ci, &cil);
     return 0;
 }
 
@@ -138,25 +225,86 @@ conf_fcb_load(struct conf_store *cs, conf_store_load_cb cb, void *cb_arg)
 
     arg.cb = cb;
     arg.cb_arg = cb_arg;
+    arg.ci = NULL;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    /*
+     * Every walk goes through all records, so use it to refresh the index.
+     */
+    arg.ci = &cf->cf_index;
+    conf_index_reset(arg.ci);
+#endif
     rc = fcb_walk(&cf->cf_fcb, 0, conf_fcb_load_cb, &arg);
     if (rc) {
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+        conf_index_invalidate(arg.ci);
+#endif
         return OS_EINVAL;
     }
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    /*
+     * Lines staged by an open transaction are newer than anything in flash.
+     */
+    if (cb) {
+        conf_txn_buf_load(&cf->cf_txn, cb, cb_arg);
+    }
+#endif
     return OS_OK;
 }
 
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
 static int
-conf_fcb_var_read(struct fcb_entry *loc, char *buf, char **name, char **val)
+conf_fcb_dup_check(struct conf_store *cs, const char *name, const char *value)
 {
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
     int rc;
 
-    rc = flash_area_read(loc->fe_area, loc->fe_data_off, buf, loc->fe_data_len);
-    if (rc) {
+    rc = conf_txn_buf_dup_check(&cf->cf_txn, name, value);
+    if (rc != CONF_STORED_NONE) {
         return rc;
     }
-    buf[loc->fe_data_len] = '\0';
-    rc = conf_line_parse(buf, name, val);
-    return rc;
+#endif
+
+    return conf_index_dup_check(&cf->cf_index, conf_fcb_index_read, name,
+                                value);
+}
+
+static int
+conf_fcb_get(struct conf_store *cs, const char *name, char *buf, int buf_len)
+{
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    if (!conf_txn_buf_get(&cf->cf_txn, name, buf, buf_len)) {
+        return 0;
+    }
+#endif
+    return conf_index_get(&cf->cf_index, conf_fcb_index_read, name, buf,
+                          buf_len);
+}
+#endif
+
+/*
+ * Returns 1 if a record after loc has a value for name.
+ */
+static int
+conf_fcb_newer(const char *name, char *buf, int buf_len, void *arg)
+{
+    struct conf_fcb_newer_arg *cna = arg;
+    struct fcb_entry loc2;
+    int len;
+
+    loc2 = *cna->loc;
+    while (fcb_getnext(cna->fcb, &loc2) == 0) {
+        len = conf_fcb_var_read(&loc2, buf, buf_len);
+        if (len < 0) {
+            continue;
+        }
+        if (conf_record_find(buf, len, name, NULL)) {
+            return 1;
+        }
+    }
+    return 0;
 }
 
 static void
@@ -166,68 +314,47 @@ conf_fcb_compress_internal(struct fcb *fcb,
                            void *cn_arg)
 {
     int rc;
-    char buf1[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    char buf2[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    char buf1[CONF_RECORD_MAX_LEN];
+    char buf2[CONF_RECORD_MAX_LEN];
+    struct conf_fcb_newer_arg cna;
     struct fcb_entry loc1;
     struct fcb_entry loc2;
-    char *name1, *val1;
-    char *name2, *val2;
-    int copy;
+    int len1;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_fcb *cf;
+#endif
 
     rc = fcb_append_to_scratch(fcb);
     if (rc) {
         return; /* XXX */
     }
 
+    cna.fcb = fcb;
+    cna.loc = &loc1;
     loc1.fe_area = NULL;
     loc1.fe_elem_off = 0;
     while (fcb_getnext(fcb, &loc1) == 0) {
         if (loc1.fe_area != fcb->f_oldest) {
             break;
         }
-        rc = conf_fcb_var_read(&loc1, buf1, &name1, &val1);
-        if (rc) {
-            continue;
-        }
-        if (!val1) {
-            continue;
-        }
-        loc2 = loc1;
-        copy = 1;
-        while (fcb_getnext(fcb, &loc2) == 0) {
-            rc = conf_fcb_var_read(&loc2, buf2, &name2, &val2);
-            if (rc) {
-                continue;
-            }
-            if (!strcmp(name1, name2)) {
-                copy = 0;
-                break;
-            }
-        }
-        if (!copy) {
+        len1 = conf_fcb_var_read(&loc1, buf1, sizeof(buf1));
+        if (len1 < 0) {
             continue;
         }
 
-        if (copy_or_not) {
-            if (copy_or_not(name1, val1, cn_arg)) {
-                /* Copy rejected */
-                continue;
-            }
-        }
         /*
-         * Can't find one. Must copy.
+         * Lines still in use are copied as one record.
          */
-        rc = flash_area_read(loc1.fe_area, loc1.fe_data_off, buf1,
-          loc1.fe_data_len);
-        if (rc) {
+        len1 = conf_record_compact(buf1, len1, buf2, sizeof(buf2),
+                                   conf_fcb_newer, &cna, copy_or_not, cn_arg);
+        if (!len1) {
             continue;
         }
-        rc = fcb_append(fcb, loc1.fe_data_len, &loc2);
+        rc = fcb_append(fcb, len1, &loc2);
         if (rc) {
             continue;
         }
-        rc = flash_area_write(loc2.fe_area, loc2.fe_data_off, buf1,
-          loc1.fe_data_len);
+        rc = flash_area_write(loc2.fe_area, loc2.fe_data_off, buf1, len1);
         if (rc) {
             continue;
         }
@@ -238,10 +365,19 @@ conf_fcb_compress_internal(struct fcb *fcb,
         /* XXXX */
         ;
     }
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    /*
+     * Records were moved, and the ones left behind erased.
+     */
+    cf = conf_fcb_find(fcb);
+    if (cf) {
+        conf_fcb_index_build(cf);
+    }
+#endif
 }
 
 static int
-conf_fcb_append(struct fcb *fcb, char *buf, int len)
+conf_fcb_append(struct fcb *fcb, char *buf, int len, struct fcb_entry *locp)
 {
     int rc;
     int i;
@@ -265,14 +401,68 @@ conf_fcb_append(struct fcb *fcb, char *buf, int len)
         return OS_EINVAL;
     }
     fcb_append_finish(fcb, &loc);
+    *locp = loc;
+    return OS_OK;
+}
+
+/*
+ * Appends a record of one or more lines, and points the index at it.
+ * Modifies buf.
+ */
+static int
+conf_fcb_record_write(char *buf, int len, void *arg)
+{
+    struct fcb *fcb = arg;
+    struct fcb_entry loc;
+    int rc;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_index_loc cil;
+    struct conf_fcb *cf;
+#endif
+
+    rc = conf_fcb_append(fcb, buf, len, &loc);
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    if (rc == 0) {
+        cf = conf_fcb_find(fcb);
+        if (cf) {
+            conf_fcb_index_loc(&loc, &cil);
+            conf_record_load(buf, len, NULL, NULL, &cf->cf_index, &cil);
+        }
+    }
+#endif
+    return rc;
+}
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+static int
+conf_fcb_save_start(struct conf_store *cs)
+{
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+
+    conf_txn_buf_start(&cf->cf_txn);
     return OS_OK;
 }
 
+static int
+conf_fcb_save_end(struct conf_store *cs)
+{
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+
+    return conf_txn_buf_end(&cf->cf_txn, conf_fcb_record_write, &cf->cf_fcb);
+}
+#endif
+
 static int
 conf_fcb_save(struct conf_store *cs, const char *name, const char *value)
 {
     struct conf_fcb *cf = (struct conf_fcb *)cs;
 
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    if (cf->cf_txn.ctb_open) {
+        return conf_txn_buf_stage(&cf->cf_txn, name, value,
+                                  conf_fcb_record_write, &cf->cf_fcb);
+    }
+#endif
     return conf_fcb_kv_save(&cf->cf_fcb, name, value);
 }
 
@@ -289,35 +479,23 @@ static int
 conf_kv_load_cb(struct fcb_entry *loc, void *arg)
 {
     struct conf_kv_load_cb_arg *cb_arg = arg;
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    char *name_str;
+    char buf[CONF_RECORD_MAX_LEN];
     char *val_str;
-    int rc;
     int len;
 
-    len = loc->fe_data_len;
-    if (len >= sizeof(buf)) {
-        len = sizeof(buf) - 1;
-    }
-
-    rc = flash_area_read(loc->fe_area, loc->fe_data_off, buf, len);
-    if (rc) {
-        return 0;
-    }
-    buf[len] = '\0';
-
-    rc = conf_line_parse(buf, &name_str, &val_str);
-    if (rc) {
+    len = conf_fcb_var_read(loc, buf, sizeof(buf));
+    if (len < 0) {
         return 0;
     }
 
-    if (strcmp(name_str, cb_arg->name)) {
-        return 0;
+    if (conf_record_find(buf, len, cb_arg->name, &val_str)) {
+        if (!val_str) {
+            val_str = "";
+        }
+        strncpy(cb_arg->value, val_str, cb_arg->len);
+        cb_arg->value[cb_arg->len - 1] = '\0';
     }
 
-    strncpy(cb_arg->value, val_str, cb_arg->len);
-    cb_arg->value[cb_arg->len - 1] = '\0';
-
     return 0;
 }
 
@@ -326,6 +504,18 @@ conf_fcb_kv_load(struct fcb *fcb, const char *name, char *value, size_t len)
 {
     struct conf_kv_load_cb_arg arg;
     int rc;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_fcb *cf;
+
+    cf = conf_fcb_find(fcb);
+    if (cf) {
+        rc = conf_index_get(&cf->cf_index, conf_fcb_index_read, name, value,
+                            len);
+        if (rc == 0 || rc == OS_ENOENT) {
+            return OS_OK;
+        }
+    }
+#endif
 
     arg.name = name;
     arg.value = value;
@@ -342,7 +532,7 @@ conf_fcb_kv_load(struct fcb *fcb, const char *name, char *value, size_t len)
 int
 conf_fcb_kv_save(struct fcb *fcb, const char *name, const char *value)
 {
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    char buf[CONF_LINE_MAX_LEN];
     int len;
 
     if (!name) {
@@ -353,7 +543,7 @@ conf_fcb_kv_save(struct fcb *fcb, const char *name, const char *value)
     if (len < 0 || len + 2 > sizeof(buf)) {
         return OS_INVALID_PARM;
     }
-    return conf_fcb_append(fcb, buf, len);
+    return conf_fcb_record_write(buf, len, fcb);
 }
 
 #endif
@@ -35,6 +35,12 @@
 struct conf_fcb2_load_cb_arg {
     conf_store_load_cb cb;
     void *cb_arg;
+    struct conf_index *ci;
+};
+
+struct conf_fcb2_newer_arg {
+    struct fcb2 *fcb;
+    struct fcb2_entry *loc;
 };
 
 struct conf_kv_load_cb_arg {
@@ -47,12 +53,81 @@ static int conf_fcb2_load(struct conf_store *, conf_store_load_cb cb,
                           void *cb_arg);
 static int conf_fcb2_save(struct conf_store *, const char *name,
                           const char *value);
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+static int conf_fcb2_dup_check(struct conf_store *, const char *name,
+                               const char *value);
+static int conf_fcb2_get(struct conf_store *, const char *name, char *buf,
+                         int buf_len);
+#endif
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+static int conf_fcb2_save_start(struct conf_store *);
+static int conf_fcb2_save_end(struct conf_store *);
+#endif
 
 static struct conf_store_itf conf_fcb2_itf = {
     .csi_load = conf_fcb2_load,
     .csi_save = conf_fcb2_save,
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    .csi_save_start = conf_fcb2_save_start,
+    .csi_save_end = conf_fcb2_save_end,
+#endif
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    .csi_dup_check = conf_fcb2_dup_check,
+    .csi_get = conf_fcb2_get,
+#endif
 };
 
+static void
+conf_fcb2_index_loc(struct fcb2_entry *loc, struct conf_index_loc *cil)
+{
+    cil->cil_area = loc->fe_range;
+    cil->cil_data_off = loc->fe_data_off;
+    cil->cil_sector = loc->fe_sector;
+    cil->cil_data_len = loc->fe_data_len;
+}
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+static int
+conf_fcb2_index_read(const struct conf_index_loc *cil, char *buf, int len)
+{
+    struct fcb2_entry loc;
+
+    loc.fe_range = cil->cil_area;
+    loc.fe_sector = cil->cil_sector;
+    loc.fe_data_off = cil->cil_data_off;
+    loc.fe_data_len = cil->cil_data_len;
+    return fcb2_read(&loc, 0, buf, len);
+}
+
+/*
+ * Returns the config source using this FCB, if any. The kv API works on
+ * bare FCBs, and must keep the index of a registered source up to date.
+ */
+static struct conf_fcb2 *
+conf_fcb2_find(struct fcb2 *fcb)
+{
+    struct conf_store *cs;
+    struct conf_fcb2 *cf;
+
+    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+        cf = (struct conf_fcb2 *)cs;
+        if (cs->cs_itf == &conf_fcb2_itf && &cf->cf2_fcb == fcb) {
+            return cf;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Rebuilds the index with a walk through the FCB.
+ */
+static void
+conf_fcb2_index_build(struct conf_fcb2 *cf)
+{
+    conf_fcb2_load(&cf->cf2_store, NULL, NULL);
+}
+#endif
+
 int
 conf_fcb2_src(struct conf_fcb2 *cf)
 {
@@ -82,8 +157,14 @@ conf_fcb2_src(struct conf_fcb2 *cf)
         }
     }
 
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    memset(&cf->cf2_txn, 0, sizeof(cf->cf2_txn));
+#endif
     cf->cf2_store.cs_itf = &conf_fcb2_itf;
     conf_src_register(&cf->cf2_store);
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    conf_fcb2_index_build(cf);
+#endif
 
     return OS_OK;
 }
@@ -91,40 +172,52 @@ conf_fcb2_src(struct conf_fcb2 *cf)
 int
 conf_fcb2_dst(struct conf_fcb2 *cf)
 {
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    memset(&cf->cf2_txn, 0, sizeof(cf->cf2_txn));
+#endif
     cf->cf2_store.cs_itf = &conf_fcb2_itf;
     conf_dst_register(&cf->cf2_store);
 
     return OS_OK;
 }
 
+/*
+ * Reads a record, and returns its length or -1 on failure.
+ */
 static int
-conf_fcb2_load_cb(struct fcb2_entry *loc, void *arg)
+conf_fcb2_var_read(struct fcb2_entry *loc, char *buf, int buf_len)
 {
-    struct conf_fcb2_load_cb_arg *argp;
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    char *name_str;
-    char *val_str;
-    int rc;
     int len;
-
-    argp = (struct conf_fcb2_load_cb_arg *)arg;
+    int rc;
 
     len = loc->fe_data_len;
-    if (len >= sizeof(buf)) {
-        len = sizeof(buf) - 1;
+    if (len >= buf_len) {
+        len = buf_len - 1;
     }
-
     rc = fcb2_read(loc, 0, buf, len);
     if (rc) {
-        return 0;
+        return -1;
     }
     buf[len] = '\0';
+    return len;
+}
 
-    rc = conf_line_parse(buf, &name_str, &val_str);
-    if (rc) {
+static int
+conf_fcb2_load_cb(struct fcb2_entry *loc, void *arg)
+{
+    struct conf_fcb2_load_cb_arg *argp;
+    char buf[CONF_RECORD_MAX_LEN];
+    struct conf_index_loc cil;
+    int len;
+
+    argp = (struct conf_fcb2_load_cb_arg *)arg;
+
+    len = conf_fcb2_var_read(loc, buf, sizeof(buf));
+    if (len < 0) {
         return 0;
     }
-    argp->cb(name_str, val_str, argp->cb_arg);
+    conf_fcb2_index_loc(loc, &cil);
+    conf_record_load(buf, len, argp->cb, argp->cb_arg, argp->ci, &cil);
     return 0;
 }
 
@@ -137,25 +230,86 @@ conf_fcb2_load(struct conf_store *cs, conf_store_load_cb cb, void *cb_arg)
 
     arg.cb = cb;
     arg.cb_arg = cb_arg;
+    arg.ci = NULL;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    /*
+     * Every walk goes through all records, so use it to refresh the index.
+     */
+    arg.ci = &cf->cf2_index;
+    conf_index_reset(arg.ci);
+#endif
     rc = fcb2_walk(&cf->cf2_fcb, FCB2_SECTOR_OLDEST, conf_fcb2_load_cb, &arg);
     if (rc) {
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+        conf_index_invalidate(arg.ci);
+#endif
         return OS_EINVAL;
     }
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    /*
+     * Lines staged by an open transaction are newer than anything in flash.
+     */
+    if (cb) {
+        conf_txn_buf_load(&cf->cf2_txn, cb, cb_arg);
+    }
+#endif
     return OS_OK;
 }
 
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
 static int
-conf_fcb2_var_read(struct fcb2_entry *loc, char *buf, char **name, char **val)
+conf_fcb2_dup_check(struct conf_store *cs, const char *name, const char *value)
 {
+    struct conf_fcb2 *cf = (struct conf_fcb2 *)cs;
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
     int rc;
 
-    rc = fcb2_read(loc, 0, buf, loc->fe_data_len);
-    if (rc) {
+    rc = conf_txn_buf_dup_check(&cf->cf2_txn, name, value);
+    if (rc != CONF_STORED_NONE) {
         return rc;
     }
-    buf[loc->fe_data_len] = '\0';
-    rc = conf_line_parse(buf, name, val);
-    return rc;
+#endif
+
+    return conf_index_dup_check(&cf->cf2_index, conf_fcb2_index_read, name,
+                                value);
+}
+
+static int
+conf_fcb2_get(struct conf_store *cs, const char *name, char *buf, int buf_len)
+{
+    struct conf_fcb2 *cf = (struct conf_fcb2 *)cs;
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    if (!conf_txn_buf_get(&cf->cf2_txn, name, buf, buf_len)) {
+        return 0;
+    }
+#endif
+    return conf_index_get(&cf->cf2_index, conf_fcb2_index_read, name, buf,
+                          buf_len);
+}
+#endif
+
+/*
+ * Returns 1 if a record after loc has a value for name.
+ */
+static int
+conf_fcb2_newer(const char *name, char *buf, int buf_len, void *arg)
+{
+    struct conf_fcb2_newer_arg *cna = arg;
+    struct fcb2_entry loc2;
+    int len;
+
+    loc2 = *cna->loc;
+    while (fcb2_getnext(cna->fcb, &loc2) == 0) {
+        len = conf_fcb2_var_read(&loc2, buf, buf_len);
+        if (len < 0) {
+            continue;
+        }
+        if (conf_record_find(buf, len, name, NULL)) {
+            return 1;
+        }
+    }
+    return 0;
 }
 
 static void
@@ -165,66 +319,48 @@ conf_fcb2_compress_internal(struct fcb2 *fcb,
                             void *cn_arg)
 {
     int rc;
-    char buf1[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    char buf2[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    char buf1[CONF_RECORD_MAX_LEN];
+    char buf2[CONF_RECORD_MAX_LEN];
+    struct conf_fcb2_newer_arg cna;
     struct fcb2_entry loc1;
     struct fcb2_entry loc2;
-    char *name1, *val1;
-    char *name2, *val2;
-    int copy;
+    int len1;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_fcb2 *cf;
+#endif
 
     rc = fcb2_append_to_scratch(fcb);
     if (rc) {
         return; /* XXX */
     }
 
+    cna.fcb = fcb;
+    cna.loc = &loc1;
     loc1.fe_range = NULL;
     loc1.fe_entry_num = 0;
     while (fcb2_getnext(fcb, &loc1) == 0) {
         if (loc1.fe_sector != fcb->f_oldest_sec) {
             break;
         }
-        rc = conf_fcb2_var_read(&loc1, buf1, &name1, &val1);
-        if (rc) {
-            continue;
-        }
-        if (!val1) {
-            continue;
-        }
-        loc2 = loc1;
-        copy = 1;
-        while (fcb2_getnext(fcb, &loc2) == 0) {
-            rc = conf_fcb2_var_read(&loc2, buf2, &name2, &val2);
-            if (rc) {
-                continue;
-            }
-            if (!strcmp(name1, name2)) {
-                copy = 0;
-                break;
-            }
-        }
-        if (!copy) {
+        len1 = conf_fcb2_var_read(&loc1, buf1, sizeof(buf1));
+        if (len1 < 0) {
             continue;
         }
 
-        if (copy_or_not) {
-            if (copy_or_not(name1, val1, cn_arg)) {
-                /* Copy rejected */
-                continue;
-            }
-        }
         /*
-         * Can't find one. Must copy.
+         * Lines still in use are copied as one record.
          */
-        rc = fcb2_read(&loc1, 0, buf1, loc1.fe_data_len);
-        if (rc) {
+        len1 = conf_record_compact(buf1, len1, buf2, sizeof(buf2),
+                                   conf_fcb2_newer, &cna, copy_or_not,
+                                   cn_arg);
+        if (!len1) {
             continue;
         }
-        rc = fcb2_append(fcb, loc1.fe_data_len, &loc2);
+        rc = fcb2_append(fcb, len1, &loc2);
         if (rc) {
             continue;
         }
-        rc = fcb2_write(&loc2, 0, buf1, loc1.fe_data_len);
+        rc = fcb2_write(&loc2, 0, buf1, len1);
         if (rc) {
             continue;
         }
@@ -235,10 +371,20 @@ conf_fcb2_compress_internal(struct fcb2 *fcb,
         /* XXXX */
         ;
     }
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    /*
+     * Records were moved, and the ones left behind erased.
+     */
+    cf = conf_fcb2_find(fcb);
+    if (cf) {
+        conf_fcb2_index_build(cf);
+    }
+#endif
 }
 
 static int
-conf_fcb2_append(struct fcb2 *fcb, char *buf, int len)
+conf_fcb2_append(struct fcb2 *fcb, char *buf, int len,
+                 struct fcb2_entry *locp)
 {
     int rc;
     int i;
@@ -262,14 +408,69 @@ conf_fcb2_append(struct fcb2 *fcb, char *buf, int len)
         return OS_EINVAL;
     }
     fcb2_append_finish(&loc);
+    *locp = loc;
     return OS_OK;
 }
 
+/*
+ * Appends a record of one or more lines, and points the index at it.
+ * Modifies buf.
+ */
+static int
+conf_fcb2_record_write(char *buf, int len, void *arg)
+{
+    struct fcb2 *fcb = arg;
+    struct fcb2_entry loc;
+    int rc;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_index_loc cil;
+    struct conf_fcb2 *cf;
+#endif
+
+    rc = conf_fcb2_append(fcb, buf, len, &loc);
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    if (rc == 0) {
+        cf = conf_fcb2_find(fcb);
+        if (cf) {
+            conf_fcb2_index_loc(&loc, &cil);
+            conf_record_load(buf, len, NULL, NULL, &cf->cf2_index, &cil);
+        }
+    }
+#endif
+    return rc;
+}
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+static int
+conf_fcb2_save_start(struct conf_store *cs)
+{
+    struct conf_fcb2 *cf = (struct conf_fcb2 *)cs;
+
+    conf_txn_buf_start(&cf->cf2_txn);
+    return OS_OK;
+}
+
+static int
+conf_fcb2_save_end(struct conf_store *cs)
+{
+    struct conf_fcb2 *cf = (struct conf_fcb2 *)cs;
+
+    return conf_txn_buf_end(&cf->cf2_txn, conf_fcb2_record_write,
+                            &cf->cf2_fcb);
+}
+#endif
+
 static int
 conf_fcb2_save(struct conf_store *cs, const char *name, const char *value)
 {
     struct conf_fcb2 *cf = (struct conf_fcb2 *)cs;
 
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+    if (cf->cf2_txn.ctb_open) {
+        return conf_txn_buf_stage(&cf->cf2_txn, name, value,
+                                  conf_fcb2_record_write, &cf->cf2_fcb);
+    }
+#endif
     return conf_fcb2_kv_save(&cf->cf2_fcb, name, value);
 }
 
@@ -286,35 +487,23 @@ static int
 conf_kv_load_cb(struct fcb2_entry *loc, void *arg)
 {
     struct conf_kv_load_cb_arg *cb_arg = arg;
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    char *name_str;
+    char buf[CONF_RECORD_MAX_LEN];
     char *val_str;
-    int rc;
     int len;
 
-    len = loc->fe_data_len;
-    if (len >= sizeof(buf)) {
-        len = sizeof(buf) - 1;
-    }
-
-    rc = fcb2_read(loc, 0, buf, len);
-    if (rc) {
-        return 0;
-    }
-    buf[len] = '\0';
-
-    rc = conf_line_parse(buf, &name_str, &val_str);
-    if (rc) {
+    len = conf_fcb2_var_read(loc, buf, sizeof(buf));
+    if (len < 0) {
         return 0;
     }
 
-    if (strcmp(name_str, cb_arg->name)) {
-        return 0;
+    if (conf_record_find(buf, len, cb_arg->name, &val_str)) {
+        if (!val_str) {
+            val_str = "";
+        }
+        strncpy(cb_arg->value, val_str, cb_arg->len);
+        cb_arg->value[cb_arg->len - 1] = '\0';
     }
 
-    strncpy(cb_arg->value, val_str, cb_arg->len);
-    cb_arg->value[cb_arg->len - 1] = '\0';
-
     return 0;
 }
 
@@ -323,6 +512,18 @@ conf_fcb2_kv_load(struct fcb2 *fcb, const char *name, char *value, size_t len)
 {
     struct conf_kv_load_cb_arg arg;
     int rc;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_fcb2 *cf;
+
+    cf = conf_fcb2_find(fcb);
+    if (cf) {
+        rc = conf_index_get(&cf->cf2_index, conf_fcb2_index_read, name, value,
+                            len);
+        if (rc == 0 || rc == OS_ENOENT) {
+            return OS_OK;
+        }
+    }
+#endif
 
     arg.name = name;
     arg.value = value;
@@ -339,7 +540,7 @@ conf_fcb2_kv_load(struct fcb2 *fcb, const char *name, char *value, size_t len)
 int
 conf_fcb2_kv_save(struct fcb2 *fcb, const char *name, const char *value)
 {
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    char buf[CONF_LINE_MAX_LEN];
     int len;
 
     if (!name) {
@@ -350,7 +551,7 @@ conf_fcb2_kv_save(struct fcb2 *fcb, const char *name, const char *value)
     if (len < 0 || len + 2 > sizeof(buf)) {
         return OS_INVALID_PARM;
     }
-    return conf_fcb2_append(fcb, buf, len);
+    return conf_fcb2_record_write(buf, len, fcb);
 }
 
 #endif
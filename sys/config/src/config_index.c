@@ -0,0 +1,235 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+
+#include <string.h>
+
+#include "config/config.h"
+#include "config/config_store.h"
+#include "config/config_index.h"
+#include "config_priv.h"
+
+#define CONF_INDEX_SIZE         MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE)
+#define CONF_INDEX_MAX_CNT      (CONF_INDEX_SIZE - CONF_INDEX_SIZE / 4)
+
+#if CONF_INDEX_SIZE < 4 || (CONF_INDEX_SIZE & (CONF_INDEX_SIZE - 1))
+#error "CONFIG_FCB_INDEX_SIZE must be a power of two"
+#endif
+
+/*
+ * Names are identified by two independent 32-bit hashes (FNV-1a and djb2),
+ * which makes it very unlikely that two settings map to the same entry.
+ * Whenever the index is used to skip a write or to return a value, the
+ * record itself is read back and its name compared, so a collision can
+ * only cost an extra write.
+ */
+static uint32_t
+conf_index_hash(const char *str, uint32_t *hash2)
+{
+    uint32_t h1;
+    uint32_t h2;
+    uint8_t c;
+
+    h1 = 2166136261UL;
+    h2 = 5381;
+    while ((c = *str++) != '\0') {
+        h1 = (h1 ^ c) * 16777619UL;
+        h2 = (h2 * 33) ^ c;
+    }
+    if (hash2) {
+        *hash2 = h2;
+    }
+    return h1;
+}
+
+static uint32_t
+conf_index_val_hash(const char *val)
+{
+    if (!val) {
+        val = "";
+    }
+    return conf_index_hash(val, NULL);
+}
+
+/*
+ * Returns the entry for the name, or the free slot where it would go.
+ */
+static struct conf_index_entry *
+conf_index_find(struct conf_index *ci, const char *name, uint32_t *hash1,
+                uint32_t *hash2)
+{
+    struct conf_index_entry *cie;
+    uint32_t idx;
+
+    *hash1 = conf_index_hash(name, hash2);
+    idx = *hash1;
+    while (1) {
+        idx &= CONF_INDEX_SIZE - 1;
+        cie = &ci->ci_entries[idx];
+        if (!cie->cie_loc.cil_area ||
+            (cie->cie_name_hash == *hash1 && cie->cie_name_hash2 == *hash2)) {
+            return cie;
+        }
+        idx++;
+    }
+}
+
+/*
+ * Reads the record of an entry, and finds the value for the given name in
+ * it.
+ */
+static int
+conf_index_read(struct conf_index_entry *cie, conf_index_read_fn read_fn,
+                const char *name, char *buf, int buf_len, char **valp)
+{
+    int len;
+    int rc;
+
+    len = cie->cie_loc.cil_data_len;
+    if (len >= buf_len) {
+        len = buf_len - 1;
+    }
+    rc = read_fn(&cie->cie_loc, buf, len);
+    if (rc) {
+        return -1;
+    }
+    buf[len] = '\0';
+
+    if (!conf_record_find(buf, len, name, valp)) {
+        return -1;
+    }
+    return 0;
+}
+
+void
+conf_index_reset(struct conf_index *ci)
+{
+    memset(ci->ci_entries, 0, sizeof(ci->ci_entries));
+    ci->ci_cnt = 0;
+    ci->ci_valid = 1;
+}
+
+void
+conf_index_invalidate(struct conf_index *ci)
+{
+    ci->ci_valid = 0;
+}
+
+void
+conf_index_update(struct conf_index *ci, const char *name, const char *val,
+                  const struct conf_index_loc *loc)
+{
+    struct conf_index_entry *cie;
+    uint32_t h1;
+    uint32_t h2;
+
+    if (!ci->ci_valid) {
+        return;
+    }
+    cie = conf_index_find(ci, name, &h1, &h2);
+    if (!cie->cie_loc.cil_area) {
+        if (ci->ci_cnt >= CONF_INDEX_MAX_CNT) {
+            /*
+             * Out of room; lookups walk the FCB until the next rebuild.
+             */
+            ci->ci_valid = 0;
+            return;
+        }
+        ci->ci_cnt++;
+        cie->cie_name_hash = h1;
+        cie->cie_name_hash2 = h2;
+    }
+    cie->cie_val_hash = conf_index_val_hash(val);
+    cie->cie_loc = *loc;
+}
+
+int
+conf_index_dup_check(struct conf_index *ci, conf_index_read_fn read_fn,
+                     const char *name, const char *val)
+{
+    char buf[CONF_RECORD_MAX_LEN];
+    struct conf_index_entry *cie;
+    char *val_str;
+    uint32_t h1;
+    uint32_t h2;
+    int rc;
+
+    if (!ci->ci_valid) {
+        return -1;
+    }
+    cie = conf_index_find(ci, name, &h1, &h2);
+    if (!cie->cie_loc.cil_area) {
+        return CONF_STORED_NONE;
+    }
+    if (cie->cie_val_hash != conf_index_val_hash(val)) {
+        return CONF_STORED_DIFFERENT;
+    }
+
+    rc = conf_index_read(cie, read_fn, name, buf, sizeof(buf), &val_str);
+    if (rc) {
+        return -1;
+    }
+    if (!val_str) {
+        val_str = "";
+    }
+    if (!val) {
+        val = "";
+    }
+    if (strcmp(val_str, val)) {
+        return CONF_STORED_DIFFERENT;
+    }
+    return CONF_STORED_SAME;
+}
+
+int
+conf_index_get(struct conf_index *ci, conf_index_read_fn read_fn,
+               const char *name, char *val, int val_len)
+{
+    char buf[CONF_RECORD_MAX_LEN];
+    struct conf_index_entry *cie;
+    char *val_str;
+    uint32_t h1;
+    uint32_t h2;
+    int rc;
+
+    if (!ci->ci_valid) {
+        return -1;
+    }
+    cie = conf_index_find(ci, name, &h1, &h2);
+    if (!cie->cie_loc.cil_area) {
+        return OS_ENOENT;
+    }
+
+    rc = conf_index_read(cie, read_fn, name, buf, sizeof(buf), &val_str);
+    if (rc) {
+        return -1;
+    }
+    if (!val_str) {
+        val_str = "";
+    }
+    strncpy(val, val_str, val_len - 1);
+    val[val_len - 1] = '\0';
+    return 0;
+}
+
+#endif
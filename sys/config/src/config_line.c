@@ -20,7 +20,10 @@
 #include <ctype.h>
 #include <string.h>
 
+#include "os/mynewt.h"
+
 #include "config/config.h"
+#include "config/config_store.h"
 #include "config_priv.h"
 
 int
@@ -97,3 +100,276 @@ conf_line_make(char *dst, int dlen, const char *name, const char *value)
 
     return off;
 }
+
+int
+conf_line_compact(char *dst, const char *name, const char *val)
+{
+    int nlen;
+    int vlen;
+
+    nlen = strlen(name);
+    if (val) {
+        vlen = strlen(val);
+    } else {
+        vlen = 0;
+    }
+    memmove(dst, name, nlen);
+    dst[nlen] = '=';
+    memmove(dst + nlen + 1, val, vlen);
+    dst[nlen + 1 + vlen] = '\0';
+
+    return nlen + 1 + vlen;
+}
+
+int
+conf_record_next(char *buf, int len, int *offp, char **namep, char **valp)
+{
+    int off;
+
+    while (*offp < len) {
+        off = *offp;
+        *offp = off + strlen(buf + off) + 1;
+        if (conf_line_parse(buf + off, namep, valp) == 0) {
+            return off;
+        }
+    }
+    return -1;
+}
+
+int
+conf_record_find(char *buf, int len, const char *name, char **valp)
+{
+    char *name_str;
+    char *val_str;
+    int found;
+    int off;
+
+    found = 0;
+    off = 0;
+    while (conf_record_next(buf, len, &off, &name_str, &val_str) >= 0) {
+        if (strcmp(name_str, name)) {
+            continue;
+        }
+        if (valp) {
+            *valp = val_str;
+        }
+        found = 1;
+    }
+    return found;
+}
+
+void
+conf_record_load(char *buf, int len, conf_store_load_cb cb, void *cb_arg,
+                 struct conf_index *ci, const struct conf_index_loc *loc)
+{
+    char *name_str;
+    char *val_str;
+    int off;
+
+    off = 0;
+    while (conf_record_next(buf, len, &off, &name_str, &val_str) >= 0) {
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+        if (ci) {
+            conf_index_update(ci, name_str, val_str, loc);
+        }
+#endif
+        if (cb) {
+            cb(name_str, val_str, cb_arg);
+        }
+    }
+}
+
+int
+conf_record_compact(char *buf, int len, char *tmp, int tmp_len,
+                    conf_record_newer_fn newer, void *newer_arg,
+                    int (*copy_or_not)(const char *name, const char *val,
+                                       void *cn_arg),
+                    void *cn_arg)
+{
+    char *name_str;
+    char *val_str;
+    int off;
+    int out;
+
+    off = 0;
+    out = 0;
+    while (conf_record_next(buf, len, &off, &name_str, &val_str) >= 0) {
+        if (!val_str) {
+            continue;
+        }
+        memcpy(tmp, buf + off, len - off + 1);
+        if (conf_record_find(tmp, len - off, name_str, NULL)) {
+            continue;
+        }
+        if (newer(name_str, tmp, tmp_len, newer_arg)) {
+            continue;
+        }
+        if (copy_or_not) {
+            if (copy_or_not(name_str, val_str, cn_arg)) {
+                /* Copy rejected */
+                continue;
+            }
+        }
+        out += conf_line_compact(buf + out, name_str, val_str) + 1;
+    }
+    if (!out) {
+        return 0;
+    }
+    return out - 1;
+}
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+void
+conf_txn_buf_start(struct conf_txn_buf *ctb)
+{
+    ctb->ctb_open = 1;
+    ctb->ctb_full = 0;
+    ctb->ctb_len = 0;
+}
+
+/*
+ * Writes the staged lines as one record.
+ */
+static int
+conf_txn_buf_flush(struct conf_txn_buf *ctb, conf_record_write_fn write_fn,
+                   void *arg)
+{
+    int len;
+
+    len = ctb->ctb_len;
+    if (!len) {
+        return OS_OK;
+    }
+    ctb->ctb_len = 0;
+    return write_fn(ctb->ctb_buf, len, arg);
+}
+
+int
+conf_txn_buf_end(struct conf_txn_buf *ctb, conf_record_write_fn write_fn,
+                 void *arg)
+{
+    ctb->ctb_open = 0;
+    if (ctb->ctb_full) {
+        ctb->ctb_full = 0;
+        return OS_ENOMEM;
+    }
+    return conf_txn_buf_flush(ctb, write_fn, arg);
+}
+
+/*
+ * Adds a line to the record being staged. Lines are separated by '\0',
+ * which conf_line_make() leaves after each one.
+ *
+ * A transaction is written as one record, so that it is stored either
+ * completely or not at all. If it does not fit, it is discarded, and this
+ * and the remaining saves as well as conf_txn_commit() fail. Lines staged by
+ * a plain conf_save() are written out whenever the buffer fills up.
+ */
+int
+conf_txn_buf_stage(struct conf_txn_buf *ctb, const char *name,
+                   const char *value, conf_record_write_fn write_fn,
+                   void *arg)
+{
+    int off;
+    int len;
+    int rc;
+
+    if (!name) {
+        return OS_INVALID_PARM;
+    }
+    if (ctb->ctb_full) {
+        return OS_ENOMEM;
+    }
+    off = ctb->ctb_len;
+    if (off) {
+        off++;
+    }
+    len = -1;
+    if (off < sizeof(ctb->ctb_buf)) {
+        len = conf_line_make(ctb->ctb_buf + off, sizeof(ctb->ctb_buf) - off,
+                             name, value);
+    }
+    if (len < 0) {
+        if (!off) {
+            return OS_INVALID_PARM;
+        }
+        if (conf_txn_is_open()) {
+            ctb->ctb_full = 1;
+            ctb->ctb_len = 0;
+            return OS_ENOMEM;
+        }
+        rc = conf_txn_buf_flush(ctb, write_fn, arg);
+        if (rc) {
+            return rc;
+        }
+        off = 0;
+        len = conf_line_make(ctb->ctb_buf, sizeof(ctb->ctb_buf), name, value);
+        if (len < 0) {
+            return OS_INVALID_PARM;
+        }
+    }
+    ctb->ctb_len = off + len;
+    return OS_OK;
+}
+
+int
+conf_txn_buf_dup_check(struct conf_txn_buf *ctb, const char *name,
+                       const char *value)
+{
+    char staged[CONF_MAX_VAL_LEN + 1];
+
+    if (conf_txn_buf_get(ctb, name, staged, sizeof(staged))) {
+        return CONF_STORED_NONE;
+    }
+    if (strcmp(staged, value ? value : "")) {
+        return CONF_STORED_DIFFERENT;
+    }
+    return CONF_STORED_SAME;
+}
+
+/*
+ * Lookups parse a copy, leaving the staged lines as they are.
+ */
+int
+conf_txn_buf_get(struct conf_txn_buf *ctb, const char *name, char *val,
+                 int val_len)
+{
+    char buf[sizeof(ctb->ctb_buf)];
+    char *val_str;
+    int len;
+
+    len = ctb->ctb_len;
+    if (!len) {
+        return OS_ENOENT;
+    }
+    memcpy(buf, ctb->ctb_buf, len);
+    buf[len] = '\0';
+
+    if (!conf_record_find(buf, len, name, &val_str)) {
+        return OS_ENOENT;
+    }
+    if (!val_str) {
+        val_str = "";
+    }
+    strncpy(val, val_str, val_len - 1);
+    val[val_len - 1] = '\0';
+    return 0;
+}
+
+void
+conf_txn_buf_load(struct conf_txn_buf *ctb, conf_store_load_cb cb,
+                  void *cb_arg)
+{
+    char buf[sizeof(ctb->ctb_buf)];
+    int len;
+
+    len = ctb->ctb_len;
+    if (!len) {
+        return;
+    }
+    memcpy(buf, ctb->ctb_buf, len);
+    buf[len] = '\0';
+
+    conf_record_load(buf, len, cb, cb_arg, NULL, NULL);
+}
+#endif
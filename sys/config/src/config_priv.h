@@ -20,6 +20,10 @@
 #ifndef __CONFIG_PRIV_H_
 #define __CONFIG_PRIV_H_
 
+#include "config/config_store.h"
+#include "config/config_index.h"
+#include "config/config_txn.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -31,6 +35,82 @@ struct mgmt_cbuf;
 int conf_line_parse(char *buf, char **namep, char **valp);
 int conf_line_make(char *dst, int dlen, const char *name, const char *val);
 int conf_line_make2(char *dst, int dlen, const char *name, const char *value);
+
+/*
+ * Like conf_line_make(), but name and val may lie within dst as long as they
+ * don't start before it; used to compact records in place.
+ */
+int conf_line_compact(char *dst, const char *name, const char *val);
+
+/*
+ * A record read from storage holds one "name=value" line, or several
+ * separated by '\0' if it was written by a config transaction.  buf must be
+ * '\0' terminated at len.
+ *
+ * conf_record_next() parses the line at *offp in place and advances *offp
+ * past it.  Returns the offset of the line, or -1 when there are no more.
+ * conf_record_find() returns 1 if any line of the record is for name, and
+ * points *valp, if given, at the last value for it.
+ */
+int conf_record_next(char *buf, int len, int *offp, char **namep,
+                     char **valp);
+int conf_record_find(char *buf, int len, const char *name, char **valp);
+
+struct conf_index;
+
+/*
+ * Passes each line of a record read from storage to cb, if given.  If ci is
+ * given, points the index entries of the settings at the record, at loc.
+ */
+void conf_record_load(char *buf, int len, conf_store_load_cb cb, void *cb_arg,
+                      struct conf_index *ci,
+                      const struct conf_index_loc *loc);
+
+/*
+ * Compaction of a record being copied by compression.  newer() returns 1
+ * if a later record holds a value for name; buf is scratch space of
+ * buf_len bytes for it.  Lines deleted, overwritten later on, or rejected by
+ * copy_or_not are dropped, and the rest moved to the start of buf.  tmp
+ * must be as large as buf.  Returns the length of the compacted record, or
+ * 0 if nothing is left to copy.
+ */
+typedef int (*conf_record_newer_fn)(const char *name, char *buf, int buf_len,
+                                    void *arg);
+int conf_record_compact(char *buf, int len, char *tmp, int tmp_len,
+                        conf_record_newer_fn newer, void *newer_arg,
+                        int (*copy_or_not)(const char *name, const char *val,
+                                           void *cn_arg),
+                        void *cn_arg);
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+/*
+ * Staging of settings saved in a transaction, shared by the FCB stores.
+ * write_fn appends a record to the store; it may modify buf.
+ *
+ * conf_txn_buf_dup_check() returns one of CONF_STORED_SAME/DIFFERENT, or
+ * CONF_STORED_NONE if the setting is not staged.  conf_txn_buf_get()
+ * returns 0 with the staged value copied to val, or OS_ENOENT.
+ */
+typedef int (*conf_record_write_fn)(char *buf, int len, void *arg);
+
+/*
+ * Returns 1 while a conf_txn_begin() transaction is open.
+ */
+int conf_txn_is_open(void);
+
+void conf_txn_buf_start(struct conf_txn_buf *ctb);
+int conf_txn_buf_end(struct conf_txn_buf *ctb, conf_record_write_fn write_fn,
+                     void *arg);
+int conf_txn_buf_stage(struct conf_txn_buf *ctb, const char *name,
+                       const char *value, conf_record_write_fn write_fn,
+                       void *arg);
+int conf_txn_buf_dup_check(struct conf_txn_buf *ctb, const char *name,
+                           const char *value);
+int conf_txn_buf_get(struct conf_txn_buf *ctb, const char *name, char *val,
+                     int val_len);
+void conf_txn_buf_load(struct conf_txn_buf *ctb, conf_store_load_cb cb,
+                       void *cb_arg);
+#endif
 struct conf_handler *conf_parse_and_lookup(char *name, int *name_argc,
                                            char *name_argv[]);
 
@@ -40,6 +120,29 @@ struct conf_handler *conf_parse_and_lookup(char *name, int *name_argc,
 int conf_export_cb(struct conf_handler *ch, conf_export_func_t export_func,
                    conf_export_tgt_t tgt);
 
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+typedef int (*conf_index_read_fn)(const struct conf_index_loc *loc,
+                                  char *buf, int len);
+
+/*
+ * Empties the index and marks it valid; the owner then calls
+ * conf_index_update() for every record in storage order.
+ */
+void conf_index_reset(struct conf_index *ci);
+void conf_index_invalidate(struct conf_index *ci);
+void conf_index_update(struct conf_index *ci, const char *name,
+                       const char *val, const struct conf_index_loc *loc);
+
+/*
+ * Lookups for csi_dup_check/csi_get.  Return -1 if the index can't be
+ * trusted, and the caller has to walk the storage instead.
+ */
+int conf_index_dup_check(struct conf_index *ci, conf_index_read_fn read_fn,
+                         const char *name, const char *val);
+int conf_index_get(struct conf_index *ci, conf_index_read_fn read_fn,
+                   const char *name, char *val, int val_len);
+#endif
+
 SLIST_HEAD(conf_store_head, conf_store);
 extern struct conf_store_head conf_load_srcs;
 SLIST_HEAD(conf_handler_head, conf_handler);
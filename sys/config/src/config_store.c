@@ -41,6 +41,8 @@ struct conf_store_head conf_load_srcs;
 struct conf_store *conf_save_dst;
 static bool conf_loading;
 static bool conf_loaded;
+static struct conf_store *conf_txn_dst;
+static int conf_txn_depth;
 
 void
 conf_src_register(struct conf_store *cs)
@@ -154,6 +156,31 @@ conf_get_value_cb(char *name, char *val, void *cb_arg)
     }
 }
 
+/*
+ * Look the value up using csi_get of every config store.  Returns -1 if
+ * some store can't answer without a full walk.
+ */
+static int
+conf_get_value_fast(struct conf_get_val_arg *cgva)
+{
+    struct conf_store *cs;
+    int rc;
+
+    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+        if (!cs->cs_itf->csi_get) {
+            return -1;
+        }
+        rc = cs->cs_itf->csi_get(cs, cgva->name, cgva->val,
+                                 sizeof(cgva->val));
+        if (rc == 0) {
+            cgva->seen = 1;
+        } else if (rc != OS_ENOENT) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 int
 conf_get_stored_value(char *name, char *buf, int buf_len)
 {
@@ -170,8 +197,12 @@ conf_get_stored_value(char *name, char *buf, int buf_len)
      * for every config store
      */
     conf_lock();
-    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
-        cs->cs_itf->csi_load(cs, conf_get_value_cb, &cgva);
+    if (conf_get_value_fast(&cgva)) {
+        cgva.val[0] = '\0';
+        cgva.seen = 0;
+        SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+            cs->cs_itf->csi_load(cs, conf_get_value_cb, &cgva);
+        }
     }
     conf_unlock();
 
@@ -209,6 +240,40 @@ conf_dup_check_cb(char *name, char *val, void *cb_arg)
     }
 }
 
+/*
+ * Duplicate check using csi_dup_check of every config store; the latest
+ * store holding the setting decides.  Returns -1 if some store can't answer
+ * without a full walk.
+ */
+static int
+conf_dup_check_fast(const char *name, const char *value)
+{
+    struct conf_store *cs;
+    int is_dup;
+    int rc;
+
+    is_dup = 0;
+    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+        if (!cs->cs_itf->csi_dup_check) {
+            return -1;
+        }
+        rc = cs->cs_itf->csi_dup_check(cs, name, value);
+        switch (rc) {
+        case CONF_STORED_NONE:
+            break;
+        case CONF_STORED_SAME:
+            is_dup = 1;
+            break;
+        case CONF_STORED_DIFFERENT:
+            is_dup = 0;
+            break;
+        default:
+            return -1;
+        }
+    }
+    return is_dup;
+}
+
 /*
  * Append a single value to persisted config. Don't store duplicate value.
  */
@@ -230,9 +295,12 @@ conf_save_one(const char *name, char *value)
      */
     cdca.name = name;
     cdca.val = value;
-    cdca.is_dup = 0;
-    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
-        cs->cs_itf->csi_load(cs, conf_dup_check_cb, &cdca);
+    cdca.is_dup = conf_dup_check_fast(name, value);
+    if (cdca.is_dup < 0) {
+        cdca.is_dup = 0;
+        SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+            cs->cs_itf->csi_load(cs, conf_dup_check_cb, &cdca);
+        }
     }
     if (cdca.is_dup == 1) {
         rc = 0;
@@ -251,15 +319,91 @@ conf_store_one(char *name, char *value)
     conf_save_one(name, value);
 }
 
+int
+conf_txn_begin(void)
+{
+    struct conf_store *cs;
+    int rc;
+
+    conf_lock();
+    if (conf_txn_depth) {
+        conf_txn_depth++;
+        return 0;
+    }
+    cs = conf_save_dst;
+    if (!cs) {
+        conf_unlock();
+        return OS_ENOENT;
+    }
+    if (cs->cs_itf->csi_save_start) {
+        rc = cs->cs_itf->csi_save_start(cs);
+        if (rc) {
+            conf_unlock();
+            return rc;
+        }
+    }
+    conf_txn_dst = cs;
+    conf_txn_depth = 1;
+
+    /*
+     * Lock is held until conf_txn_commit().
+     */
+    return 0;
+}
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN)
+int
+conf_txn_is_open(void)
+{
+    return conf_txn_depth != 0;
+}
+#endif
+
+int
+conf_txn_commit(void)
+{
+    struct conf_store *cs;
+    int rc;
+
+    conf_lock();
+    if (!conf_txn_depth) {
+        conf_unlock();
+        return OS_EINVAL;
+    }
+    rc = 0;
+    if (--conf_txn_depth == 0) {
+        cs = conf_txn_dst;
+        if (cs->cs_itf->csi_save_end) {
+            rc = cs->cs_itf->csi_save_end(cs);
+        }
+        conf_txn_dst = NULL;
+    }
+
+    /*
+     * Once for the lock taken above, and once for conf_txn_begin().
+     */
+    conf_unlock();
+    conf_unlock();
+    return rc;
+}
+
 int
 conf_save_tree(char *name)
 {
     int name_argc;
     char *name_argv[CONF_MAX_DIR_DEPTH];
+    struct conf_store *cs;
     struct conf_handler *ch;
+    int in_txn;
     int rc;
+    int rc2;
 
     conf_lock();
+    cs = conf_save_dst;
+    if (!cs) {
+        rc = OS_ENOENT;
+        goto out;
+    }
 
     ch = conf_parse_and_lookup(name, &name_argc, name_argv);
     if (!ch) {
@@ -267,7 +411,20 @@ conf_save_tree(char *name)
         goto out;
     }
 
+    /*
+     * Same as conf_save(); the subtree goes out as one write.
+     */
+    in_txn = conf_txn_depth != 0;
+    if (!in_txn && cs->cs_itf->csi_save_start) {
+        cs->cs_itf->csi_save_start(cs);
+    }
     rc = conf_export_cb(ch, conf_store_one, CONF_EXPORT_PERSIST);
+    if (!in_txn && cs->cs_itf->csi_save_end) {
+        rc2 = cs->cs_itf->csi_save_end(cs);
+        if (!rc) {
+            rc = rc2;
+        }
+    }
 
 out:
     conf_unlock();
@@ -284,6 +441,7 @@ conf_save(void)
 {
     struct conf_store *cs;
     struct conf_handler *ch;
+    int in_txn;
     int rc;
     int rc2;
 
@@ -294,7 +452,11 @@ conf_save(void)
         goto out;
     }
 
-    if (cs->cs_itf->csi_save_start) {
+    /*
+     * Within a transaction, the settings are written when it commits.
+     */
+    in_txn = conf_txn_depth != 0;
+    if (!in_txn && cs->cs_itf->csi_save_start) {
         cs->cs_itf->csi_save_start(cs);
     }
     rc = 0;
@@ -304,8 +466,11 @@ conf_save(void)
             rc = rc2;
         }
     }
-    if (cs->cs_itf->csi_save_end) {
-        cs->cs_itf->csi_save_end(cs);
+    if (!in_txn && cs->cs_itf->csi_save_end) {
+        rc2 = cs->cs_itf->csi_save_end(cs);
+        if (!rc) {
+            rc = rc2;
+        }
     }
 out:
     conf_unlock();
@@ -316,5 +481,7 @@ void
 conf_store_init(void)
 {
     conf_loaded = false;
+    conf_txn_dst = NULL;
+    conf_txn_depth = 0;
     SLIST_INIT(&conf_load_srcs);
 }
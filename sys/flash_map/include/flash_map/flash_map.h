@@ -89,6 +89,21 @@ int flash_area_write(const struct flash_area *, uint32_t off, const void *src,
   uint32_t len);
 int flash_area_erase(const struct flash_area *, uint32_t off, uint32_t len);
 
+/*
+ * Write combining.  Once enabled for an area, sequential writes to it are
+ * accumulated in RAM and only reach flash when a FLASH_MAP_WRITE_BUF_SIZE
+ * aligned page fills, when a non-sequential write or an erase hits the area,
+ * or when flash_area_flush() is called.  Reads through flash_area_read() see
+ * pending data; direct hal_flash accesses do not.
+ *
+ * flash_area_wbuf_enable() returns SYS_ENOTSUP if FLASH_MAP_WRITE_BUF is
+ * disabled and SYS_ENOMEM if all buffers are in use.  flash_area_flush() is
+ * a no-op when nothing is pending.
+ */
+int flash_area_wbuf_enable(const struct flash_area *);
+int flash_area_wbuf_disable(const struct flash_area *);
+int flash_area_flush(const struct flash_area *);
+
 /*
  * Whether the whole area is empty.
  */
@@ -38,6 +38,7 @@ TEST_CASE_DECL(flash_map_test_case_1)
 TEST_CASE_DECL(flash_map_test_case_2)
 TEST_CASE_DECL(flash_map_test_case_3)
 TEST_CASE_DECL(flash_map_test_case_new_areas)
+TEST_CASE_DECL(flash_map_test_case_wbuf)
 
 TEST_SUITE(flash_map_test_suite)
 {
@@ -45,6 +46,7 @@ TEST_SUITE(flash_map_test_suite)
     flash_map_test_case_2();
     flash_map_test_case_3();
     flash_map_test_case_new_areas();
+    flash_map_test_case_wbuf();
 }
 
 int
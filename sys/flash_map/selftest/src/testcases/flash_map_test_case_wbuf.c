@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "flash_map_test.h"
+
+/*
+ * Test write combining: small sequential writes are held back until a page
+ * fills or the area is flushed, and remain visible to flash_area_read().
+ */
+TEST_CASE_SELF(flash_map_test_case_wbuf)
+{
+    const struct flash_area *fa;
+    uint8_t wd[1000];
+    uint8_t rd[1000];
+    uint32_t pending;
+    uint32_t off;
+    int i;
+    int rc;
+
+    rc = flash_area_open(FLASH_AREA_NFFS, &fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_open() fail");
+
+    rc = flash_area_erase(fa, 0, fa->fa_size);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_erase() fail");
+
+    rc = flash_area_wbuf_enable(fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_wbuf_enable() fail");
+
+    for (i = 0; i < sizeof(wd); i++) {
+        wd[i] = i;
+    }
+    for (off = 0; off < sizeof(wd); off += 20) {
+        rc = flash_area_write(fa, off, wd + off, 20);
+        TEST_ASSERT_FATAL(rc == 0, "flash_area_write() fail");
+    }
+
+    /* Everything is visible through the flash map... */
+    rc = flash_area_read(fa, 0, rd, sizeof(rd));
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_read() fail");
+    TEST_ASSERT(memcmp(wd, rd, sizeof(wd)) == 0);
+
+    /* ...but the tail after the last full page has not reached flash. */
+    pending = (fa->fa_off + sizeof(wd)) % MYNEWT_VAL(FLASH_MAP_WRITE_BUF_SIZE);
+    TEST_ASSERT_FATAL(pending > 0);
+    rc = hal_flash_isempty(fa->fa_device_id,
+                           fa->fa_off + sizeof(wd) - pending, rd, pending);
+    TEST_ASSERT(rc == 1);
+    rc = hal_flash_read(fa->fa_device_id, fa->fa_off, rd,
+                        sizeof(wd) - pending);
+    TEST_ASSERT_FATAL(rc == 0, "hal_flash_read() fail");
+    TEST_ASSERT(memcmp(wd, rd, sizeof(wd) - pending) == 0);
+
+    rc = flash_area_flush(fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_flush() fail");
+    rc = hal_flash_read(fa->fa_device_id, fa->fa_off, rd, sizeof(rd));
+    TEST_ASSERT_FATAL(rc == 0, "hal_flash_read() fail");
+    TEST_ASSERT(memcmp(wd, rd, sizeof(wd)) == 0);
+
+    rc = flash_area_wbuf_disable(fa);
+    TEST_ASSERT(rc == 0);
+}
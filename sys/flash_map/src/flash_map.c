@@ -29,10 +29,303 @@
 #include "mfg/mfg.h"
 #endif
 #include "flash_map/flash_map.h"
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+#include "stats/stats.h"
+#endif
 
 const struct flash_area *flash_map;
 int flash_map_entries;
 
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+
+#define FLASH_MAP_WBUF_SIZE     MYNEWT_VAL(FLASH_MAP_WRITE_BUF_SIZE)
+
+/**
+ * Write-combining buffer covering one range of a flash device.  Holds the
+ * tail of a run of sequential writes that does not yet fill a
+ * FLASH_MAP_WBUF_SIZE-aligned page.  Pending bytes never cross a page
+ * boundary.
+ */
+struct flash_map_wbuf {
+    uint8_t fw_in_use;
+    uint8_t fw_device_id;
+    uint32_t fw_start;          /* Device address range covered. */
+    uint32_t fw_end;
+    uint32_t fw_addr;           /* Device address of fw_buf[0]. */
+    uint32_t fw_len;            /* Number of pending bytes. */
+    uint8_t fw_buf[FLASH_MAP_WBUF_SIZE];
+};
+
+static struct flash_map_wbuf flash_map_wbufs[MYNEWT_VAL(FLASH_MAP_WRITE_BUF_COUNT)];
+static struct os_mutex flash_map_wbuf_mtx;
+
+STATS_SECT_START(flash_map_stats)
+    STATS_SECT_ENTRY(wbuf_writes)
+    STATS_SECT_ENTRY(wbuf_bytes)
+    STATS_SECT_ENTRY(wbuf_flushes)
+    STATS_SECT_ENTRY(wbuf_direct)
+STATS_SECT_END
+
+STATS_NAME_START(flash_map_stats)
+    STATS_NAME(flash_map_stats, wbuf_writes)
+    STATS_NAME(flash_map_stats, wbuf_bytes)
+    STATS_NAME(flash_map_stats, wbuf_flushes)
+    STATS_NAME(flash_map_stats, wbuf_direct)
+STATS_NAME_END(flash_map_stats)
+
+STATS_SECT_DECL(flash_map_stats) flash_map_stats;
+
+static void
+flash_map_wbuf_lock(void)
+{
+    if (os_started()) {
+        os_mutex_pend(&flash_map_wbuf_mtx, OS_TIMEOUT_NEVER);
+    }
+}
+
+static void
+flash_map_wbuf_unlock(void)
+{
+    if (os_started()) {
+        os_mutex_release(&flash_map_wbuf_mtx);
+    }
+}
+
+/**
+ * Finds the write buffer that covers any part of the specified device range.
+ */
+static struct flash_map_wbuf *
+flash_map_wbuf_find(uint8_t device_id, uint32_t addr, uint32_t len)
+{
+    struct flash_map_wbuf *wb;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(FLASH_MAP_WRITE_BUF_COUNT); i++) {
+        wb = &flash_map_wbufs[i];
+        if (wb->fw_in_use &&
+            wb->fw_device_id == device_id &&
+            addr < wb->fw_end && addr + len > wb->fw_start) {
+
+            return wb;
+        }
+    }
+
+    return NULL;
+}
+
+static bool
+flash_map_wbuf_overlaps(const struct flash_map_wbuf *wb, uint32_t addr,
+                        uint32_t len)
+{
+    return wb->fw_len != 0 &&
+           addr < wb->fw_addr + wb->fw_len && addr + len > wb->fw_addr;
+}
+
+static int
+flash_map_wbuf_flush(struct flash_map_wbuf *wb)
+{
+    int rc;
+
+    if (wb->fw_len == 0) {
+        return 0;
+    }
+
+    rc = hal_flash_write(wb->fw_device_id, wb->fw_addr, wb->fw_buf,
+                         wb->fw_len);
+    /* Pending data is dropped on failure, as an unbuffered write would have
+     * been.
+     */
+    wb->fw_len = 0;
+    STATS_INC(flash_map_stats, wbuf_flushes);
+
+    return rc;
+}
+
+/**
+ * Writes through a write buffer.  Data is appended to the pending bytes while
+ * the run stays sequential and inside one page; a page is written to flash
+ * as soon as it fills.  Page-aligned runs of whole pages bypass the buffer.
+ */
+static int
+flash_map_wbuf_write(struct flash_map_wbuf *wb, uint32_t addr,
+                     const uint8_t *src, uint32_t len)
+{
+    uint32_t page_end;
+    uint32_t chunk;
+    int rc;
+
+    STATS_INC(flash_map_stats, wbuf_writes);
+
+    while (len > 0) {
+        if (wb->fw_len != 0 && addr != wb->fw_addr + wb->fw_len) {
+            rc = flash_map_wbuf_flush(wb);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+
+        if (wb->fw_len == 0 && addr % FLASH_MAP_WBUF_SIZE == 0 &&
+            len >= FLASH_MAP_WBUF_SIZE) {
+
+            chunk = len - len % FLASH_MAP_WBUF_SIZE;
+            rc = hal_flash_write(wb->fw_device_id, addr, (void *)src, chunk);
+            if (rc != 0) {
+                return rc;
+            }
+            STATS_INC(flash_map_stats, wbuf_direct);
+        } else {
+            page_end = addr - addr % FLASH_MAP_WBUF_SIZE + FLASH_MAP_WBUF_SIZE;
+            chunk = min(len, page_end - addr);
+
+            if (wb->fw_len == 0) {
+                wb->fw_addr = addr;
+            }
+            memcpy(wb->fw_buf + wb->fw_len, src, chunk);
+            wb->fw_len += chunk;
+            STATS_INCN(flash_map_stats, wbuf_bytes, chunk);
+
+            if (addr + chunk == page_end) {
+                rc = flash_map_wbuf_flush(wb);
+                if (rc != 0) {
+                    return rc;
+                }
+            }
+        }
+
+        addr += chunk;
+        src += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes any pending data that overlaps the specified device range so that
+ * flash contents can be inspected or erased directly.
+ */
+static int
+flash_map_wbuf_flush_range(uint8_t device_id, uint32_t addr, uint32_t len)
+{
+    struct flash_map_wbuf *wb;
+    int rc;
+
+    rc = 0;
+    wb = flash_map_wbuf_find(device_id, addr, len);
+    if (wb != NULL && flash_map_wbuf_overlaps(wb, addr, len)) {
+        rc = flash_map_wbuf_flush(wb);
+    }
+
+    return rc;
+}
+
+int
+flash_area_wbuf_enable(const struct flash_area *fa)
+{
+    struct flash_map_wbuf *wb;
+    int rc;
+    int i;
+
+    flash_map_wbuf_lock();
+
+    wb = flash_map_wbuf_find(fa->fa_device_id, fa->fa_off, fa->fa_size);
+    if (wb != NULL) {
+        if (wb->fw_start == fa->fa_off &&
+            wb->fw_end == fa->fa_off + fa->fa_size) {
+            rc = 0;
+        } else {
+            rc = SYS_EINVAL;
+        }
+        goto done;
+    }
+
+    rc = SYS_ENOMEM;
+    for (i = 0; i < MYNEWT_VAL(FLASH_MAP_WRITE_BUF_COUNT); i++) {
+        wb = &flash_map_wbufs[i];
+        if (!wb->fw_in_use) {
+            wb->fw_in_use = 1;
+            wb->fw_device_id = fa->fa_device_id;
+            wb->fw_start = fa->fa_off;
+            wb->fw_end = fa->fa_off + fa->fa_size;
+            wb->fw_len = 0;
+            rc = 0;
+            break;
+        }
+    }
+
+done:
+    flash_map_wbuf_unlock();
+    return rc;
+}
+
+int
+flash_area_wbuf_disable(const struct flash_area *fa)
+{
+    struct flash_map_wbuf *wb;
+    int rc;
+
+    flash_map_wbuf_lock();
+
+    rc = 0;
+    wb = flash_map_wbuf_find(fa->fa_device_id, fa->fa_off, fa->fa_size);
+    if (wb != NULL) {
+        rc = flash_map_wbuf_flush(wb);
+        wb->fw_in_use = 0;
+    }
+
+    flash_map_wbuf_unlock();
+    return rc;
+}
+
+int
+flash_area_flush(const struct flash_area *fa)
+{
+    int rc;
+
+    flash_map_wbuf_lock();
+    rc = flash_map_wbuf_flush_range(fa->fa_device_id, fa->fa_off,
+                                    fa->fa_size);
+    flash_map_wbuf_unlock();
+
+    return rc;
+}
+
+int
+flash_map_wbuf_sysdown(int reason)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(FLASH_MAP_WRITE_BUF_COUNT); i++) {
+        if (flash_map_wbufs[i].fw_in_use) {
+            flash_map_wbuf_flush(&flash_map_wbufs[i]);
+        }
+    }
+
+    return SYSDOWN_COMPLETE;
+}
+
+#else
+
+int
+flash_area_wbuf_enable(const struct flash_area *fa)
+{
+    return SYS_ENOTSUP;
+}
+
+int
+flash_area_wbuf_disable(const struct flash_area *fa)
+{
+    return 0;
+}
+
+int
+flash_area_flush(const struct flash_area *fa)
+{
+    return 0;
+}
+
+#endif
+
 static int
 flash_area_find_idx(uint8_t id)
 {
@@ -234,30 +527,104 @@ int
 flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
     uint32_t len)
 {
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+    struct flash_map_wbuf *wb;
+    uint32_t addr;
+    uint32_t start;
+    uint32_t end;
+    int rc;
+#endif
+
     if (off > fa->fa_size || off + len > fa->fa_size) {
         return -1;
     }
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+    addr = fa->fa_off + off;
+
+    flash_map_wbuf_lock();
+
+    rc = hal_flash_read(fa->fa_device_id, addr, dst, len);
+    if (rc == 0) {
+        /* Data that is still pending in a write buffer takes precedence over
+         * what is in flash.
+         */
+        wb = flash_map_wbuf_find(fa->fa_device_id, addr, len);
+        if (wb != NULL && flash_map_wbuf_overlaps(wb, addr, len)) {
+            start = max(addr, wb->fw_addr);
+            end = min(addr + len, wb->fw_addr + wb->fw_len);
+            memcpy((uint8_t *)dst + (start - addr),
+                   wb->fw_buf + (start - wb->fw_addr), end - start);
+        }
+    }
+
+    flash_map_wbuf_unlock();
+    return rc;
+#else
     return hal_flash_read(fa->fa_device_id, fa->fa_off + off, dst, len);
+#endif
 }
 
 int
 flash_area_write(const struct flash_area *fa, uint32_t off, const void *src,
     uint32_t len)
 {
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+    struct flash_map_wbuf *wb;
+    int rc;
+#endif
+
     if (off > fa->fa_size || off + len > fa->fa_size) {
         return -1;
     }
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+    flash_map_wbuf_lock();
+
+    wb = flash_map_wbuf_find(fa->fa_device_id, fa->fa_off + off, len);
+    if (wb != NULL &&
+        fa->fa_off + off >= wb->fw_start &&
+        fa->fa_off + off + len <= wb->fw_end) {
+
+        rc = flash_map_wbuf_write(wb, fa->fa_off + off, src, len);
+    } else {
+        rc = flash_map_wbuf_flush_range(fa->fa_device_id, fa->fa_off + off,
+                                        len);
+        if (rc == 0) {
+            rc = hal_flash_write(fa->fa_device_id, fa->fa_off + off,
+                                 (void *)src, len);
+        }
+    }
+
+    flash_map_wbuf_unlock();
+    return rc;
+#else
     return hal_flash_write(fa->fa_device_id, fa->fa_off + off,
                            (void *)src, len);
+#endif
 }
 
 int
 flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
 {
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+    int rc;
+#endif
+
     if (off > fa->fa_size || off + len > fa->fa_size) {
         return -1;
     }
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+    flash_map_wbuf_lock();
+
+    rc = flash_map_wbuf_flush_range(fa->fa_device_id, fa->fa_off + off, len);
+    if (rc == 0) {
+        rc = hal_flash_erase(fa->fa_device_id, fa->fa_off + off, len);
+    }
+
+    flash_map_wbuf_unlock();
+    return rc;
+#else
     return hal_flash_erase(fa->fa_device_id, fa->fa_off + off, len);
+#endif
 }
 
 uint8_t
@@ -291,6 +658,15 @@ flash_area_is_empty(const struct flash_area *fa, bool *empty)
     int rc;
 
     *empty = false;
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+    flash_map_wbuf_lock();
+    rc = flash_map_wbuf_flush_range(fa->fa_device_id, fa->fa_off,
+                                    fa->fa_size);
+    flash_map_wbuf_unlock();
+    if (rc != 0) {
+        return rc;
+    }
+#endif
     rc = hal_flash_isempty_no_buf(fa->fa_device_id, fa->fa_off, fa->fa_size);
     if (rc < 0) {
         return rc;
@@ -305,6 +681,16 @@ int
 flash_area_read_is_empty(const struct flash_area *fa, uint32_t off, void *dst,
                          uint32_t len)
 {
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+    int rc;
+
+    flash_map_wbuf_lock();
+    rc = flash_map_wbuf_flush_range(fa->fa_device_id, fa->fa_off + off, len);
+    flash_map_wbuf_unlock();
+    if (rc != 0) {
+        return rc;
+    }
+#endif
     return hal_flash_isempty(fa->fa_device_id, fa->fa_off + off, dst, len);
 }
 
@@ -504,6 +890,17 @@ flash_map_init(void)
     rc = hal_flash_init();
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(FLASH_MAP_WRITE_BUF)
+    rc = os_mutex_init(&flash_map_wbuf_mtx);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    rc = stats_init_and_reg(
+        STATS_HDR(flash_map_stats),
+        STATS_SIZE_INIT_PARMS(flash_map_stats, STATS_SIZE_32),
+        STATS_NAME_INIT_PARMS(flash_map_stats), "flash_map");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
     /* Use the hardcoded default flash map.  This is done for two reasons:
      * 1. A minimal flash map configuration is required to boot strap the
      *    process of reading the flash map from the manufacturing meta regions.
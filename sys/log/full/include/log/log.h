@@ -19,6 +19,7 @@
 #ifndef __SYS_LOG_FULL_H__
 #define __SYS_LOG_FULL_H__
 
+#include <stdarg.h>
 #include "os/mynewt.h"
 #include "cbmem/cbmem.h"
 #include "log_common/log_common.h"
@@ -94,6 +95,13 @@ typedef int (*lh_append_mbuf_func_t)(struct log *, struct os_mbuf *om);
 typedef int (*lh_append_mbuf_body_func_t)(struct log *log,
                                           const struct log_entry_hdr *hdr,
                                           struct os_mbuf *om);
+/*
+ * Appends several entries in one call.  `buf` holds `len` bytes of entries
+ * back to back, each a uint16_t length (unaligned, host order) followed by
+ * that many bytes of header and body.
+ */
+typedef int (*lh_append_batch_func_t)(struct log *log, const void *buf,
+                                      int len);
 typedef int (*lh_walk_func_t)(struct log *,
         log_walk_func_t walk_func, struct log_offset *log_offset);
 typedef int (*lh_flush_func_t)(struct log *);
@@ -113,6 +121,8 @@ struct log_handler {
     lh_append_body_func_t log_append_body;
     lh_append_mbuf_func_t log_append_mbuf;
     lh_append_mbuf_body_func_t log_append_mbuf_body;
+    /* Optional; used by the async log to write a whole batch at once. */
+    lh_append_batch_func_t log_append_batch;
     lh_walk_func_t log_walk;
     lh_walk_func_t log_walk_sector;
     lh_flush_func_t log_flush;
@@ -131,6 +141,8 @@ struct log_handler {
 
 /* Flags used to indicate type of data in reserved payload*/
 #define LOG_FLAGS_IMG_HASH (1 << 0)
+/* The body is a dictionary entry written by log_printf(); see LOG_DICT. */
+#define LOG_FLAGS_DICT     (1 << 1)
 
 #if MYNEWT_VAL(LOG_VERSION) == 3
 struct log_entry_hdr {
@@ -508,6 +520,30 @@ log_append_mbuf(struct log *log, uint8_t module, uint8_t level,
 
 void log_printf(struct log *log, uint8_t module, uint8_t level,
         const char *msg, ...);
+
+#if MYNEWT_VAL(LOG_DICT)
+/**
+ * @brief Encodes a log_printf() call as a dictionary entry body.
+ *
+ * Instead of formatting the message, the address of the format string is
+ * written, followed by the raw value of each argument in native byte order:
+ * int-sized words for integers and characters, 8 bytes for doubles and
+ * "ll" integers, pointer-sized words for "l", "z", "t" and pointers, and
+ * the NUL-terminated contents of "%s" strings.  A host-side decoder finds the
+ * format string in the application ELF and formats the message there.
+ *
+ * @param buf                   The buffer to encode into.
+ * @param buf_len               The size of the buffer.  Arguments that do
+ *                                  not fit are left out; a string argument
+ *                                  is truncated.
+ * @param fmt                   The printf-style format string; must not be
+ *                                  on the stack or in the heap.
+ * @param ap                    The format arguments.
+ *
+ * @return                      The number of bytes written to buf.
+ */
+int log_dict_encode(void *buf, int buf_len, const char *fmt, va_list ap);
+#endif
 int log_read(struct log *log, const void *dptr, void *buf, uint16_t off,
         uint16_t len);
 
@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef __SYS_LOG_ASYNC_H_
+#define __SYS_LOG_ASYNC_H_
+
+#include "os/mynewt.h"
+#include "log/log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(LOG_ASYNC)
+
+/** Full queue: drop the new entry. */
+#define LOG_ASYNC_POLICY_DROP           0
+/** Full queue: wait for the writer task to free space. */
+#define LOG_ASYNC_POLICY_BLOCK          1
+/** Full queue: evict the oldest queued entries if their level is lower. */
+#define LOG_ASYNC_POLICY_DROP_LOWEST    2
+
+#if MYNEWT_VAL(LOG_STATS)
+STATS_SECT_START(log_async_stats)
+    STATS_SECT_ENTRY(queued)
+    STATS_SECT_ENTRY(written)
+    STATS_SECT_ENTRY(drops)
+    STATS_SECT_ENTRY(evicts)
+    STATS_SECT_ENTRY(blocks)
+    STATS_SECT_ENTRY(batches)
+    STATS_SECT_ENTRY(errs)
+    STATS_SECT_ENTRY(depth)
+    STATS_SECT_ENTRY(depth_max)
+STATS_SECT_END
+#endif
+
+/**
+ * State of an asynchronous log.  A log registered with log_async_handler
+ * takes a pointer to one of these as its argument.
+ */
+struct log_async {
+    /** The log the target handler operates on. */
+    struct log la_target;
+
+    /** The log registered with log_async_handler. */
+    struct log *la_log;
+
+    /** Queue of entries not yet handed to the target. */
+    uint8_t *la_buf;
+    uint16_t la_size;
+
+    /** Offset of the oldest queued entry. */
+    uint16_t la_off;
+
+    /** Bytes and entries currently queued. */
+    uint16_t la_used;
+    uint16_t la_cnt;
+
+    /** Bytes at the head the writer task is copying out. */
+    uint16_t la_claimed;
+
+    /** Highest number of bytes ever queued. */
+    uint16_t la_used_max;
+
+    /** One of the LOG_ASYNC_POLICY_[...] constants. */
+    uint8_t la_policy;
+
+    /** Number of callers blocked on a full queue. */
+    uint8_t la_waiters;
+
+    /** Number of entries reserved but still being copied in. */
+    uint8_t la_pending;
+
+    struct os_sem la_sem;
+    struct os_event la_ev;
+    struct os_callout la_timer;
+
+#if MYNEWT_VAL(LOG_STATS)
+    STATS_SECT_DECL(log_async_stats) la_stats;
+#endif
+};
+
+extern const struct log_handler log_async_handler;
+
+/**
+ * @brief Configures an asynchronous log.
+ *
+ * Entries appended to a log registered with log_async_handler and `la` are
+ * queued in `buf` and later written by the writer task, using the `target`
+ * handler with `target_arg` as the log argument.
+ *
+ * @param la                    The async log state to initialize.
+ * @param target                Handler entries are eventually written with.
+ * @param target_arg            Log argument of the target handler, e.g. a
+ *                                  struct fcb_log.
+ * @param buf                   Memory holding the queue.
+ * @param buf_len               Size of the queue, in bytes.
+ * @param name                  Name to register the queue statistics under;
+ *                                  NULL to not register them.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int log_async_init(struct log_async *la, const struct log_handler *target,
+                   void *target_arg, void *buf, uint16_t buf_len,
+                   const char *name);
+
+/**
+ * @brief Sets what an async log does with new entries when its queue is
+ * full.
+ *
+ * @param la                    The async log.
+ * @param policy                One of the LOG_ASYNC_POLICY_[...] constants.
+ */
+void log_async_set_policy(struct log_async *la, uint8_t policy);
+
+/**
+ * @brief Writes all queued entries of an async log to its target now.
+ *
+ * Reads and walks of the log do this implicitly.
+ *
+ * @param log                   A log registered with log_async_handler.
+ *
+ * @return                      0 on success; the error of the first failed
+ *                                  write otherwise.
+ */
+int log_async_drain(struct log *log);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYS_LOG_ASYNC_H_ */
@@ -56,6 +56,46 @@ struct log_fcb_bset {
     int lfs_next;
 };
 
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+/** An entry remembered by the sparse index. */
+struct log_fcb_sidx_slot {
+#if MYNEWT_VAL(LOG_FCB)
+    struct fcb_entry lsl_entry;
+#elif MYNEWT_VAL(LOG_FCB2)
+    struct fcb2_entry lsl_entry;
+#endif
+    /* The index of the log entry that the FCB entry contains. */
+    uint32_t lsl_index;
+};
+
+/** Sparse index of one FCB sector. */
+struct log_fcb_sidx_sector {
+    /** Every (1 << lss_shift)th entry of the sector, starting with the first. */
+    struct log_fcb_sidx_slot lss_slots[MYNEWT_VAL(LOG_FCB_SPARSE_INDEX_SLOTS)];
+
+    /** The number of entries in the sector. */
+    uint16_t lss_cnt;
+
+    /** Log2 of the number of entries between slots. */
+    uint8_t lss_shift;
+
+    /** The number of slots in use; 0 if nothing is known of the sector. */
+    uint8_t lss_nslots;
+};
+
+/** A sparse index of an fcb log. */
+struct log_fcb_sidx {
+    /** Array of sectors, indexed by FCB sector number. */
+    struct log_fcb_sidx_sector *lsi_sectors;
+
+    /** The number of sectors in the array. */
+    int lsi_cap;
+
+    /** Whether the index describes every entry in the log. */
+    uint8_t lsi_valid;
+};
+#endif
+
 /**
  * fcb_log is needed as the number of entries in a log
  */
@@ -72,6 +112,9 @@ struct fcb_log {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     struct log_fcb_bset fl_bset;
 #endif
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    struct log_fcb_sidx fl_sidx;
+#endif
 };
 
 #elif MYNEWT_VAL(LOG_FCB2)
@@ -87,6 +130,9 @@ struct fcb_log {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     struct log_fcb_bset fl_bset;
 #endif
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    struct log_fcb_sidx fl_sidx;
+#endif
 };
 #endif
 
@@ -161,6 +207,88 @@ void log_fcb_add_bmark(struct fcb_log *fcb_log, const struct fcb2_entry *entry,
 #endif
 #endif
 
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+
+struct log;
+struct log_offset;
+
+/**
+ * The sparse index speeds up seeks in FCB-backed logs.  For each sector it
+ * keeps the first entry, the latest timestamp, and a few entries spread
+ * over the sector.  A seek picks the sector with a binary search, and walks
+ * from the closest remembered entry within it.
+ *
+ * The index is kept up to date as entries are appended, and as sectors are
+ * rotated out or the log is flushed.  Entries already in the log when the
+ * index is configured are indexed with one walk on the first seek.
+ */
+
+/**
+ * @brief Configures an fcb_log to use the specified buffer for its sparse
+ * index.
+ *
+ * @param fcb_log               The log to configure.
+ * @param buf                   The buffer to use for the index.
+ * @param sector_cnt            The number of sectors the buffer holds.  The
+ *                                  index is not used if this is smaller
+ *                                  than the number of sectors in the FCB.
+ */
+void log_fcb_init_sidx(struct fcb_log *fcb_log,
+                       struct log_fcb_sidx_sector *buf, int sector_cnt);
+
+/**
+ * @brief Empties the sparse index of the supplied fcb_log.  This is meant
+ * to get called when the FCB is cleared.
+ *
+ * @param fcb_log               The fcb_log to clear.
+ */
+void log_fcb_clear_sidx(struct fcb_log *fcb_log);
+
+/**
+ * @brief Drops the oldest FCB/FCB2 sector from the sparse index.  This is
+ * meant to get called just before the sector is rotated out.
+ *
+ * @param fcb_log               The fcb_log to operate on.
+ */
+void log_fcb_rotate_sidx(struct fcb_log *fcb_log);
+
+/**
+ * Adds a newly appended entry to the sparse index.
+ *
+ * @param fcb_log               The log the entry was appended to.
+ * @param entry                 The FCB entry holding the log entry.
+ * @param index                 The index of the log entry.
+ */
+#if MYNEWT_VAL(LOG_FCB)
+void log_fcb_add_sidx(struct fcb_log *fcb_log, const struct fcb_entry *entry,
+                      uint32_t index);
+#elif MYNEWT_VAL(LOG_FCB2)
+void log_fcb_add_sidx(struct fcb_log *fcb_log, const struct fcb2_entry *entry,
+                      uint32_t index);
+#endif
+
+/**
+ * @brief Searches the sparse index for the entry to start a seek from: the
+ * closest indexed entry at or before the requested index.  Like the walk
+ * without the index, it does not filter by timestamp.
+ *
+ * @param log                   The log to search.
+ * @param log_offset            The index to look for.
+ * @param entry                 On success, the entry to start from.
+ * @param index                 On success, the log index of that entry.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOTSUP if the index can't be used.
+ */
+#if MYNEWT_VAL(LOG_FCB)
+int log_fcb_find_sidx(struct log *log, const struct log_offset *log_offset,
+                      struct fcb_entry *entry, uint32_t *index);
+#elif MYNEWT_VAL(LOG_FCB2)
+int log_fcb_find_sidx(struct log *log, const struct log_offset *log_offset,
+                      struct fcb2_entry *entry, uint32_t *index);
+#endif
+#endif
+
 #ifdef __cplusplus
 }
 #endif
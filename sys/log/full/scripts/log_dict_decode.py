@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Decodes dictionary log entries (LOG_DICT) into text.
+
+Reads the output of the shell "log" command, or lines of hex entry bodies,
+and replaces each "dict:<hex>" body with the formatted message.  The format
+strings are looked up in the ELF of the application that wrote the log.
+
+    log_dict_decode.py app.elf [log.txt]
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+CONV_RE = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?'
+                     r'(hh|h|ll|l|j|z|t|L)?([diouxXcpfFeEgGaAsn%])')
+DICT_RE = re.compile(r'dict:([0-9a-fA-F]+)')
+
+
+class Elf:
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF':
+            raise ValueError('%s: not an ELF file' % path)
+
+        self.is64 = self.data[4] == 2
+        self.endian = '<' if self.data[5] == 1 else '>'
+        self.ptr_size = 8 if self.is64 else 4
+
+        if self.is64:
+            shoff, = self.unpack('Q', 0x28)
+            shentsize, shnum = self.unpack('HH', 0x3a)
+        else:
+            shoff, = self.unpack('I', 0x20)
+            shentsize, shnum = self.unpack('HH', 0x2e)
+
+        # (address, size, file offset) of each section loaded from the file.
+        self.sections = []
+        for i in range(shnum):
+            off = shoff + i * shentsize
+            if self.is64:
+                _, sh_type, _, addr, offset, size = \
+                    self.unpack('IIQQQQ', off)
+            else:
+                _, sh_type, _, addr, offset, size = \
+                    self.unpack('IIIIII', off)
+            # Skip SHT_NULL and SHT_NOBITS.
+            if addr != 0 and sh_type not in (0, 8):
+                self.sections.append((addr, size, offset))
+
+    def unpack(self, fmt, off):
+        return struct.unpack_from(self.endian + fmt, self.data, off)
+
+    def string_at(self, addr):
+        for sec_addr, size, offset in self.sections:
+            if sec_addr <= addr < sec_addr + size:
+                start = offset + addr - sec_addr
+                end = self.data.index(b'\0', start)
+                return self.data[start:end].decode('utf-8', 'replace')
+        return None
+
+
+class Body:
+    def __init__(self, elf, data):
+        self.elf = elf
+        self.data = data
+        self.off = 0
+
+    def take(self, fmt, size):
+        if self.off + size > len(self.data):
+            raise IndexError
+        val, = struct.unpack_from(self.elf.endian + fmt, self.data, self.off)
+        self.off += size
+        return val
+
+    def int_arg(self, lmod, signed):
+        if lmod in ('ll', 'j'):
+            fmt, size = 'q', 8
+        elif lmod in ('l', 'z', 't'):
+            fmt, size = ('q', 8) if self.elf.is64 else ('i', 4)
+        else:
+            fmt, size = 'i', 4
+        return self.take(fmt if signed else fmt.upper(), size)
+
+    def str_arg(self):
+        end = self.data.find(b'\0', self.off)
+        if end < 0:
+            end = len(self.data)
+        s = self.data[self.off:end].decode('utf-8', 'replace')
+        self.off = end + 1
+        return s
+
+
+def decode(elf, data):
+    body = Body(elf, data)
+    try:
+        addr = body.take('Q' if elf.is64 else 'I', elf.ptr_size)
+    except IndexError:
+        return '<empty dict entry>'
+
+    fmt = elf.string_at(addr)
+    if fmt is None:
+        return '<unknown format string 0x%x>' % addr
+
+    def conv(m):
+        flags, width, prec, lmod, spec = m.groups()
+        if spec == '%':
+            return '%'
+        if width == '*':
+            width = str(body.int_arg(None, True))
+        if prec == '*':
+            prec = str(body.int_arg(None, True))
+        pyspec = '%' + flags + (width or '')
+        if prec is not None:
+            pyspec += '.' + prec
+
+        if spec in 'di':
+            return (pyspec + 'd') % body.int_arg(lmod, True)
+        if spec in 'ouxX':
+            return (pyspec + spec.replace('u', 'd')) % body.int_arg(lmod, False)
+        if spec == 'c':
+            return (pyspec + 'c') % chr(body.int_arg(lmod, False) & 0xff)
+        if spec == 'p':
+            return '0x%x' % body.take('Q' if elf.is64 else 'I', elf.ptr_size)
+        if spec in 'fFeEgG':
+            return (pyspec + spec) % body.take('d', 8)
+        if spec in 'aA':
+            return body.take('d', 8).hex()
+        if spec == 's':
+            return (pyspec + 's') % body.str_arg()
+        return ''
+
+    out = []
+    pos = 0
+    for m in CONV_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        try:
+            out.append(conv(m))
+        except IndexError:
+            out.append('<truncated>')
+            pos = len(fmt)
+            break
+        pos = m.end()
+    out.append(fmt[pos:])
+
+    return ''.join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Decode dictionary (LOG_DICT) log entries.')
+    parser.add_argument('elf', help='ELF of the application that logged')
+    parser.add_argument('input', nargs='?', type=argparse.FileType('r'),
+                        default=sys.stdin,
+                        help='Shell "log" output or hex bodies (default: '
+                             'stdin)')
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    for line in args.input:
+        line = line.rstrip('\n')
+        if DICT_RE.search(line):
+            line = DICT_RE.sub(
+                lambda m: decode(elf, bytes.fromhex(m.group(1))), line)
+        elif re.fullmatch(r'\s*[0-9a-fA-F]+\s*', line) and \
+                len(line.strip()) % 2 == 0:
+            line = decode(elf, bytes.fromhex(line.strip()))
+        print(line)
+
+
+if __name__ == '__main__':
+    main()
@@ -40,6 +40,10 @@ static struct log ltfbu_log;
 
 static struct log_fcb_bmark ltfbu_bmarks[LTFBU_MAX_BMARKS];
 
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+static struct log_fcb_sidx_sector ltfbu_sidx[2];
+#endif
+
 static struct flash_sector_range ltfbu_fcb_range = {
     .fsr_flash_area = {
         .fa_off = 0 * LTFBU_SECTOR_SIZE,
@@ -165,8 +169,8 @@ ltfbu_verify_log_walk(struct log *log, struct log_offset *log_offset,
     return 0;
 }
 
-void
-ltfbu_verify_log(uint32_t start_idx)
+static void
+ltfbu_verify_log_ts(uint32_t start_idx, int64_t ts)
 {
     struct ltfbu_walk_arg arg;
     struct ltfbu_slice slice;
@@ -182,7 +186,7 @@ ltfbu_verify_log(uint32_t start_idx)
     log_offset = (struct log_offset) {
         .lo_arg = &arg,
         .lo_index = start_idx,
-        .lo_ts = 0,
+        .lo_ts = ts,
         .lo_data_len = 0,
     };
 
@@ -192,6 +196,15 @@ ltfbu_verify_log(uint32_t start_idx)
     TEST_ASSERT_FATAL(arg.cur == slice.count);
 }
 
+void
+ltfbu_verify_log(uint32_t start_idx)
+{
+    ltfbu_verify_log_ts(start_idx, 0);
+
+    /* FCB logs ignore a timestamp other than -1, index or no index. */
+    ltfbu_verify_log_ts(start_idx, INT64_MAX);
+}
+
 void
 ltfbu_init(const struct ltfbu_cfg *cfg)
 {
@@ -222,6 +235,12 @@ ltfbu_init(const struct ltfbu_cfg *cfg)
     if (cfg->bmark_count > 0) {
         log_fcb_init_bmarks(&ltfbu_fcb_log, ltfbu_bmarks, cfg->bmark_count);
     }
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    if (cfg->sidx) {
+        log_fcb_init_sidx(&ltfbu_fcb_log, ltfbu_sidx,
+                          sizeof(ltfbu_sidx) / sizeof(ltfbu_sidx[0]));
+    }
+#endif
 
     log_register("log", &ltfbu_log, &log_fcb_handler, &ltfbu_fcb_log,
                  LOG_SYSLEVEL);
@@ -28,6 +28,8 @@ TEST_SUITE(log_test_suite_fcb_bookmarks)
     log_test_case_fcb_bookmarks_s10_l100_b1_p200();
     log_test_case_fcb_bookmarks_s10_l100_b10_p2000();
     log_test_case_fcb_bookmarks_s100_l500_b10_p2000();
+    log_test_case_fcb_bookmarks_s10_l100_b0_sidx_p2000();
+    log_test_case_fcb_bookmarks_s100_l500_b10_sidx_p2000();
 }
 
 int
@@ -27,6 +27,7 @@ struct ltfbu_cfg {
     int skip_mod;
     int body_len;
     int bmark_count;
+    int sidx;
     int pop_count;
 };
 
@@ -40,5 +41,7 @@ TEST_CASE_DECL(log_test_case_fcb_bookmarks_s0_l1_b1_p100);
 TEST_CASE_DECL(log_test_case_fcb_bookmarks_s10_l100_b1_p200);
 TEST_CASE_DECL(log_test_case_fcb_bookmarks_s10_l100_b10_p2000);
 TEST_CASE_DECL(log_test_case_fcb_bookmarks_s100_l500_b10_p2000);
+TEST_CASE_DECL(log_test_case_fcb_bookmarks_s10_l100_b0_sidx_p2000);
+TEST_CASE_DECL(log_test_case_fcb_bookmarks_s100_l500_b10_sidx_p2000);
 
 #endif
@@ -28,6 +28,9 @@
 #include "fcb/fcb2.h"
 #endif
 #include "log/log.h"
+#if MYNEWT_VAL(LOG_ASYNC)
+#include "log/log_async.h"
+#endif
 #include "log_test_util.h"
 
 #ifdef __cplusplus
@@ -48,6 +51,10 @@ void ltu_setup_fcb(struct fcb_log *fcb_log, struct log *log);
 void ltu_setup_2fcbs(struct fcb_log *fcb_log1, struct log *log1,
                      struct fcb_log *fcb_log2, struct log *log2);
 void ltu_setup_cbmem(struct cbmem *cbmem, struct log *log);
+#if MYNEWT_VAL(LOG_ASYNC)
+void ltu_setup_async(struct log_async *la, void *buf, uint16_t buf_len,
+                     struct cbmem *cbmem, struct log *log);
+#endif
 void ltu_verify_contents(struct log *log);
 
 TEST_SUITE_DECL(log_test_suite_cbmem_flat);
@@ -74,6 +81,14 @@ TEST_CASE_DECL(log_test_case_append_cb);
 
 TEST_CASE_DECL(log_test_case_2logs);
 
+TEST_SUITE_DECL(log_test_suite_async);
+TEST_CASE_DECL(log_test_case_async_append);
+TEST_CASE_DECL(log_test_case_async_policy);
+TEST_CASE_DECL(log_test_case_async_fcb);
+
+TEST_SUITE_DECL(log_test_suite_dict);
+TEST_CASE_DECL(log_test_case_dict);
+
 #ifdef __cplusplus
 }
 #endif
@@ -180,6 +180,20 @@ ltu_setup_cbmem(struct cbmem *cbmem, struct log *log)
     log_register("log", log, &log_cbmem_handler, cbmem, LOG_SYSLEVEL);
 }
 
+#if MYNEWT_VAL(LOG_ASYNC)
+void
+ltu_setup_async(struct log_async *la, void *buf, uint16_t buf_len,
+                struct cbmem *cbmem, struct log *log)
+{
+    int rc;
+
+    cbmem_init(cbmem, ltu_cbmem_buf, sizeof ltu_cbmem_buf);
+    rc = log_async_init(la, &log_cbmem_handler, cbmem, buf, buf_len, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    log_register("log", log, &log_async_handler, la, LOG_SYSLEVEL);
+}
+#endif
+
 static int
 ltu_walk_verify(struct log *log, struct log_offset *log_offset,
                 const void *dptr, uint16_t len)
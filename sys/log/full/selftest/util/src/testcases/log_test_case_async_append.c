@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_ASYNC)
+static uint8_t ltcaa_buf[512];
+#endif
+
+TEST_CASE_SELF(log_test_case_async_append)
+{
+#if MYNEWT_VAL(LOG_ASYNC)
+    struct log_async la;
+    struct cbmem cbmem;
+    struct log log;
+    char *str;
+    int rc;
+    int i;
+
+    ltu_setup_async(&la, ltcaa_buf, sizeof ltcaa_buf, &cbmem, &log);
+
+    for (i = 0; ; i++) {
+        str = ltu_str_logs[i];
+        if (!str) {
+            break;
+        }
+
+        rc = log_append_body(&log, 0, 0, LOG_ETYPE_STRING, str, strlen(str));
+        TEST_ASSERT(rc == 0);
+    }
+
+    /* Nothing is written until the queue is drained. */
+    TEST_ASSERT(la.la_cnt == i);
+    TEST_ASSERT(cbmem.c_entry_start == NULL);
+
+    rc = log_async_drain(&log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(la.la_cnt == 0);
+    TEST_ASSERT(la.la_used == 0);
+
+    ltu_verify_contents(&log);
+
+    /* Walks drain the queue themselves. */
+    for (i = 0; ltu_str_logs[i] != NULL; i++) {
+        str = ltu_str_logs[i];
+        log_append_body(&log, 0, 0, LOG_ETYPE_STRING, str, strlen(str));
+    }
+    ltu_verify_contents(&log);
+#endif
+}
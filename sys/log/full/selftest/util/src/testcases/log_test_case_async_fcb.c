@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_ASYNC) && MYNEWT_VAL(LOG_FCB)
+static uint8_t ltcaf_buf[512];
+#endif
+
+TEST_CASE_SELF(log_test_case_async_fcb)
+{
+#if MYNEWT_VAL(LOG_ASYNC) && MYNEWT_VAL(LOG_FCB)
+    struct log_async la;
+    struct fcb_log fcb_log;
+    struct log fcb_log_log;
+    struct log log;
+    char *str;
+    int rc;
+    int i;
+
+    ltu_setup_fcb(&fcb_log, &fcb_log_log);
+    rc = log_async_init(&la, &log_fcb_handler, &fcb_log, ltcaf_buf,
+                        sizeof ltcaf_buf, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    log_register("log", &log, &log_async_handler, &la, LOG_SYSLEVEL);
+
+    for (i = 0; ; i++) {
+        str = ltu_str_logs[i];
+        if (!str) {
+            break;
+        }
+
+        rc = log_append_body(&log, 0, 0, LOG_ETYPE_STRING, str, strlen(str));
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT(la.la_cnt == i);
+
+    /* The FCB handler takes whole batches. */
+    rc = log_async_drain(&log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(la.la_cnt == 0);
+#if MYNEWT_VAL(LOG_STATS)
+    TEST_ASSERT(la.la_stats.swritten == i);
+    TEST_ASSERT(la.la_stats.sbatches < i);
+    TEST_ASSERT(la.la_stats.serrs == 0);
+#endif
+
+    ltu_verify_contents(&log);
+#endif
+}
@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_ASYNC)
+
+/* Room for exactly four entries with a one byte body. */
+#define LTCAP_ENTRY_SZ  (4 + LOG_BASE_ENTRY_HDR_SIZE + 1)
+
+static uint8_t ltcap_buf[4 * LTCAP_ENTRY_SZ];
+
+struct ltcap_seen {
+    char bodies[8];
+    uint8_t levels[8];
+    int count;
+};
+
+static int
+ltcap_walk(struct log *log, struct log_offset *log_offset,
+           const struct log_entry_hdr *hdr, const void *dptr, uint16_t len)
+{
+    struct ltcap_seen *seen;
+    int rc;
+
+    seen = log_offset->lo_arg;
+    TEST_ASSERT_FATAL(seen->count < sizeof(seen->bodies));
+    TEST_ASSERT(len == 1);
+
+    rc = log_read_body(log, dptr, &seen->bodies[seen->count], 0, 1);
+    TEST_ASSERT(rc == 1);
+    seen->levels[seen->count] = hdr->ue_level;
+    seen->count++;
+
+    return 0;
+}
+
+static void
+ltcap_verify(struct log *log, const char *bodies, const uint8_t *levels,
+             int count)
+{
+    struct log_offset log_offset = { 0 };
+    struct ltcap_seen seen = { 0 };
+    int rc;
+
+    log_offset.lo_arg = &seen;
+    rc = log_walk_body(log, ltcap_walk, &log_offset);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(seen.count == count);
+    TEST_ASSERT(memcmp(seen.bodies, bodies, count) == 0);
+    TEST_ASSERT(memcmp(seen.levels, levels, count) == 0);
+}
+#endif
+
+TEST_CASE_SELF(log_test_case_async_policy)
+{
+#if MYNEWT_VAL(LOG_ASYNC)
+    static const uint8_t drop_levels[] = {
+        LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO,
+    };
+    static const uint8_t lowest_levels[] = {
+        LOG_LEVEL_DEBUG, LOG_LEVEL_WARN, LOG_LEVEL_ERROR, LOG_LEVEL_ERROR,
+    };
+    struct log_async la;
+    struct cbmem cbmem;
+    struct log log;
+    int rc;
+
+    /*** Drop: a full queue rejects new entries. */
+    ltu_setup_async(&la, ltcap_buf, sizeof ltcap_buf, &cbmem, &log);
+    log_async_set_policy(&la, LOG_ASYNC_POLICY_DROP);
+
+    TEST_ASSERT(log_append_body(&log, 0, LOG_LEVEL_INFO, LOG_ETYPE_STRING,
+                                "a", 1) == 0);
+    TEST_ASSERT(log_append_body(&log, 0, LOG_LEVEL_INFO, LOG_ETYPE_STRING,
+                                "b", 1) == 0);
+    TEST_ASSERT(log_append_body(&log, 0, LOG_LEVEL_INFO, LOG_ETYPE_STRING,
+                                "c", 1) == 0);
+    TEST_ASSERT(log_append_body(&log, 0, LOG_LEVEL_INFO, LOG_ETYPE_STRING,
+                                "d", 1) == 0);
+    TEST_ASSERT(la.la_used == sizeof ltcap_buf);
+    rc = log_append_body(&log, 0, LOG_LEVEL_ERROR, LOG_ETYPE_STRING, "e", 1);
+    TEST_ASSERT(rc != 0);
+
+    ltcap_verify(&log, "abcd", drop_levels, 4);
+
+    /* Draining made room again. */
+    rc = log_append_body(&log, 0, LOG_LEVEL_INFO, LOG_ETYPE_STRING, "f", 1);
+    TEST_ASSERT(rc == 0);
+
+    rc = log_flush(&log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(la.la_cnt == 0);
+
+    /*** Drop lowest: new entries evict the oldest ones of a lower level. */
+    log_async_set_policy(&la, LOG_ASYNC_POLICY_DROP_LOWEST);
+
+    TEST_ASSERT(log_append_body(&log, 0, LOG_LEVEL_DEBUG, LOG_ETYPE_STRING,
+                                "a", 1) == 0);
+    TEST_ASSERT(log_append_body(&log, 0, LOG_LEVEL_INFO, LOG_ETYPE_STRING,
+                                "b", 1) == 0);
+    TEST_ASSERT(log_append_body(&log, 0, LOG_LEVEL_DEBUG, LOG_ETYPE_STRING,
+                                "c", 1) == 0);
+    TEST_ASSERT(log_append_body(&log, 0, LOG_LEVEL_WARN, LOG_ETYPE_STRING,
+                                "d", 1) == 0);
+
+    /* Evicts "a", then "b". */
+    TEST_ASSERT(log_append_body(&log, 0, LOG_LEVEL_ERROR, LOG_ETYPE_STRING,
+                                "e", 1) == 0);
+    TEST_ASSERT(log_append_body(&log, 0, LOG_LEVEL_ERROR, LOG_ETYPE_STRING,
+                                "f", 1) == 0);
+
+    /* The oldest entry, "c", is not below debug; dropped. */
+    rc = log_append_body(&log, 0, LOG_LEVEL_DEBUG, LOG_ETYPE_STRING, "g", 1);
+    TEST_ASSERT(rc != 0);
+
+    ltcap_verify(&log, "cdef", lowest_levels, 4);
+#endif
+}
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_DICT)
+static const char ltcd_fmt[] = "val=%d big=%lld s=%s c=%c";
+
+static int
+ltcd_walk(struct log *log, struct log_offset *log_offset,
+          const struct log_entry_hdr *hdr, const void *dptr, uint16_t len)
+{
+    uint8_t body[64];
+    const char *fmt;
+    long long big;
+    int val;
+    int c;
+    int rc;
+
+    TEST_ASSERT(hdr->ue_etype == LOG_ETYPE_BINARY);
+    TEST_ASSERT(hdr->ue_flags & LOG_FLAGS_DICT);
+    TEST_ASSERT_FATAL(len == sizeof(fmt) + 4 + 8 + 4 + 4);
+
+    rc = log_read_body(log, dptr, body, 0, len);
+    TEST_ASSERT_FATAL(rc == len);
+
+    memcpy(&fmt, body, sizeof(fmt));
+    memcpy(&val, body + sizeof(fmt), 4);
+    memcpy(&big, body + sizeof(fmt) + 4, 8);
+    memcpy(&c, body + sizeof(fmt) + 16, 4);
+    TEST_ASSERT(fmt == ltcd_fmt);
+    TEST_ASSERT(val == -12);
+    TEST_ASSERT(big == 1LL << 40);
+    TEST_ASSERT(memcmp(body + sizeof(fmt) + 12, "abc", 4) == 0);
+    TEST_ASSERT(c == 'x');
+
+    (*(int *)log_offset->lo_arg)++;
+
+    return 0;
+}
+#endif
+
+TEST_CASE_SELF(log_test_case_dict)
+{
+#if MYNEWT_VAL(LOG_DICT)
+    struct log_offset log_offset = { 0 };
+    struct cbmem cbmem;
+    struct log log;
+    int count;
+    int rc;
+
+    ltu_setup_cbmem(&cbmem, &log);
+
+    log_printf(&log, 0, LOG_LEVEL_INFO, ltcd_fmt, -12, 1LL << 40, "abc", 'x');
+
+    count = 0;
+    log_offset.lo_arg = &count;
+    rc = log_walk_body(&log, ltcd_walk, &log_offset);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(count == 1);
+#endif
+}
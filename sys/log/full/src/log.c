@@ -497,7 +497,7 @@ log_chk_max_entry_len(struct log *log, uint16_t len)
 
 static int
 log_append_prepare(struct log *log, uint8_t module, uint8_t level,
-                   uint8_t etype, struct log_entry_hdr *ue)
+                   uint8_t etype, uint8_t flags, struct log_entry_hdr *ue)
 {
     int rc;
     int sr;
@@ -558,8 +558,7 @@ log_append_prepare(struct log *log, uint8_t module, uint8_t level,
     ue->ue_module = module;
     ue->ue_index = idx;
     ue->ue_etype = etype;
-    /* Clear flags before assigning */
-    ue->ue_flags = 0;
+    ue->ue_flags = flags;
 #if MYNEWT_VAL(LOG_FLAGS_IMAGE_HASH)
     rc = log_fill_current_img_hash(ue);
     if (rc == SYS_ENOTSUP) {
@@ -607,7 +606,7 @@ log_append_typed(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
     }
 
     hdr = (struct log_entry_hdr *)data;
-    rc = log_append_prepare(log, module, level, etype, hdr);
+    rc = log_append_prepare(log, module, level, etype, 0, hdr);
     if (rc != 0) {
         LOG_STATS_INC(log, drops);
         goto err;
@@ -626,9 +625,10 @@ err:
     return (rc);
 }
 
-int
-log_append_body(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
-                const void *body, uint16_t body_len)
+static int
+log_append_body_flags(struct log *log, uint8_t module, uint8_t level,
+                      uint8_t etype, uint8_t flags, const void *body,
+                      uint16_t body_len)
 {
     struct log_entry_hdr hdr;
     int rc;
@@ -640,7 +640,7 @@ log_append_body(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
         return rc;
     }
 
-    rc = log_append_prepare(log, module, level, etype, &hdr);
+    rc = log_append_prepare(log, module, level, etype, flags, &hdr);
     if (rc != 0) {
         LOG_STATS_INC(log, drops);
         return rc;
@@ -657,6 +657,14 @@ log_append_body(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
     return 0;
 }
 
+int
+log_append_body(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
+                const void *body, uint16_t body_len)
+{
+    return log_append_body_flags(log, module, level, etype, 0, body,
+                                 body_len);
+}
+
 int
 log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
                               uint8_t etype, struct os_mbuf **om_ptr)
@@ -712,7 +720,7 @@ log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
         }
     }
 
-    rc = log_append_prepare(log, module, level, etype, hdr);
+    rc = log_append_prepare(log, module, level, etype, 0, hdr);
     if (rc != 0) {
         LOG_STATS_INC(log, drops);
         goto drop;
@@ -775,7 +783,7 @@ log_append_mbuf_body_no_free(struct log *log, uint8_t module, uint8_t level,
         goto drop;
     }
 
-    rc = log_append_prepare(log, module, level, etype, &hdr);
+    rc = log_append_prepare(log, module, level, etype, 0, &hdr);
     if (rc != 0) {
         LOG_STATS_INC(log, drops);
         goto drop;
@@ -816,6 +824,17 @@ log_printf(struct log *log, uint8_t module, uint8_t level,
     int len;
 
     va_start(args, msg);
+#if MYNEWT_VAL(LOG_DICT)
+    /* Streams are read by people; other logs by the host-side decoder. */
+    if (log->l_log != NULL && log->l_log->log_type != LOG_TYPE_STREAM) {
+        len = log_dict_encode(buf, sizeof(buf), msg, args);
+        va_end(args);
+
+        log_append_body_flags(log, module, level, LOG_ETYPE_BINARY,
+                              LOG_FLAGS_DICT, buf, len);
+        return;
+    }
+#endif
     len = vsnprintf(buf, LOG_PRINTF_MAX_ENTRY_LEN, msg, args);
     va_end(args);
     if (len >= LOG_PRINTF_MAX_ENTRY_LEN) {
@@ -0,0 +1,735 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_ASYNC)
+
+#include <stddef.h>
+#include <string.h>
+#include "log/log.h"
+#include "log/log_async.h"
+
+#define LOG_ASYNC_BATCH_SIZE    MYNEWT_VAL(LOG_ASYNC_BATCH_SIZE)
+#define LOG_ASYNC_STACK_SIZE    MYNEWT_VAL(LOG_ASYNC_STACK_SIZE)
+
+#if MYNEWT_VAL(LOG_STATS)
+#define LOG_ASYNC_STATS_INC(la, name)       STATS_INC((la)->la_stats, name)
+#define LOG_ASYNC_STATS_INCN(la, name, cnt) \
+    STATS_INCN((la)->la_stats, name, cnt)
+#define LOG_ASYNC_STATS_SET(la, name, val)  STATS_SET((la)->la_stats, name, val)
+#else
+#define LOG_ASYNC_STATS_INC(la, name)
+#define LOG_ASYNC_STATS_INCN(la, name, cnt)
+#define LOG_ASYNC_STATS_SET(la, name, val)
+#endif
+
+/*
+ * Every queued entry is prefixed with one of these; the entry header and
+ * body follow.  Entries are stored back to back and wrap around the end of
+ * the queue buffer.  Space is reserved in a critical section and the entry
+ * copied in outside of it; the writer task only takes entries at the head
+ * of the queue once they are marked done.
+ */
+struct log_async_rec {
+    uint16_t lar_len;       /* Header + body length. */
+    uint8_t lar_level;
+    uint8_t lar_flags;
+};
+
+/* The entry has been copied in. */
+#define LOG_ASYNC_REC_F_DONE    0x01
+/* Copying the entry in failed; it is discarded. */
+#define LOG_ASYNC_REC_F_BAD     0x02
+
+#if MYNEWT_VAL(LOG_STATS)
+STATS_NAME_START(log_async_stats)
+    STATS_NAME(log_async_stats, queued)
+    STATS_NAME(log_async_stats, written)
+    STATS_NAME(log_async_stats, drops)
+    STATS_NAME(log_async_stats, evicts)
+    STATS_NAME(log_async_stats, blocks)
+    STATS_NAME(log_async_stats, batches)
+    STATS_NAME(log_async_stats, errs)
+    STATS_NAME(log_async_stats, depth)
+    STATS_NAME(log_async_stats, depth_max)
+STATS_NAME_END(log_async_stats)
+#endif
+
+static struct os_eventq log_async_evq;
+static struct os_task log_async_task;
+static os_stack_t log_async_stack[OS_STACK_ALIGN(LOG_ASYNC_STACK_SIZE)];
+
+/* Serializes writes to the targets and use of the batch buffer. */
+static struct os_mutex log_async_mtx;
+static uint8_t log_async_batch[LOG_ASYNC_BATCH_SIZE];
+
+static uint16_t
+log_async_wrap(const struct log_async *la, uint32_t off)
+{
+    if (off >= la->la_size) {
+        off -= la->la_size;
+    }
+    return off;
+}
+
+static void
+log_async_put(struct log_async *la, uint16_t off, const void *src,
+              uint16_t len)
+{
+    uint16_t chunk;
+
+    chunk = min(len, la->la_size - off);
+    memcpy(la->la_buf + off, src, chunk);
+    memcpy(la->la_buf, (const uint8_t *)src + chunk, len - chunk);
+}
+
+static void
+log_async_get(const struct log_async *la, uint16_t off, void *dst,
+              uint16_t len)
+{
+    uint16_t chunk;
+
+    chunk = min(len, la->la_size - off);
+    memcpy(dst, la->la_buf + off, chunk);
+    memcpy((uint8_t *)dst + chunk, la->la_buf, len - chunk);
+}
+
+static int
+log_async_put_mbuf(struct log_async *la, uint16_t off,
+                   const struct os_mbuf *om, uint16_t om_off, uint16_t len)
+{
+    uint16_t chunk;
+    int rc;
+
+    chunk = min(len, la->la_size - off);
+    rc = os_mbuf_copydata(om, om_off, chunk, la->la_buf + off);
+    if (rc == 0) {
+        rc = os_mbuf_copydata(om, om_off + chunk, len - chunk, la->la_buf);
+    }
+    return rc;
+}
+
+/**
+ * Removes the entry at the head of the queue if its level is below `level`.
+ * Entries still being copied in or out are left alone.  Must be called in a
+ * critical section.
+ *
+ * @return                      1 if an entry was evicted; 0 if the head
+ *                                  entry did not qualify.
+ */
+static int
+log_async_evict(struct log_async *la, uint8_t level)
+{
+    struct log_async_rec rec;
+    uint16_t len;
+
+    if (la->la_cnt == 0 || la->la_claimed != 0) {
+        return 0;
+    }
+
+    log_async_get(la, la->la_off, &rec, sizeof(rec));
+    if (!(rec.lar_flags & LOG_ASYNC_REC_F_DONE)) {
+        return 0;
+    }
+    if (rec.lar_level >= level && !(rec.lar_flags & LOG_ASYNC_REC_F_BAD)) {
+        return 0;
+    }
+
+    len = sizeof(rec) + rec.lar_len;
+    la->la_off = log_async_wrap(la, (uint32_t)la->la_off + len);
+    la->la_used -= len;
+    la->la_cnt--;
+
+    return 1;
+}
+
+/**
+ * Blocking is only possible from a task other than the writer, once the OS
+ * runs.  Interrupt handlers must not log to async logs using the blocking
+ * policy.
+ */
+static int
+log_async_can_block(void)
+{
+    return os_started() && os_sched_get_current_task() != &log_async_task;
+}
+
+static void
+log_async_kick(struct log_async *la)
+{
+    if (la->la_used >= LOG_ASYNC_BATCH_SIZE) {
+        os_eventq_put(&log_async_evq, &la->la_ev);
+    } else if (!os_callout_queued(&la->la_timer)) {
+        os_callout_reset(&la->la_timer,
+                         os_time_ms_to_ticks32(MYNEWT_VAL(LOG_ASYNC_FLUSH_MS)));
+    }
+}
+
+static int
+log_async_enqueue(struct log *log, const struct log_entry_hdr *hdr,
+                  const void *body, const struct os_mbuf *om,
+                  uint16_t om_off, int body_len)
+{
+    struct log_async *la;
+    struct log_async_rec rec;
+    uint16_t rec_off;
+    uint16_t hdr_len;
+    uint16_t need;
+    uint16_t off;
+    os_sr_t sr;
+    int rc;
+
+    la = log->l_arg;
+    hdr_len = log_hdr_len(hdr);
+    if (sizeof(rec) + hdr_len + body_len > LOG_ASYNC_BATCH_SIZE ||
+        sizeof(rec) + hdr_len + body_len > la->la_size) {
+        LOG_ASYNC_STATS_INC(la, drops);
+        return OS_ENOMEM;
+    }
+    rec.lar_len = hdr_len + body_len;
+    rec.lar_level = hdr->ue_level;
+    rec.lar_flags = 0;
+    need = sizeof(rec) + rec.lar_len;
+
+    OS_ENTER_CRITICAL(sr);
+    while (la->la_size - la->la_used < need) {
+        if (la->la_policy == LOG_ASYNC_POLICY_DROP_LOWEST &&
+            log_async_evict(la, rec.lar_level)) {
+            LOG_ASYNC_STATS_INC(la, evicts);
+            continue;
+        }
+        if (la->la_policy != LOG_ASYNC_POLICY_BLOCK ||
+            !log_async_can_block()) {
+            OS_EXIT_CRITICAL(sr);
+            LOG_ASYNC_STATS_INC(la, drops);
+            return OS_ENOMEM;
+        }
+
+        la->la_waiters++;
+        OS_EXIT_CRITICAL(sr);
+
+        LOG_ASYNC_STATS_INC(la, blocks);
+        os_eventq_put(&log_async_evq, &la->la_ev);
+        rc = os_sem_pend(&la->la_sem,
+                         os_time_ms_to_ticks32(MYNEWT_VAL(LOG_ASYNC_BLOCK_MS)));
+        if (rc != 0) {
+            LOG_ASYNC_STATS_INC(la, drops);
+            return OS_ENOMEM;
+        }
+        OS_ENTER_CRITICAL(sr);
+    }
+
+    rec_off = log_async_wrap(la, (uint32_t)la->la_off + la->la_used);
+    log_async_put(la, rec_off, &rec, sizeof(rec));
+    la->la_used += need;
+    la->la_cnt++;
+    la->la_pending++;
+    if (la->la_used > la->la_used_max) {
+        la->la_used_max = la->la_used;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    off = log_async_wrap(la, (uint32_t)rec_off + sizeof(rec));
+    log_async_put(la, off, hdr, hdr_len);
+    off = log_async_wrap(la, (uint32_t)off + hdr_len);
+    if (om != NULL) {
+        rc = log_async_put_mbuf(la, off, om, om_off, body_len);
+    } else {
+        log_async_put(la, off, body, body_len);
+        rc = 0;
+    }
+
+    rec.lar_flags = LOG_ASYNC_REC_F_DONE;
+    if (rc != 0) {
+        rec.lar_flags |= LOG_ASYNC_REC_F_BAD;
+    }
+    OS_ENTER_CRITICAL(sr);
+    la->la_buf[log_async_wrap(la, (uint32_t)rec_off +
+                                  offsetof(struct log_async_rec,
+                                           lar_flags))] = rec.lar_flags;
+    la->la_pending--;
+    OS_EXIT_CRITICAL(sr);
+
+    if (rc != 0) {
+        LOG_ASYNC_STATS_INC(la, errs);
+        return rc;
+    }
+
+    LOG_ASYNC_STATS_INC(la, queued);
+    LOG_ASYNC_STATS_SET(la, depth, la->la_used);
+    LOG_ASYNC_STATS_SET(la, depth_max, la->la_used_max);
+
+    log_async_kick(la);
+
+    return 0;
+}
+
+/**
+ * Writes a batch of entries, each a uint16_t length followed by the header
+ * and body, to the target.  Handlers without log_append_batch get one
+ * entry at a time.
+ */
+static int
+log_async_write_batch(struct log_async *la, uint16_t batch_len,
+                      uint16_t batch_cnt)
+{
+    const struct log_entry_hdr *hdr;
+    uint16_t entry_len;
+    uint16_t hdr_len;
+    uint16_t off;
+    int first_rc;
+    int rc;
+
+    la->la_target.l_rotate_notify_cb = la->la_log->l_rotate_notify_cb;
+
+    if (la->la_target.l_log->log_append_batch) {
+        rc = la->la_target.l_log->log_append_batch(&la->la_target,
+                                                   log_async_batch,
+                                                   batch_len);
+        if (rc != 0) {
+            LOG_ASYNC_STATS_INC(la, errs);
+        } else {
+            LOG_ASYNC_STATS_INCN(la, written, batch_cnt);
+        }
+        return rc;
+    }
+
+    first_rc = 0;
+    for (off = 0; off < batch_len; off += sizeof(entry_len) + entry_len) {
+        memcpy(&entry_len, log_async_batch + off, sizeof(entry_len));
+        hdr = (const void *)(log_async_batch + off + sizeof(entry_len));
+        hdr_len = log_hdr_len(hdr);
+
+        rc = la->la_target.l_log->log_append_body(
+            &la->la_target, hdr, (const uint8_t *)hdr + hdr_len,
+            entry_len - hdr_len);
+        if (rc != 0) {
+            LOG_ASYNC_STATS_INC(la, errs);
+            if (first_rc == 0) {
+                first_rc = rc;
+            }
+        } else {
+            LOG_ASYNC_STATS_INC(la, written);
+        }
+    }
+
+    return first_rc;
+}
+
+/**
+ * Moves finished entries from the head of the queue into the batch buffer,
+ * as many as fit, and writes them to the target until none are left.  The
+ * entries are claimed in a critical section but copied outside of it; they
+ * are only released once copied.
+ */
+static int
+log_async_drain_internal(struct log_async *la)
+{
+    struct log_async_rec rec;
+    uint16_t batch_len;
+    uint16_t batch_cnt;
+    uint16_t claimed;
+    uint16_t cnt;
+    uint16_t off;
+    uint16_t i;
+    uint8_t waiters;
+    os_sr_t sr;
+    int first_rc;
+    int rc;
+
+    rc = os_mutex_pend(&log_async_mtx, OS_WAIT_FOREVER);
+    if (rc != 0 && rc != OS_NOT_STARTED) {
+        return SYS_EUNKNOWN;
+    }
+
+    first_rc = 0;
+    for (;;) {
+        batch_len = 0;
+        claimed = 0;
+
+        OS_ENTER_CRITICAL(sr);
+        off = la->la_off;
+        for (cnt = 0; cnt < la->la_cnt; cnt++) {
+            log_async_get(la, off, &rec, sizeof(rec));
+            if (!(rec.lar_flags & LOG_ASYNC_REC_F_DONE)) {
+                break;
+            }
+            if (!(rec.lar_flags & LOG_ASYNC_REC_F_BAD)) {
+                if (batch_len + sizeof(rec.lar_len) + rec.lar_len >
+                    LOG_ASYNC_BATCH_SIZE) {
+                    break;
+                }
+                batch_len += sizeof(rec.lar_len) + rec.lar_len;
+            }
+            claimed += sizeof(rec) + rec.lar_len;
+            off = log_async_wrap(la, (uint32_t)off + sizeof(rec) +
+                                     rec.lar_len);
+        }
+        la->la_claimed = claimed;
+        OS_EXIT_CRITICAL(sr);
+
+        if (claimed == 0) {
+            break;
+        }
+
+        /* Only this task moves the head while entries are claimed. */
+        batch_len = 0;
+        batch_cnt = 0;
+        off = la->la_off;
+        for (i = 0; i < cnt; i++) {
+            log_async_get(la, off, &rec, sizeof(rec));
+            if (!(rec.lar_flags & LOG_ASYNC_REC_F_BAD)) {
+                memcpy(log_async_batch + batch_len, &rec.lar_len,
+                       sizeof(rec.lar_len));
+                log_async_get(la, log_async_wrap(la, (uint32_t)off +
+                                                     sizeof(rec)),
+                              log_async_batch + batch_len +
+                              sizeof(rec.lar_len), rec.lar_len);
+                batch_len += sizeof(rec.lar_len) + rec.lar_len;
+                batch_cnt++;
+            }
+            off = log_async_wrap(la, (uint32_t)off + sizeof(rec) +
+                                     rec.lar_len);
+        }
+
+        OS_ENTER_CRITICAL(sr);
+        la->la_off = off;
+        la->la_used -= claimed;
+        la->la_cnt -= cnt;
+        la->la_claimed = 0;
+        waiters = la->la_waiters;
+        la->la_waiters = 0;
+        OS_EXIT_CRITICAL(sr);
+
+        while (waiters-- > 0) {
+            os_sem_release(&la->la_sem);
+        }
+
+        LOG_ASYNC_STATS_SET(la, depth, la->la_used);
+
+        if (batch_cnt == 0) {
+            continue;
+        }
+
+        LOG_ASYNC_STATS_INC(la, batches);
+        rc = log_async_write_batch(la, batch_len, batch_cnt);
+        if (rc != 0 && first_rc == 0) {
+            first_rc = rc;
+        }
+    }
+
+    os_mutex_release(&log_async_mtx);
+
+    return first_rc;
+}
+
+int
+log_async_drain(struct log *log)
+{
+    return log_async_drain_internal(log->l_arg);
+}
+
+static void
+log_async_event_cb(struct os_event *ev)
+{
+    struct log_async *la;
+
+    la = ev->ev_arg;
+    os_callout_stop(&la->la_timer);
+    log_async_drain_internal(la);
+}
+
+static void
+log_async_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&log_async_evq);
+    }
+}
+
+static int
+log_async_append(struct log *log, void *buf, int len)
+{
+    const struct log_entry_hdr *hdr;
+    uint16_t hdr_len;
+
+    hdr = buf;
+    hdr_len = log_hdr_len(hdr);
+
+    return log_async_enqueue(log, hdr, (uint8_t *)buf + hdr_len, NULL, 0,
+                             len - hdr_len);
+}
+
+static int
+log_async_append_body(struct log *log, const struct log_entry_hdr *hdr,
+                      const void *body, int body_len)
+{
+    return log_async_enqueue(log, hdr, body, NULL, 0, body_len);
+}
+
+static int
+log_async_append_mbuf(struct log *log, struct os_mbuf *om)
+{
+    const struct log_entry_hdr *hdr;
+    uint16_t hdr_len;
+
+    /* log_append_mbuf_typed_no_free() pulled the header up. */
+    hdr = (const struct log_entry_hdr *)om->om_data;
+    hdr_len = log_hdr_len(hdr);
+
+    return log_async_enqueue(log, hdr, NULL, om, hdr_len,
+                             os_mbuf_len(om) - hdr_len);
+}
+
+static int
+log_async_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
+                           struct os_mbuf *om)
+{
+    return log_async_enqueue(log, hdr, NULL, om, 0, os_mbuf_len(om));
+}
+
+/*
+ * Entries are only read through pointers handed out by a walk, which
+ * drains the queue first; reads go straight to the target.
+ */
+static int
+log_async_read(struct log *log, const void *dptr, void *buf, uint16_t offset,
+               uint16_t len)
+{
+    struct log_async *la;
+
+    la = log->l_arg;
+    return la->la_target.l_log->log_read(&la->la_target, dptr, buf, offset,
+                                         len);
+}
+
+static int
+log_async_read_mbuf(struct log *log, const void *dptr, struct os_mbuf *om,
+                    uint16_t offset, uint16_t len)
+{
+    struct log_async *la;
+
+    la = log->l_arg;
+    if (!la->la_target.l_log->log_read_mbuf) {
+        return SYS_ENOTSUP;
+    }
+    return la->la_target.l_log->log_read_mbuf(&la->la_target, dptr, om,
+                                              offset, len);
+}
+
+static int
+log_async_walk(struct log *log, log_walk_func_t walk_func,
+               struct log_offset *log_offset)
+{
+    struct log_async *la;
+
+    la = log->l_arg;
+    log_async_drain_internal(la);
+    return la->la_target.l_log->log_walk(&la->la_target, walk_func,
+                                         log_offset);
+}
+
+static int
+log_async_walk_sector(struct log *log, log_walk_func_t walk_func,
+                      struct log_offset *log_offset)
+{
+    struct log_async *la;
+
+    la = log->l_arg;
+    if (!la->la_target.l_log->log_walk_sector) {
+        return SYS_ENOTSUP;
+    }
+    log_async_drain_internal(la);
+    return la->la_target.l_log->log_walk_sector(&la->la_target, walk_func,
+                                                log_offset);
+}
+
+static int
+log_async_flush(struct log *log)
+{
+    struct log_async *la;
+    uint8_t waiters;
+    os_sr_t sr;
+    int rc;
+
+    la = log->l_arg;
+
+    /* Keeps the writer task from copying out entries being discarded. */
+    rc = os_mutex_pend(&log_async_mtx, OS_WAIT_FOREVER);
+    if (rc != 0 && rc != OS_NOT_STARTED) {
+        return SYS_EUNKNOWN;
+    }
+
+    /* Queued entries are discarded along with the stored ones. */
+    OS_ENTER_CRITICAL(sr);
+    if (la->la_pending != 0) {
+        /* Entries still being copied in can't be dropped. */
+        OS_EXIT_CRITICAL(sr);
+        os_mutex_release(&log_async_mtx);
+        return SYS_EBUSY;
+    }
+    la->la_off = 0;
+    la->la_used = 0;
+    la->la_cnt = 0;
+    waiters = la->la_waiters;
+    la->la_waiters = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    while (waiters-- > 0) {
+        os_sem_release(&la->la_sem);
+    }
+    LOG_ASYNC_STATS_SET(la, depth, 0);
+
+    rc = la->la_target.l_log->log_flush(&la->la_target);
+    os_mutex_release(&log_async_mtx);
+
+    return rc;
+}
+
+#if MYNEWT_VAL(LOG_STORAGE_INFO)
+static int
+log_async_storage_info(struct log *log, struct log_storage_info *info)
+{
+    struct log_async *la;
+
+    la = log->l_arg;
+    if (!la->la_target.l_log->log_storage_info) {
+        return SYS_ENOTSUP;
+    }
+    log_async_drain_internal(la);
+    return la->la_target.l_log->log_storage_info(&la->la_target, info);
+}
+#endif
+
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+static int
+log_async_set_watermark(struct log *log, uint32_t index)
+{
+    struct log_async *la;
+
+    la = log->l_arg;
+    if (!la->la_target.l_log->log_set_watermark) {
+        return SYS_ENOTSUP;
+    }
+    return la->la_target.l_log->log_set_watermark(&la->la_target, index);
+}
+#endif
+
+static int
+log_async_registered(struct log *log)
+{
+    struct log_async *la;
+
+    la = log->l_arg;
+    la->la_log = log;
+    la->la_target.l_name = log->l_name;
+    la->la_target.l_level = log->l_level;
+
+    if (la->la_target.l_log->log_registered) {
+        return la->la_target.l_log->log_registered(&la->la_target);
+    }
+    return 0;
+}
+
+int
+log_async_init(struct log_async *la, const struct log_handler *target,
+               void *target_arg, void *buf, uint16_t buf_len,
+               const char *name)
+{
+    int rc;
+
+    if (target == NULL || target == &log_async_handler) {
+        return SYS_EINVAL;
+    }
+
+    memset(la, 0, sizeof(*la));
+    la->la_target.l_log = target;
+    la->la_target.l_arg = target_arg;
+    la->la_buf = buf;
+    la->la_size = buf_len;
+    la->la_policy = MYNEWT_VAL(LOG_ASYNC_POLICY);
+
+    rc = os_sem_init(&la->la_sem, 0);
+    if (rc != 0) {
+        return SYS_EUNKNOWN;
+    }
+
+    la->la_ev.ev_cb = log_async_event_cb;
+    la->la_ev.ev_arg = la;
+    os_callout_init(&la->la_timer, &log_async_evq, log_async_event_cb, la);
+
+#if MYNEWT_VAL(LOG_STATS)
+    stats_init(STATS_HDR(la->la_stats),
+               STATS_SIZE_INIT_PARMS(la->la_stats, STATS_SIZE_32),
+               STATS_NAME_INIT_PARMS(log_async_stats));
+    if (name != NULL) {
+        stats_register(name, STATS_HDR(la->la_stats));
+    }
+#endif
+
+    return 0;
+}
+
+void
+log_async_set_policy(struct log_async *la, uint8_t policy)
+{
+    la->la_policy = policy;
+}
+
+void
+log_async_pkg_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    os_eventq_init(&log_async_evq);
+
+    rc = os_mutex_init(&log_async_mtx);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    rc = os_task_init(&log_async_task, "log_async", log_async_task_handler,
+                      NULL, MYNEWT_VAL(LOG_ASYNC_TASK_PRIO), OS_WAIT_FOREVER,
+                      log_async_stack, LOG_ASYNC_STACK_SIZE);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+const struct log_handler log_async_handler = {
+    .log_type             = LOG_TYPE_STORAGE,
+    .log_read             = log_async_read,
+    .log_read_mbuf        = log_async_read_mbuf,
+    .log_append           = log_async_append,
+    .log_append_body      = log_async_append_body,
+    .log_append_mbuf      = log_async_append_mbuf,
+    .log_append_mbuf_body = log_async_append_mbuf_body,
+    .log_walk             = log_async_walk,
+    .log_walk_sector      = log_async_walk_sector,
+    .log_flush            = log_async_flush,
+#if MYNEWT_VAL(LOG_STORAGE_INFO)
+    .log_storage_info     = log_async_storage_info,
+#endif
+#if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
+    .log_set_watermark    = log_async_set_watermark,
+#endif
+    .log_registered       = log_async_registered,
+};
+
+#endif
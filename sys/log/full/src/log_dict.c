@@ -0,0 +1,198 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "log/log.h"
+
+#if MYNEWT_VAL(LOG_DICT)
+
+struct log_dict_buf {
+    uint8_t *cur;
+    uint8_t *end;
+    bool full;
+};
+
+static void
+log_dict_put(struct log_dict_buf *b, const void *src, int len)
+{
+    if (b->full || b->end - b->cur < len) {
+        b->full = true;
+        return;
+    }
+    memcpy(b->cur, src, len);
+    b->cur += len;
+}
+
+#define LOG_DICT_PUT_ARG(b_, ap_, type_) do {   \
+    type_ v_ = va_arg(ap_, type_);              \
+    log_dict_put((b_), &v_, sizeof(v_));        \
+} while (0)
+
+static void
+log_dict_put_str(struct log_dict_buf *b, const char *s)
+{
+    size_t len;
+
+    if (b->full) {
+        return;
+    }
+    if (s == NULL) {
+        s = "(null)";
+    }
+
+    len = strlen(s);
+    if (len >= b->end - b->cur) {
+        /* Truncate; nothing fits after the string anyway. */
+        if (b->cur == b->end) {
+            b->full = true;
+            return;
+        }
+        len = b->end - b->cur - 1;
+        b->full = true;
+    }
+    memcpy(b->cur, s, len);
+    b->cur[len] = '\0';
+    b->cur += len + 1;
+}
+
+static const char *
+log_dict_skip_digits(const char *p)
+{
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    return p;
+}
+
+int
+log_dict_encode(void *buf, int buf_len, const char *fmt, va_list ap)
+{
+    struct log_dict_buf b;
+    const char *p;
+    int lcount;
+    char lmod;
+
+    b.cur = buf;
+    b.end = b.cur + buf_len;
+    b.full = false;
+
+    log_dict_put(&b, &fmt, sizeof(fmt));
+    if (b.full) {
+        return 0;
+    }
+
+    /*
+     * Walk the conversions only as far as needed to pull each argument off
+     * the list with its promoted type; nothing is formatted.
+     */
+    for (p = strchr(fmt, '%'); p != NULL && !b.full; p = strchr(p, '%')) {
+        p++;
+
+        while (*p != '\0' && strchr("-+ #0", *p) != NULL) {
+            p++;
+        }
+        if (*p == '*') {
+            LOG_DICT_PUT_ARG(&b, ap, int);
+            p++;
+        } else {
+            p = log_dict_skip_digits(p);
+        }
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                LOG_DICT_PUT_ARG(&b, ap, int);
+                p++;
+            } else {
+                p = log_dict_skip_digits(p);
+            }
+        }
+
+        lmod = '\0';
+        lcount = 0;
+        while (*p != '\0' && strchr("hljztL", *p) != NULL) {
+            lmod = *p;
+            lcount++;
+            p++;
+        }
+
+        switch (*p) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'c':
+            if (lmod == 'j' || (lmod == 'l' && lcount > 1)) {
+                LOG_DICT_PUT_ARG(&b, ap, long long);
+            } else if (lmod == 'l') {
+                LOG_DICT_PUT_ARG(&b, ap, long);
+            } else if (lmod == 'z') {
+                LOG_DICT_PUT_ARG(&b, ap, size_t);
+            } else if (lmod == 't') {
+                LOG_DICT_PUT_ARG(&b, ap, ptrdiff_t);
+            } else {
+                LOG_DICT_PUT_ARG(&b, ap, int);
+            }
+            break;
+
+        case 'p':
+            LOG_DICT_PUT_ARG(&b, ap, void *);
+            break;
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (lmod == 'L') {
+                double v = va_arg(ap, long double);
+                log_dict_put(&b, &v, sizeof(v));
+            } else {
+                LOG_DICT_PUT_ARG(&b, ap, double);
+            }
+            break;
+
+        case 's':
+            log_dict_put_str(&b, va_arg(ap, const char *));
+            break;
+
+        case 'n':
+            (void)va_arg(ap, void *);
+            break;
+
+        case '\0':
+            return b.cur - (uint8_t *)buf;
+
+        default:
+            /* "%%" and unknown conversions take no argument. */
+            break;
+        }
+        p++;
+    }
+
+    return b.cur - (uint8_t *)buf;
+}
+
+#endif
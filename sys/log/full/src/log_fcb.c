@@ -111,7 +111,8 @@ found_ent:
  *
  * The "index" field corresponds to a log entry index.
  *
- * If bookmarks are enabled, this function uses them in the search.
+ * If bookmarks or the sparse index are enabled, this function uses them in
+ * the search.
  *
  * @return                      0 if an entry was found
  *                              SYS_ENOENT if there are no suitable entries.
@@ -123,11 +124,15 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
 {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     const struct log_fcb_bmark *bmark;
+#endif
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    uint32_t sidx_index;
 #endif
     struct log_entry_hdr hdr;
     struct fcb_log *fcb_log;
     struct fcb *fcb;
     int rc;
+    bool sidx_found = false;
     bool bmark_found = false;
 
     fcb_log = log->l_arg;
@@ -161,8 +166,19 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
         return SYS_ENOENT;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    rc = log_fcb_find_sidx(log, log_offset, out_entry, &sidx_index);
+    sidx_found = (rc == 0);
+#endif
+
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     bmark = log_fcb_closest_bmark(fcb_log, log_offset->lo_index);
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    /* Only use a bookmark which is closer than the sparse index entry. */
+    if (sidx_found && bmark != NULL && bmark->lfb_index <= sidx_index) {
+        bmark = NULL;
+    }
+#endif
     if (bmark != NULL) {
         *out_entry = bmark->lfb_entry;
         bmark_found = true;
@@ -177,7 +193,7 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
      * GTE to any random non-zero value. If bookmark is set, it is expected
      * that the log is walked from there.
      */
-    if ((bmark_found == false) && (log_offset->lo_index != 0)) {
+    if (!sidx_found && !bmark_found && (log_offset->lo_index != 0)) {
         rc = fcb_walk_back_find_start(fcb, log, log_offset, out_entry);
         if (rc != 0) {
             return rc;
@@ -250,6 +266,9 @@ log_fcb_start_append(struct log *log, int len, struct fcb_entry *loc)
         /* The FCB needs to be rotated. */
         log_fcb_rotate_bmarks(fcb_log);
 #endif
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+        log_fcb_rotate_sidx(fcb_log);
+#endif
 
         rc = fcb_rotate(fcb);
         if (rc) {
@@ -371,6 +390,58 @@ log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    log_fcb_add_sidx(fcb_log, &loc, hdr->ue_index);
+#endif
+
+    return 0;
+}
+
+/**
+ * Header and body of each batched entry are contiguous, so unlike
+ * log_fcb_append_body() each entry takes a single flash write.
+ */
+static int
+log_fcb_append_batch(struct log *log, const void *buf, int len)
+{
+    const struct log_entry_hdr *hdr;
+    struct fcb_log *fcb_log;
+    struct fcb_entry loc;
+    const uint8_t *u8p;
+    uint16_t entry_len;
+    int rc;
+
+    fcb_log = (struct fcb_log *)log->l_arg;
+
+    u8p = buf;
+    while (len > 0) {
+        memcpy(&entry_len, u8p, sizeof(entry_len));
+        u8p += sizeof(entry_len);
+        hdr = (const struct log_entry_hdr *)u8p;
+
+        rc = log_fcb_start_append(log, entry_len, &loc);
+        if (rc != 0) {
+            return rc;
+        }
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, u8p, entry_len);
+        if (rc != 0) {
+            return rc;
+        }
+        rc = fcb_append_finish(&fcb_log->fl_fcb, &loc);
+        if (rc != 0) {
+            return rc;
+        }
+
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+        log_fcb_add_sidx(fcb_log, &loc, hdr->ue_index);
+#else
+        (void)hdr;
+#endif
+
+        u8p += entry_len;
+        len -= sizeof(entry_len) + entry_len;
+    }
+
     return 0;
 }
 
@@ -451,11 +522,16 @@ log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+    /* This also restores loc.fe_data_off, advanced by the writes above. */
     rc = fcb_append_finish(fcb, &loc);
     if (rc != 0) {
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    log_fcb_add_sidx(fcb_log, &loc, hdr->ue_index);
+#endif
+
     return 0;
 }
 
@@ -651,6 +727,9 @@ log_fcb_flush(struct log *log)
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     log_fcb_clear_bmarks(fcb_log);
 #endif
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    log_fcb_clear_sidx(fcb_log);
+#endif
 
     return fcb_clear(fcb);
 }
@@ -823,13 +902,13 @@ done:
  *
  * @param log      Log this operation applies to
  * @param entry    FCB2 location for the entry being copied
- * @param dst_fcb  FCB2 area where data is getting copied to.
+ * @param dst_log  FCB log where data is getting copied to.
  *
  * @return 0 on success; non-zero on error
  */
 static int
 log_fcb_copy_entry(struct log *log, struct fcb_entry *entry,
-                   struct fcb *dst_fcb)
+                   struct fcb_log *dst_log)
 {
     struct log_entry_hdr ueh;
     char data[MYNEWT_VAL(LOG_FCB_COPY_MAX_ENTRY_LEN) + LOG_BASE_ENTRY_HDR_SIZE +
@@ -837,7 +916,7 @@ log_fcb_copy_entry(struct log *log, struct fcb_entry *entry,
     uint16_t hdr_len;
     int dlen;
     int rc;
-    struct fcb *fcb_tmp;
+    struct fcb_log *fcb_log_tmp;
 
     rc = log_fcb_read(log, entry, &ueh, 0, LOG_BASE_ENTRY_HDR_SIZE);
 
@@ -856,11 +935,11 @@ log_fcb_copy_entry(struct log *log, struct fcb_entry *entry,
     }
 
     /* Changing the fcb to be logged to be dst fcb */
-    fcb_tmp = &((struct fcb_log *)log->l_arg)->fl_fcb;
+    fcb_log_tmp = log->l_arg;
 
-    log->l_arg = dst_fcb;
+    log->l_arg = dst_log;
     rc = log_fcb_append(log, data, dlen);
-    log->l_arg = fcb_tmp;
+    log->l_arg = fcb_log_tmp;
     if (rc) {
         goto err;
     }
@@ -874,13 +953,13 @@ err:
  *
  * @param log      Log this operation applies to
  * @param src_fcb  FCB area which is the source of data
- * @param dst_fcb  FCB area which is the target
+ * @param dst_log  FCB log which is the target
  * @param offset   Flash offset where to start the copy
  *
  * @return 0 on success; non-zero on error
  */
 static int
-log_fcb_copy(struct log *log, struct fcb *src_fcb, struct fcb *dst_fcb,
+log_fcb_copy(struct log *log, struct fcb *src_fcb, struct fcb_log *dst_log,
              uint32_t offset)
 {
     struct fcb_entry entry;
@@ -892,7 +971,7 @@ log_fcb_copy(struct log *log, struct fcb *src_fcb, struct fcb *dst_fcb,
         if (entry.fe_elem_off < offset) {
             continue;
         }
-        rc = log_fcb_copy_entry(log, &entry, dst_fcb);
+        rc = log_fcb_copy_entry(log, &entry, dst_log);
         if (rc) {
             break;
         }
@@ -913,7 +992,8 @@ static int
 log_fcb_rtr_erase(struct log *log)
 {
     struct fcb_log *fcb_log;
-    struct fcb fcb_scratch;
+    struct fcb_log fcb_log_scratch;
+    struct fcb *fcb_scratch;
     struct fcb *fcb;
     const struct flash_area *ptr;
     struct fcb_entry entry;
@@ -929,19 +1009,24 @@ log_fcb_rtr_erase(struct log *log)
     fcb_log = log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
-    memset(&fcb_scratch, 0, sizeof(fcb_scratch));
+    /*
+     * The scratch FCB is wrapped in an fcb_log of its own, with no entry
+     * limit, bookmarks or index, for log_fcb_append() to write to.
+     */
+    memset(&fcb_log_scratch, 0, sizeof(fcb_log_scratch));
+    fcb_scratch = &fcb_log_scratch.fl_fcb;
 
     if (flash_area_open(FLASH_AREA_IMAGE_SCRATCH, &ptr)) {
         goto err;
     }
     sector = *ptr;
-    fcb_scratch.f_sectors = &sector;
-    fcb_scratch.f_sector_cnt = 1;
-    fcb_scratch.f_magic = 0x7EADBADF;
-    fcb_scratch.f_version = g_log_info.li_version;
+    fcb_scratch->f_sectors = &sector;
+    fcb_scratch->f_sector_cnt = 1;
+    fcb_scratch->f_magic = 0x7EADBADF;
+    fcb_scratch->f_version = g_log_info.li_version;
 
     flash_area_erase(&sector, 0, sector.fa_size);
-    rc = fcb_init(&fcb_scratch);
+    rc = fcb_init(fcb_scratch);
     if (rc) {
         goto err;
     }
@@ -953,7 +1038,7 @@ log_fcb_rtr_erase(struct log *log)
     }
 
     /* Copy to scratch */
-    rc = log_fcb_copy(log, fcb, &fcb_scratch, entry.fe_elem_off);
+    rc = log_fcb_copy(log, fcb, &fcb_log_scratch, entry.fe_elem_off);
     if (rc) {
         goto err;
     }
@@ -965,7 +1050,7 @@ log_fcb_rtr_erase(struct log *log)
     }
 
     /* Copy back from scratch */
-    rc = log_fcb_copy(log, &fcb_scratch, fcb, 0);
+    rc = log_fcb_copy(log, fcb_scratch, fcb_log, 0);
 
 err:
     return (rc);
@@ -979,6 +1064,7 @@ const struct log_handler log_fcb_handler = {
     .log_append_body      = log_fcb_append_body,
     .log_append_mbuf      = log_fcb_append_mbuf,
     .log_append_mbuf_body = log_fcb_append_mbuf_body,
+    .log_append_batch     = log_fcb_append_batch,
     .log_walk             = log_fcb_walk,
     .log_walk_sector      = log_fcb_walk_area,
     .log_flush            = log_fcb_flush,
@@ -46,7 +46,8 @@ static int log_fcb2_rtr_erase(struct log *log);
  *
  * The "index" field corresponds to a log entry index.
  *
- * If bookmarks are enabled, this function uses them in the search.
+ * If bookmarks or the sparse index are enabled, this function uses them in
+ * the search.
  *
  * @return                      0 if an entry was found
  *                              SYS_ENOENT if there are no suitable entries.
@@ -58,11 +59,15 @@ log_fcb2_find_gte(struct log *log, struct log_offset *log_offset,
 {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     const struct log_fcb_bmark *bmark;
+#endif
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    uint32_t sidx_index;
 #endif
     struct log_entry_hdr hdr;
     struct fcb_log *fcb_log;
     struct fcb2 *fcb;
     int rc;
+    bool sidx_found = false;
 
     fcb_log = log->l_arg;
     fcb = &fcb_log->fl_fcb;
@@ -94,16 +99,29 @@ log_fcb2_find_gte(struct log *log, struct log_offset *log_offset,
         return SYS_ENOENT;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    rc = log_fcb_find_sidx(log, log_offset, out_entry, &sidx_index);
+    sidx_found = (rc == 0);
+#endif
+
     /*
      * Start from beginning.
      */
-    memset(out_entry, 0, sizeof(*out_entry));
-    rc = fcb2_getnext(fcb, out_entry);
-    if (rc != 0) {
-        return SYS_EUNKNOWN;
+    if (!sidx_found) {
+        memset(out_entry, 0, sizeof(*out_entry));
+        rc = fcb2_getnext(fcb, out_entry);
+        if (rc != 0) {
+            return SYS_EUNKNOWN;
+        }
     }
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     bmark = log_fcb_closest_bmark(fcb_log, log_offset->lo_index);
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    /* Only use a bookmark which is closer than the sparse index entry. */
+    if (sidx_found && bmark != NULL && bmark->lfb_index <= sidx_index) {
+        bmark = NULL;
+    }
+#endif
     if (bmark != NULL) {
         *out_entry = bmark->lfb_entry;
     }
@@ -173,6 +191,9 @@ log_fcb2_start_append(struct log *log, int len, struct fcb2_entry *loc)
         /* The FCB needs to be rotated. */
         log_fcb_rotate_bmarks(fcb_log);
 #endif
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+        log_fcb_rotate_sidx(fcb_log);
+#endif
 
         rc = fcb2_rotate(fcb);
         if (rc) {
@@ -284,6 +305,10 @@ log_fcb2_append_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    log_fcb_add_sidx(log->l_arg, &loc, hdr->ue_index);
+#endif
+
     return 0;
 }
 
@@ -366,6 +391,10 @@ log_fcb2_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    log_fcb_add_sidx(log->l_arg, &loc, hdr->ue_index);
+#endif
+
     return 0;
 }
 
@@ -528,6 +557,9 @@ log_fcb2_flush(struct log *log)
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     log_fcb_clear_bmarks(fcb_log);
 #endif
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+    log_fcb_clear_sidx(fcb_log);
+#endif
 
     return fcb2_clear(fcb);
 }
@@ -728,13 +760,13 @@ done:
  *
  * @param log      Log this operation applies to
  * @param entry    FCB2 location for the entry being copied
- * @param dst_fcb  FCB2 area where data is getting copied to.
+ * @param dst_log  FCB2 log where data is getting copied to.
  *
  * @return 0 on success; non-zero on error
  */
 static int
 log_fcb2_copy_entry(struct log *log, struct fcb2_entry *entry,
-                    struct fcb2 *dst_fcb)
+                    struct fcb_log *dst_log)
 {
     struct log_entry_hdr ueh;
     char data[LOG_PRINTF_MAX_ENTRY_LEN + LOG_BASE_ENTRY_HDR_SIZE +
@@ -742,7 +774,7 @@ log_fcb2_copy_entry(struct log *log, struct fcb2_entry *entry,
     uint16_t hdr_len;
     int dlen;
     int rc;
-    struct fcb2 *fcb_tmp;
+    struct fcb_log *fcb_log_tmp;
 
     rc = log_fcb2_read(log, entry, &ueh, 0, LOG_BASE_ENTRY_HDR_SIZE);
     if (rc != LOG_BASE_ENTRY_HDR_SIZE) {
@@ -761,10 +793,10 @@ log_fcb2_copy_entry(struct log *log, struct fcb2_entry *entry,
     /*
      * Changing the fcb to be logged to be dst fcb.
      */
-    fcb_tmp = log->l_arg;
-    log->l_arg = dst_fcb;
+    fcb_log_tmp = log->l_arg;
+    log->l_arg = dst_log;
     rc = log_fcb2_append(log, data, dlen);
-    log->l_arg = fcb_tmp;
+    log->l_arg = fcb_log_tmp;
     if (rc) {
         goto err;
     }
@@ -778,13 +810,13 @@ err:
  *
  * @param log      Log this operation applies to
  * @param src_fcb  FCB2 area which is the source of data
- * @param dst_fcb  FCB2 area which is the target
+ * @param dst_log  FCB2 log which is the target
  * @param from     FCB2 location where to start the copy
  *
  * @return 0 on success; non-zero on error
  */
 static int
-log_fcb2_copy(struct log *log, struct fcb2 *src_fcb, struct fcb2 *dst_fcb,
+log_fcb2_copy(struct log *log, struct fcb2 *src_fcb, struct fcb_log *dst_log,
               struct fcb2_entry *from)
 {
     struct fcb2_entry entry;
@@ -794,7 +826,7 @@ log_fcb2_copy(struct log *log, struct fcb2 *src_fcb, struct fcb2 *dst_fcb,
 
     entry = *from;
     do {
-        rc = log_fcb2_copy_entry(log, &entry, dst_fcb);
+        rc = log_fcb2_copy_entry(log, &entry, dst_log);
         if (rc) {
             break;
         }
@@ -820,7 +852,8 @@ static int
 log_fcb2_rtr_erase(struct log *log)
 {
     struct fcb_log *fcb_log;
-    struct fcb2 fcb_scratch;
+    struct fcb_log fcb_log_scratch;
+    struct fcb2 *fcb_scratch;
     struct fcb2 *fcb;
     struct fcb2_entry entry;
     int rc;
@@ -836,21 +869,26 @@ log_fcb2_rtr_erase(struct log *log)
     fcb_log = log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
-    memset(&fcb_scratch, 0, sizeof(fcb_scratch));
+    /*
+     * The scratch FCB is wrapped in an fcb_log of its own, with no entry
+     * limit, bookmarks or index, for log_fcb2_append() to write to.
+     */
+    memset(&fcb_log_scratch, 0, sizeof(fcb_log_scratch));
+    fcb_scratch = &fcb_log_scratch.fl_fcb;
 
     range_cnt = 1;
     if (flash_area_to_sector_ranges(FLASH_AREA_IMAGE_SCRATCH, &range_cnt,
                                     &range)) {
         goto err;
     }
-    fcb_scratch.f_ranges = &range;
-    fcb_scratch.f_sector_cnt = 1;
-    fcb_scratch.f_range_cnt = 1;
-    fcb_scratch.f_magic = 0x7EADBAE0;
-    fcb_scratch.f_version = g_log_info.li_version;
+    fcb_scratch->f_ranges = &range;
+    fcb_scratch->f_sector_cnt = 1;
+    fcb_scratch->f_range_cnt = 1;
+    fcb_scratch->f_magic = 0x7EADBAE0;
+    fcb_scratch->f_version = g_log_info.li_version;
 
     flash_area_erase(&range.fsr_flash_area, 0, range.fsr_flash_area.fa_size);
-    rc = fcb2_init(&fcb_scratch);
+    rc = fcb2_init(fcb_scratch);
     if (rc) {
         goto err;
     }
@@ -862,7 +900,7 @@ log_fcb2_rtr_erase(struct log *log)
     }
 
     /* Copy to scratch */
-    rc = log_fcb2_copy(log, fcb, &fcb_scratch, &entry);
+    rc = log_fcb2_copy(log, fcb, &fcb_log_scratch, &entry);
     if (rc) {
         goto err;
     }
@@ -874,12 +912,12 @@ log_fcb2_rtr_erase(struct log *log)
     }
 
     memset(&entry, 0, sizeof(entry));
-    rc = fcb2_getnext(&fcb_scratch, &entry);
+    rc = fcb2_getnext(fcb_scratch, &entry);
     if (rc) {
         goto err;
     }
     /* Copy back from scratch */
-    rc = log_fcb2_copy(log, &fcb_scratch, fcb, &entry);
+    rc = log_fcb2_copy(log, fcb_scratch, fcb_log, &entry);
 
 err:
     return (rc);
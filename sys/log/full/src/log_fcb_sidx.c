@@ -0,0 +1,288 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_FCB_SPARSE_INDEX)
+
+#include "log/log.h"
+#include "log/log_fcb.h"
+
+#define LOG_FCB_SIDX_SLOTS      MYNEWT_VAL(LOG_FCB_SPARSE_INDEX_SLOTS)
+
+#if LOG_FCB_SIDX_SLOTS < 2 || LOG_FCB_SIDX_SLOTS % 2
+#error "LOG_FCB_SPARSE_INDEX_SLOTS must be an even number"
+#endif
+
+#if MYNEWT_VAL(LOG_FCB)
+typedef struct fcb_entry log_fcb_sidx_entry_t;
+#elif MYNEWT_VAL(LOG_FCB2)
+typedef struct fcb2_entry log_fcb_sidx_entry_t;
+#endif
+
+/*
+ * FCB sector number of the oldest and active sectors, and of an entry.
+ */
+static int
+log_fcb_sidx_oldest(const struct fcb_log *fcb_log)
+{
+#if MYNEWT_VAL(LOG_FCB)
+    return fcb_log->fl_fcb.f_oldest - fcb_log->fl_fcb.f_sectors;
+#elif MYNEWT_VAL(LOG_FCB2)
+    return fcb_log->fl_fcb.f_oldest_sec;
+#endif
+}
+
+static int
+log_fcb_sidx_sector(const struct fcb_log *fcb_log,
+                    const log_fcb_sidx_entry_t *entry)
+{
+#if MYNEWT_VAL(LOG_FCB)
+    return entry->fe_area - fcb_log->fl_fcb.f_sectors;
+#elif MYNEWT_VAL(LOG_FCB2)
+    return entry->fe_sector;
+#endif
+}
+
+/*
+ * Position of an entry within its sector.
+ */
+static uint32_t
+log_fcb_sidx_entry_pos(const log_fcb_sidx_entry_t *entry)
+{
+#if MYNEWT_VAL(LOG_FCB)
+    return entry->fe_elem_off;
+#elif MYNEWT_VAL(LOG_FCB2)
+    return entry->fe_entry_num;
+#endif
+}
+
+/*
+ * Sector which is pos sectors newer than the oldest one.
+ */
+static struct log_fcb_sidx_sector *
+log_fcb_sidx_at(const struct fcb_log *fcb_log, int oldest, int pos)
+{
+    int sec;
+
+    sec = oldest + pos;
+    if (sec >= fcb_log->fl_fcb.f_sector_cnt) {
+        sec -= fcb_log->fl_fcb.f_sector_cnt;
+    }
+    return &fcb_log->fl_sidx.lsi_sectors[sec];
+}
+
+void
+log_fcb_init_sidx(struct fcb_log *fcb_log,
+                  struct log_fcb_sidx_sector *buf, int sector_cnt)
+{
+    fcb_log->fl_sidx = (struct log_fcb_sidx) {
+        .lsi_sectors = buf,
+        .lsi_cap = sector_cnt,
+    };
+}
+
+void
+log_fcb_clear_sidx(struct fcb_log *fcb_log)
+{
+    struct log_fcb_sidx *sidx;
+    int i;
+
+    sidx = &fcb_log->fl_sidx;
+    if (sidx->lsi_cap < fcb_log->fl_fcb.f_sector_cnt) {
+        return;
+    }
+    for (i = 0; i < fcb_log->fl_fcb.f_sector_cnt; i++) {
+        sidx->lsi_sectors[i].lss_nslots = 0;
+    }
+    sidx->lsi_valid = 1;
+}
+
+void
+log_fcb_rotate_sidx(struct fcb_log *fcb_log)
+{
+    if (!fcb_log->fl_sidx.lsi_valid) {
+        return;
+    }
+    log_fcb_sidx_at(fcb_log, log_fcb_sidx_oldest(fcb_log), 0)->lss_nslots = 0;
+}
+
+void
+log_fcb_add_sidx(struct fcb_log *fcb_log, const log_fcb_sidx_entry_t *entry,
+                 uint32_t index)
+{
+    struct log_fcb_sidx_sector *lss;
+    struct log_fcb_sidx_slot *slot;
+    uint16_t n;
+    int i;
+
+    if (!fcb_log->fl_sidx.lsi_valid) {
+        return;
+    }
+    lss = &fcb_log->fl_sidx.lsi_sectors[log_fcb_sidx_sector(fcb_log, entry)];
+
+    /*
+     * An entry which is not past the last one remembered means that the
+     * sector has been erased and reused.
+     */
+    if (lss->lss_nslots &&
+        log_fcb_sidx_entry_pos(entry) <=
+        log_fcb_sidx_entry_pos(&lss->lss_slots[lss->lss_nslots - 1].lsl_entry)) {
+        lss->lss_nslots = 0;
+    }
+
+    if (!lss->lss_nslots) {
+        lss->lss_slots[0].lsl_entry = *entry;
+        lss->lss_slots[0].lsl_index = index;
+        lss->lss_cnt = 1;
+        lss->lss_shift = 0;
+        lss->lss_nslots = 1;
+        return;
+    }
+
+    n = lss->lss_cnt++;
+    if (n & ((1 << lss->lss_shift) - 1)) {
+        return;
+    }
+
+    /*
+     * Out of slots; keep every other one, and remember entries half as
+     * often. n is then still a multiple of the (doubled) interval.
+     */
+    if (lss->lss_nslots == LOG_FCB_SIDX_SLOTS) {
+        for (i = 1; i < LOG_FCB_SIDX_SLOTS / 2; i++) {
+            lss->lss_slots[i] = lss->lss_slots[i * 2];
+        }
+        lss->lss_nslots = LOG_FCB_SIDX_SLOTS / 2;
+        lss->lss_shift++;
+    }
+    slot = &lss->lss_slots[lss->lss_nslots++];
+    slot->lsl_entry = *entry;
+    slot->lsl_index = index;
+}
+
+/*
+ * Indexes the entries already in the log.
+ */
+static int
+log_fcb_sidx_build(struct log *log)
+{
+    struct log_entry_hdr hdr;
+    struct fcb_log *fcb_log;
+    log_fcb_sidx_entry_t loc;
+    int rc;
+
+    fcb_log = log->l_arg;
+
+    log_fcb_clear_sidx(fcb_log);
+    if (!fcb_log->fl_sidx.lsi_valid) {
+        return SYS_ENOTSUP;
+    }
+
+    memset(&loc, 0, sizeof(loc));
+#if MYNEWT_VAL(LOG_FCB)
+    while (fcb_getnext(&fcb_log->fl_fcb, &loc) == 0) {
+#elif MYNEWT_VAL(LOG_FCB2)
+    while (fcb2_getnext(&fcb_log->fl_fcb, &loc) == 0) {
+#endif
+        rc = log_read_hdr(log, &loc, &hdr);
+        if (rc != 0) {
+            fcb_log->fl_sidx.lsi_valid = 0;
+            return rc;
+        }
+        log_fcb_add_sidx(fcb_log, &loc, hdr.ue_index);
+    }
+    return 0;
+}
+
+int
+log_fcb_find_sidx(struct log *log, const struct log_offset *log_offset,
+                  log_fcb_sidx_entry_t *entry, uint32_t *index)
+{
+    const struct log_fcb_sidx_sector *lss;
+    const struct log_fcb_sidx_slot *slot;
+    struct fcb_log *fcb_log;
+    int oldest;
+    int cnt;
+    int lo;
+    int hi;
+    int mid;
+
+    fcb_log = log->l_arg;
+
+    if (!fcb_log->fl_sidx.lsi_valid) {
+        if (log_fcb_sidx_build(log)) {
+            return SYS_ENOTSUP;
+        }
+    }
+
+    oldest = log_fcb_sidx_oldest(fcb_log);
+#if MYNEWT_VAL(LOG_FCB)
+    cnt = fcb_log->fl_fcb.f_active.fe_area - fcb_log->fl_fcb.f_sectors;
+#elif MYNEWT_VAL(LOG_FCB2)
+    cnt = fcb_log->fl_fcb.f_active.fe_sector;
+#endif
+    cnt -= oldest;
+    if (cnt < 0) {
+        cnt += fcb_log->fl_fcb.f_sector_cnt;
+    }
+    cnt++;
+
+    /* Last sector whose first entry is at or before the requested index. */
+    lo = 0;
+    hi = cnt - 1;
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        lss = log_fcb_sidx_at(fcb_log, oldest, mid);
+        if (!lss->lss_nslots) {
+            return SYS_ENOTSUP;
+        }
+        if (lss->lss_slots[0].lsl_index <= log_offset->lo_index) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    lss = log_fcb_sidx_at(fcb_log, oldest, lo);
+    if (!lss->lss_nslots) {
+        return SYS_ENOTSUP;
+    }
+
+    /* Last slot at or before the requested index. */
+    lo = 0;
+    hi = lss->lss_nslots - 1;
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (lss->lss_slots[mid].lsl_index <= log_offset->lo_index) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    slot = &lss->lss_slots[lo];
+
+    *entry = slot->lsl_entry;
+    *index = slot->lsl_index;
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(LOG_FCB_SPARSE_INDEX) */
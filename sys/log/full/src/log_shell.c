@@ -81,6 +81,10 @@ shell_log_dump_entry(struct log *log, struct log_offset *log_offset,
         cbor_value_to_pretty(stdout, &cbor_value);
         break;
     default:
+        if (ueh->ue_flags & LOG_FLAGS_DICT) {
+            /* For scripts/log_dict_decode.py */
+            console_write("dict:", 5);
+        }
         for (off = 0; off < rc; off += blksz) {
             blksz = dlen - off;
             if (blksz > sizeof(tmp) >> 1) {
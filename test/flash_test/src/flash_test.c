@@ -23,6 +23,7 @@
 #include <hal/hal_bsp.h>
 #include <hal/hal_flash.h>
 #include <hal/hal_flash_int.h>
+#include <flash_map/flash_map.h>
 #include <shell/shell.h>
 #include <stdio.h>
 #include <string.h>
@@ -31,6 +32,8 @@ static int flash_cli_cmd(const struct shell_cmd *cmd, int argc, char **argv,
                          struct streamer *streamer);
 static int flash_speed_test_cli(const struct shell_cmd *cmd, int argc,
                                 char **argv, struct streamer *streamer);
+static int flash_wspeed_test_cli(const struct shell_cmd *cmd, int argc,
+                                 char **argv, struct streamer *streamer);
 
 static struct shell_cmd flash_cmd_struct =
     SHELL_CMD_EXT("flash", flash_cli_cmd, NULL);
@@ -38,6 +41,9 @@ static struct shell_cmd flash_cmd_struct =
 static struct shell_cmd flash_speed_cli_struct =
     SHELL_CMD_EXT("flash_speed", flash_speed_test_cli, NULL);
 
+static struct shell_cmd flash_wspeed_cli_struct =
+    SHELL_CMD_EXT("flash_wspeed", flash_wspeed_test_cli, NULL);
+
 static int
 flash_cli_cmd(const struct shell_cmd *cmd, int argc, char **argv,
               struct streamer *streamer)
@@ -324,6 +330,142 @@ flash_speed_test_cli(const struct shell_cmd *cmd, int argc, char **argv,
     return 0;
 }
 
+/*
+ * Writes len bytes to the start of an erased flash area in chunks of sz
+ * bytes, either straight through hal_flash_write() or through
+ * flash_area_write() with write combining enabled.  Returns the number of
+ * ticks taken, or -1 on failure.
+ */
+static int
+flash_wspeed_test(const struct flash_area *fa, uint32_t len, uint32_t sz,
+                  int combine)
+{
+    os_time_t start_time;
+    uint8_t *data_buf;
+    uint32_t off;
+    uint32_t i;
+    int ticks;
+    int rc;
+
+    data_buf = malloc(sz);
+    if (!data_buf) {
+        return -1;
+    }
+    ticks = -1;
+    for (i = 0; i < sz; i++) {
+        data_buf[i] = i;
+    }
+
+    rc = flash_area_erase(fa, 0, fa->fa_size);
+    if (rc) {
+        goto out;
+    }
+    if (combine) {
+        rc = flash_area_wbuf_enable(fa);
+        if (rc) {
+            goto out;
+        }
+    }
+
+    start_time = os_time_get();
+    for (off = 0; off + sz <= len; off += sz) {
+        if (combine) {
+            rc = flash_area_write(fa, off, data_buf, sz);
+        } else {
+            rc = hal_flash_write(fa->fa_device_id, fa->fa_off + off,
+                                 data_buf, sz);
+        }
+        if (rc) {
+            console_printf("write(0x%x, %d) = %d\n",
+              (unsigned int)off, (unsigned int)sz, rc);
+            break;
+        }
+    }
+    if (combine) {
+        if (!rc) {
+            rc = flash_area_flush(fa);
+        }
+        flash_area_wbuf_disable(fa);
+    }
+    if (!rc) {
+        ticks = os_time_get() - start_time;
+    }
+
+out:
+    free(data_buf);
+    return ticks;
+}
+
+static int
+flash_wspeed_test_cli(const struct shell_cmd *cmd, int argc, char **argv,
+                      struct streamer *streamer)
+{
+    const struct flash_area *fa;
+    char *ep;
+    uint32_t len;
+    uint32_t sz;
+    int area_id;
+    int direct;
+    int combined;
+    int rc;
+
+    if (argc < 3) {
+        streamer_printf(streamer,
+          "flash_wspeed <area_id> <wr_sz> [len]\n");
+        return 0;
+    }
+
+    area_id = strtoul(argv[1], &ep, 10);
+    if (*ep != '\0') {
+        streamer_printf(streamer, "Invalid area_id: %s\n", argv[1]);
+        return 0;
+    }
+    rc = flash_area_open(area_id, &fa);
+    if (rc) {
+        streamer_printf(streamer, "Flash area %d not found\n", area_id);
+        return 0;
+    }
+
+    sz = strtoul(argv[2], &ep, 0);
+    if (*ep != '\0' || sz == 0) {
+        streamer_printf(streamer, "Invalid write size: %s\n", argv[2]);
+        goto out;
+    }
+
+    len = fa->fa_size;
+    if (argc > 3) {
+        len = strtoul(argv[3], &ep, 0);
+        if (*ep != '\0' || len > fa->fa_size) {
+            streamer_printf(streamer, "Invalid length: %s\n", argv[3]);
+            goto out;
+        }
+    }
+
+    streamer_printf(streamer,
+      "Write speed test, area %d, %d bytes in %d byte writes\n",
+      area_id, (unsigned int)len, (unsigned int)sz);
+
+    direct = flash_wspeed_test(fa, len, sz, 0);
+    if (direct < 0) {
+        streamer_printf(streamer, "hal_flash_write test failed\n");
+        goto out;
+    }
+    streamer_printf(streamer, "hal_flash_write:  %lu ms\n",
+      (unsigned long)os_time_ticks_to_ms32(direct));
+
+    combined = flash_wspeed_test(fa, len, sz, 1);
+    if (combined < 0) {
+        streamer_printf(streamer, "flash_area_write test failed\n");
+        goto out;
+    }
+    streamer_printf(streamer, "flash_area_write: %lu ms (combined)\n",
+      (unsigned long)os_time_ticks_to_ms32(combined));
+
+out:
+    flash_area_close(fa);
+    return 0;
+}
+
 /*
  * Initialize the package. Only called from sysinit().
  */
@@ -332,4 +474,5 @@ flash_test_init(void)
 {
     shell_cmd_register(&flash_cmd_struct);
     shell_cmd_register(&flash_speed_cli_struct);
+    shell_cmd_register(&flash_wspeed_cli_struct);
 }
@@ -30,6 +30,12 @@ struct cbmem_entry_hdr {
     uint16_t ceh_flags;
 } __attribute__((packed));
 
+/** Set in ceh_flags once a reserved entry has been filled in. */
+#define CBMEM_ENTRY_F_COMMITTED     0x0001
+
+/** cbmem appends reserve space without taking the mutex. */
+#define CBMEM_F_LOCKFREE            0x01
+
 struct cbmem {
     struct os_mutex c_lock;
 
@@ -38,6 +44,18 @@ struct cbmem {
     uint8_t *c_buf;
     uint8_t *c_buf_end;
     uint8_t *c_buf_cur_end;
+
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    uint8_t c_flags;
+    /* Number of holders of cbmem_lock_acquire(); no entry is overwritten
+     * while this is nonzero.
+     */
+    uint8_t c_readers;
+    /* Number of reserved entries not yet committed. */
+    uint16_t c_pending;
+    /* Number of appends that failed for lack of overwritable space. */
+    uint32_t c_drops;
+#endif
 };
 
 struct cbmem_iter {
@@ -71,6 +89,8 @@ struct cbmem_scat_gath {
         + ((struct cbmem_entry_hdr *) (__p))->ceh_len)
 #define CBMEM_ENTRY_NEXT(__p) ((struct cbmem_entry_hdr *) \
         ((uint8_t *) (__p) + CBMEM_ENTRY_SIZE(__p)))
+#define CBMEM_ENTRY_DATA(__p) ((void *) \
+        ((uint8_t *) (__p) + sizeof(struct cbmem_entry_hdr)))
 
 typedef int (*cbmem_walk_func_t)(struct cbmem *, struct cbmem_entry_hdr *, 
         void *arg);
@@ -78,6 +98,55 @@ typedef int (*cbmem_walk_func_t)(struct cbmem *, struct cbmem_entry_hdr *,
 int cbmem_lock_acquire(struct cbmem *cbmem);
 int cbmem_lock_release(struct cbmem *cbmem);
 int cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len);
+
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+/**
+ * @brief Initializes a cbmem whose appends never block.
+ *
+ * Appends to a lock-free cbmem reserve space for the entry in a short
+ * critical section, copy the data in without holding any lock and then mark
+ * the entry committed, so they can be made from several tasks and from
+ * interrupt context concurrently.  Iterators skip entries that are not yet
+ * committed.
+ *
+ * An append fails, rather than overwrite old entries, if one of the entries
+ * it would overwrite is still uncommitted or if a reader holds the cbmem
+ * through cbmem_lock_acquire().  Such failures are counted in c_drops.
+ *
+ * @param cbmem                 The cbmem to initialize.
+ * @param buf                   The entry buffer.
+ * @param buf_len               The size of buf, in bytes.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int cbmem_lockfree_init(struct cbmem *cbmem, void *buf, uint32_t buf_len);
+
+/**
+ * @brief Reserves space for an entry in a lock-free cbmem.
+ *
+ * The entry's data, CBMEM_ENTRY_DATA(hdr), must be filled in and the entry
+ * passed to cbmem_commit().  Readers skip the entry until then.  May be
+ * called from interrupt context.
+ *
+ * @param cbmem                 The cbmem to append to.
+ * @param len                   The length of the entry's data, in bytes.
+ *
+ * @return                      The reserved entry on success;
+ *                              NULL if there is no room.
+ */
+struct cbmem_entry_hdr *cbmem_reserve(struct cbmem *cbmem, uint16_t len);
+
+/**
+ * @brief Publishes an entry reserved with cbmem_reserve().
+ *
+ * May be called from interrupt context.
+ *
+ * @param cbmem                 The cbmem the entry was reserved in.
+ * @param hdr                   The reserved entry.
+ */
+void cbmem_commit(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr);
+#endif
+
 int cbmem_append(struct cbmem *cbmem, void *data, uint16_t len);
 int cbmem_append_mbuf(struct cbmem *cbmem, const struct os_mbuf *om);
 
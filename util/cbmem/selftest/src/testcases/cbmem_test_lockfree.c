@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cbmem_test/cbmem_test.h"
+
+#define CBMEM_LF_ENTRY_SIZE     28
+#define CBMEM_LF_BUF_SIZE       (4 * (CBMEM_LF_ENTRY_SIZE + \
+                                      sizeof(struct cbmem_entry_hdr)))
+
+static int
+cbmem_test_lockfree_count(struct cbmem *cbmem)
+{
+    struct cbmem_iter iter;
+    int count;
+
+    count = 0;
+    cbmem_iter_start(cbmem, &iter);
+    while (cbmem_iter_next(cbmem, &iter) != NULL) {
+        count++;
+    }
+
+    return count;
+}
+
+TEST_CASE_SELF(cbmem_test_lockfree)
+{
+    static uint8_t buf[CBMEM_LF_BUF_SIZE];
+    struct cbmem_entry_hdr *hdrs[4];
+    struct cbmem_entry_hdr *hdr;
+    struct cbmem_iter iter;
+    struct cbmem cbmem;
+    uint8_t data[CBMEM_LF_ENTRY_SIZE];
+    int rc;
+    int i;
+
+    rc = cbmem_lockfree_init(&cbmem, buf, sizeof(buf));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Reserved entries are invisible to readers until committed, whatever
+     * the commit order.
+     */
+    for (i = 0; i < 4; i++) {
+        hdrs[i] = cbmem_reserve(&cbmem, CBMEM_LF_ENTRY_SIZE);
+        TEST_ASSERT_FATAL(hdrs[i] != NULL);
+        memset(CBMEM_ENTRY_DATA(hdrs[i]), i, CBMEM_LF_ENTRY_SIZE);
+    }
+    TEST_ASSERT(cbmem_test_lockfree_count(&cbmem) == 0);
+
+    cbmem_commit(&cbmem, hdrs[2]);
+    cbmem_iter_start(&cbmem, &iter);
+    TEST_ASSERT(cbmem_iter_next(&cbmem, &iter) == hdrs[2]);
+    TEST_ASSERT(cbmem_iter_next(&cbmem, &iter) == NULL);
+
+    /* The buffer is full and its oldest entry is still being written. */
+    TEST_ASSERT(cbmem_reserve(&cbmem, CBMEM_LF_ENTRY_SIZE) == NULL);
+    TEST_ASSERT(cbmem.c_drops == 1);
+    TEST_ASSERT(cbmem_flush(&cbmem) == OS_EBUSY);
+
+    cbmem_commit(&cbmem, hdrs[0]);
+    cbmem_commit(&cbmem, hdrs[1]);
+    cbmem_commit(&cbmem, hdrs[3]);
+    TEST_ASSERT(cbmem_test_lockfree_count(&cbmem) == 4);
+
+    /* Nothing is overwritten while a reader holds the cbmem. */
+    rc = cbmem_lock_acquire(&cbmem);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(cbmem_append(&cbmem, data, sizeof(data)) != 0);
+    TEST_ASSERT(cbmem.c_drops == 2);
+    rc = cbmem_lock_release(&cbmem);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Otherwise the oldest committed entry makes way, as in locked mode. */
+    memset(data, 4, sizeof(data));
+    rc = cbmem_append(&cbmem, data, sizeof(data));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    i = 1;
+    cbmem_iter_start(&cbmem, &iter);
+    while ((hdr = cbmem_iter_next(&cbmem, &iter)) != NULL) {
+        rc = cbmem_read(&cbmem, hdr, data, 0, sizeof(data));
+        TEST_ASSERT_FATAL(rc == CBMEM_LF_ENTRY_SIZE);
+        TEST_ASSERT(data[0] == i && data[CBMEM_LF_ENTRY_SIZE - 1] == i);
+        i++;
+    }
+    TEST_ASSERT(i == 5);
+
+    TEST_ASSERT(cbmem_flush(&cbmem) == 0);
+    TEST_ASSERT(cbmem_test_lockfree_count(&cbmem) == 0);
+}
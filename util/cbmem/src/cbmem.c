@@ -35,20 +35,59 @@ cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len)
     return (0);
 }
 
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
 int
-cbmem_lock_acquire(struct cbmem *cbmem)
+cbmem_lockfree_init(struct cbmem *cbmem, void *buf, uint32_t buf_len)
 {
     int rc;
 
-    if (!os_started()) {
-        return (0);
+    rc = cbmem_init(cbmem, buf, buf_len);
+    if (rc != 0) {
+        return (rc);
     }
 
-    rc = os_mutex_pend(&cbmem->c_lock, OS_WAIT_FOREVER);
-    if (rc != 0) {
-        goto err;
+    cbmem->c_flags |= CBMEM_F_LOCKFREE;
+
+    return (0);
+}
+
+static inline bool
+cbmem_is_lockfree(const struct cbmem *cbmem)
+{
+    return (cbmem->c_flags & CBMEM_F_LOCKFREE) != 0;
+}
+#else
+static inline bool
+cbmem_is_lockfree(const struct cbmem *cbmem)
+{
+    return false;
+}
+#endif
+
+int
+cbmem_lock_acquire(struct cbmem *cbmem)
+{
+    int rc;
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    os_sr_t sr;
+#endif
+
+    if (os_started()) {
+        rc = os_mutex_pend(&cbmem->c_lock, OS_WAIT_FOREVER);
+        if (rc != 0) {
+            goto err;
+        }
     }
 
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    /* Appends don't take the mutex in lock-free mode; they check the reader
+     * count instead.
+     */
+    OS_ENTER_CRITICAL(sr);
+    cbmem->c_readers++;
+    OS_EXIT_CRITICAL(sr);
+#endif
+
     return (0);
 err:
     return (rc);
@@ -58,6 +97,13 @@ int
 cbmem_lock_release(struct cbmem *cbmem)
 {
     int rc;
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    cbmem->c_readers--;
+    OS_EXIT_CRITICAL(sr);
+#endif
 
     if (!os_started()) {
         return (0);
@@ -73,21 +119,49 @@ err:
     return (rc);
 }
 
+/**
+ * Indicates whether an entry about to be discarded to make room for a new
+ * one may be overwritten.  In lock-free mode, entries still being written and
+ * entries a reader may be looking at are left alone.
+ */
+static bool
+cbmem_can_discard(const struct cbmem *cbmem,
+                  const struct cbmem_entry_hdr *hdr)
+{
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    if (cbmem_is_lockfree(cbmem)) {
+        return cbmem->c_readers == 0 &&
+               (hdr->ceh_flags & CBMEM_ENTRY_F_COMMITTED);
+    }
+#endif
+
+    return true;
+}
 
-static int
-cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
-                      copy_data_func_t *copy_func)
+/**
+ * Finds room for an entry of the given length, discarding the oldest entries
+ * as necessary, and links it in as the newest entry.  The cbmem is only
+ * modified if room is found.
+ *
+ * @return                      The new entry's header; NULL if there is no
+ *                                  room.
+ */
+static struct cbmem_entry_hdr *
+cbmem_place(struct cbmem *cbmem, uint16_t len)
 {
     struct cbmem_entry_hdr *dst;
+    uint8_t *cur_end;
     uint8_t *start;
     uint8_t *end;
-    int rc;
+    uint8_t *p;
 
-    rc = cbmem_lock_acquire(cbmem);
-    if (rc != 0) {
-        goto err;
+    if (sizeof(*dst) + len > (uint32_t)(cbmem->c_buf_end - cbmem->c_buf)) {
+        return (NULL);
     }
 
+    cur_end = cbmem->c_buf_cur_end;
+    start = (uint8_t *) cbmem->c_entry_start;
+
     if (cbmem->c_entry_end) {
         dst = CBMEM_ENTRY_NEXT(cbmem->c_entry_end);
     } else {
@@ -99,11 +173,20 @@ cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
      * the item to the beginning of the buffer.
      */
     if (end > cbmem->c_buf_end) {
-        cbmem->c_buf_cur_end = (uint8_t *) dst;
+        cur_end = (uint8_t *) dst;
         dst = (struct cbmem_entry_hdr *) cbmem->c_buf;
         end = (uint8_t *) dst + len + sizeof(*dst);
-        if ((uint8_t *) cbmem->c_entry_start >= cbmem->c_buf_cur_end) {
-            cbmem->c_entry_start = (struct cbmem_entry_hdr *) cbmem->c_buf;
+        if (start >= cur_end) {
+            /* The entries between start and the old end of the buffer are
+             * dropped.
+             */
+            for (p = start; p < cbmem->c_buf_cur_end;
+                 p = (uint8_t *) CBMEM_ENTRY_NEXT(p)) {
+                if (!cbmem_can_discard(cbmem, (void *) p)) {
+                    return (NULL);
+                }
+            }
+            start = cbmem->c_buf;
         }
     }
 
@@ -111,29 +194,102 @@ cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
      * start of the buffer, move start forward until you don't overwrite it
      * anymore.
      */
-    start = (uint8_t *) cbmem->c_entry_start;
     if (start && (uint8_t *) dst < start + CBMEM_ENTRY_SIZE(start) &&
             end > start) {
         while (start < end) {
+            if (!cbmem_can_discard(cbmem, (void *) start)) {
+                return (NULL);
+            }
             start = (uint8_t *) CBMEM_ENTRY_NEXT(start);
-            if (start == cbmem->c_buf_cur_end) {
+            if (start == cur_end) {
                 start = cbmem->c_buf;
                 break;
             }
         }
-        cbmem->c_entry_start = (struct cbmem_entry_hdr *) start;
     }
 
-    /* Copy the entry into the log
-     */
     dst->ceh_len = len;
-    copy_func((uint8_t *) dst + sizeof(*dst), data, len);
+    dst->ceh_flags = 0;
 
+    cbmem->c_buf_cur_end = cur_end;
+    cbmem->c_entry_start = (struct cbmem_entry_hdr *) start;
     cbmem->c_entry_end = dst;
     if (!cbmem->c_entry_start) {
         cbmem->c_entry_start = dst;
     }
 
+    return (dst);
+}
+
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+struct cbmem_entry_hdr *
+cbmem_reserve(struct cbmem *cbmem, uint16_t len)
+{
+    struct cbmem_entry_hdr *hdr;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    hdr = cbmem_place(cbmem, len);
+    if (hdr != NULL) {
+        cbmem->c_pending++;
+    } else {
+        cbmem->c_drops++;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return (hdr);
+}
+
+void
+cbmem_commit(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    hdr->ceh_flags |= CBMEM_ENTRY_F_COMMITTED;
+    cbmem->c_pending--;
+    OS_EXIT_CRITICAL(sr);
+}
+#endif
+
+
+static int
+cbmem_append_internal(struct cbmem *cbmem, const void *data, uint16_t len,
+                      copy_data_func_t *copy_func)
+{
+    struct cbmem_entry_hdr *dst;
+    int rc;
+
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    if (cbmem_is_lockfree(cbmem)) {
+        dst = cbmem_reserve(cbmem, len);
+        if (dst == NULL) {
+            return (-1);
+        }
+
+        copy_func(CBMEM_ENTRY_DATA(dst), data, len);
+        cbmem_commit(cbmem, dst);
+
+        return (0);
+    }
+#endif
+
+    rc = cbmem_lock_acquire(cbmem);
+    if (rc != 0) {
+        goto err;
+    }
+
+    dst = cbmem_place(cbmem, len);
+    if (dst == NULL) {
+        cbmem_lock_release(cbmem);
+        goto err;
+    }
+
+    /* Copy the entry into the log
+     */
+    copy_func(CBMEM_ENTRY_DATA(dst), data, len);
+    dst->ceh_flags = CBMEM_ENTRY_F_COMMITTED;
+
     rc = cbmem_lock_release(cbmem);
     if (rc != 0) {
         goto err;
@@ -226,13 +382,18 @@ cbmem_append_scat_gath(struct cbmem *cbmem, const struct cbmem_scat_gath *sg)
 void
 cbmem_iter_start(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
+    os_sr_t sr;
+
+    /* Lock-free appends may be updating the cbmem concurrently. */
+    OS_ENTER_CRITICAL(sr);
     iter->ci_start = cbmem->c_entry_start;
     iter->ci_cur = cbmem->c_entry_start;
     iter->ci_end = cbmem->c_entry_end;
+    OS_EXIT_CRITICAL(sr);
 }
 
-struct cbmem_entry_hdr *
-cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
+static struct cbmem_entry_hdr *
+cbmem_iter_next_any(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
     struct cbmem_entry_hdr *hdr;
 
@@ -261,9 +422,23 @@ err:
     return (hdr);
 }
 
+struct cbmem_entry_hdr *
+cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
+{
+    struct cbmem_entry_hdr *hdr;
+
+    do {
+        hdr = cbmem_iter_next_any(cbmem, iter);
+    } while (hdr != NULL && cbmem_is_lockfree(cbmem) &&
+             !(hdr->ceh_flags & CBMEM_ENTRY_F_COMMITTED));
+
+    return (hdr);
+}
+
 int
 cbmem_flush(struct cbmem *cbmem)
 {
+    os_sr_t sr;
     int rc;
 
     rc = cbmem_lock_acquire(cbmem);
@@ -271,9 +446,20 @@ cbmem_flush(struct cbmem *cbmem)
         goto err;
     }
 
+    OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(CBMEM_LOCKFREE)
+    /* Entries still being written can't be dropped. */
+    if (cbmem->c_pending != 0) {
+        OS_EXIT_CRITICAL(sr);
+        cbmem_lock_release(cbmem);
+        rc = OS_EBUSY;
+        goto err;
+    }
+#endif
     cbmem->c_entry_start = NULL;
     cbmem->c_entry_end = NULL;
     cbmem->c_buf_cur_end = NULL;
+    OS_EXIT_CRITICAL(sr);
 
     rc = cbmem_lock_release(cbmem);
     if (rc != 0) {
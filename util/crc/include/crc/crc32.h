@@ -0,0 +1,67 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * CRC32 (IEEE 802.3, reflected polynomial 0xedb88320) and CRC32C
+ * (Castagnoli, reflected polynomial 0x82f63b78).
+ */
+
+#ifndef _UTIL_CRC32_H_
+#define _UTIL_CRC32_H_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRC32_INITIAL_CRC       0       /* what to seed crc32/crc32c with */
+
+/**
+ * Calculates the CRC32 of a buffer.  A large input can be processed in
+ * pieces by passing the result of each call as the initial_crc of the next;
+ * the first call is seeded with CRC32_INITIAL_CRC.
+ *
+ * @param initial_crc           CRC of the preceding data, or
+ *                                  CRC32_INITIAL_CRC.
+ * @param buf                   The data to checksum.
+ * @param len                   The number of bytes in buf.
+ *
+ * @return                      The CRC32 of the data processed so far.
+ */
+uint32_t crc32(uint32_t initial_crc, const void *buf, int len);
+
+/**
+ * Calculates the CRC32C of a buffer.  Incremental use is the same as for
+ * crc32().
+ *
+ * @param initial_crc           CRC of the preceding data, or
+ *                                  CRC32_INITIAL_CRC.
+ * @param buf                   The data to checksum.
+ * @param len                   The number of bytes in buf.
+ *
+ * @return                      The CRC32C of the data processed so far.
+ */
+uint32_t crc32c(uint32_t initial_crc, const void *buf, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
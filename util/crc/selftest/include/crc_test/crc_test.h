@@ -0,0 +1,45 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _CRC_TEST_H_
+#define _CRC_TEST_H_
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRC_TEST_BUF_SIZE   256
+
+extern uint8_t crc_test_buf[CRC_TEST_BUF_SIZE];
+
+TEST_CASE_DECL(crc_test_vectors);
+TEST_CASE_DECL(crc_test_incremental);
+TEST_SUITE_DECL(crc_test_suite);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "crc_test/crc_test.h"
+
+uint8_t crc_test_buf[CRC_TEST_BUF_SIZE];
+
+static void
+crc_test_fill_buf(void *arg)
+{
+    int i;
+
+    for (i = 0; i < CRC_TEST_BUF_SIZE; i++) {
+        crc_test_buf[i] = i * 7 + 3;
+    }
+}
+
+TEST_SUITE(crc_test_suite)
+{
+    tu_suite_set_pre_test_cb(crc_test_fill_buf, NULL);
+
+    crc_test_vectors();
+    crc_test_incremental();
+}
+
+int
+main(int argc, char **argv)
+{
+    crc_test_suite();
+    return tu_any_failed;
+}
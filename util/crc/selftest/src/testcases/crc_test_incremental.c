@@ -0,0 +1,59 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "crc_test/crc_test.h"
+
+TEST_CASE_SELF(crc_test_incremental)
+{
+    uint32_t crc32_full;
+    uint32_t crc32c_full;
+    uint16_t crc16_full;
+    int split;
+    int off;
+
+    /* Splitting the input at any point, and starting at any alignment, must
+     * not change the result of the sliced loops.
+     */
+    for (off = 0; off < 8; off++) {
+        crc16_full = crc16_ccitt(CRC16_INITIAL_CRC, crc_test_buf + off,
+                                 CRC_TEST_BUF_SIZE - 8);
+        crc32_full = crc32(CRC32_INITIAL_CRC, crc_test_buf + off,
+                           CRC_TEST_BUF_SIZE - 8);
+        crc32c_full = crc32c(CRC32_INITIAL_CRC, crc_test_buf + off,
+                             CRC_TEST_BUF_SIZE - 8);
+
+        for (split = 0; split <= CRC_TEST_BUF_SIZE - 8; split += 13) {
+            TEST_ASSERT(crc16_ccitt(crc16_ccitt(CRC16_INITIAL_CRC,
+                                                crc_test_buf + off, split),
+                                    crc_test_buf + off + split,
+                                    CRC_TEST_BUF_SIZE - 8 - split) ==
+                        crc16_full);
+            TEST_ASSERT(crc32(crc32(CRC32_INITIAL_CRC,
+                                    crc_test_buf + off, split),
+                              crc_test_buf + off + split,
+                              CRC_TEST_BUF_SIZE - 8 - split) ==
+                        crc32_full);
+            TEST_ASSERT(crc32c(crc32c(CRC32_INITIAL_CRC,
+                                      crc_test_buf + off, split),
+                               crc_test_buf + off + split,
+                               CRC_TEST_BUF_SIZE - 8 - split) ==
+                        crc32c_full);
+        }
+    }
+}